@@ -0,0 +1,149 @@
+#include "alertengine.h"
+#include <QSettings>
+#include <QDebug>
+#include <cctype>
+
+bool AlertRule::operator==(const AlertRule& other) const
+{
+    return name == other.name && metric == other.metric && below == other.below && threshold == other.threshold &&
+           hysteresis == other.hysteresis && forMs == other.forMs && cooldownMs == other.cooldownMs;
+}
+
+AlertEngine::AlertEngine()
+    : m_values()
+    , m_firingMetrics(0)
+    , m_lastMs(0)
+{
+}
+
+void AlertEngine::configure(const AlertRules& rules)
+{
+    m_rules = rules;
+    m_predicates.clear();
+    m_inputs.clear();
+    quint32 inputs = 0;
+    for (const AlertRule& rule : rules) {
+        Predicate predicate;
+        predicate.metric = static_cast<int>(rule.metric);
+        predicate.sign = rule.below ? -1.0 : 1.0;
+        predicate.fire = predicate.sign * rule.threshold;
+        predicate.clear = predicate.fire - qMax(0.0, rule.hysteresis);
+        predicate.forMs = qMax(0, rule.forMs);
+        predicate.cooldownMs = qMax(0, rule.cooldownMs);
+        m_predicates.push_back(predicate);
+        inputs |= quint32(1) << predicate.metric;
+    }
+    for (int m = 0; m < MetricCount; ++m) {
+        if (inputs & (quint32(1) << m)) {
+            m_inputs.push_back(m);
+        }
+    }
+    m_states.assign(rules.size(), State());
+    m_firingMetrics = 0;
+    m_lastMs = 0;
+}
+
+quint32 AlertEngine::evaluate(const SysInfo& info, qint64 timestampMs)
+{
+    if (timestampMs < m_lastMs) {
+        m_states.assign(m_states.size(), State());
+    }
+    m_lastMs = timestampMs;
+    for (int m : m_inputs) {
+        m_values[m] = metricValue(info, static_cast<Metric>(m));
+    }
+
+    quint32 firingMetrics = 0;
+    const size_t count = m_predicates.size();
+    for (size_t i = 0; i < count; ++i) {
+        const Predicate& predicate = m_predicates[i];
+        State& state = m_states[i];
+        const double raw = m_values[predicate.metric];
+        const double value = predicate.sign * raw;
+        if (raw < 0.0) {
+            state.pendingSinceMs = -1;
+        } else if (state.firing) {
+            if (value < predicate.clear) {
+                state.firing = false;
+                state.quietUntilMs = timestampMs + predicate.cooldownMs;
+            }
+        } else if (value > predicate.fire) {
+            if (state.pendingSinceMs < 0) {
+                state.pendingSinceMs = timestampMs;
+            }
+            if (timestampMs - state.pendingSinceMs >= predicate.forMs && timestampMs >= state.quietUntilMs) {
+                state.firing = true;
+                state.pendingSinceMs = -1;
+                ++state.fired;
+            }
+        } else {
+            state.pendingSinceMs = -1;
+        }
+        firingMetrics |= quint32(state.firing) << predicate.metric;
+    }
+    m_firingMetrics = firingMetrics;
+    return firingMetrics;
+}
+
+AlertRules AlertEngine::load(QSettings& settings)
+{
+    // An empty array turns alerting off; only a missing one gets the defaults
+    if (!settings.contains("alerts/size")) {
+        return defaultRules();
+    }
+    AlertRules rules;
+    const int size = settings.beginReadArray("alerts");
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        AlertRule rule;
+        const QByteArray metric = settings.value("metric").toString().toLatin1();
+        if (!metricFromName(metric.constData(), rule.metric)) {
+            qWarning() << "Alert rule" << i << "has an unknown metric" << metric << "and is ignored";
+            continue;
+        }
+        rule.name = settings.value("name", QString("%1_%2").arg(QString::fromLatin1(metric)).arg(i)).toString().toLatin1();
+        // The name ends up as an exporter label value, where quotes and backslashes would need escaping
+        for (char& c : rule.name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+                c = '_';
+            }
+        }
+        rule.below = settings.value("condition", "above").toString() == "below";
+        rule.threshold = settings.value("threshold").toDouble();
+        rule.hysteresis = settings.value("hysteresis", 0.0).toDouble();
+        rule.forMs = static_cast<int>(settings.value("forSeconds", 0.0).toDouble() * 1000);
+        rule.cooldownMs = static_cast<int>(settings.value("cooldownSeconds", 0.0).toDouble() * 1000);
+        rules.push_back(rule);
+    }
+    settings.endArray();
+    return rules;
+}
+
+AlertRules AlertEngine::defaultRules()
+{
+    AlertRule cpuTemp;
+    cpuTemp.name = "cpu_temp_high";
+    cpuTemp.metric = Metric::CpuTemp;
+    cpuTemp.threshold = 90.0;
+    cpuTemp.hysteresis = 5.0;
+    cpuTemp.forMs = 5000;
+    cpuTemp.cooldownMs = 30000;
+
+    AlertRule gpuLoad;
+    gpuLoad.name = "gpu_load_high";
+    gpuLoad.metric = Metric::GpuLoad;
+    gpuLoad.threshold = 95.0;
+    gpuLoad.hysteresis = 10.0;
+    gpuLoad.forMs = 10000;
+    gpuLoad.cooldownMs = 30000;
+
+    AlertRule memory;
+    memory.name = "memory_high";
+    memory.metric = Metric::MemUsage;
+    memory.threshold = 90.0;
+    memory.hysteresis = 5.0;
+    memory.forMs = 10000;
+    memory.cooldownMs = 60000;
+
+    return { cpuTemp, gpuLoad, memory };
+}
@@ -0,0 +1,90 @@
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <vector>
+#include "sysinfo.h"
+
+class QSettings;
+
+// One threshold on one metric, as stored in the alerts settings array
+struct AlertRule {
+    QByteArray name;          // label for the exporter, e.g. "cpu_temp_high"
+    Metric metric = Metric::CpuLoad;
+    bool below = false;       // fires when the value drops below threshold instead of rising above it
+    double threshold = 0.0;
+    // A firing rule clears only once the value is this far back on the other side
+    double hysteresis = 0.0;
+    // How long the value must stay past threshold before the rule fires
+    int forMs = 0;
+    // How long a cleared rule stays quiet before it can fire again
+    int cooldownMs = 0;
+
+    bool operator==(const AlertRule& other) const;
+    bool operator!=(const AlertRule& other) const { return !(*this == other); }
+};
+
+using AlertRules = std::vector<AlertRule>;
+
+// Evaluates threshold rules against every sample.
+//
+// configure() compiles the rules once into a flat array of predicates in which a "below"
+// rule is an "above" rule on the negated value, so evaluating a rule is a load, a multiply
+// and two compares with no branching on its kind. Each metric a rule reads is fetched once
+// per sample however many rules read it. Negative values mean N/A: they start a pending
+// rule's forMs over without clearing a firing one. Nothing here reads a clock, so replaying
+// a recording gives the same transitions every time. Not thread-safe; SysInfoMonitor calls it on the
+// sampler thread only.
+class AlertEngine
+{
+public:
+    static_assert(MetricCount <= 32, "alertMetrics has one bit per metric");
+
+    AlertEngine();
+
+    // Starts every rule over, cleared
+    void configure(const AlertRules& rules);
+    const AlertRules& rules() const { return m_rules; }
+
+    // Returns the firing metrics as SysInfo::alertMetrics bits. Samples are expected in
+    // time order; one from before the previous starts every rule over.
+    quint32 evaluate(const SysInfo& info, qint64 timestampMs);
+
+    quint32 firingMetrics() const { return m_firingMetrics; }
+    bool firing(int rule) const { return m_states[rule].firing; }
+    // Times the rule has fired since configure()
+    quint64 firedCount(int rule) const { return m_states[rule].fired; }
+
+    // Reads the "alerts" settings array; the defaults below when there is none
+    static AlertRules load(QSettings& settings);
+    static AlertRules defaultRules();
+
+private:
+    struct Predicate {
+        int metric;
+        double sign;      // +1 above, -1 below
+        double fire;      // sign * threshold
+        double clear;     // fire - hysteresis
+        qint64 forMs;
+        qint64 cooldownMs;
+    };
+
+    struct State {
+        qint64 pendingSinceMs = -1;
+        qint64 quietUntilMs = 0;
+        quint64 fired = 0;
+        bool firing = false;
+    };
+
+    AlertRules m_rules;
+    std::vector<Predicate> m_predicates;
+    std::vector<State> m_states;
+    // Metrics any rule reads, fetched once per sample into m_values
+    std::vector<int> m_inputs;
+    double m_values[MetricCount];
+    quint32 m_firingMetrics;
+    qint64 m_lastMs;
+};
+
+#endif // ALERTENGINE_H
@@ -0,0 +1,746 @@
+// winsys-bench: microbenchmarks for the sampling, decoding and rendering hot paths.
+//
+// Built with -DWINSYS_BUILD_BENCH=ON (needs Google Benchmark). Runs without a display: the
+// offscreen platform plugin is used unless QT_QPA_PLATFORM says otherwise, and settings go
+// to a throwaway INI file so the user's own are neither read nor changed. Output is JSON
+// unless --benchmark_format is given, so CI can diff runs with benchmark's compare.py.
+
+#include <benchmark/benchmark.h>
+#include <QApplication>
+#include <QFile>
+#include <QImage>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "metriccollector.h"
+#include "playbackcollector.h"
+#include "samplerecording.h"
+#include "sensorprotocol.h"
+#include "overlaysettings.h"
+#include "overlaywidget.h"
+#include "metricformatter.h"
+#include "processtable.h"
+#include "frametimingengine.h"
+#include "metricstatistics.h"
+#include "alertengine.h"
+#include "cpucores.h"
+#include "heatstrip.h"
+#include "procparse.h"
+#include "procsnapshots.h"
+
+namespace {
+
+std::atomic<quint64> allocationCount(0);
+
+} // namespace
+
+// Counts heap allocations on every thread, Qt's included (QString goes straight to malloc,
+// so counting operator new alone would miss it). glibc only.
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+extern "C" void* malloc(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+namespace {
+
+// Allocations per iteration since start, as a benchmark counter
+benchmark::Counter allocationsPerIteration(quint64 start)
+{
+    return benchmark::Counter(static_cast<double>(allocationCount.load(std::memory_order_relaxed) - start),
+                              benchmark::Counter::kAvgIterations);
+}
+
+QTemporaryDir* scratchDir = nullptr;
+
+// A sample that exercises every row, with values that change from call to call so the
+// text of each row really changes
+SysInfo sampleAt(int i)
+{
+    SysInfo info;
+    info.cpuLoad = 10.0 + (i % 50);
+    info.memUsage = 40 + i % 7;
+    info.totalRamMB = 32768;
+    info.availRamMB = 20000 - i % 100;
+    info.diskLoad = (i % 13) * 1.5;
+    info.gpuLoad = (i % 29) * 0.5;
+    info.networkDownloadSpeed = 0.05 * (i % 11);
+    info.networkUploadSpeed = 0.01 * (i % 5);
+    info.dailyDataUsageMB = 1200 + i / 10;
+    info.cpuTemp = 45.0 + (i % 10) * 0.5;
+    info.gpuTemp = 40.0 + (i % 8) * 0.5;
+    info.activeProcesses = 300 + i % 4;
+    info.systemUptime = 12.0 + i / 3600.0;
+    const char* const names[TopProcessCount] = { "game.exe", "browser", "compiler" };
+    for (int p = 0; p < TopProcessCount; ++p) {
+        std::strncpy(info.topCpu[p].name, names[p], sizeof(info.topCpu[p].name) - 1);
+        info.topCpu[p].pid = 1000 + p;
+        info.topCpu[p].cpuPercent = 30.0f / (p + 1) + (i % 7) * 0.1f;
+        info.topMemory[p] = info.topCpu[p];
+        info.topMemory[p].residentMB = 4096.0f / (p + 1) + i % 50;
+    }
+    info.cpuCores.count = 16;
+    for (int core = 0; core < info.cpuCores.count; ++core) {
+        info.cpuCores.load[core] = static_cast<quint8>((core * 7 + i) % 101);
+        info.cpuCores.frequencyMHz[core] = static_cast<quint16>(3000 + core * 50 + i % 100);
+    }
+    info.cpuCores.busiest[0] = static_cast<qint16>(i % 16);
+    info.cpuCoreMaxLoad = 100 - i % 5;
+    info.cpuFrequencyMHz = 3400.0 + i % 100;
+    info.cpuFrequencyMaxMHz = 3750.0 + i % 100;
+    return info;
+}
+
+std::string writeRecording(int samples)
+{
+    const std::string path = scratchDir->filePath("bench.wsr").toStdString();
+    std::remove(path.c_str());
+    SampleRecording::Recorder recorder;
+    recorder.open(path);
+    for (int i = 0; i < samples; ++i) {
+        recorder.append(sampleAt(i), 1700000000000LL + i * 1000LL);
+    }
+    recorder.close();
+    return path;
+}
+
+// One overlay shared by the widget benchmarks; creating it starts the sampler thread,
+// which the long update interval below keeps out of the way
+OverlayWidget& overlay()
+{
+    static OverlayWidget* widget = [] {
+        auto* w = new OverlayWidget;
+        w->resize(w->sizeHint());
+        // Hidden or unexposed, the overlay only keeps the latest sample and renders nothing
+        w->show();
+        QCoreApplication::processEvents();
+        return w;
+    }();
+    return *widget;
+}
+
+void useRenderer(const char* renderer)
+{
+    QSettings s;
+    if (s.value("appearance/renderer").toString() != renderer) {
+        s.setValue("appearance/renderer", renderer);
+        s.sync();
+        SettingsStore::instance()->reload();
+    }
+}
+
+} // namespace
+
+// --- Collection ---
+
+static void BM_CollectorSample(benchmark::State& state)
+{
+    std::unique_ptr<MetricCollector> collector = MetricCollector::createDefault();
+    collector->initialize();
+    SysInfo info;
+    for (auto _ : state) {
+        collector->collect(info);
+        benchmark::DoNotOptimize(info);
+    }
+    state.SetLabel(collector->name());
+}
+BENCHMARK(BM_CollectorSample)->Unit(benchmark::kMicrosecond);
+
+// Sampling cost with the first N metric groups enabled, in MetricGroup order; the rest are
+// never opened
+static void BM_CollectorEnabledGroups(benchmark::State& state)
+{
+    const int enabled = static_cast<int>(state.range(0));
+    std::unique_ptr<MetricCollector> collector = MetricCollector::createDefault();
+    collector->setEnabledGroups((MetricGroups(1) << enabled) - 1);
+    collector->initialize();
+    SysInfo info;
+    for (auto _ : state) {
+        collector->collectGroups(info, AllMetricGroups);
+        benchmark::DoNotOptimize(info);
+    }
+    state.SetLabel(collector->name());
+}
+BENCHMARK(BM_CollectorEnabledGroups)->DenseRange(0, MetricGroupCount)->Unit(benchmark::kMicrosecond);
+
+// One refresh of every process on this machine plus both top-N selections, once the table
+// holds them all; the label says how many there were
+static void BM_ProcessTableRefresh(benchmark::State& state)
+{
+    ProcessTable table;
+    table.refresh();
+    TopProcess top[TopProcessCount];
+    for (auto _ : state) {
+        table.refresh();
+        table.topByCpu(top, TopProcessCount);
+        table.topByMemory(top, TopProcessCount);
+        benchmark::DoNotOptimize(top);
+    }
+    state.SetLabel(std::to_string(table.count()) + " processes");
+}
+BENCHMARK(BM_ProcessTableRefresh)->Unit(benchmark::kMicrosecond);
+
+static void BM_PlaybackSample(benchmark::State& state)
+{
+    const int samples = 100000;
+    const std::string path = writeRecording(samples);
+    auto collector = std::make_unique<PlaybackCollector>(path, 0.0);
+    collector->initialize();
+    SysInfo info;
+    for (auto _ : state) {
+        if (collector->finished()) {
+            state.PauseTiming();
+            collector = std::make_unique<PlaybackCollector>(path, 0.0);
+            collector->initialize();
+            state.ResumeTiming();
+        }
+        collector->collect(info);
+        benchmark::DoNotOptimize(info);
+    }
+    state.SetLabel("playback");
+}
+BENCHMARK(BM_PlaybackSample);
+
+static void BM_RecorderAppend(benchmark::State& state)
+{
+    SampleRecording::Recorder recorder;
+    recorder.open(scratchDir->filePath("append.wsr").toStdString());
+    const SysInfo a = sampleAt(1);
+    const SysInfo b = sampleAt(2);
+    qint64 timestamp = 1700000000000LL;
+    for (auto _ : state) {
+        timestamp += 1000;
+        recorder.append((timestamp & 1024) ? a : b, timestamp);
+    }
+}
+BENCHMARK(BM_RecorderAppend);
+
+// --- Frame timing ---
+
+// Ten seconds of synthetic presents at N fps replayed through the engine, statistics read
+// every 100 ms as the sampler would. Timing only; tst_frametiming checks the statistics.
+static void BM_FrameTimingReplay(benchmark::State& state)
+{
+    const double fps = static_cast<double>(state.range(0));
+    SyntheticFrameSource source(fps);
+    std::vector<qint64> presents;
+    source.generate(10 * 1000 * 1000, presents);
+
+    auto replay = [&presents] {
+        FrameTimingEngine engine;
+        qint64 nextReadUs = 100 * 1000;
+        for (qint64 timestampUs : presents) {
+            if (timestampUs >= nextReadUs) {
+                benchmark::DoNotOptimize(engine.stats(nextReadUs));
+                nextReadUs += 100 * 1000;
+            }
+            engine.addPresent(timestampUs);
+        }
+        return engine.stats(presents.back());
+    };
+    FrameTimingEngine::Stats stats;
+    for (auto _ : state) {
+        stats = replay();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * presents.size()));
+    state.SetLabel(std::to_string(static_cast<int>(stats.fps)) + " fps, 1% low " +
+                   std::to_string(static_cast<int>(stats.low1PercentFps)));
+}
+BENCHMARK(BM_FrameTimingReplay)->Arg(60)->Arg(1000)->Arg(5000)->Unit(benchmark::kMicrosecond);
+
+// --- Metric statistics ---
+
+// One sample through the statistics stage with every metric on the given statistic, so the
+// per-sample cost is the worst case of that statistic
+static void BM_MetricStatistics(benchmark::State& state)
+{
+    MetricStatisticsConfig config;
+    for (MetricStatistic& statistic : config.statistic) {
+        statistic = static_cast<MetricStatistic>(state.range(0));
+    }
+    MetricStatistics statistics;
+    statistics.configure(config);
+    qint64 timestampMs = 1700000000000LL;
+    int i = 0;
+    for (auto _ : state) {
+        SysInfo info = sampleAt(i++);
+        timestampMs += 1000;
+        statistics.apply(info, timestampMs);
+        benchmark::DoNotOptimize(info);
+    }
+    state.SetLabel(metricStatisticName(config.statistic[0]));
+}
+BENCHMARK(BM_MetricStatistics)->DenseRange(0, MetricStatisticCount - 1);
+
+// --- Per-core load ---
+
+// /proc/stat text for the given number of CPUs after the given number of seconds: core c is
+// busy (c * 37) % 100 percent of the time, so the busiest cores are known in advance
+std::string procStatText(int cores, int second)
+{
+    std::string text = "cpu  0 0 0 0 0 0 0 0 0 0\n";
+    char line[160];
+    for (int core = 0; core < cores; ++core) {
+        // 100 ticks per second split into user, system and idle, with a large boot offset
+        const unsigned long long busy = 1000000ULL + static_cast<unsigned long long>(second) * ((core * 37) % 100);
+        const unsigned long long idle = 9000000ULL + static_cast<unsigned long long>(second) * (100 - (core * 37) % 100);
+        std::snprintf(line, sizeof(line), "cpu%d %llu 12 %llu %llu 345 0 678 0 0 0\n", core, busy - busy / 4, busy / 4,
+                      idle);
+        text += line;
+    }
+    text += "intr 123456789 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\nctxt 987654321\n";
+    return text;
+}
+
+// One tick of per-core processing at 16 to 256 CPUs: parsing the cpuN lines of /proc/stat,
+// the load deltas and the max, mean and busiest-N aggregation. Fails when the busiest
+// cores are not the ones the text was made with.
+static void BM_CpuCoreAggregate(benchmark::State& state)
+{
+    const int cores = static_cast<int>(state.range(0));
+    const std::string texts[2] = { procStatText(cores, 1), procStatText(cores, 2) };
+    CpuCoreAggregator aggregator;
+    aggregator.reset(0);
+    readProcStatCores(procStatText(cores, 0), aggregator);
+    aggregator.update();
+    for (int core = 0; core < aggregator.cores(); ++core) {
+        aggregator.frequencies()[core] = 2000.0f + 10.0f * core;
+    }
+    SysInfo info;
+    int i = 0;
+    for (auto _ : state) {
+        // Alternating snapshots make every other delta negative; the cost is the same
+        readProcStatCores(texts[i++ & 1], aggregator);
+        aggregator.update();
+        aggregator.summarize(info);
+        benchmark::DoNotOptimize(info.cpuCores);
+    }
+
+    // Replayed forwards, the busiest cores are the ones with the largest (c * 37) % 100
+    aggregator.reset(0);
+    readProcStatCores(texts[0], aggregator);
+    aggregator.update();
+    readProcStatCores(texts[1], aggregator);
+    aggregator.update();
+    aggregator.summarize(info);
+    std::vector<int> expected(cores);
+    for (int core = 0; core < cores; ++core) {
+        expected[core] = core;
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](int a, int b) { return (a * 37) % 100 > (b * 37) % 100; });
+    for (int k = 0; k < BusiestCoreCount && k < cores; ++k) {
+        if (info.cpuCores.busiest[k] != expected[k] || info.cpuCores.load[expected[k]] != (expected[k] * 37) % 100) {
+            state.SkipWithError("busiest cores differ from the script");
+            return;
+        }
+    }
+    state.SetLabel(std::to_string(info.cpuCores.count) + " cores");
+}
+BENCHMARK(BM_CpuCoreAggregate)->Arg(16)->Arg(64)->Arg(256);
+
+// Drawing the cores row's heat strip for 256 cores whose loads all change every tick
+static void BM_HeatStrip(benchmark::State& state)
+{
+    HeatStrip strip;
+    quint8 loads[2][MaxCpuCores];
+    for (int core = 0; core < MaxCpuCores; ++core) {
+        loads[0][core] = static_cast<quint8>((core * 37) % 101);
+        loads[1][core] = static_cast<quint8>((core * 37 + 1) % 101);
+    }
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(strip.setLoads(loads[i++ & 1], MaxCpuCores));
+    }
+}
+BENCHMARK(BM_HeatStrip);
+
+// --- /proc parsing ---
+
+#ifdef Q_OS_LINUX
+
+// The snapshot as a file in the scratch directory, so both parsers below read the same text
+std::string procSnapshotPath(int snapshot)
+{
+    const std::string path = scratchDir->filePath(QString("proc-%1").arg(snapshot)).toStdString();
+    if (FILE* file = std::fopen(path.c_str(), "wb")) {
+        std::fputs(procSnapshots[snapshot], file);
+        std::fclose(file);
+    }
+    return path;
+}
+
+// Reading and parsing one /proc file the way ProcfsCollector does: kept open, re-read with
+// pread into the same buffer and parsed in place. Arg: meminfo, stat, net/dev, pid/stat.
+static void BM_ProcParse(benchmark::State& state)
+{
+    const int snapshot = static_cast<int>(state.range(0));
+    const std::string path = procSnapshotPath(snapshot);
+    ProcFile file;
+    file.open(path);
+    ProcKeyTable meminfoKeys{ "MemTotal:", "MemAvailable:" };
+    const quint64 allocations = allocationCount.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseProcFast(snapshot, file.read(), meminfoKeys));
+    }
+    state.counters["allocs"] = allocationsPerIteration(allocations);
+    state.SetLabel(procSnapshotNames[snapshot]);
+}
+BENCHMARK(BM_ProcParse)->DenseRange(0, ProcSnapshotCount - 1);
+
+// The same with QFile, QString::split and toULongLong
+static void BM_ProcParseNaive(benchmark::State& state)
+{
+    const int snapshot = static_cast<int>(state.range(0));
+    const QString path = QString::fromStdString(procSnapshotPath(snapshot));
+    const quint64 allocations = allocationCount.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        QFile file(path);
+        file.open(QIODevice::ReadOnly);
+        benchmark::DoNotOptimize(parseProcNaive(snapshot, file.readAll()));
+    }
+    state.counters["allocs"] = allocationsPerIteration(allocations);
+    state.SetLabel(procSnapshotNames[snapshot]);
+}
+BENCHMARK(BM_ProcParseNaive)->DenseRange(0, ProcSnapshotCount - 1);
+
+#endif
+
+// --- Alerts ---
+
+// CPU temperature script for the replay below, one sample per second: a 5 s spike that
+// min duration filters out, a long excursion wobbling inside the hysteresis band, and a
+// second one that starts during the cooldown
+double scriptedCpuTemp(int second)
+{
+    if ((second >= 100 && second < 105) || (second >= 200 && second < 230) || (second >= 270 && second < 300)) {
+        return 95.0;
+    }
+    if (second >= 230 && second < 260) {
+        return second % 2 ? 88.0 : 93.0;
+    }
+    return 60.0;
+}
+
+// A recording of the script replayed through the default rules. Timing only;
+// tst_alertengine replays the same script and checks the transitions.
+static void BM_AlertReplay(benchmark::State& state)
+{
+    const int samples = 400;
+    const qint64 startMs = 1700000000000LL;
+    const std::string path = scratchDir->filePath("alerts.wsr").toStdString();
+    std::remove(path.c_str());
+    {
+        SampleRecording::Recorder recorder;
+        recorder.open(path);
+        for (int i = 0; i < samples; ++i) {
+            SysInfo info = sampleAt(i);
+            info.cpuTemp = scriptedCpuTemp(i);
+            info.memUsage = 40;
+            info.gpuLoad = 10.0;
+            recorder.append(info, startMs + i * 1000LL);
+        }
+        recorder.close();
+    }
+
+    for (auto _ : state) {
+        PlaybackCollector collector(path, 0.0);
+        collector.initialize();
+        AlertEngine alerts;
+        alerts.configure(AlertEngine::defaultRules());
+        SysInfo info;
+        while (!collector.finished()) {
+            collector.collect(info);
+            benchmark::DoNotOptimize(alerts.evaluate(info, collector.timestampMs()));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * samples));
+}
+BENCHMARK(BM_AlertReplay)->Unit(benchmark::kMicrosecond);
+
+// One sample through N rules spread over every metric, half of them firing
+static void BM_AlertEvaluate(benchmark::State& state)
+{
+    AlertRules rules(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < rules.size(); ++i) {
+        rules[i].name = "rule";
+        rules[i].metric = static_cast<Metric>(i % MetricCount);
+        rules[i].below = i % 2;
+        rules[i].threshold = 50.0;
+        rules[i].hysteresis = 5.0;
+        rules[i].forMs = 2000;
+    }
+    AlertEngine alerts;
+    alerts.configure(rules);
+    qint64 timestampMs = 1700000000000LL;
+    int i = 0;
+    for (auto _ : state) {
+        timestampMs += 1000;
+        benchmark::DoNotOptimize(alerts.evaluate(sampleAt(i++), timestampMs));
+    }
+}
+BENCHMARK(BM_AlertEvaluate)->Arg(3)->Arg(100);
+
+// --- Sensor helper protocol (replaces the old TempReader text parsing) ---
+
+static void BM_SensorFrameDecode(benchmark::State& state)
+{
+    using namespace SensorProtocol;
+    Frame frame;
+    frame.add(CpuPackageTemp, 55.5f);
+    frame.add(GpuCoreTemp, 48.0f);
+    frame.add(GpuHotspotTemp, 60.25f);
+    frame.add(CpuPackagePower, 35.0f);
+    frame.add(GpuPower, 80.0f);
+    frame.add(CpuFanSpeed, 1200.0f);
+    frame.add(GpuFanSpeed, 900.0f);
+    unsigned char bytes[MaxFrameSize];
+    const size_t size = encode(frame, bytes);
+
+    FrameParser parser;
+    Frame decoded;
+    for (auto _ : state) {
+        parser.feed(bytes, size);
+        parser.next(decoded);
+        benchmark::DoNotOptimize(decoded);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+}
+BENCHMARK(BM_SensorFrameDecode);
+
+// --- Row formatting ---
+
+// updateStats' formatting before MetricFormatter, kept as the baseline to compare against
+void legacyFormat(const SysInfo& info, QString* rows)
+{
+    rows[MetricFormatter::CpuRow] = QString("CPU: %1%").arg(QString::number(info.cpuLoad, 'f', 1));
+    rows[MetricFormatter::MemRow] = QString("MEM: %1%").arg(QString::number(info.memUsage));
+    rows[MetricFormatter::RamRow] = QString("RAM: %1/%2 MB").arg(QString::number(info.totalRamMB - info.availRamMB)).arg(QString::number(info.totalRamMB));
+    rows[MetricFormatter::DiskRow] = QString("DSK: %1%").arg(QString::number(info.diskLoad, 'f', 1));
+    rows[MetricFormatter::GpuRow] = QString("GPU: %1%").arg(QString::number(info.gpuLoad, 'f', 1));
+
+    // Network metrics with better formatting
+    if (info.networkDownloadSpeed >= 1.0) {
+        rows[MetricFormatter::NetDownRow] = QString("↓: %1 MB/s").arg(QString::number(info.networkDownloadSpeed, 'f', 2));
+    } else if (info.networkDownloadSpeed >= 0.001) {
+        rows[MetricFormatter::NetDownRow] = QString("↓: %1 KB/s").arg(QString::number(info.networkDownloadSpeed * 1024, 'f', 1));
+    } else {
+        rows[MetricFormatter::NetDownRow] = "↓: 0.00 KB/s";
+    }
+
+    if (info.networkUploadSpeed >= 1.0) {
+        rows[MetricFormatter::NetUpRow] = QString("↑: %1 MB/s").arg(QString::number(info.networkUploadSpeed, 'f', 2));
+    } else if (info.networkUploadSpeed >= 0.001) {
+        rows[MetricFormatter::NetUpRow] = QString("↑: %1 KB/s").arg(QString::number(info.networkUploadSpeed * 1024, 'f', 1));
+    } else {
+        rows[MetricFormatter::NetUpRow] = "↑: 0.00 KB/s";
+    }
+
+    // Daily data usage with better formatting
+    if (info.dailyDataUsageMB >= 1024) {
+        rows[MetricFormatter::DailyDataRow] = QString("Daily: %1 GB").arg(QString::number(info.dailyDataUsageMB / 1024.0, 'f', 2));
+    } else {
+        rows[MetricFormatter::DailyDataRow] = QString("Daily: %1 MB").arg(QString::number(info.dailyDataUsageMB, 'f', 0));
+    }
+
+    // Temperature readings
+    if (info.cpuTemp >= 0) {
+        rows[MetricFormatter::CpuTempRow] = QString("CPU°: %1°C").arg(QString::number(info.cpuTemp, 'f', 1));
+    } else {
+        rows[MetricFormatter::CpuTempRow] = "CPU°: N/A";
+    }
+
+    if (info.gpuTemp >= 0) {
+        rows[MetricFormatter::GpuTempRow] = QString("GPU°: %1°C").arg(QString::number(info.gpuTemp, 'f', 1));
+    } else {
+        rows[MetricFormatter::GpuTempRow] = "GPU°: N/A";
+    }
+
+    // Process count
+    rows[MetricFormatter::ProcessesRow] = QString("Proc: %1").arg(QString::number(info.activeProcesses));
+
+    // System uptime with better formatting
+    if (info.systemUptime < 1) {
+        rows[MetricFormatter::UptimeRow] = QString("Up: %1m").arg(QString::number(info.systemUptime * 60, 'f', 0));
+    } else if (info.systemUptime < 24) {
+        rows[MetricFormatter::UptimeRow] = QString("Up: %1h").arg(QString::number(info.systemUptime, 'f', 1));
+    } else {
+        int days = static_cast<int>(info.systemUptime / 24);
+        double remainingHours = info.systemUptime - (days * 24);
+        if (remainingHours < 0.1) {
+            rows[MetricFormatter::UptimeRow] = QString("Up: %1d").arg(QString::number(days));
+        } else {
+            rows[MetricFormatter::UptimeRow] = QString("Up: %1d %2h").arg(QString::number(days)).arg(QString::number(remainingHours, 'f', 0));
+        }
+    }
+
+    // FPS - placeholder for now
+    rows[MetricFormatter::FpsRow] = "FPS: N/A";
+
+    // What the overlay itself costs
+    if (info.selfCpuPercent >= 0) {
+        rows[MetricFormatter::SelfRow] = QString("Self: %1% %2 MB").arg(QString::number(info.selfCpuPercent, 'f', 1))
+                                          .arg(QString::number(info.selfMemoryMB, 'f', 0));
+    } else {
+        rows[MetricFormatter::SelfRow] = "Self: N/A";
+    }
+
+
+}
+
+static void BM_FormatRowsLegacy(benchmark::State& state)
+{
+    const SysInfo samples[2] = { sampleAt(1), sampleAt(2) };
+    QString rows[MetricFormatter::RowCount];
+    int i = 0;
+    const quint64 allocations = allocationCount.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        legacyFormat(samples[i++ & 1], rows);
+        benchmark::DoNotOptimize(rows);
+    }
+    state.counters["allocs"] = allocationsPerIteration(allocations);
+}
+BENCHMARK(BM_FormatRowsLegacy);
+
+// Arg 0: every row changes each tick; arg 1: typical tick, only the load rows change
+static void BM_FormatRows(benchmark::State& state)
+{
+    SysInfo samples[2] = { sampleAt(1), sampleAt(2) };
+    if (state.range(0)) {
+        samples[1] = samples[0];
+        samples[1].cpuLoad += 3.2;
+        samples[1].diskLoad += 1.5;
+    }
+    MetricFormatter formatter;
+    QString rows[MetricFormatter::RowCount];
+    int i = 0;
+    const quint64 allocations = allocationCount.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        // What updateStats does: format everything, make strings only for changed rows
+        const quint32 changed = formatter.format(samples[i++ & 1]);
+        for (int row = 0; row < MetricFormatter::RowCount; ++row) {
+            if (changed & (1u << row)) {
+                rows[row] = formatter.string(row);
+            }
+        }
+        benchmark::DoNotOptimize(rows);
+    }
+    state.counters["allocs"] = allocationsPerIteration(allocations);
+    state.SetLabel(state.range(0) ? "few rows change" : "all rows change");
+}
+BENCHMARK(BM_FormatRows)->Arg(0)->Arg(1);
+
+// --- Overlay ---
+
+static void BM_UpdateStats(benchmark::State& state)
+{
+    useRenderer(state.range(0) ? "Painted" : "Widgets");
+    OverlayWidget& widget = overlay();
+    const SysInfo samples[2] = { sampleAt(1), sampleAt(2) };
+    int i = 0;
+    const quint64 allocations = allocationCount.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        widget.updateStats(samples[i++ & 1]);
+    }
+    state.counters["allocs"] = allocationsPerIteration(allocations);
+    state.SetLabel(state.range(0) ? "painted" : "widgets");
+}
+BENCHMARK(BM_UpdateStats)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_PaintCycle(benchmark::State& state)
+{
+    useRenderer(state.range(0) ? "Painted" : "Widgets");
+    OverlayWidget& widget = overlay();
+    widget.resize(widget.sizeHint());
+    QImage image(widget.size(), QImage::Format_ARGB32_Premultiplied);
+    const SysInfo samples[2] = { sampleAt(1), sampleAt(2) };
+    int i = 0;
+    for (auto _ : state) {
+        // A tick as the user sees it: new values, then a full repaint of the window
+        widget.updateStats(samples[i++ & 1]);
+        image.fill(Qt::transparent);
+        widget.render(&image);
+        benchmark::DoNotOptimize(image.constBits());
+    }
+    state.SetLabel(state.range(0) ? "painted" : "widgets");
+}
+BENCHMARK(BM_PaintCycle)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_LoadSettingsSnapshot(benchmark::State& state)
+{
+    for (auto _ : state) {
+        OverlaySettings settings = OverlaySettings::load();
+        benchmark::DoNotOptimize(settings);
+    }
+}
+BENCHMARK(BM_LoadSettingsSnapshot)->Unit(benchmark::kMicrosecond);
+
+static void BM_ApplyAllSettings(benchmark::State& state)
+{
+    useRenderer("Widgets");
+    OverlayWidget& widget = overlay();
+    for (auto _ : state) {
+        // What the overlay does when every group changed: re-style, re-layout, re-show
+        emit SettingsStore::instance()->changed(SettingsStore::AllGroups);
+    }
+    benchmark::DoNotOptimize(&widget);
+}
+BENCHMARK(BM_ApplyAllSettings)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("WinSysOverlay");
+    QCoreApplication::setApplicationName("WinSys-Bench");
+
+    QTemporaryDir dir;
+    scratchDir = &dir;
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, dir.path());
+    {
+        QSettings s;
+        s.setValue("behavior/updateInterval", 60000);
+        s.setValue("behavior/historyMinutes", 10);
+        s.setValue("appearance/showSparklines", true);
+        for (int i = 0; i < OverlaySettings::DisplayItemCount; ++i) {
+            s.setValue(OverlaySettings::displayKey(i), true);
+        }
+    }
+
+    std::vector<char*> arguments(argv, argv + argc);
+    bool formatGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        formatGiven = formatGiven || std::strncmp(argv[i], "--benchmark_format", 18) == 0;
+    }
+    char jsonFormat[] = "--benchmark_format=json";
+    if (!formatGiven) {
+        arguments.push_back(jsonFormat);
+    }
+    int count = static_cast<int>(arguments.size());
+    benchmark::Initialize(&count, arguments.data());
+    if (benchmark::ReportUnrecognizedArguments(count, arguments.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
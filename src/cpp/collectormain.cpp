@@ -0,0 +1,6 @@
+#include "headlesscollector.h"
+
+int main(int argc, char *argv[])
+{
+    return runHeadlessCollector(argc, argv);
+}
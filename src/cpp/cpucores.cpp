@@ -0,0 +1,133 @@
+#include "cpucores.h"
+#include "procparse.h"
+#include <algorithm>
+
+CpuCoreAggregator::CpuCoreAggregator()
+    : m_cores(0)
+{
+}
+
+void CpuCoreAggregator::reset(int cores)
+{
+    m_cores = qBound(0, cores, MaxCpuCores);
+    for (std::vector<quint64>* counters : { &m_total, &m_busy, &m_lastTotal, &m_lastBusy }) {
+        counters->assign(m_cores, 0);
+    }
+    m_load.assign(m_cores, 0.0f);
+    m_frequency.assign(m_cores, 0.0f);
+}
+
+void CpuCoreAggregator::grow(int cores)
+{
+    cores = qMin(cores, MaxCpuCores);
+    if (cores <= m_cores) {
+        return;
+    }
+    m_cores = cores;
+    for (std::vector<quint64>* counters : { &m_total, &m_busy, &m_lastTotal, &m_lastBusy }) {
+        counters->resize(m_cores, 0);
+    }
+    m_load.resize(m_cores, 0.0f);
+    m_frequency.resize(m_cores, 0.0f);
+}
+
+void CpuCoreAggregator::update()
+{
+    const int n = m_cores;
+    const quint64* total = m_total.data();
+    const quint64* busy = m_busy.data();
+    const quint64* lastTotal = m_lastTotal.data();
+    const quint64* lastBusy = m_lastBusy.data();
+    float* load = m_load.data();
+    for (int i = 0; i < n; ++i) {
+        const quint64 totalDelta = total[i] - lastTotal[i];
+        const quint64 busyDelta = busy[i] - lastBusy[i];
+        // Unprimed cores have no previous total; offline ones have not moved
+        const float scale = (lastTotal[i] != 0 && totalDelta != 0) ? 100.0f / static_cast<float>(totalDelta) : 0.0f;
+        load[i] = static_cast<float>(busyDelta) * scale;
+    }
+    std::copy(m_total.begin(), m_total.end(), m_lastTotal.begin());
+    std::copy(m_busy.begin(), m_busy.end(), m_lastBusy.begin());
+}
+
+void CpuCoreAggregator::summarize(SysInfo& info) const
+{
+    CpuCores& out = info.cpuCores;
+    const int n = m_cores;
+    const float* load = m_load.data();
+    const float* frequency = m_frequency.data();
+    quint8* loadOut = out.load;
+    quint16* frequencyOut = out.frequencyMHz;
+    out.count = n;
+
+    // Clamped as floats so a stray reading cannot wrap around; +0.5 rounds
+    for (int i = 0; i < n; ++i) {
+        loadOut[i] = static_cast<quint8>(std::min(std::max(load[i], 0.0f), 100.0f) + 0.5f);
+        frequencyOut[i] = static_cast<quint16>(std::min(std::max(frequency[i], 0.0f), 65535.0f) + 0.5f);
+    }
+
+    unsigned maxLoad = 0;
+    unsigned frequencySum = 0;
+    unsigned frequencyMax = 0;
+    unsigned frequencyKnown = 0;
+    for (int i = 0; i < n; ++i) {
+        maxLoad = std::max<unsigned>(maxLoad, loadOut[i]);
+        frequencySum += frequencyOut[i];
+        frequencyMax = std::max<unsigned>(frequencyMax, frequencyOut[i]);
+        frequencyKnown += frequencyOut[i] != 0;
+    }
+
+    // Kept sorted, busiest first; on a tie the lower core number stays ahead
+    int busiestLoad[BusiestCoreCount];
+    for (int k = 0; k < BusiestCoreCount; ++k) {
+        busiestLoad[k] = -1;
+        out.busiest[k] = -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        const int value = loadOut[i];
+        if (value <= busiestLoad[BusiestCoreCount - 1]) {
+            continue;
+        }
+        int k = BusiestCoreCount - 1;
+        for (; k > 0 && value > busiestLoad[k - 1]; --k) {
+            busiestLoad[k] = busiestLoad[k - 1];
+            out.busiest[k] = out.busiest[k - 1];
+        }
+        busiestLoad[k] = value;
+        out.busiest[k] = static_cast<qint16>(i);
+    }
+
+    info.cpuCoreMaxLoad = n > 0 ? static_cast<double>(maxLoad) : -1.0;
+    info.cpuFrequencyMHz = frequencyKnown > 0 ? static_cast<double>(frequencySum) / frequencyKnown : -1.0;
+    info.cpuFrequencyMaxMHz = frequencyKnown > 0 ? static_cast<double>(frequencyMax) : -1.0;
+}
+
+int readProcStatCores(std::string_view text, CpuCoreAggregator& cores)
+{
+    // The aggregate "cpu " line comes first, then one "cpuN" line per online CPU; nothing
+    // after the last of them is looked at, in particular not the long "intr" line
+    int lines = 0;
+    for (ProcCursor cursor(text); cursor.consume("cpu"); cursor.nextLine()) {
+        if (cursor.consume(" ")) {
+            continue;
+        }
+        const quint64 cpu = cursor.number();
+        if (cpu >= static_cast<quint64>(MaxCpuCores)) {
+            continue;
+        }
+        const int core = static_cast<int>(cpu);
+        cores.grow(core + 1);
+        // user nice system idle iowait irq softirq steal; guest time is already counted in
+        // user and nice
+        quint64 fields[8];
+        for (quint64& field : fields) {
+            field = cursor.number();
+        }
+        const quint64 total = fields[0] + fields[1] + fields[2] + fields[3] + fields[4] + fields[5] + fields[6] +
+                              fields[7];
+        cores.totalTicks()[core] = total;
+        cores.busyTicks()[core] = total - fields[3] - fields[4];
+        ++lines;
+    }
+    return lines;
+}
@@ -0,0 +1,58 @@
+#ifndef CPUCORES_H
+#define CPUCORES_H
+
+#include <QtGlobal>
+#include <string_view>
+#include <vector>
+#include "sysinfo.h"
+
+// Turns per-logical-CPU counters into SysInfo::cpuCores and the core metrics.
+//
+// State is kept as structure-of-arrays, one contiguous array per counter, so every pass is
+// a plain indexed loop the compiler turns into vector code: the tick deltas, quantizing
+// loads and clocks for SysInfo, and the max and sum reductions. The reductions run on the
+// quantized integers, which unlike float sums and maxima vectorize without -ffast-math.
+// Only the busiest-N selection is scalar, and it turns most cores away with one compare.
+// Not thread-safe; collectors own one each on the sampler thread.
+class CpuCoreAggregator
+{
+public:
+    CpuCoreAggregator();
+
+    // Sets the number of cores, at most MaxCpuCores, and forgets every previous counter
+    void reset(int cores);
+    // Grows to at least cores, keeping what the existing cores have; new ones start unprimed
+    void grow(int cores);
+    int cores() const { return m_cores; }
+
+    // Inputs, one slot per core, filled in by the collector before update()/summarize().
+    // Cumulative busy and total time in any unit, e.g. /proc/stat jiffies.
+    quint64* totalTicks() { return m_total.data(); }
+    quint64* busyTicks() { return m_busy.data(); }
+    // Percent, for sources that report the load itself (PDH); update() overwrites it
+    float* loads() { return m_load.data(); }
+    // Current clock in MHz, 0 where unknown
+    float* frequencies() { return m_frequency.data(); }
+
+    // Turns the tick counters into loads since the previous call. A core seen for the first
+    // time since reset() or grow() reads 0 until its next sample.
+    void update();
+    // Fills info.cpuCores, cpuCoreMaxLoad, cpuFrequencyMHz and cpuFrequencyMaxMHz
+    void summarize(SysInfo& info) const;
+
+private:
+    int m_cores;
+    std::vector<quint64> m_total;
+    std::vector<quint64> m_busy;
+    std::vector<quint64> m_lastTotal;
+    std::vector<quint64> m_lastBusy;
+    std::vector<float> m_load;
+    std::vector<float> m_frequency;
+};
+
+// Reads the "cpuN ..." lines of /proc/stat text into the aggregator's tick arrays, growing
+// it when a higher CPU number shows up (hotplug). CPUs from MaxCpuCores on are ignored.
+// Returns the number of lines read.
+int readProcStatCores(std::string_view text, CpuCoreAggregator& cores);
+
+#endif // CPUCORES_H
@@ -0,0 +1,145 @@
+#include "etwframesource.h"
+#include <cstddef>
+
+namespace {
+
+// Microsoft-Windows-DXGI {CA11C036-0102-4A2D-A6AD-F03CFED5D3C9}
+const GUID DxgiProvider = { 0xca11c036, 0x0102, 0x4a2d, { 0xa6, 0xad, 0xf0, 0x3c, 0xfe, 0xd5, 0xd3, 0xc9 } };
+// Present_Start: one per IDXGISwapChain::Present call
+constexpr USHORT PresentStartEvent = 42;
+
+const wchar_t SessionName[] = L"WinSysOverlayFrames";
+
+// EVENT_TRACE_PROPERTIES is followed by the session name it refers to
+struct SessionProperties {
+    EVENT_TRACE_PROPERTIES properties;
+    wchar_t name[sizeof(SessionName) / sizeof(wchar_t)];
+};
+
+void resetProperties(SessionProperties& session)
+{
+    ZeroMemory(&session, sizeof(session));
+    session.properties.Wnode.BufferSize = sizeof(session);
+    session.properties.Wnode.Flags = WNODE_FLAG_TRACED_GUID;
+    // Event timestamps in raw QPC ticks, the same clock as nowUs()
+    session.properties.Wnode.ClientContext = 1;
+    session.properties.LogFileMode = EVENT_TRACE_REAL_TIME_MODE;
+    // Presents arrive in bursts; small buffers flushed every second keep latency down
+    session.properties.BufferSize = 64;
+    session.properties.MinimumBuffers = 8;
+    session.properties.FlushTimer = 1;
+    session.properties.LoggerNameOffset = offsetof(SessionProperties, name);
+}
+
+} // namespace
+
+EtwFrameSource::EtwFrameSource()
+    : m_session(0)
+    , m_trace(INVALID_PROCESSTRACE_HANDLE)
+    , m_foregroundPid(0)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_ticksPerSecond = frequency.QuadPart;
+}
+
+EtwFrameSource::~EtwFrameSource()
+{
+    stop();
+}
+
+bool EtwFrameSource::start()
+{
+    stop();
+    SessionProperties session;
+    resetProperties(session);
+    ControlTraceW(0, SessionName, &session.properties, EVENT_TRACE_CONTROL_STOP);
+
+    resetProperties(session);
+    if (StartTraceW(&m_session, SessionName, &session.properties) != ERROR_SUCCESS) {
+        m_session = 0;
+        return false;
+    }
+    if (EnableTraceEx2(m_session, &DxgiProvider, EVENT_CONTROL_CODE_ENABLE_PROVIDER, TRACE_LEVEL_INFORMATION,
+                       0, 0, 0, nullptr) != ERROR_SUCCESS) {
+        stop();
+        return false;
+    }
+
+    EVENT_TRACE_LOGFILEW logFile = {};
+    logFile.LoggerName = const_cast<wchar_t*>(SessionName);
+    logFile.ProcessTraceMode = PROCESS_TRACE_MODE_REAL_TIME | PROCESS_TRACE_MODE_EVENT_RECORD |
+                               PROCESS_TRACE_MODE_RAW_TIMESTAMP;
+    logFile.EventRecordCallback = &EtwFrameSource::onEvent;
+    logFile.Context = this;
+    m_trace = OpenTraceW(&logFile);
+    if (m_trace == INVALID_PROCESSTRACE_HANDLE) {
+        stop();
+        return false;
+    }
+    m_consumer = std::thread([this] {
+        ProcessTrace(&m_trace, 1, nullptr, nullptr);
+    });
+    return true;
+}
+
+void EtwFrameSource::stop()
+{
+    // Closing the trace makes ProcessTrace() return once it has delivered what it has
+    if (m_trace != INVALID_PROCESSTRACE_HANDLE) {
+        CloseTrace(m_trace);
+        m_trace = INVALID_PROCESSTRACE_HANDLE;
+    }
+    if (m_session) {
+        SessionProperties session;
+        resetProperties(session);
+        ControlTraceW(m_session, nullptr, &session.properties, EVENT_TRACE_CONTROL_STOP);
+        m_session = 0;
+    }
+    if (m_consumer.joinable()) {
+        m_consumer.join();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.clear();
+}
+
+void WINAPI EtwFrameSource::onEvent(PEVENT_RECORD record)
+{
+    auto* self = static_cast<EtwFrameSource*>(record->UserContext);
+    const EVENT_HEADER& header = record->EventHeader;
+    if (header.EventDescriptor.Id != PresentStartEvent || !IsEqualGUID(header.ProviderId, DxgiProvider) ||
+        header.ProcessId != self->m_foregroundPid.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const qint64 us = self->toUs(header.TimeStamp.QuadPart);
+    std::lock_guard<std::mutex> lock(self->m_mutex);
+    self->m_pending.push_back(us);
+}
+
+void EtwFrameSource::drain(std::vector<qint64>& timestampsUs)
+{
+    // Presents from a window that lost the foreground in the meantime still count this
+    // once; from now on only the new owner's do
+    DWORD pid = 0;
+    if (HWND window = GetForegroundWindow()) {
+        GetWindowThreadProcessId(window, &pid);
+    }
+    m_foregroundPid.store(pid, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    timestampsUs.insert(timestampsUs.end(), m_pending.begin(), m_pending.end());
+    m_pending.clear();
+}
+
+qint64 EtwFrameSource::nowUs() const
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return toUs(now.QuadPart);
+}
+
+qint64 EtwFrameSource::toUs(qint64 ticks) const
+{
+    // Split to avoid overflowing ticks * 1e6 after a few days of uptime
+    return ticks / m_ticksPerSecond * 1000000 + ticks % m_ticksPerSecond * 1000000 / m_ticksPerSecond;
+}
@@ -0,0 +1,46 @@
+#ifndef ETWFRAMESOURCE_H
+#define ETWFRAMESOURCE_H
+
+#include "frameeventsource.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <windows.h>
+#include <evntrace.h>
+#include <evntcons.h>
+
+// Present events from the Microsoft-Windows-DXGI ETW provider, counted for the process that
+// owns the foreground window, which is the game while one is being played.
+//
+// A real-time trace session is started under a fixed name (one left behind by a crashed
+// run is stopped first) and consumed on a thread of its own, since ProcessTrace() blocks
+// until the session closes. Starting a session needs administrator rights or membership in
+// Performance Log Users; without them start() fails and FPS reads N/A.
+class EtwFrameSource : public FrameEventSource
+{
+public:
+    EtwFrameSource();
+    ~EtwFrameSource() override;
+
+    const char* name() const override { return "etw"; }
+    bool start() override;
+    void stop() override;
+    void drain(std::vector<qint64>& timestampsUs) override;
+    qint64 nowUs() const override;
+
+private:
+    static void WINAPI onEvent(PEVENT_RECORD record);
+    qint64 toUs(qint64 ticks) const;
+
+    TRACEHANDLE m_session;
+    TRACEHANDLE m_trace;
+    std::thread m_consumer;
+    qint64 m_ticksPerSecond;
+    // Written by drain() on the sampler thread, read by the consumer
+    std::atomic<DWORD> m_foregroundPid;
+    std::mutex m_mutex;
+    std::vector<qint64> m_pending;
+};
+
+#endif // ETWFRAMESOURCE_H
@@ -0,0 +1,173 @@
+#include "frameeventsource.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+#ifdef Q_OS_WIN
+#include "etwframesource.h"
+#endif
+
+namespace {
+
+// Frames further back than this are skipped rather than replayed, e.g. after the sampler
+// was stopped for a while; the statistics window is shorter anyway
+constexpr qint64 MaxBacklogUs = 10 * 1000 * 1000;
+
+qint64 steadyNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// splitmix64, so a seed gives the same frames on every platform and standard library
+quint64 nextRandom(quint64& state)
+{
+    quint64 z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+std::unique_ptr<FrameEventSource> FrameEventSource::create(const std::string& spec)
+{
+    if (spec.rfind("synthetic", 0) == 0) {
+        double fps = 144.0;
+        if (spec.size() > 10 && spec[9] == ':') {
+            fps = std::strtod(spec.c_str() + 10, nullptr);
+        }
+        return std::make_unique<SyntheticFrameSource>(fps > 0 ? fps : 144.0);
+    }
+    if (spec.rfind("file:", 0) == 0) {
+        return std::make_unique<FileFrameSource>(spec.substr(5));
+    }
+#ifdef Q_OS_WIN
+    if (spec.empty() || spec == "etw") {
+        return std::make_unique<EtwFrameSource>();
+    }
+#endif
+    return nullptr;
+}
+
+// --- Synthetic ---
+
+SyntheticFrameSource::SyntheticFrameSource(double fps, quint64 seed)
+    : m_frameUs(1e6 / fps)
+    , m_state(seed)
+    , m_nextUs(0)
+    , m_frame(0)
+    , m_startUs(0)
+{
+}
+
+bool SyntheticFrameSource::start()
+{
+    m_startUs = steadyNowUs();
+    m_nextUs = 0;
+    return true;
+}
+
+qint64 SyntheticFrameSource::nowUs() const
+{
+    return steadyNowUs() - m_startUs;
+}
+
+void SyntheticFrameSource::drain(std::vector<qint64>& timestampsUs)
+{
+    const qint64 now = nowUs();
+    if (now - m_nextUs > MaxBacklogUs) {
+        m_nextUs = now - MaxBacklogUs;
+    }
+    generate(now, timestampsUs);
+}
+
+void SyntheticFrameSource::generate(qint64 untilUs, std::vector<qint64>& timestampsUs)
+{
+    while (m_nextUs <= untilUs) {
+        timestampsUs.push_back(m_nextUs);
+        // +-5% jitter, and one frame in a hundred takes three times as long
+        const double jitter = (static_cast<double>(nextRandom(m_state) >> 11) / 9007199254740992.0 - 0.5) * 0.1;
+        const double stutter = ++m_frame % 100 == 0 ? 3.0 : 1.0;
+        m_nextUs += qMax<qint64>(1, std::llround(m_frameUs * (1.0 + jitter) * stutter));
+    }
+}
+
+// --- File replay ---
+
+FileFrameSource::FileFrameSource(std::string path)
+    : m_path(std::move(path))
+    , m_loopUs(0)
+    , m_next(0)
+    , m_offsetUs(0)
+    , m_startUs(0)
+{
+}
+
+bool FileFrameSource::load(const std::string& path, std::vector<qint64>& timestampsUs)
+{
+    timestampsUs.clear();
+    std::ifstream in(path);
+    std::string line;
+    double firstMs = 0.0;
+    while (std::getline(in, line)) {
+        const size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        char* end = nullptr;
+        const double ms = std::strtod(line.c_str() + start, &end);
+        if (end == line.c_str() + start) {
+            continue;
+        }
+        if (timestampsUs.empty()) {
+            firstMs = ms;
+        }
+        const qint64 us = std::llround((ms - firstMs) * 1000.0);
+        // Out-of-order lines would make negative frame times; keep the clock monotonic
+        if (timestampsUs.empty() || us > timestampsUs.back()) {
+            timestampsUs.push_back(us);
+        }
+    }
+    return timestampsUs.size() >= 2;
+}
+
+bool FileFrameSource::start()
+{
+    if (m_timestamps.empty() && !load(m_path, m_timestamps)) {
+        m_timestamps.clear();
+        return false;
+    }
+    // The gap before the first frame of the next loop is the file's average frame time
+    const qint64 last = m_timestamps.back();
+    m_loopUs = last + last / static_cast<qint64>(m_timestamps.size() - 1);
+    m_next = 0;
+    m_offsetUs = 0;
+    m_startUs = steadyNowUs();
+    return true;
+}
+
+qint64 FileFrameSource::nowUs() const
+{
+    return steadyNowUs() - m_startUs;
+}
+
+void FileFrameSource::drain(std::vector<qint64>& timestampsUs)
+{
+    if (m_timestamps.empty()) {
+        return;
+    }
+    const qint64 now = nowUs();
+    // Whole loops that fell out of the backlog are skipped
+    while (now - (m_offsetUs + m_loopUs) > MaxBacklogUs) {
+        m_offsetUs += m_loopUs;
+    }
+    while (m_offsetUs + m_timestamps[m_next] <= now) {
+        timestampsUs.push_back(m_offsetUs + m_timestamps[m_next]);
+        if (++m_next == m_timestamps.size()) {
+            m_next = 0;
+            m_offsetUs += m_loopUs;
+        }
+    }
+}
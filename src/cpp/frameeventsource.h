@@ -0,0 +1,88 @@
+#ifndef FRAMEEVENTSOURCE_H
+#define FRAMEEVENTSOURCE_H
+
+#include <QtGlobal>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Where present (frame) timestamps come from, for FrameTimingEngine.
+//
+// Timestamps are microseconds on the source's own clock and never go backwards. A live
+// source reports presents as they happen; the replay sources make them up from a file or
+// a generator, so the FPS path can be exercised on machines with nothing to measure. Like
+// collectors, sources are created, used and destroyed on the sampler thread; one that
+// listens on a thread of its own (ETW) hands events over under a lock, so none is dropped
+// however fast they come.
+class FrameEventSource
+{
+public:
+    virtual ~FrameEventSource() = default;
+
+    virtual const char* name() const = 0;
+    // False if the source cannot deliver anything, e.g. missing file or no permission
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    // Appends the timestamps of the presents since the previous call, oldest first
+    virtual void drain(std::vector<qint64>& timestampsUs) = 0;
+    // Now on the source's clock; the statistics window ends here
+    virtual qint64 nowUs() const = 0;
+
+    // "synthetic[:fps]", "file:<path>", "etw" (Windows only) or "none". Empty picks the
+    // platform default: ETW on Windows, none elsewhere. Returns nullptr for "none" and for
+    // anything it does not recognise.
+    static std::unique_ptr<FrameEventSource> create(const std::string& spec);
+};
+
+// A deterministic stand-in for a game: frames at a nominal rate with a little jitter and a
+// stutter every so often, from a fixed seed. Each call produces the frames that fit up to
+// the current time, so it never falls behind however long the gaps between calls.
+class SyntheticFrameSource : public FrameEventSource
+{
+public:
+    explicit SyntheticFrameSource(double fps, quint64 seed = 1);
+
+    const char* name() const override { return "synthetic"; }
+    bool start() override;
+    void stop() override {}
+    void drain(std::vector<qint64>& timestampsUs) override;
+    qint64 nowUs() const override;
+
+    // The frames that follow, up to and including untilUs, independent of the wall clock
+    void generate(qint64 untilUs, std::vector<qint64>& timestampsUs);
+
+private:
+    double m_frameUs;
+    quint64 m_state;
+    qint64 m_nextUs;
+    qint64 m_frame;
+    qint64 m_startUs;
+};
+
+// Replays present timestamps from a text file, one per line in milliseconds ('#' starts a
+// comment), e.g. the TimeInSeconds column of a PresentMon capture scaled by 1000. The file
+// plays in real time and loops, so the overlay shows it like a running game.
+class FileFrameSource : public FrameEventSource
+{
+public:
+    explicit FileFrameSource(std::string path);
+
+    const char* name() const override { return "file"; }
+    bool start() override;
+    void stop() override {}
+    void drain(std::vector<qint64>& timestampsUs) override;
+    qint64 nowUs() const override;
+
+    // Reads path into timestamps, relative to the first; false if it holds fewer than two
+    static bool load(const std::string& path, std::vector<qint64>& timestampsUs);
+
+private:
+    std::string m_path;
+    std::vector<qint64> m_timestamps;
+    qint64 m_loopUs;
+    size_t m_next;
+    qint64 m_offsetUs;
+    qint64 m_startUs;
+};
+
+#endif // FRAMEEVENTSOURCE_H
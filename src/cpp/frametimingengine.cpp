@@ -0,0 +1,81 @@
+#include "frametimingengine.h"
+
+FrameTimingEngine::FrameTimingEngine()
+    : m_frameTimes(SliceUs, WindowSlices)
+    , m_lastPresentUs(-1)
+    , m_framesSeen(0)
+{
+}
+
+FrameTimingEngine::~FrameTimingEngine()
+{
+    if (m_source) {
+        m_source->stop();
+    }
+}
+
+bool FrameTimingEngine::setSource(std::unique_ptr<FrameEventSource> source)
+{
+    if (m_source) {
+        m_source->stop();
+    }
+    reset();
+    m_source = std::move(source);
+    if (m_source && !m_source->start()) {
+        m_source.reset();
+    }
+    return m_source != nullptr;
+}
+
+void FrameTimingEngine::reset()
+{
+    m_frameTimes.clear();
+    m_lastPresentUs = -1;
+}
+
+void FrameTimingEngine::addPresent(qint64 timestampUs)
+{
+    ++m_framesSeen;
+    if (m_lastPresentUs >= 0 && timestampUs > m_lastPresentUs) {
+        const qint64 frameUs = timestampUs - m_lastPresentUs;
+        if (frameUs <= MaxFrameUs) {
+            m_frameTimes.add(static_cast<uint64_t>(frameUs), timestampUs);
+        }
+    }
+    m_lastPresentUs = qMax(m_lastPresentUs, timestampUs);
+}
+
+FrameTimingEngine::Stats FrameTimingEngine::stats(qint64 nowUs)
+{
+    m_frameTimes.advance(nowUs);
+    Stats stats;
+    const uint64_t recentFrames = m_frameTimes.recentCount(FpsSlices);
+    const uint64_t recentUs = m_frameTimes.recentSum(FpsSlices);
+    if (recentFrames == 0 || recentUs == 0) {
+        // Nothing presented lately: no game in front, or it is paused
+        return stats;
+    }
+    stats.fps = 1e6 * static_cast<double>(recentFrames) / static_cast<double>(recentUs);
+    const QuantileSketch& window = m_frameTimes.window();
+    stats.frameTimeP50Ms = window.quantile(0.50) / 1000.0;
+    stats.frameTimeP99Ms = window.quantile(0.99) / 1000.0;
+    stats.low1PercentFps = stats.frameTimeP99Ms > 0 ? 1000.0 / stats.frameTimeP99Ms : -1.0;
+    return stats;
+}
+
+void FrameTimingEngine::sample(SysInfo& info)
+{
+    Stats stats;
+    if (m_source) {
+        m_buffer.clear();
+        m_source->drain(m_buffer);
+        for (qint64 timestampUs : m_buffer) {
+            addPresent(timestampUs);
+        }
+        stats = this->stats(m_source->nowUs());
+    }
+    info.fps = stats.fps;
+    info.fpsLow1Percent = stats.low1PercentFps;
+    info.frameTimeP50Ms = stats.frameTimeP50Ms;
+    info.frameTimeP99Ms = stats.frameTimeP99Ms;
+}
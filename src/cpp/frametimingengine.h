@@ -0,0 +1,60 @@
+#ifndef FRAMETIMINGENGINE_H
+#define FRAMETIMINGENGINE_H
+
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+#include "frameeventsource.h"
+#include "quantilesketch.h"
+#include "sysinfo.h"
+
+// Frame rate statistics from a stream of present timestamps.
+//
+// Frame times (the gaps between presents) go into a sliding quantile sketch of
+// WindowSlices slices of SliceUs each. FPS is frames over frame time in the newest second;
+// the 1% low is 1000 / the 99th percentile frame time, and the percentiles span the whole
+// window, so one hitch stays visible for a few seconds. Memory is fixed whatever the rate.
+// Nothing here reads a clock: the same timestamps always give the same statistics.
+class FrameTimingEngine
+{
+public:
+    static constexpr qint64 SliceUs = 250 * 1000;
+    static constexpr int WindowSlices = 20;    // 5 s for the percentiles
+    static constexpr int FpsSlices = 4;        // 1 s for FPS
+    // A gap this long is a pause (menu, alt-tab), not a frame
+    static constexpr qint64 MaxFrameUs = 1000 * 1000;
+
+    struct Stats {
+        double fps = -1.0;
+        double low1PercentFps = -1.0;
+        double frameTimeP50Ms = -1.0;
+        double frameTimeP99Ms = -1.0;
+    };
+
+    FrameTimingEngine();
+    ~FrameTimingEngine();
+
+    // Takes over source and starts it; nullptr (or a source that fails to start) leaves
+    // the statistics N/A
+    bool setSource(std::unique_ptr<FrameEventSource> source);
+    FrameEventSource* source() const { return m_source.get(); }
+
+    // Drains the source and writes its statistics into info
+    void sample(SysInfo& info);
+
+    // The pure part, for replays: feed presents in order, then read up to a time
+    void addPresent(qint64 timestampUs);
+    Stats stats(qint64 nowUs);
+    void reset();
+
+    quint64 framesSeen() const { return m_framesSeen; }
+
+private:
+    std::unique_ptr<FrameEventSource> m_source;
+    std::vector<qint64> m_buffer;
+    SlidingQuantileSketch m_frameTimes;
+    qint64 m_lastPresentUs;
+    quint64 m_framesSeen;
+};
+
+#endif // FRAMETIMINGENGINE_H
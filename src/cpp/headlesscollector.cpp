@@ -0,0 +1,255 @@
+#include "headlesscollector.h"
+#include "sysinfomonitor.h"
+#include "samplersettings.h"
+#include "processusage.h"
+#include "instrumentation.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QMetaObject>
+#include <QTimer>
+#include <QDebug>
+#include <csignal>
+
+namespace {
+
+std::atomic<bool> interrupted(false);
+
+void onInterrupt(int)
+{
+    interrupted.store(true, std::memory_order_relaxed);
+}
+
+} // namespace
+
+bool HeadlessCollector::parseArguments(const QStringList& arguments, Options& options, QString& error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Writes system metrics as CSV or JSON lines without a display.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "headless", "Accepted for compatibility with winsys-overlay." },
+        { "format", "Output format: csv or jsonl (default csv).", "format", "csv" },
+        { { "o", "output" }, "Write to file instead of stdout.", "file" },
+        { "interval", "Sampling interval in milliseconds (default: the overlay's setting).", "ms" },
+        { "duration", "Stop after this many seconds (default: run until interrupted).", "seconds" },
+        { "history", "Minutes of in-memory history to keep (default 0).", "minutes" },
+        { "metrics-port", "Also serve OpenMetrics on http://127.0.0.1:<port>/metrics.", "port" },
+        { "record", "Also append every sample to a recording.", "file" },
+        { "playback", "Replay a recording instead of sampling the system.", "file" },
+        { "speed", "Playback speed, 1 for real time, 0 for as fast as possible (default 0).", "factor" },
+    });
+    if (!parser.parse(arguments)) {
+        error = parser.errorText();
+        return false;
+    }
+    if (parser.isSet("help")) {
+        error = parser.helpText();
+        return false;
+    }
+
+    const QString format = parser.value("format");
+    if (format == "csv") {
+        options.format = Format::Csv;
+    } else if (format == "jsonl" || format == "json") {
+        options.format = Format::JsonLines;
+    } else {
+        error = QString("Unknown format: %1").arg(format);
+        return false;
+    }
+    options.outputPath = parser.value("output");
+    options.recordPath = parser.value("record");
+    options.playbackPath = parser.value("playback");
+    if (parser.isSet("speed")) {
+        bool ok = false;
+        options.playbackSpeed = parser.value("speed").toDouble(&ok);
+        if (!ok || options.playbackSpeed < 0.0) {
+            error = QString("Invalid --speed: %1").arg(parser.value("speed"));
+            return false;
+        }
+    }
+
+    auto number = [&](const char* name, int minimum, int& target) {
+        if (!parser.isSet(name)) {
+            return true;
+        }
+        bool ok = false;
+        const int value = parser.value(name).toInt(&ok);
+        if (!ok || value < minimum) {
+            error = QString("Invalid --%1: %2").arg(name, parser.value(name));
+            return false;
+        }
+        target = value;
+        return true;
+    };
+    return number("interval", 10, options.intervalMs) && number("duration", 1, options.durationSeconds) &&
+           number("history", 0, options.historyMinutes) && number("metrics-port", 1, options.metricsPort);
+}
+
+HeadlessCollector::HeadlessCollector(const Options& options, const QElapsedTimer& clock, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_clock(clock)
+    , m_monitor(nullptr)
+    , m_output(nullptr)
+    , m_samples(0)
+    , m_finished(false)
+{
+}
+
+HeadlessCollector::~HeadlessCollector()
+{
+    // Joins the sampler thread, so no observer call can race with closing the file
+    delete m_monitor;
+    if (m_output && m_output != stdout) {
+        std::fclose(m_output);
+    }
+}
+
+bool HeadlessCollector::start()
+{
+    if (m_options.outputPath.isEmpty()) {
+        m_output = stdout;
+    } else {
+        m_output = std::fopen(QFile::encodeName(m_options.outputPath).constData(), "w");
+        if (!m_output) {
+            qWarning() << "Cannot open" << m_options.outputPath << "for writing";
+            return false;
+        }
+    }
+    writeHeader();
+
+    // Sensor helper settings are shared with the overlay; the rest comes from the command line
+    SamplerSettings settings = SamplerSettings::load();
+    if (m_options.intervalMs > 0) {
+        settings.updateInterval = m_options.intervalMs;
+    }
+    settings.historyMinutes = m_options.historyMinutes;
+    settings.trackDailyData = false;
+    if (m_options.metricsPort > 0) {
+        settings.exporterEnabled = true;
+        settings.exporterPort = m_options.metricsPort;
+    }
+    // Only what the command line asks for; the overlay's own recording is left alone
+    settings.recordingPath = m_options.recordPath;
+    settings.playbackPath = m_options.playbackPath;
+    settings.playbackSpeed = m_options.playbackSpeed;
+
+    m_monitor = new SysInfoMonitor(settings);
+    m_monitor->addSampleObserver([this](const SysInfo& info, qint64 timestampMs) {
+        writeSample(info, timestampMs);
+    });
+    connect(m_monitor, &SysInfoMonitor::playbackFinished, this, &HeadlessCollector::finish);
+
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+    if (m_options.durationSeconds > 0) {
+        QTimer::singleShot(m_options.durationSeconds * 1000, this, &HeadlessCollector::finish);
+    }
+    m_monitor->start();
+    return true;
+}
+
+void HeadlessCollector::writeHeader()
+{
+    if (m_options.format != Format::Csv) {
+        return;
+    }
+    std::fputs("timestamp_ms", m_output);
+    for (int m = 0; m < MetricCount; ++m) {
+        std::fputc(',', m_output);
+        std::fputs(metricName(static_cast<Metric>(m)), m_output);
+    }
+    std::fputc('\n', m_output);
+    std::fflush(m_output);
+}
+
+void HeadlessCollector::writeSample(const SysInfo& info, qint64 timestampMs)
+{
+    // Called on the sampler thread. One fixed buffer per line and one write, no allocation.
+    char line[2048];
+    size_t length = 0;
+    auto append = [&](int written) {
+        if (written > 0) {
+            length = qMin(length + static_cast<size_t>(written), sizeof(line) - 1);
+        }
+    };
+
+    const bool json = m_options.format == Format::JsonLines;
+    append(std::snprintf(line, sizeof(line), json ? "{\"timestamp_ms\":%lld" : "%lld",
+                         static_cast<long long>(timestampMs)));
+    for (int m = 0; m < MetricCount; ++m) {
+        const Metric metric = static_cast<Metric>(m);
+        if (json) {
+            append(std::snprintf(line + length, sizeof(line) - length, ",\"%s\":", metricName(metric)));
+        } else {
+            append(std::snprintf(line + length, sizeof(line) - length, ","));
+        }
+        append(formatMetricValue(line + length, sizeof(line) - length, metricValue(info, metric)));
+    }
+    append(std::snprintf(line + length, sizeof(line) - length, json ? "}\n" : "\n"));
+    std::fwrite(line, 1, length, m_output);
+    std::fflush(m_output);
+
+    if (m_samples.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::fprintf(stderr, "winsys-collector: first sample after %lld ms, resident %lld kB\n",
+                     static_cast<long long>(m_clock.elapsed()),
+                     static_cast<long long>(ProcessUsage::memory().residentKb));
+    }
+    // The signal handler can only set a flag; it is noticed with the next sample
+    if (interrupted.load(std::memory_order_relaxed)) {
+        QMetaObject::invokeMethod(this, &HeadlessCollector::finish, Qt::QueuedConnection);
+    }
+}
+
+void HeadlessCollector::finish()
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_monitor->stop();
+    const ProcessUsage::Memory memory = ProcessUsage::memory();
+    std::fprintf(stderr, "winsys-collector: %llu samples in %lld ms, resident %lld kB (peak %lld kB), cpu %lld ms\n",
+                 static_cast<unsigned long long>(m_samples.load(std::memory_order_relaxed)),
+                 static_cast<long long>(m_clock.elapsed()),
+                 static_cast<long long>(memory.residentKb),
+                 static_cast<long long>(memory.peakResidentKb),
+                 static_cast<long long>(ProcessUsage::cpuTimeMs()));
+#if WINSYS_INSTRUMENTATION
+    for (int s = 0; s < Instrumentation::StageCount; ++s) {
+        const auto stage = static_cast<Instrumentation::Stage>(s);
+        const Instrumentation::LatencyHistogram& latencies = Instrumentation::histogram(stage);
+        if (latencies.count() == 0) {
+            continue;
+        }
+        std::fprintf(stderr, "winsys-collector: %-12s p50 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+                     Instrumentation::stageName(stage), latencies.quantileNs(0.5) / 1e3,
+                     latencies.quantileNs(0.99) / 1e3, latencies.maxNs() / 1e3);
+    }
+#endif
+    QCoreApplication::quit();
+}
+
+int runHeadlessCollector(int argc, char *argv[])
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("WinSysOverlay");
+    QCoreApplication::setApplicationName("WinSys-Overlay");
+
+    HeadlessCollector::Options options;
+    QString error;
+    if (!HeadlessCollector::parseArguments(QCoreApplication::arguments(), options, error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return error.startsWith("Usage:") ? 0 : 1;
+    }
+
+    HeadlessCollector collector(options, clock);
+    if (!collector.start()) {
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,71 @@
+#ifndef HEADLESSCOLLECTOR_H
+#define HEADLESSCOLLECTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdio>
+#include "sysinfo.h"
+
+class SysInfoMonitor;
+
+// Runs the sampler without any UI and writes every sample as one line of CSV or JSON, for
+// servers and CI machines with no display. No Qt Gui or Widgets; winsys-collector links
+// neither, and the overlay hands over to it when started with --headless.
+//
+// Lines are formatted and written on the sampler thread straight from the sample, so a
+// slow consumer never makes the collector skip samples the way the overlay coalesces them.
+class HeadlessCollector : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Format { Csv, JsonLines };
+
+    struct Options {
+        Format format = Format::Csv;
+        // Empty writes to stdout
+        QString outputPath;
+        // 0 keeps the configured behavior/updateInterval
+        int intervalMs = 0;
+        // 0 runs until interrupted
+        int durationSeconds = 0;
+        // History is only needed by consumers of SysInfoMonitor::history(), so it stays
+        // minimal unless asked for
+        int historyMinutes = 0;
+        // Serves OpenMetrics on this localhost port; 0 follows exporter/enabled
+        int metricsPort = 0;
+        // Also append every sample to this recording
+        QString recordPath;
+        // Replay this recording instead of sampling; speed 0 replays as fast as possible
+        QString playbackPath;
+        double playbackSpeed = 0.0;
+    };
+
+    // Returns false and sets error on invalid arguments. arguments includes the program name.
+    static bool parseArguments(const QStringList& arguments, Options& options, QString& error);
+
+    // clock started at process entry, for the time-to-first-sample report
+    HeadlessCollector(const Options& options, const QElapsedTimer& clock, QObject *parent = nullptr);
+    ~HeadlessCollector();
+
+    bool start();
+
+private:
+    void writeHeader();
+    void writeSample(const SysInfo& info, qint64 timestampMs);
+    void finish();
+
+    Options m_options;
+    QElapsedTimer m_clock;
+    SysInfoMonitor* m_monitor;
+    FILE* m_output;
+    std::atomic<quint64> m_samples;
+    bool m_finished;
+};
+
+// Entry point shared by winsys-collector and "winsys-overlay --headless"
+int runHeadlessCollector(int argc, char *argv[]);
+
+#endif // HEADLESSCOLLECTOR_H
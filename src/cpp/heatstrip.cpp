@@ -0,0 +1,113 @@
+#include "heatstrip.h"
+#include <QColor>
+#include <QPainter>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int MaxColumns = 64;
+// Cells are as wide as fits this many pixels, within the bounds below
+const int TargetWidth = 96;
+const int MinCellWidth = 2;
+const int MaxCellWidth = 6;
+
+} // namespace
+
+HeatStrip::HeatStrip(int height)
+    : m_height(height)
+    , m_columns(0)
+    , m_cellWidth(0)
+    , m_cellHeight(0)
+{
+    // Hue from green (120°) to red (0°), more opaque as the load rises
+    for (int load = 0; load <= 100; ++load) {
+        const double t = load / 100.0;
+        const QColor color = QColor::fromHsvF((1.0 - t) / 3.0, 0.85, 0.55 + 0.45 * t, 0.45 + 0.55 * t);
+        m_palette[load] = qPremultiply(color.rgba());
+    }
+}
+
+void HeatStrip::relayout(int count)
+{
+    if (count == 0) {
+        m_image = QImage();
+        m_columns = m_cellWidth = m_cellHeight = 0;
+        return;
+    }
+    m_columns = std::min(count, MaxColumns);
+    const int lines = (count + m_columns - 1) / m_columns;
+    m_cellWidth = std::clamp(TargetWidth / m_columns, MinCellWidth, MaxCellWidth);
+    m_cellHeight = std::max(1, m_height / lines);
+    m_image = QImage(m_columns * m_cellWidth, lines * m_cellHeight, QImage::Format_ARGB32_Premultiplied);
+}
+
+bool HeatStrip::setLoads(const quint8* loads, int count)
+{
+    if (count == static_cast<int>(m_loads.size()) && (count == 0 || std::memcmp(loads, m_loads.data(), count) == 0)) {
+        return false;
+    }
+    if (count != static_cast<int>(m_loads.size())) {
+        relayout(count);
+    }
+    m_loads.assign(loads, loads + count);
+    if (count == 0) {
+        return true;
+    }
+
+    // Wide cells get a transparent last column so neighbours stay apart
+    const bool gap = m_cellWidth >= 4;
+    const int lines = m_image.height() / m_cellHeight;
+    const size_t lineBytes = static_cast<size_t>(m_image.width()) * sizeof(QRgb);
+    for (int line = 0; line < lines; ++line) {
+        const int top = line * m_cellHeight;
+        QRgb* pixels = reinterpret_cast<QRgb*>(m_image.scanLine(top));
+        for (int column = 0; column < m_columns; ++column) {
+            const int core = line * m_columns + column;
+            const QRgb color = core < count ? m_palette[std::min<int>(loads[core], 100)] : 0;
+            QRgb* cell = pixels + column * m_cellWidth;
+            for (int x = 0; x < m_cellWidth; ++x) {
+                cell[x] = color;
+            }
+            if (gap) {
+                cell[m_cellWidth - 1] = 0;
+            }
+        }
+        for (int y = 1; y < m_cellHeight; ++y) {
+            std::memcpy(m_image.scanLine(top + y), pixels, lineBytes);
+        }
+    }
+    return true;
+}
+
+void HeatStrip::paint(QPainter& painter, const QPoint& topLeft) const
+{
+    if (!m_image.isNull()) {
+        painter.drawImage(topLeft, m_image);
+    }
+}
+
+HeatStripWidget::HeatStripWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setFixedSize(m_strip.size());
+    setAttribute(Qt::WA_TranslucentBackground);
+}
+
+void HeatStripWidget::setLoads(const quint8* loads, int count)
+{
+    if (!m_strip.setLoads(loads, count)) {
+        return;
+    }
+    if (size() != m_strip.size()) {
+        setFixedSize(m_strip.size());
+    }
+    update();
+}
+
+void HeatStripWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    m_strip.paint(painter, QPoint(0, (height() - m_strip.size().height()) / 2));
+}
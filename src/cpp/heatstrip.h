@@ -0,0 +1,56 @@
+#ifndef HEATSTRIP_H
+#define HEATSTRIP_H
+
+#include <QImage>
+#include <QSize>
+#include <QWidget>
+#include <vector>
+
+class QPainter;
+
+// Compact per-core load strip: one cell per logical CPU, coloured from a dim green at idle
+// through yellow to red at full load.
+//
+// Up to 64 cells sit side by side; more cores wrap into further lines of the same total
+// height, so 256 cores make four lines of 64. A new set of loads is drawn in one pass
+// straight into the image's scanlines: each line of cells is written once from a 101-entry
+// colour table and copied down to the cell height, with no QPainter calls at all.
+class HeatStrip
+{
+public:
+    explicit HeatStrip(int height = 14);
+
+    QSize size() const { return m_image.size(); }
+
+    // Loads in percent, one per core; false when they are what is shown already
+    bool setLoads(const quint8* loads, int count);
+    void paint(QPainter& painter, const QPoint& topLeft) const;
+
+private:
+    void relayout(int count);
+
+    int m_height;
+    QImage m_image;
+    std::vector<quint8> m_loads;
+    int m_columns;
+    int m_cellWidth;
+    int m_cellHeight;
+    QRgb m_palette[101];
+};
+
+class HeatStripWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit HeatStripWidget(QWidget *parent = nullptr);
+
+    void setLoads(const quint8* loads, int count);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    HeatStrip m_strip;
+};
+
+#endif // HEATSTRIP_H
@@ -0,0 +1,121 @@
+#include "helpersupervisor.h"
+#include "sensorhelperclient.h"
+#include <QDebug>
+
+HelperSupervisor::HelperSupervisor(SensorHelperClient* client, QObject *parent)
+    : QObject(parent)
+    , m_client(client)
+    , m_health(HelperHealth::Disabled)
+    , m_restartTimer(new QTimer(this))
+    , m_watchdog(new QTimer(this))
+    , m_backoffMs(0)
+    , m_restartCount(0)
+    , m_lastStartupMs(-1)
+    , m_lastStartupCpuMs(-1)
+{
+    m_restartTimer->setSingleShot(true);
+    connect(m_restartTimer, &QTimer::timeout, this, &HelperSupervisor::launch);
+    connect(m_watchdog, &QTimer::timeout, this, &HelperSupervisor::checkHung);
+    connect(m_client, &SensorHelperClient::firstFrameReceived, this, &HelperSupervisor::onFirstFrame);
+    connect(m_client, &SensorHelperClient::helperFinished, this, &HelperSupervisor::onHelperFinished);
+    m_budgetClock.start();
+}
+
+void HelperSupervisor::start()
+{
+    m_restartTimes.clear();
+    m_backoffMs = m_policy.initialBackoffMs;
+    m_restartTimer->stop();
+    launch();
+}
+
+void HelperSupervisor::stop()
+{
+    m_restartTimer->stop();
+    m_watchdog->stop();
+    m_client->stop();
+    setHealth(HelperHealth::Disabled);
+}
+
+void HelperSupervisor::launch()
+{
+    m_runClock.start();
+    if (!m_client->start()) {
+        // Missing executable: retrying will not help until the settings change
+        setHealth(HelperHealth::Failed);
+        return;
+    }
+    setHealth(HelperHealth::Starting);
+    m_watchdog->start(qMax(250, m_policy.hangTimeoutMs / 4));
+}
+
+void HelperSupervisor::onFirstFrame()
+{
+    m_lastStartupMs = m_client->startupMs();
+    m_lastStartupCpuMs = m_client->cpuTimeMs();
+    qDebug() << "Sensor helper ready after" << m_lastStartupMs << "ms," << m_lastStartupCpuMs << "ms CPU";
+    setHealth(HelperHealth::Running);
+}
+
+void HelperSupervisor::onHelperFinished()
+{
+    m_watchdog->stop();
+    if (m_health == HelperHealth::Disabled) {
+        return;
+    }
+    scheduleRestart();
+}
+
+void HelperSupervisor::checkHung()
+{
+    const int timeout = m_health == HelperHealth::Starting ? m_policy.startupTimeoutMs : m_policy.hangTimeoutMs;
+    if (m_client->isRunning() && m_client->silenceMs() > timeout) {
+        qWarning() << "Sensor helper silent for" << m_client->silenceMs() << "ms, killing it";
+        // helperFinished() follows and schedules the restart
+        m_client->kill();
+    }
+}
+
+void HelperSupervisor::scheduleRestart()
+{
+    const qint64 now = m_budgetClock.elapsed();
+    while (!m_restartTimes.isEmpty() && now - m_restartTimes.first() > m_policy.budgetWindowMs) {
+        m_restartTimes.removeFirst();
+    }
+    if (m_restartTimes.size() >= m_policy.restartBudget) {
+        qWarning() << "Sensor helper restarted" << m_restartTimes.size() << "times within"
+                   << m_policy.budgetWindowMs / 1000 << "s, giving up";
+        setHealth(HelperHealth::Failed);
+        return;
+    }
+    m_restartTimes.append(now);
+    ++m_restartCount;
+
+    int delay;
+    if (m_runClock.elapsed() >= m_policy.stableRunMs) {
+        // Warm restart: the helper was healthy, so this is likely a one-off
+        m_backoffMs = m_policy.initialBackoffMs;
+        delay = 0;
+    } else {
+        delay = m_backoffMs;
+        m_backoffMs = qMin(m_backoffMs * 2, m_policy.maxBackoffMs);
+    }
+    setHealth(HelperHealth::Restarting);
+    m_restartTimer->start(delay);
+}
+
+void HelperSupervisor::setHealth(HelperHealth health)
+{
+    if (health == m_health) {
+        return;
+    }
+    m_health = health;
+    emit healthChanged(health);
+}
+
+void HelperSupervisor::report(SysInfo& info) const
+{
+    info.helperHealth = static_cast<int>(m_health);
+    info.helperRestarts = m_restartCount;
+    info.helperStartupMs = static_cast<double>(m_lastStartupMs);
+}
@@ -0,0 +1,86 @@
+#ifndef HELPERSUPERVISOR_H
+#define HELPERSUPERVISOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+#include "sysinfo.h"
+
+class SensorHelperClient;
+
+// Owns the lifecycle of the sensor helper process: starts it, notices when it crashes or
+// hangs, and restarts it with exponential backoff until a restart budget is used up.
+//
+// A helper that had been running stably for a while is restarted at once (a warm restart)
+// and the backoff starts over. A helper that keeps dying during startup waits 1 s, 2 s,
+// 4 s and so on before each attempt, up to a cap. Every attempt re-runs the helper's full
+// hardware enumeration, so when the budget is spent the supervisor gives up and reports
+// Failed until it is started again.
+//
+// Lives on the sampler thread next to the client it supervises.
+class HelperSupervisor : public QObject
+{
+    Q_OBJECT
+public:
+    struct Policy {
+        int initialBackoffMs = 1000;
+        int maxBackoffMs = 60000;
+        // At most this many restarts within budgetWindowMs
+        int restartBudget = 5;
+        int budgetWindowMs = 10 * 60 * 1000;
+        // A run this long counts as stable and earns an immediate restart
+        int stableRunMs = 60000;
+        // No frame or heartbeat for this long counts as hung. Startup gets longer because
+        // LibreHardwareMonitor's first enumeration can take several seconds.
+        int hangTimeoutMs = 5000;
+        int startupTimeoutMs = 30000;
+    };
+
+    explicit HelperSupervisor(SensorHelperClient* client, QObject *parent = nullptr);
+
+    void setPolicy(const Policy& policy) { m_policy = policy; }
+    const Policy& policy() const { return m_policy; }
+
+    // Resets the backoff and the budget, then launches the helper
+    void start();
+    void stop();
+
+    HelperHealth health() const { return m_health; }
+    int restartCount() const { return m_restartCount; }
+    // Cost of the most recent (re)start: wall time and helper CPU time until its first frame
+    qint64 lastStartupMs() const { return m_lastStartupMs; }
+    qint64 lastStartupCpuMs() const { return m_lastStartupCpuMs; }
+
+    // Copies the health fields into a sample
+    void report(SysInfo& info) const;
+
+signals:
+    void healthChanged(HelperHealth health);
+
+private slots:
+    void launch();
+    void onFirstFrame();
+    void onHelperFinished();
+    void checkHung();
+
+private:
+    void setHealth(HelperHealth health);
+    void scheduleRestart();
+
+    SensorHelperClient* m_client;
+    Policy m_policy;
+    HelperHealth m_health;
+    QTimer* m_restartTimer;
+    QTimer* m_watchdog;
+    QElapsedTimer m_runClock;
+    QElapsedTimer m_budgetClock;
+    // Times of recent restarts on m_budgetClock, oldest first
+    QVector<qint64> m_restartTimes;
+    int m_backoffMs;
+    int m_restartCount;
+    qint64 m_lastStartupMs;
+    qint64 m_lastStartupCpuMs;
+};
+
+#endif // HELPERSUPERVISOR_H
@@ -0,0 +1,63 @@
+#include "instanceregistry.h"
+#include <algorithm>
+
+InstanceRegistry::InstanceRegistry(int refreshIntervalMs)
+    : m_nextId(1)
+    , m_refreshInterval(refreshIntervalMs)
+    , m_refreshed(false)
+{
+}
+
+bool InstanceRegistry::refreshDue() const
+{
+    return !m_refreshed || std::chrono::steady_clock::now() - m_lastRefresh >= m_refreshInterval;
+}
+
+InstanceRegistry::Diff InstanceRegistry::update(std::vector<std::string> names)
+{
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    // Both lists are sorted, so one merge pass finds what stayed, came and went
+    Diff diff;
+    std::vector<Instance> current;
+    current.reserve(names.size());
+    auto known = m_instances.begin();
+    for (std::string& name : names) {
+        while (known != m_instances.end() && known->name < name) {
+            diff.removed.push_back(std::move(*known));
+            ++known;
+        }
+        if (known != m_instances.end() && known->name == name) {
+            current.push_back(std::move(*known));
+            ++known;
+        } else {
+            current.push_back(Instance{ m_nextId++, std::move(name) });
+            diff.added.push_back(current.back());
+        }
+    }
+    for (; known != m_instances.end(); ++known) {
+        diff.removed.push_back(std::move(*known));
+    }
+    m_instances = std::move(current);
+
+    m_lastRefresh = std::chrono::steady_clock::now();
+    m_refreshed = true;
+    return diff;
+}
+
+void InstanceRegistry::clear()
+{
+    m_instances.clear();
+    m_refreshed = false;
+}
+
+int InstanceRegistry::indexOf(std::string_view name) const
+{
+    auto it = std::lower_bound(m_instances.begin(), m_instances.end(), name,
+                               [](const Instance& instance, std::string_view key) { return instance.name < key; });
+    if (it == m_instances.end() || it->name != name) {
+        return -1;
+    }
+    return static_cast<int>(it - m_instances.begin());
+}
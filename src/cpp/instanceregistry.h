@@ -0,0 +1,59 @@
+#ifndef INSTANCEREGISTRY_H
+#define INSTANCEREGISTRY_H
+
+#include <QtGlobal>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The current set of a counter's instances: GPU engines, network interfaces, DRM cards.
+//
+// Collectors re-enumerate on a slow cadence (refreshDue()) and hand the names they found
+// to update(), which diffs them against the known set. An instance keeps its ID for as
+// long as it is present, so per-instance state such as an open counter or the previous
+// byte count survives refreshes; only added and removed instances need work. A name that
+// disappears and comes back is a new instance with a new ID.
+class InstanceRegistry
+{
+public:
+    using Id = quint32;
+
+    struct Instance {
+        Id id;
+        std::string name;
+    };
+
+    struct Diff {
+        std::vector<Instance> added;
+        std::vector<Instance> removed;
+        bool empty() const { return added.empty() && removed.empty(); }
+    };
+
+    static constexpr int DefaultRefreshIntervalMs = 5000;
+
+    explicit InstanceRegistry(int refreshIntervalMs = DefaultRefreshIntervalMs);
+
+    // True before the first update() and once the refresh interval has passed since the last
+    bool refreshDue() const;
+    // Replaces the known set with names (any order, duplicates allowed) and returns the
+    // instances that were added and removed
+    Diff update(std::vector<std::string> names);
+    // Forgets every instance, e.g. when the collector closes the group; the next refresh is due at once
+    void clear();
+
+    // Sorted by name; indices change on update(), IDs do not
+    const std::vector<Instance>& instances() const { return m_instances; }
+    int size() const { return static_cast<int>(m_instances.size()); }
+    // Index of the instance called name, or -1. A binary search, so cheap enough per sample.
+    int indexOf(std::string_view name) const;
+
+private:
+    std::vector<Instance> m_instances;
+    Id m_nextId;
+    std::chrono::milliseconds m_refreshInterval;
+    std::chrono::steady_clock::time_point m_lastRefresh;
+    bool m_refreshed;
+};
+
+#endif // INSTANCEREGISTRY_H
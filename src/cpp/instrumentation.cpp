@@ -0,0 +1,113 @@
+#include "instrumentation.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Instrumentation {
+
+namespace {
+
+LatencyHistogram histograms[StageCount];
+
+int highestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+} // namespace
+
+const char* stageName(Stage stage)
+{
+    switch (stage) {
+    case Stage::Tick: return "tick";
+    case Stage::Collect: return "collect";
+    case Stage::SensorIpc: return "sensor_ipc";
+    case Stage::Publish: return "publish";
+    case Stage::UpdateStats: return "update_stats";
+    case Stage::Layout: return "layout";
+    case Stage::Paint: return "paint";
+    case Stage::Count: break;
+    }
+    return "";
+}
+
+LatencyHistogram& histogram(Stage stage)
+{
+    return histograms[static_cast<int>(stage)];
+}
+
+int LatencyHistogram::bucketIndex(uint64_t ns)
+{
+    // The first two powers of two are exact; above that, the top SubBucketBits bits below
+    // the leading one pick the sub-bucket
+    if (ns < 2 * SubBuckets) {
+        return static_cast<int>(ns);
+    }
+    const uint64_t largest = (uint64_t(1) << (MaxExponent + 1)) - 1;
+    if (ns > largest) {
+        ns = largest;
+    }
+    const int shift = highestBit(ns) - SubBucketBits;
+    const int mantissa = static_cast<int>(ns >> shift);
+    return (shift + 1) * SubBuckets + (mantissa - SubBuckets);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < 2 * SubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = index / SubBuckets - 1;
+    const uint64_t mantissa = static_cast<uint64_t>(index % SubBuckets + SubBuckets);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    m_buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::quantileNs(double q) const
+{
+    const uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    // Rank of the requested value, 1-based, so q = 0 is the minimum and q = 1 the maximum
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    rank = rank < 1 ? 1 : (rank > total ? total : rank);
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            const uint64_t bound = bucketUpperBound(i);
+            const uint64_t max = maxNs();
+            return bound < max ? bound : max;
+        }
+    }
+    return maxNs();
+}
+
+} // namespace Instrumentation
@@ -0,0 +1,104 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifndef WINSYS_INSTRUMENTATION
+#define WINSYS_INSTRUMENTATION 0
+#endif
+
+// What the overlay itself costs, stage by stage (CMake option WINSYS_INSTRUMENTATION).
+//
+// WINSYS_TRACE_SCOPE(Stage) times the rest of the enclosing scope into that stage's
+// latency histogram. Without WINSYS_INSTRUMENTATION the macro expands to nothing and no
+// histogram is ever touched, so such a build pays nothing for the timers.
+namespace Instrumentation {
+
+enum class Stage : int {
+    Tick,        // one whole sampler tick, collect to publish
+    Collect,     // the collector backend
+    SensorIpc,   // decoding helper frames from the pipe, or reading the shared segment
+    Publish,     // history, observers, exporter render and the handoff to the GUI
+    UpdateStats, // turning a sample into overlay row text
+    Layout,      // relayout after the rows changed
+    Paint,       // repainting the overlay window
+    Count
+};
+
+constexpr int StageCount = static_cast<int>(Stage::Count);
+
+// Stable snake_case name, used as the exporter's stage label
+const char* stageName(Stage stage);
+
+// Log-linear latency histogram in the style of HdrHistogram: 16 linear sub-buckets per
+// power of two, so a recorded value is off by at most 1/16 from 1 ns up to about half an
+// hour, in fixed storage. Recording is a few relaxed atomic adds and safe from any
+// thread; readers get a view that may be a sample or two behind.
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxExponent = 40;
+    static constexpr int BucketCount = (MaxExponent - SubBucketBits + 2) * SubBuckets;
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sumNs() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return m_max.load(std::memory_order_relaxed); }
+    // Value at quantile q in [0, 1], as the upper bound of its bucket; 0 when empty
+    uint64_t quantileNs(double q) const;
+
+    static int bucketIndex(uint64_t ns);
+    // Largest value that lands in bucket index
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    std::atomic<uint64_t> m_buckets[BucketCount] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+LatencyHistogram& histogram(Stage stage);
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Stage stage)
+        : m_stage(stage)
+        , m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        histogram(m_stage).record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Stage m_stage;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace Instrumentation
+
+#if WINSYS_INSTRUMENTATION
+#define WINSYS_TRACE_CONCAT_(a, b) a##b
+#define WINSYS_TRACE_CONCAT(a, b) WINSYS_TRACE_CONCAT_(a, b)
+#define WINSYS_TRACE_SCOPE(stage) \
+    Instrumentation::ScopedTimer WINSYS_TRACE_CONCAT(winsysTraceScope, __LINE__)(Instrumentation::Stage::stage)
+#else
+#define WINSYS_TRACE_SCOPE(stage) static_cast<void>(0)
+#endif
+
+#endif // INSTRUMENTATION_H
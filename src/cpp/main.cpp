@@ -1,4 +1,5 @@
 #include "overlaywidget.h"
+#include "headlesscollector.h"
 
 #include <QApplication>
 #include <QSettings>
@@ -8,9 +9,17 @@
 #include <QLibraryInfo>
 #include <QLoggingCategory>
 #include <QFileInfo>
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // Decided before any QApplication exists, so no display connection is ever opened
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            return runHeadlessCollector(argc, argv);
+        }
+    }
+
     // Enable Qt logging for debugging
     QLoggingCategory::setFilterRules("qt.qpa.plugin.debug=true");
     
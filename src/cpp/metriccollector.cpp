@@ -0,0 +1,31 @@
+#include "metriccollector.h"
+
+#ifdef Q_OS_WIN
+#include "pdhcollector.h"
+#elif defined(Q_OS_LINUX)
+#include "procfscollector.h"
+#else
+namespace {
+
+// Used on platforms without a native backend so the rest of the overlay still runs
+class NullCollector : public MetricCollector
+{
+public:
+    const char* name() const override { return "null"; }
+    bool initialize() override { return true; }
+    void collect(SysInfo&) override {}
+};
+
+} // namespace
+#endif
+
+std::unique_ptr<MetricCollector> MetricCollector::createDefault()
+{
+#ifdef Q_OS_WIN
+    return std::make_unique<PdhCollector>();
+#elif defined(Q_OS_LINUX)
+    return std::make_unique<ProcfsCollector>();
+#else
+    return std::make_unique<NullCollector>();
+#endif
+}
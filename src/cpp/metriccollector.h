@@ -0,0 +1,74 @@
+#ifndef METRICCOLLECTOR_H
+#define METRICCOLLECTOR_H
+
+#include <functional>
+#include <memory>
+#include "sysinfo.h"
+
+// Parts of a sample that a collector refreshes independently, so each can be sampled on
+// its own cadence (see SamplingScheduler). Fields outside the requested groups keep the
+// values they had.
+enum class MetricGroup : int {
+    Cpu,          // cpuLoad
+    Memory,       // memUsage, totalRamMB, availRamMB
+    Disk,         // diskLoad
+    Gpu,          // gpuLoad
+    Network,      // networkDownloadSpeed, networkUploadSpeed
+    Temperatures, // cpuTemp, gpuTemp when the collector provides them
+    Processes,    // activeProcesses
+    Uptime,       // systemUptime
+    TopProcesses, // topCpu, topMemory; also activeProcesses
+    Frames,       // fps and frame times, measured by the sampler's FrameTimingEngine
+    CpuCores,     // cpuCores, cpuCoreMaxLoad, cpuFrequencyMHz, cpuFrequencyMaxMHz
+    Count
+};
+
+constexpr int MetricGroupCount = static_cast<int>(MetricGroup::Count);
+
+using MetricGroups = quint32;
+
+constexpr MetricGroups metricGroupBit(MetricGroup group)
+{
+    return MetricGroups(1) << static_cast<int>(group);
+}
+
+constexpr MetricGroups AllMetricGroups = (MetricGroups(1) << MetricGroupCount) - 1;
+
+// The groups behind the Metric set, i.e. what the exporter and recordings publish. The
+// top process lists are only ever shown, and walking every process is not free.
+constexpr MetricGroups MetricSetGroups = AllMetricGroups & ~metricGroupBit(MetricGroup::TopProcesses);
+
+// A platform backend that fills a SysInfo with one sample. Collectors are created, used and
+// destroyed on the sampler thread, so implementations do not need to be thread-safe.
+//
+// Network speeds are reported in MB/s; the sampler integrates them into the daily data usage.
+// Temperatures are left untouched unless providesTemperatures() returns true, in which case
+// the sampler does not start the TempReader sensor helper.
+class MetricCollector
+{
+public:
+    virtual ~MetricCollector() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool initialize() = 0;
+    virtual void collect(SysInfo& info) = 0;
+    // Refreshes only the given groups. Rates are computed over the time since the group was
+    // last collected. The default collects everything.
+    virtual void collectGroups(SysInfo& info, MetricGroups groups) { Q_UNUSED(groups); collect(info); }
+    // Opens the sources the given groups read and closes the rest; groups that are not
+    // enabled are never collected. May be called before initialize(), which then opens only
+    // these. Everything is enabled by default.
+    virtual void setEnabledGroups(MetricGroups groups) { Q_UNUSED(groups); }
+    virtual bool providesTemperatures() const { return false; }
+    // A finite source such as a recording has nothing more to collect
+    virtual bool finished() const { return false; }
+
+    // Returns the native backend for the platform the overlay was built for
+    static std::unique_ptr<MetricCollector> createDefault();
+};
+
+// Makes the collector the sampler uses instead of createDefault(), e.g. a fake in tests.
+// Called on the sampler thread.
+using MetricCollectorFactory = std::function<std::unique_ptr<MetricCollector>()>;
+
+#endif // METRICCOLLECTOR_H
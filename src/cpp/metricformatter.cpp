@@ -0,0 +1,309 @@
+#include "metricformatter.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Appends to a row buffer; anything past the end is dropped
+class TextWriter
+{
+public:
+    TextWriter(char16_t* text, int capacity) : m_text(text), m_capacity(capacity), m_length(0) {}
+
+    int length() const { return m_length; }
+
+    TextWriter& operator<<(const char16_t* literal)
+    {
+        while (*literal && m_length < m_capacity) {
+            m_text[m_length++] = *literal++;
+        }
+        return *this;
+    }
+
+    TextWriter& operator<<(long long value)
+    {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        appendAscii(digits, result.ptr);
+        return *this;
+    }
+
+    // value with a fixed number of decimals, rounded half away from zero
+    TextWriter& fixed(double value, int decimals)
+    {
+        static const double scales[] = { 1.0, 10.0, 100.0, 1000.0 };
+        if (!std::isfinite(value)) {
+            return *this << u"nan";
+        }
+        const long long scaled = std::llround(value * scales[decimals]);
+        const long long scale = static_cast<long long>(scales[decimals]);
+        if (scaled < 0) {
+            *this << u"-";
+        }
+        const long long magnitude = scaled < 0 ? -scaled : scaled;
+        *this << magnitude / scale;
+        if (decimals > 0) {
+            char digits[4];
+            long long fraction = magnitude % scale;
+            for (int i = decimals - 1; i >= 0; --i) {
+                digits[i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            *this << u".";
+            appendAscii(digits, digits + decimals);
+        }
+        return *this;
+    }
+
+    // UTF-8 text, at most maxChars characters; anything outside the BMP or malformed shows as '?'
+    TextWriter& utf8(const char* text, int maxChars)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+        for (int chars = 0; *p && chars < maxChars && m_length < m_capacity; ++chars) {
+            char16_t c = u'?';
+            if (*p < 0x80) {
+                c = *p++;
+            } else if ((*p & 0xe0) == 0xc0 && (p[1] & 0xc0) == 0x80) {
+                c = static_cast<char16_t>(((p[0] & 0x1f) << 6) | (p[1] & 0x3f));
+                p += 2;
+            } else if ((*p & 0xf0) == 0xe0 && (p[1] & 0xc0) == 0x80 && (p[2] & 0xc0) == 0x80) {
+                c = static_cast<char16_t>(((p[0] & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f));
+                p += 3;
+            } else {
+                ++p;
+                while ((*p & 0xc0) == 0x80) ++p;
+            }
+            m_text[m_length++] = c;
+        }
+        return *this;
+    }
+
+private:
+    void appendAscii(const char* begin, const char* end)
+    {
+        for (; begin != end && m_length < m_capacity; ++begin) {
+            m_text[m_length++] = static_cast<char16_t>(*begin);
+        }
+    }
+
+    char16_t* m_text;
+    int m_capacity;
+    int m_length;
+};
+
+void writeSpeed(TextWriter& w, const char16_t* prefix, double mbPerSecond)
+{
+    w << prefix;
+    if (mbPerSecond >= 1.0) {
+        w.fixed(mbPerSecond, 2) << u" MB/s";
+    } else if (mbPerSecond >= 0.001) {
+        w.fixed(mbPerSecond * 1024, 1) << u" KB/s";
+    } else {
+        w << u"0.00 KB/s";
+    }
+}
+
+void writeTemperature(TextWriter& w, const char16_t* prefix, double celsius)
+{
+    w << prefix;
+    if (celsius >= 0) {
+        w.fixed(celsius, 1) << u"°C";
+    } else {
+        w << u"N/A";
+    }
+}
+
+// "name value, name value, ..." for the non-empty slots; value writes one process's figure
+template <typename F>
+void writeTopProcesses(TextWriter& w, const char16_t* prefix, const TopProcess* top, F value)
+{
+    // Long names are cut so all of them fit a row
+    constexpr int MaxNameChars = 14;
+    w << prefix;
+    int written = 0;
+    for (int i = 0; i < TopProcessCount; ++i) {
+        if (top[i].pid == 0) {
+            continue;
+        }
+        if (written++ > 0) {
+            w << u", ";
+        }
+        if (top[i].name[0]) {
+            w.utf8(top[i].name, MaxNameChars);
+        } else {
+            w << u"[" << static_cast<long long>(top[i].pid) << u"]";
+        }
+        w << u" ";
+        value(top[i]);
+    }
+    if (written == 0) {
+        w << u"N/A";
+    }
+}
+
+// "Cores: max 97% (#12 #3 #40) 3.42 GHz": the busiest core's load, which cores are busiest
+// and the mean clock where the platform reports one
+void writeCores(TextWriter& w, const SysInfo& info)
+{
+    w << u"Cores: ";
+    if (info.cpuCoreMaxLoad < 0) {
+        w << u"N/A";
+        return;
+    }
+    w << u"max ";
+    w.fixed(info.cpuCoreMaxLoad, 0) << u"%";
+    // A played back recording has the aggregates only
+    if (info.cpuCores.count > 0 && info.cpuCores.busiest[0] >= 0) {
+        w << u" (";
+        for (int i = 0; i < BusiestCoreCount && info.cpuCores.busiest[i] >= 0; ++i) {
+            w << (i > 0 ? u" #" : u"#") << static_cast<long long>(info.cpuCores.busiest[i]);
+        }
+        w << u")";
+    }
+    if (info.cpuFrequencyMHz >= 1000) {
+        w << u" ";
+        w.fixed(info.cpuFrequencyMHz / 1000.0, 2) << u" GHz";
+    } else if (info.cpuFrequencyMHz >= 0) {
+        w << u" ";
+        w.fixed(info.cpuFrequencyMHz, 0) << u" MHz";
+    }
+}
+
+} // namespace
+
+MetricFormatter::MetricFormatter()
+{
+    invalidate();
+}
+
+void MetricFormatter::invalidate()
+{
+    // No row formats to an empty string, so every row compares as changed
+    for (Text& row : m_rows) {
+        row.length = 0;
+    }
+}
+
+QString MetricFormatter::string(int row) const
+{
+    return QString(reinterpret_cast<const QChar*>(m_rows[row].text), m_rows[row].length);
+}
+
+quint32 MetricFormatter::format(const SysInfo& info)
+{
+    quint32 changed = 0;
+    Text scratch;
+    for (int row = 0; row < RowCount; ++row) {
+        formatRow(row, info, scratch);
+        Text& current = m_rows[row];
+        if (scratch.length == current.length &&
+            std::memcmp(scratch.text, current.text, sizeof(char16_t) * scratch.length) == 0) {
+            continue;
+        }
+        std::memcpy(current.text, scratch.text, sizeof(char16_t) * scratch.length);
+        current.length = scratch.length;
+        changed |= 1u << row;
+    }
+    return changed;
+}
+
+void MetricFormatter::formatRow(int row, const SysInfo& info, Text& out) const
+{
+    TextWriter w(out.text, MaxRowLength);
+    switch (row) {
+    case CpuRow:
+        w << u"CPU: ";
+        w.fixed(info.cpuLoad, 1) << u"%";
+        break;
+    case MemRow:
+        w << u"MEM: " << static_cast<long long>(info.memUsage) << u"%";
+        break;
+    case RamRow:
+        w << u"RAM: " << static_cast<long long>(info.totalRamMB - info.availRamMB) << u"/"
+          << static_cast<long long>(info.totalRamMB) << u" MB";
+        break;
+    case DiskRow:
+        w << u"DSK: ";
+        w.fixed(info.diskLoad, 1) << u"%";
+        break;
+    case GpuRow:
+        w << u"GPU: ";
+        w.fixed(info.gpuLoad, 1) << u"%";
+        break;
+    case FpsRow:
+        w << u"FPS: ";
+        if (info.fps >= 0) {
+            w.fixed(info.fps, 0);
+            if (info.fpsLow1Percent >= 0) {
+                w << u" (1%: ";
+                w.fixed(info.fpsLow1Percent, 0) << u")";
+            }
+        } else {
+            w << u"N/A";
+        }
+        break;
+    case NetDownRow:
+        writeSpeed(w, u"↓: ", info.networkDownloadSpeed);
+        break;
+    case NetUpRow:
+        writeSpeed(w, u"↑: ", info.networkUploadSpeed);
+        break;
+    case DailyDataRow:
+        w << u"Daily: ";
+        if (info.dailyDataUsageMB >= 1024) {
+            w.fixed(info.dailyDataUsageMB / 1024.0, 2) << u" GB";
+        } else {
+            w << static_cast<long long>(info.dailyDataUsageMB) << u" MB";
+        }
+        break;
+    case CpuTempRow:
+        writeTemperature(w, u"CPU°: ", info.cpuTemp);
+        break;
+    case GpuTempRow:
+        writeTemperature(w, u"GPU°: ", info.gpuTemp);
+        break;
+    case ProcessesRow:
+        w << u"Proc: " << static_cast<long long>(info.activeProcesses);
+        break;
+    case UptimeRow:
+        w << u"Up: ";
+        if (info.systemUptime < 1) {
+            w.fixed(info.systemUptime * 60, 0) << u"m";
+        } else if (info.systemUptime < 24) {
+            w.fixed(info.systemUptime, 1) << u"h";
+        } else {
+            const long long days = static_cast<long long>(info.systemUptime / 24);
+            const double remainingHours = info.systemUptime - days * 24;
+            w << days << u"d";
+            if (remainingHours >= 0.1) {
+                w << u" ";
+                w.fixed(remainingHours, 0) << u"h";
+            }
+        }
+        break;
+    case SelfRow:
+        w << u"Self: ";
+        if (info.selfCpuPercent >= 0) {
+            w.fixed(info.selfCpuPercent, 1) << u"% ";
+            w.fixed(info.selfMemoryMB, 0) << u" MB";
+        } else {
+            w << u"N/A";
+        }
+        break;
+    case TopCpuRow:
+        writeTopProcesses(w, u"Top CPU: ", info.topCpu, [&w](const TopProcess& process) {
+            w.fixed(process.cpuPercent, 1) << u"%";
+        });
+        break;
+    case TopMemRow:
+        writeTopProcesses(w, u"Top MEM: ", info.topMemory, [&w](const TopProcess& process) {
+            w.fixed(process.residentMB, 0) << u" MB";
+        });
+        break;
+    case CoresRow:
+        writeCores(w, info);
+        break;
+    }
+    out.length = w.length();
+}
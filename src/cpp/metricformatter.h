@@ -0,0 +1,47 @@
+#ifndef METRICFORMATTER_H
+#define METRICFORMATTER_H
+
+#include <QString>
+#include "sysinfo.h"
+
+// Turns a sample into the overlay's row text without allocating.
+//
+// Every row is written as UTF-16 into a fixed buffer, numbers as fixed-point integers via
+// std::to_chars, and compared with what the row showed last time. format() reports which
+// rows changed, so the overlay only touches those; only then is a QString made, because
+// the label has to keep a copy of its text anyway.
+class MetricFormatter
+{
+public:
+    // Same order as the overlay rows and OverlaySettings::displayKey()
+    enum Row {
+        CpuRow, MemRow, RamRow, DiskRow, GpuRow, FpsRow, NetDownRow, NetUpRow,
+        DailyDataRow, CpuTempRow, GpuTempRow, ProcessesRow, UptimeRow, SelfRow,
+        TopCpuRow, TopMemRow, CoresRow, RowCount
+    };
+
+    static constexpr int MaxRowLength = 96;
+
+    MetricFormatter();
+
+    // Formats every row; returns a bit mask (1 << row) of the rows whose text changed
+    quint32 format(const SysInfo& info);
+    // Makes the next format() report every row, e.g. after the rows were re-created
+    void invalidate();
+
+    const char16_t* text(int row) const { return m_rows[row].text; }
+    int length(int row) const { return m_rows[row].length; }
+    QString string(int row) const;
+
+private:
+    struct Text {
+        char16_t text[MaxRowLength];
+        int length;
+    };
+
+    void formatRow(int row, const SysInfo& info, Text& out) const;
+
+    Text m_rows[RowCount];
+};
+
+#endif // METRICFORMATTER_H
@@ -0,0 +1,168 @@
+#include "metrichistory.h"
+#include <algorithm>
+
+MetricHistory::MetricHistory(int capacity)
+    : m_capacity(std::max(capacity, 1))
+    , m_values(new std::atomic<float>[static_cast<size_t>(MetricCount) * std::max(capacity, 1)])
+    , m_timestamps(new std::atomic<qint64>[std::max(capacity, 1)])
+    , m_count(0)
+    , m_queueStorage(new quint32[static_cast<size_t>(MetricCount) * 2 * std::max(capacity, 1)])
+    , m_statsSequence(0)
+    , m_statsSamples(0)
+{
+    for (size_t i = 0; i < static_cast<size_t>(MetricCount) * m_capacity; ++i) {
+        m_values[i].store(0.0f, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < m_capacity; ++i) {
+        m_timestamps[i].store(0, std::memory_order_relaxed);
+    }
+    for (int m = 0; m < MetricCount; ++m) {
+        m_minQueues[m].sequence = m_queueStorage.get() + static_cast<size_t>(2 * m) * m_capacity;
+        m_maxQueues[m].sequence = m_queueStorage.get() + static_cast<size_t>(2 * m + 1) * m_capacity;
+        m_sums[m] = 0.0;
+        m_validCounts[m] = 0;
+        m_statsMin[m].store(0.0f, std::memory_order_relaxed);
+        m_statsMax[m].store(0.0f, std::memory_order_relaxed);
+        m_statsMean[m].store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+std::atomic<float>& MetricHistory::valueAt(Metric metric, quint64 sequence) const
+{
+    return m_values[static_cast<size_t>(metric) * m_capacity + sequence % m_capacity];
+}
+
+void MetricHistory::updateQueue(MonotonicQueue& queue, Metric metric, quint64 sequence, float value, bool keepMinimum)
+{
+    // The queue holds the low 32 bits of sample sequence numbers; ages are computed with
+    // wrapping arithmetic, which is exact because the window is far smaller than 2^32.
+    const quint32 sequence32 = static_cast<quint32>(sequence);
+    const quint32 capacity = static_cast<quint32>(m_capacity);
+
+    // Expire the sample that this push overwrites
+    while (queue.size > 0 && sequence32 - queue.sequence[queue.head] >= capacity) {
+        queue.head = (queue.head + 1) % m_capacity;
+        --queue.size;
+    }
+
+    // N/A values never become the extreme
+    if (value < 0.0f) {
+        return;
+    }
+
+    // Drop samples that can no longer be the extreme while the new one is in the window
+    while (queue.size > 0) {
+        const int tail = (queue.head + queue.size - 1) % m_capacity;
+        const quint64 tailSequence = sequence - (sequence32 - queue.sequence[tail]);
+        const float tailValue = valueAt(metric, tailSequence).load(std::memory_order_relaxed);
+        if (keepMinimum ? tailValue < value : tailValue > value) {
+            break;
+        }
+        --queue.size;
+    }
+
+    queue.sequence[(queue.head + queue.size) % m_capacity] = sequence32;
+    ++queue.size;
+}
+
+void MetricHistory::push(const SysInfo& info, qint64 timestampMs)
+{
+    const quint64 sequence = m_count.load(std::memory_order_relaxed);
+    const bool full = sequence >= static_cast<quint64>(m_capacity);
+
+    for (int m = 0; m < MetricCount; ++m) {
+        const Metric metric = static_cast<Metric>(m);
+        const float value = static_cast<float>(metricValue(info, metric));
+        std::atomic<float>& cell = valueAt(metric, sequence);
+
+        if (full) {
+            const float overwritten = cell.load(std::memory_order_relaxed);
+            if (overwritten >= 0.0f) {
+                m_sums[m] -= overwritten;
+                --m_validCounts[m];
+            }
+        }
+        updateQueue(m_minQueues[m], metric, sequence, value, true);
+        updateQueue(m_maxQueues[m], metric, sequence, value, false);
+
+        cell.store(value, std::memory_order_relaxed);
+        if (value >= 0.0f) {
+            m_sums[m] += value;
+            ++m_validCounts[m];
+        }
+    }
+    m_timestamps[sequence % m_capacity].store(timestampMs, std::memory_order_relaxed);
+    m_count.store(sequence + 1, std::memory_order_release);
+
+    // Publish the aggregates
+    const int samples = static_cast<int>(std::min<quint64>(sequence + 1, m_capacity));
+    const quint32 statsSequence = m_statsSequence.load(std::memory_order_relaxed);
+    m_statsSequence.store(statsSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int m = 0; m < MetricCount; ++m) {
+        const Metric metric = static_cast<Metric>(m);
+        if (m_validCounts[m] == 0) {
+            m_statsMin[m].store(-1.0f, std::memory_order_relaxed);
+            m_statsMax[m].store(-1.0f, std::memory_order_relaxed);
+            m_statsMean[m].store(-1.0f, std::memory_order_relaxed);
+            continue;
+        }
+        const quint64 minSequence = sequence - (static_cast<quint32>(sequence) - m_minQueues[m].sequence[m_minQueues[m].head]);
+        const quint64 maxSequence = sequence - (static_cast<quint32>(sequence) - m_maxQueues[m].sequence[m_maxQueues[m].head]);
+        m_statsMin[m].store(valueAt(metric, minSequence).load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_statsMax[m].store(valueAt(metric, maxSequence).load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_statsMean[m].store(static_cast<float>(m_sums[m] / m_validCounts[m]), std::memory_order_relaxed);
+    }
+    m_statsSamples.store(samples, std::memory_order_relaxed);
+    m_statsSequence.store(statsSequence + 2, std::memory_order_release);
+}
+
+int MetricHistory::snapshot(Metric metric, float* values, qint64* timestamps, int maxSamples) const
+{
+    const quint64 end = m_count.load(std::memory_order_acquire);
+    const quint64 available = std::min<quint64>(end, m_capacity);
+    const quint64 wanted = std::min<quint64>(available, static_cast<quint64>(std::max(maxSamples, 0)));
+    const quint64 begin = end - wanted;
+
+    for (quint64 s = begin; s < end; ++s) {
+        values[s - begin] = valueAt(metric, s).load(std::memory_order_relaxed);
+        if (timestamps) {
+            timestamps[s - begin] = m_timestamps[s % m_capacity].load(std::memory_order_relaxed);
+        }
+    }
+
+    // The writer may have lapped the oldest slots while we were copying. Samples older than
+    // (newest count - capacity) can be torn, so drop them from the front.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 endAfter = m_count.load(std::memory_order_relaxed);
+    const quint64 firstValid = endAfter >= static_cast<quint64>(m_capacity) ? endAfter - m_capacity + 1 : 0;
+    if (firstValid > begin) {
+        const quint64 dropped = std::min(firstValid - begin, wanted);
+        std::copy(values + dropped, values + wanted, values);
+        if (timestamps) {
+            std::copy(timestamps + dropped, timestamps + wanted, timestamps);
+        }
+        return static_cast<int>(wanted - dropped);
+    }
+    return static_cast<int>(wanted);
+}
+
+MetricStats MetricHistory::stats(Metric metric) const
+{
+    const int m = static_cast<int>(metric);
+    MetricStats result;
+    for (;;) {
+        const quint32 before = m_statsSequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        result.min = m_statsMin[m].load(std::memory_order_relaxed);
+        result.max = m_statsMax[m].load(std::memory_order_relaxed);
+        result.mean = m_statsMean[m].load(std::memory_order_relaxed);
+        result.samples = m_statsSamples.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_statsSequence.load(std::memory_order_relaxed) == before) {
+            return result;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef METRICHISTORY_H
+#define METRICHISTORY_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include "sysinfo.h"
+
+struct MetricStats {
+    float min = 0.0f;
+    float max = 0.0f;
+    float mean = 0.0f;
+    int samples = 0;
+};
+
+// Fixed-capacity history of every SysInfo metric.
+//
+// Samples are stored as structure-of-arrays: one contiguous ring per metric plus a shared
+// timestamp ring, all allocated up front so push() never allocates. There is exactly one
+// writer (the sampler thread); any number of readers can copy out a consistent window at
+// any time without blocking it. Rolling min/max/mean over the whole window are maintained
+// incrementally on push (monotonic queues and a running sum) and published through a
+// seqlock, so stats() is O(1). Negative values are N/A and are left out of them; a metric
+// with no value in the window has a min, max and mean of -1.
+class MetricHistory
+{
+public:
+    explicit MetricHistory(int capacity);
+    MetricHistory(const MetricHistory&) = delete;
+    MetricHistory& operator=(const MetricHistory&) = delete;
+
+    int capacity() const { return m_capacity; }
+
+    // Writer side
+    void push(const SysInfo& info, qint64 timestampMs);
+
+    // Reader side
+    quint64 sampleCount() const { return m_count.load(std::memory_order_acquire); }
+
+    // Copies up to maxSamples of the newest values, oldest first, and returns how many were
+    // copied. timestamps may be null.
+    int snapshot(Metric metric, float* values, qint64* timestamps, int maxSamples) const;
+
+    MetricStats stats(Metric metric) const;
+
+private:
+    struct MonotonicQueue {
+        quint32* sequence = nullptr;
+        int head = 0;
+        int size = 0;
+    };
+
+    std::atomic<float>& valueAt(Metric metric, quint64 sequence) const;
+    void updateQueue(MonotonicQueue& queue, Metric metric, quint64 sequence, float value, bool keepMinimum);
+
+    const int m_capacity;
+
+    std::unique_ptr<std::atomic<float>[]> m_values;
+    std::unique_ptr<std::atomic<qint64>[]> m_timestamps;
+    std::atomic<quint64> m_count;
+
+    // Writer-only bookkeeping for the rolling aggregates
+    std::unique_ptr<quint32[]> m_queueStorage;
+    MonotonicQueue m_minQueues[MetricCount];
+    MonotonicQueue m_maxQueues[MetricCount];
+    double m_sums[MetricCount];
+    int m_validCounts[MetricCount];  // values in the window that are not N/A
+
+    // Published aggregates, guarded by m_statsSequence (odd while a write is in progress)
+    alignas(64) std::atomic<quint32> m_statsSequence;
+    std::atomic<float> m_statsMin[MetricCount];
+    std::atomic<float> m_statsMax[MetricCount];
+    std::atomic<float> m_statsMean[MetricCount];
+    std::atomic<int> m_statsSamples;
+};
+
+#endif // METRICHISTORY_H
@@ -0,0 +1,308 @@
+#include "metricpanel.h"
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPaintEvent>
+#include <vector>
+
+namespace {
+
+const int IconSize = 16;
+const int RowSpacing = 5;
+const int ShadowRadius = 4;
+const QColor ShadowColor(0, 0, 0, 220);
+const int MaxCachedTexts = 512;
+
+// Three box-blur passes over the alpha channel approximate a gaussian well enough for a
+// text shadow. The shadow is pure black, so in premultiplied ARGB only alpha is non-zero.
+void blurShadow(QImage& image, int radius)
+{
+    const int width = image.width();
+    const int height = image.height();
+    std::vector<int> alpha(static_cast<size_t>(width) * height);
+    std::vector<int> scratch(alpha.size());
+    for (int y = 0; y < height; ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x) {
+            alpha[static_cast<size_t>(y) * width + x] = qAlpha(line[x]);
+        }
+    }
+
+    auto boxPass = [radius](const int* in, int* out, int count, int stride) {
+        const int window = 2 * radius + 1;
+        int sum = 0;
+        for (int i = -radius; i <= radius; ++i) {
+            sum += (i >= 0 && i < count) ? in[i * stride] : 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            out[i * stride] = sum / window;
+            const int add = i + radius + 1;
+            const int remove = i - radius;
+            sum += (add < count ? in[add * stride] : 0) - (remove >= 0 ? in[remove * stride] : 0);
+        }
+    };
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int y = 0; y < height; ++y) {
+            boxPass(&alpha[static_cast<size_t>(y) * width], &scratch[static_cast<size_t>(y) * width], width, 1);
+        }
+        for (int x = 0; x < width; ++x) {
+            boxPass(&scratch[x], &alpha[x], height, width);
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            line[x] = qRgba(0, 0, 0, alpha[static_cast<size_t>(y) * width + x]);
+        }
+    }
+}
+
+} // namespace
+
+MetricPanel::MetricPanel(int rowCount, QWidget *parent)
+    : QWidget(parent)
+    , m_rows(rowCount)
+    , m_color(Qt::white)
+    , m_horizontal(false)
+    , m_showSparklines(false)
+{
+    for (Row& row : m_rows) {
+        row.sparkline = std::make_unique<Sparkline>();
+    }
+    setAttribute(Qt::WA_TranslucentBackground);
+}
+
+void MetricPanel::setAppearance(const QFont& font, const QColor& color, const QColor& alertColor, bool horizontal)
+{
+    m_horizontal = horizontal;
+    if (font != m_font || color != m_color || alertColor != m_alertColor) {
+        m_font = font;
+        m_color = color;
+        m_alertColor = alertColor;
+        m_textCache.clear();
+        m_alertTextCache.clear();
+        for (Row& row : m_rows) {
+            row.textImage = row.text.isEmpty() ? QImage() : renderText(row.text, row.alert);
+            row.sparkline->setColor(color);
+        }
+    }
+    relayout();
+}
+
+void MetricPanel::setSparklinesVisible(bool visible)
+{
+    if (visible == m_showSparklines) {
+        return;
+    }
+    m_showSparklines = visible;
+    relayout();
+}
+
+void MetricPanel::setRowIcon(int row, const QPixmap& icon)
+{
+    m_rows[row].icon = icon;
+    update(m_rows[row].rect);
+}
+
+void MetricPanel::setRowText(int row, const QString& text)
+{
+    Row& r = m_rows[row];
+    if (r.text == text) {
+        return;
+    }
+    const int oldWidth = rowWidth(r);
+    r.text = text;
+    r.textImage = renderText(text, r.alert);
+    if (!r.visible) {
+        return;
+    }
+    if (rowWidth(r) != oldWidth) {
+        relayout();
+    } else {
+        // The shadow bleeds a few pixels past the row, repaint that too
+        update(r.rect.adjusted(-ShadowRadius, -ShadowRadius, ShadowRadius, ShadowRadius));
+    }
+}
+
+void MetricPanel::setRowVisible(int row, bool visible)
+{
+    if (m_rows[row].visible == visible) {
+        return;
+    }
+    m_rows[row].visible = visible;
+    relayout();
+}
+
+void MetricPanel::setRowAlert(int row, bool alert)
+{
+    Row& r = m_rows[row];
+    if (r.alert == alert) {
+        return;
+    }
+    r.alert = alert;
+    if (r.text.isEmpty()) {
+        return;
+    }
+    // Same text in another colour, so the width and the layout stay as they are
+    r.textImage = renderText(r.text, alert);
+    if (r.visible) {
+        update(r.rect.adjusted(-ShadowRadius, -ShadowRadius, ShadowRadius, ShadowRadius));
+    }
+}
+
+void MetricPanel::addRowSample(int row, double value)
+{
+    Row& r = m_rows[row];
+    r.sparkline->addSample(value);
+    if (r.visible && m_showSparklines) {
+        update(sparklineRect(r));
+    }
+}
+
+void MetricPanel::setRowStrip(int row, const quint8* loads, int count)
+{
+    Row& r = m_rows[row];
+    if (!r.strip) {
+        r.strip = std::make_unique<HeatStrip>();
+    }
+    const int oldWidth = rowWidth(r);
+    if (!r.strip->setLoads(loads, count) || !r.visible) {
+        return;
+    }
+    if (rowWidth(r) != oldWidth) {
+        relayout();
+    } else {
+        update(stripRect(r));
+    }
+}
+
+QImage MetricPanel::renderText(const QString& text, bool alert)
+{
+    QHash<QString, QImage>& cache = alert ? m_alertTextCache : m_textCache;
+    auto cached = cache.constFind(text);
+    if (cached != cache.constEnd()) {
+        return *cached;
+    }
+
+    QFontMetrics metrics(m_font);
+    QImage image(metrics.horizontalAdvance(text) + 2 * ShadowRadius, metrics.height() + 2 * ShadowRadius,
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    const QPoint baseline(ShadowRadius, ShadowRadius + metrics.ascent());
+
+    QPainter painter(&image);
+    painter.setFont(m_font);
+    painter.setPen(ShadowColor);
+    painter.drawText(baseline, text);
+    painter.end();
+    blurShadow(image, ShadowRadius / 2);
+
+    painter.begin(&image);
+    painter.setFont(m_font);
+    painter.setPen(alert ? m_alertColor : m_color);
+    painter.drawText(baseline, text);
+    painter.end();
+
+    if (cache.size() >= MaxCachedTexts) {
+        cache.clear();
+    }
+    cache.insert(text, image);
+    return image;
+}
+
+int MetricPanel::rowWidth(const Row& row) const
+{
+    int width = IconSize + RowSpacing;
+    if (!row.textImage.isNull()) {
+        width += row.textImage.width() - 2 * ShadowRadius;
+    }
+    if (row.strip && row.strip->size().width() > 0) {
+        width += RowSpacing + row.strip->size().width();
+    }
+    if (m_showSparklines) {
+        width += RowSpacing + row.sparkline->size().width();
+    }
+    return width;
+}
+
+QRect MetricPanel::sparklineRect(const Row& row) const
+{
+    const QSize size = row.sparkline->size();
+    return QRect(row.rect.right() + 1 - size.width(), row.rect.top() + (row.rect.height() - size.height()) / 2,
+                 size.width(), size.height());
+}
+
+QRect MetricPanel::stripRect(const Row& row) const
+{
+    const QSize size = row.strip->size();
+    int left = row.rect.left() + IconSize + RowSpacing;
+    if (!row.textImage.isNull()) {
+        left += row.textImage.width() - 2 * ShadowRadius;
+    }
+    return QRect(left + RowSpacing, row.rect.top() + (row.rect.height() - size.height()) / 2, size.width(), size.height());
+}
+
+void MetricPanel::relayout()
+{
+    const int rowHeight = qMax(IconSize, QFontMetrics(m_font).height());
+    const int spacing = m_horizontal ? 8 : 2;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    for (Row& row : m_rows) {
+        if (!row.visible) {
+            row.rect = QRect();
+            continue;
+        }
+        const int w = rowWidth(row);
+        row.rect = QRect(x, y, w, rowHeight);
+        width = qMax(width, x + w);
+        height = qMax(height, y + rowHeight);
+        if (m_horizontal) {
+            x += w + spacing;
+        } else {
+            y += rowHeight + spacing;
+        }
+    }
+
+    if (QSize(width, height) != m_contentSize) {
+        m_contentSize = QSize(width, height);
+        updateGeometry();
+    }
+    update();
+}
+
+QSize MetricPanel::sizeHint() const
+{
+    return m_contentSize;
+}
+
+QSize MetricPanel::minimumSizeHint() const
+{
+    return m_contentSize;
+}
+
+void MetricPanel::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    for (const Row& row : m_rows) {
+        if (!row.visible || !row.rect.adjusted(-ShadowRadius, -ShadowRadius, ShadowRadius, ShadowRadius).intersects(event->rect())) {
+            continue;
+        }
+        const QRect& r = row.rect;
+        painter.drawPixmap(QRect(r.left(), r.top() + (r.height() - IconSize) / 2, IconSize, IconSize), row.icon);
+        if (!row.textImage.isNull()) {
+            const int textHeight = row.textImage.height() - 2 * ShadowRadius;
+            painter.drawImage(QPoint(r.left() + IconSize + RowSpacing - ShadowRadius,
+                                     r.top() + (r.height() - textHeight) / 2 - ShadowRadius),
+                              row.textImage);
+        }
+        if (row.strip) {
+            row.strip->paint(painter, stripRect(row).topLeft());
+        }
+        if (m_showSparklines) {
+            row.sparkline->paint(painter, sparklineRect(row).topLeft());
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef METRICPANEL_H
+#define METRICPANEL_H
+
+#include <QWidget>
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QString>
+#include <memory>
+#include <vector>
+#include "sparkline.h"
+#include "heatstrip.h"
+
+// Alternative to the QLabel-per-row widget tree: a single widget that lays out every
+// metric row itself and paints icon, text, heat strip and sparkline directly.
+//
+// Text is rendered together with its drop shadow into an image once per distinct string
+// and kept in a small cache, so a row whose value flips between a handful of strings never
+// blurs anything again. Changing a row only repaints that row's rectangle; the panel is
+// re-laid out only when a row's width actually changes.
+class MetricPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MetricPanel(int rowCount, QWidget *parent = nullptr);
+
+    // alertColor is the text colour of rows flagged with setRowAlert()
+    void setAppearance(const QFont& font, const QColor& color, const QColor& alertColor, bool horizontal);
+    void setSparklinesVisible(bool visible);
+
+    void setRowIcon(int row, const QPixmap& icon);
+    void setRowText(int row, const QString& text);
+    void setRowVisible(int row, bool visible);
+    void setRowAlert(int row, bool alert);
+    void addRowSample(int row, double value);
+    // Per-core loads drawn as a heat strip after the row's text; count 0 removes it
+    void setRowStrip(int row, const quint8* loads, int count);
+    Sparkline& rowSparkline(int row) { return *m_rows[row].sparkline; }
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Row {
+        QPixmap icon;
+        QString text;
+        QImage textImage;
+        bool visible = true;
+        bool alert = false;
+        QRect rect;
+        std::unique_ptr<Sparkline> sparkline;
+        std::unique_ptr<HeatStrip> strip; // only for rows that were given one
+    };
+
+    QImage renderText(const QString& text, bool alert);
+    QRect sparklineRect(const Row& row) const;
+    QRect stripRect(const Row& row) const;
+    int rowWidth(const Row& row) const;
+    void relayout();
+
+    std::vector<Row> m_rows;
+    QFont m_font;
+    QColor m_color;
+    QColor m_alertColor;
+    bool m_horizontal;
+    bool m_showSparklines;
+    QSize m_contentSize;
+
+    // Shadowed text images keyed by string, valid for the current font and colours
+    QHash<QString, QImage> m_textCache;
+    QHash<QString, QImage> m_alertTextCache;
+};
+
+#endif // METRICPANEL_H
@@ -0,0 +1,277 @@
+#include "metricsexporter.h"
+#include "metrichistory.h"
+#include "alertengine.h"
+#include "instrumentation.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QDebug>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// Anything that has not finished its headers by now is not a scraper
+constexpr int MaxHeaderBytes = 8192;
+
+const char NotFoundResponse[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n\r\nNot Found\n";
+const char MethodNotAllowedResponse[] =
+    "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Type: text/plain\r\nContent-Length: 19\r\n\r\n"
+    "Method Not Allowed\n";
+const char UnavailableResponse[] =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\nContent-Length: 16\r\n\r\nNo sample yet.\r\n";
+
+// format takes the metric name, then the formatted value
+void appendSample(std::string& out, const char* format, const char* name, double value)
+{
+    char number[32];
+    formatMetricValue(number, sizeof(number), value);
+    char line[160];
+    const int n = std::snprintf(line, sizeof(line), format, name, number);
+    if (n > 0) {
+        out.append(line, static_cast<size_t>(qMin(n, int(sizeof(line)) - 1)));
+    }
+}
+
+void appendType(std::string& out, const char* name, const char* suffix, const char* type)
+{
+    out.append("# TYPE winsys_").append(name).append(suffix).append(" ").append(type).append("\n");
+}
+
+#if WINSYS_INSTRUMENTATION
+// Per-stage tick latency since startup, as an OpenMetrics summary
+void appendStageLatencies(std::string& out)
+{
+    using namespace Instrumentation;
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 1.0 };
+    appendType(out, "stage_latency_seconds", "", "summary");
+    for (int s = 0; s < StageCount; ++s) {
+        const Stage stage = static_cast<Stage>(s);
+        const LatencyHistogram& latencies = histogram(stage);
+        char line[160];
+        for (double q : quantiles) {
+            char number[32];
+            formatMetricValue(number, sizeof(number), latencies.quantileNs(q) / 1e9);
+            const int n = std::snprintf(line, sizeof(line), "winsys_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} %s\n",
+                                        stageName(stage), q, number);
+            out.append(line, static_cast<size_t>(qBound(0, n, int(sizeof(line)) - 1)));
+        }
+        char number[32];
+        formatMetricValue(number, sizeof(number), latencies.sumNs() / 1e9);
+        int n = std::snprintf(line, sizeof(line), "winsys_stage_latency_seconds_sum{stage=\"%s\"} %s\n", stageName(stage), number);
+        out.append(line, static_cast<size_t>(qBound(0, n, int(sizeof(line)) - 1)));
+        n = std::snprintf(line, sizeof(line), "winsys_stage_latency_seconds_count{stage=\"%s\"} %llu\n", stageName(stage),
+                          static_cast<unsigned long long>(latencies.count()));
+        out.append(line, static_cast<size_t>(qBound(0, n, int(sizeof(line)) - 1)));
+    }
+}
+#endif
+
+// Every rule's state and how often it fired, labelled with its name and metric
+void appendAlerts(std::string& out, const AlertEngine& alerts)
+{
+    const AlertRules& rules = alerts.rules();
+    if (rules.empty()) {
+        return;
+    }
+    char line[192];
+    appendType(out, "alert_firing", "", "gauge");
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const int n = std::snprintf(line, sizeof(line), "winsys_alert_firing{rule=\"%s\",metric=\"%s\"} %d\n",
+                                    rules[i].name.constData(), metricName(rules[i].metric), alerts.firing(int(i)) ? 1 : 0);
+        out.append(line, static_cast<size_t>(qBound(0, n, int(sizeof(line)) - 1)));
+    }
+    appendType(out, "alert_fired", "", "counter");
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const int n = std::snprintf(line, sizeof(line), "winsys_alert_fired_total{rule=\"%s\",metric=\"%s\"} %llu\n",
+                                    rules[i].name.constData(), metricName(rules[i].metric),
+                                    static_cast<unsigned long long>(alerts.firedCount(int(i))));
+        out.append(line, static_cast<size_t>(qBound(0, n, int(sizeof(line)) - 1)));
+    }
+}
+
+bool startsWithNoCase(const char* text, const char* prefix)
+{
+    for (; *prefix; ++text, ++prefix) {
+        if (std::tolower(static_cast<unsigned char>(*text)) != *prefix) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(const MetricHistory& history, const AlertEngine& alerts)
+    : QObject(nullptr)
+    , m_history(history)
+    , m_alerts(alerts)
+    , m_server(nullptr)
+    , m_listening(false)
+    , m_scrapes(0)
+    , m_haveResponse(false)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    close();
+}
+
+void MetricsExporter::listen(int port)
+{
+    if (!m_server) {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::acceptConnections);
+    }
+    m_server->close();
+    // Loopback only: the exporter has no authentication
+    if (!m_server->listen(QHostAddress::LocalHost, static_cast<quint16>(port))) {
+        qWarning() << "Metrics exporter cannot listen on port" << port << ":" << m_server->errorString();
+        m_listening.store(false, std::memory_order_relaxed);
+        return;
+    }
+    qDebug() << "Metrics exporter listening on http://127.0.0.1:" << m_server->serverPort() << "/metrics";
+    m_listening.store(true, std::memory_order_relaxed);
+}
+
+void MetricsExporter::close()
+{
+    m_listening.store(false, std::memory_order_relaxed);
+    if (m_server) {
+        m_server->close();
+    }
+    // abort() emits disconnected, whose handler edits m_connections
+    const QList<QTcpSocket*> sockets = m_connections.keys();
+    m_connections.clear();
+    for (QTcpSocket* socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+}
+
+void MetricsExporter::render(const SysInfo& info, qint64 timestampMs)
+{
+    if (!m_listening.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::string& body = m_body;
+    body.clear();
+    for (int m = 0; m < MetricCount; ++m) {
+        const Metric metric = static_cast<Metric>(m);
+        appendType(body, metricName(metric), "", "gauge");
+        appendSample(body, "winsys_%s %s\n", metricName(metric), metricValue(info, metric));
+    }
+    // Aggregates over the whole history window, O(1) each
+    for (int m = 0; m < MetricCount; ++m) {
+        const Metric metric = static_cast<Metric>(m);
+        const MetricStats stats = m_history.stats(metric);
+        appendType(body, metricName(metric), "_window", "gauge");
+        appendSample(body, "winsys_%s_window{stat=\"min\"} %s\n", metricName(metric), stats.min);
+        appendSample(body, "winsys_%s_window{stat=\"max\"} %s\n", metricName(metric), stats.max);
+        appendSample(body, "winsys_%s_window{stat=\"mean\"} %s\n", metricName(metric), stats.mean);
+    }
+    appendAlerts(body, m_alerts);
+    appendType(body, "window_samples", "", "gauge");
+    appendSample(body, "winsys_%s %s\n", "window_samples", m_history.stats(Metric::CpuLoad).samples);
+    appendType(body, "sample_timestamp_seconds", "", "gauge");
+    appendSample(body, "winsys_%s %s\n", "sample_timestamp_seconds", timestampMs / 1000.0);
+    // As of this render; scrapes in between are counted in the next one
+    appendType(body, "exporter_scrapes", "", "counter");
+    appendSample(body, "winsys_%s_total %s\n", "exporter_scrapes", double(m_scrapes.load(std::memory_order_relaxed)));
+#if WINSYS_INSTRUMENTATION
+    appendStageLatencies(body);
+#endif
+    body.append("# EOF\n");
+
+    std::string& response = m_responses.writeBuffer();
+    response.clear();
+    char header[160];
+    const int n = std::snprintf(header, sizeof(header),
+                                "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                                "Content-Length: %zu\r\n\r\n",
+                                body.size());
+    response.append(header, static_cast<size_t>(n));
+    response.append(body);
+    m_responses.publish();
+}
+
+void MetricsExporter::acceptConnections()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MetricsExporter::readRequests(QTcpSocket* socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+        return;
+    }
+    Connection& connection = *it;
+
+    // Keep-alive and pipelined requests are handled line by line. Only the request line and
+    // the Connection header matter; everything else is skipped.
+    char line[1024];
+    while (socket->canReadLine()) {
+        const qint64 n = socket->readLine(line, sizeof(line));
+        if (n <= 0) {
+            break;
+        }
+        connection.headerBytes += static_cast<int>(n);
+        if (connection.headerBytes > MaxHeaderBytes) {
+            socket->abort();
+            return;
+        }
+        if (!connection.haveRequestLine) {
+            connection.haveRequestLine = true;
+            connection.methodAllowed = std::strncmp(line, "GET ", 4) == 0;
+            const char* path = std::strchr(line, ' ');
+            connection.metricsPath = path && (std::strncmp(path, " /metrics ", 10) == 0 || std::strncmp(path, " / ", 3) == 0);
+            connection.closeAfterResponse = std::strstr(line, "HTTP/1.0") != nullptr;
+        } else if (line[0] == '\r' || line[0] == '\n') {
+            respond(socket, connection);
+            const bool close = connection.closeAfterResponse;
+            connection = Connection();
+            if (close) {
+                socket->disconnectFromHost();
+                return;
+            }
+        } else if (startsWithNoCase(line, "connection:") && std::strstr(line + 11, "close")) {
+            connection.closeAfterResponse = true;
+        }
+    }
+}
+
+void MetricsExporter::respond(QTcpSocket* socket, const Connection& connection)
+{
+    if (!connection.methodAllowed) {
+        socket->write(MethodNotAllowedResponse, sizeof(MethodNotAllowedResponse) - 1);
+        return;
+    }
+    if (!connection.metricsPath) {
+        socket->write(NotFoundResponse, sizeof(NotFoundResponse) - 1);
+        return;
+    }
+    // Only this thread consumes, so the read buffer stays valid until the next consume()
+    if (m_responses.consume()) {
+        m_haveResponse = true;
+    }
+    if (!m_haveResponse) {
+        socket->write(UnavailableResponse, sizeof(UnavailableResponse) - 1);
+        return;
+    }
+    const std::string& response = m_responses.readBuffer();
+    socket->write(response.data(), static_cast<qint64>(response.size()));
+    m_scrapes.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,69 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QHash>
+#include <atomic>
+#include <string>
+#include "sysinfo.h"
+#include "snapshotchannel.h"
+
+class QTcpServer;
+class QTcpSocket;
+class MetricHistory;
+class AlertEngine;
+
+// Serves the current sample and its history aggregates in OpenMetrics text format on a
+// localhost HTTP port, for Prometheus-style scrapers (exporter/enabled, exporter/port).
+//
+// The complete HTTP response, headers included, is rendered once per sample on the
+// sampler thread and handed over through a SnapshotChannel. The exporter lives on its own
+// thread; a scrape picks up the newest response and writes it with a single write() call,
+// so any number of scrapes never reach the sampler thread or render anything.
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    // Both are read while rendering, so only ever on the sampler thread
+    MetricsExporter(const MetricHistory& history, const AlertEngine& alerts);
+    ~MetricsExporter();
+
+    // Producer side, called on the sampler thread for every sample
+    void render(const SysInfo& info, qint64 timestampMs);
+
+public slots:
+    // Binds 127.0.0.1:port, replacing any previous listener
+    void listen(int port);
+    void close();
+
+private slots:
+    void acceptConnections();
+
+private:
+    struct Connection {
+        bool haveRequestLine = false;
+        bool metricsPath = false;
+        bool methodAllowed = false;
+        bool closeAfterResponse = false;
+        int headerBytes = 0;
+    };
+
+    void readRequests(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, const Connection& connection);
+
+    const MetricHistory& m_history;
+    const AlertEngine& m_alerts;
+    QTcpServer* m_server;
+    QHash<QTcpSocket*, Connection> m_connections;
+
+    // Renders are skipped while nobody is listening
+    std::atomic<bool> m_listening;
+    std::atomic<quint64> m_scrapes;
+
+    // Sampler-thread scratch for the body, so a render never allocates once warmed up
+    std::string m_body;
+    SnapshotChannel<std::string> m_responses;
+    bool m_haveResponse;
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,146 @@
+#include "metricstatistics.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Percentiles are kept in hundredths, enough for every metric the overlay shows
+constexpr double SketchScale = 100.0;
+
+double percentileOf(MetricStatistic statistic)
+{
+    switch (statistic) {
+    case MetricStatistic::P50: return 0.50;
+    case MetricStatistic::P95: return 0.95;
+    case MetricStatistic::P99: return 0.99;
+    default: return 0.0;
+    }
+}
+
+bool isPercentile(MetricStatistic statistic)
+{
+    return statistic == MetricStatistic::P50 || statistic == MetricStatistic::P95 || statistic == MetricStatistic::P99;
+}
+
+} // namespace
+
+const char* metricStatisticName(MetricStatistic statistic)
+{
+    switch (statistic) {
+    case MetricStatistic::Latest: return "latest";
+    case MetricStatistic::Average: return "avg";
+    case MetricStatistic::P50: return "p50";
+    case MetricStatistic::P95: return "p95";
+    case MetricStatistic::P99: return "p99";
+    case MetricStatistic::Peak: return "peak";
+    case MetricStatistic::Count: break;
+    }
+    return "";
+}
+
+MetricStatistic metricStatisticFromName(const char* name)
+{
+    for (int i = 0; i < MetricStatisticCount; ++i) {
+        const MetricStatistic statistic = static_cast<MetricStatistic>(i);
+        if (std::strcmp(name, metricStatisticName(statistic)) == 0) {
+            return statistic;
+        }
+    }
+    return MetricStatistic::Latest;
+}
+
+bool MetricStatisticsConfig::operator==(const MetricStatisticsConfig& other) const
+{
+    for (int i = 0; i < MetricCount; ++i) {
+        if (statistic[i] != other.statistic[i]) {
+            return false;
+        }
+    }
+    return averageSeconds == other.averageSeconds && windowSeconds == other.windowSeconds &&
+           peakHoldSeconds == other.peakHoldSeconds;
+}
+
+MetricStatistics::MetricStatistics()
+    : m_activeCount(0)
+{
+}
+
+void MetricStatistics::configure(const MetricStatisticsConfig& config)
+{
+    m_config = config;
+    m_activeCount = 0;
+    const qint64 sliceMs = qMax<qint64>(1, qint64(qMax(1, config.windowSeconds)) * 1000 / WindowSlices);
+    for (int i = 0; i < MetricCount; ++i) {
+        State& state = m_states[i];
+        const MetricStatistic statistic = config.statistic[i];
+        state.started = false;
+        // Only percentile metrics pay for the ~20 KB of sketches
+        if (isPercentile(statistic)) {
+            if (!state.window || state.window->sliceLength() != sliceMs) {
+                state.window = std::make_unique<SlidingQuantileSketch>(sliceMs, WindowSlices);
+            } else {
+                state.window->clear();
+            }
+        } else {
+            state.window.reset();
+        }
+        if (statistic != MetricStatistic::Latest) {
+            m_active[m_activeCount++] = static_cast<Metric>(i);
+        }
+    }
+}
+
+void MetricStatistics::apply(SysInfo& info, qint64 timestampMs)
+{
+    for (int i = 0; i < m_activeCount; ++i) {
+        const Metric metric = m_active[i];
+        const double value = metricValue(info, metric);
+        if (value < 0.0) {
+            continue;
+        }
+        State& state = m_states[static_cast<int>(metric)];
+        setMetricValue(info, metric, update(state, m_config.statistic[static_cast<int>(metric)], value, timestampMs));
+    }
+}
+
+double MetricStatistics::update(State& state, MetricStatistic statistic, double value, qint64 timestampMs)
+{
+    if (!state.started || timestampMs < state.lastMs) {
+        state.started = true;
+        state.average = value;
+        state.peak = value;
+        state.peakMs = timestampMs;
+        state.lastMs = timestampMs;
+        if (state.window) {
+            state.window->clear();
+        }
+    }
+    const double elapsedSeconds = (timestampMs - state.lastMs) / 1000.0;
+    state.lastMs = timestampMs;
+    // exp(-dt / tau) is how much of the previous value survives dt, whatever the cadence
+    const double tau = qMax(0.001, m_config.averageSeconds);
+    const double keep = std::exp(-elapsedSeconds / tau);
+
+    switch (statistic) {
+    case MetricStatistic::Average:
+        state.average = value + (state.average - value) * keep;
+        return state.average;
+    case MetricStatistic::P50:
+    case MetricStatistic::P95:
+    case MetricStatistic::P99:
+        state.window->add(static_cast<uint64_t>(std::llround(value * SketchScale)), timestampMs);
+        return state.window->window().quantile(percentileOf(statistic)) / SketchScale;
+    case MetricStatistic::Peak:
+        if (value >= state.peak) {
+            state.peak = value;
+            state.peakMs = timestampMs;
+        } else if (timestampMs - state.peakMs > qint64(m_config.peakHoldSeconds) * 1000) {
+            state.peak = value + (state.peak - value) * keep;
+        }
+        return state.peak;
+    case MetricStatistic::Latest:
+    case MetricStatistic::Count:
+        break;
+    }
+    return value;
+}
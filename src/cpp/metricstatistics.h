@@ -0,0 +1,75 @@
+#ifndef METRICSTATISTICS_H
+#define METRICSTATISTICS_H
+
+#include <QtGlobal>
+#include <memory>
+#include "quantilesketch.h"
+#include "sysinfo.h"
+
+// What a metric shows in place of its latest value
+enum class MetricStatistic : int {
+    Latest, Average, P50, P95, P99, Peak, Count
+};
+
+constexpr int MetricStatisticCount = static_cast<int>(MetricStatistic::Count);
+
+// Stable name for settings files ("latest", "avg", "p50", "p95", "p99", "peak")
+const char* metricStatisticName(MetricStatistic statistic);
+// Inverse of metricStatisticName(); Latest for anything it does not know
+MetricStatistic metricStatisticFromName(const char* name);
+
+struct MetricStatisticsConfig {
+    MetricStatistic statistic[MetricCount] = {};
+    // Time constant of the moving average
+    double averageSeconds = 3.0;
+    // Span of the percentiles
+    int windowSeconds = 60;
+    // How long a peak is held before it falls back
+    int peakHoldSeconds = 5;
+
+    bool operator==(const MetricStatisticsConfig& other) const;
+    bool operator!=(const MetricStatisticsConfig& other) const { return !(*this == other); }
+};
+
+// Replaces the chosen metrics of each sample with a statistic over their recent values.
+//
+// Every statistic costs O(1) per sample in memory fixed by configure(): the average is
+// exponentially weighted with a weight that follows the time since the previous sample, so
+// adaptive cadences do not skew it; percentiles come from a SlidingQuantileSketch of the
+// values in hundredths; a peak is held for peakHoldSeconds and then decays towards the
+// current value with the same time constant. Negative values mean N/A and pass through
+// without touching the statistic. Metrics left at Latest cost nothing.
+class MetricStatistics
+{
+public:
+    static constexpr int WindowSlices = 10;
+
+    MetricStatistics();
+
+    // Starts every statistic over
+    void configure(const MetricStatisticsConfig& config);
+    const MetricStatisticsConfig& config() const { return m_config; }
+
+    // Samples are expected in time order; one from before the previous restarts the statistic
+    void apply(SysInfo& info, qint64 timestampMs);
+
+private:
+    struct State {
+        double average = 0.0;
+        double peak = 0.0;
+        qint64 peakMs = 0;
+        qint64 lastMs = 0;
+        bool started = false;
+        std::unique_ptr<SlidingQuantileSketch> window;
+    };
+
+    double update(State& state, MetricStatistic statistic, double value, qint64 timestampMs);
+
+    MetricStatisticsConfig m_config;
+    State m_states[MetricCount];
+    // The metrics that have a statistic, so apply() only walks those
+    Metric m_active[MetricCount];
+    int m_activeCount;
+};
+
+#endif // METRICSTATISTICS_H
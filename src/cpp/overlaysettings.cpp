@@ -0,0 +1,172 @@
+#include "overlaysettings.h"
+#include <QSettings>
+#include <atomic>
+
+namespace {
+
+const char* const DisplayKeys[OverlaySettings::DisplayItemCount] = {
+    "display/showCpu", "display/showMem", "display/showRam", "display/showDisk", "display/showGpu",
+    "display/showFps", "display/showNetDown", "display/showNetUp", "display/showDailyData",
+    "display/showCpuTemp", "display/showGpuTemp", "display/showProcesses", "display/showUptime",
+    "display/showSelfUsage", "display/showTopCpu", "display/showTopMemory", "display/showCores"
+};
+
+// Original metrics default to visible, the newer ones are opt-in
+const bool DisplayDefaults[OverlaySettings::DisplayItemCount] = {
+    true, true, true, true, true,
+    false, false, false, false, false, false, false, false, false, false, false, false
+};
+
+// The RAM row shows total minus available, so a statistic of either alone would mislead
+const Metric StatisticMetrics[OverlaySettings::DisplayItemCount] = {
+    Metric::CpuLoad, Metric::MemUsage, Metric::Count, Metric::DiskLoad, Metric::GpuLoad,
+    Metric::Fps, Metric::NetworkDownload, Metric::NetworkUpload, Metric::Count,
+    Metric::CpuTemp, Metric::GpuTemp, Metric::ActiveProcesses, Metric::Count,
+    Metric::SelfCpu, Metric::Count, Metric::Count, Metric::CpuCoreMax
+};
+
+const char* const StatisticKeys[OverlaySettings::DisplayItemCount] = {
+    "statistics/cpu", "statistics/mem", nullptr, "statistics/disk", "statistics/gpu",
+    "statistics/fps", "statistics/netDown", "statistics/netUp", nullptr,
+    "statistics/cpuTemp", "statistics/gpuTemp", "statistics/processes", nullptr,
+    "statistics/self", nullptr, nullptr, "statistics/cores"
+};
+
+} // namespace
+
+const char* OverlaySettings::displayKey(int item)
+{
+    return DisplayKeys[item];
+}
+
+bool OverlaySettings::displayDefault(int item)
+{
+    return DisplayDefaults[item];
+}
+
+Metric OverlaySettings::statisticMetric(int item)
+{
+    return StatisticMetrics[item];
+}
+
+const char* OverlaySettings::statisticKey(int item)
+{
+    return StatisticKeys[item];
+}
+
+QColor OverlaySettings::backgroundFill() const
+{
+    QColor color = backgroundColor;
+    color.setAlpha(backgroundOpacity);
+    return color;
+}
+
+OverlaySettings OverlaySettings::load()
+{
+    QSettings s;
+    OverlaySettings settings;
+
+    settings.layoutOrientation = s.value("appearance/layoutOrientation", "Vertical").toString();
+    settings.renderer = s.value("appearance/renderer", "Widgets").toString();
+    settings.fontSize = s.value("appearance/fontSize", 11).toInt();
+    settings.fontColor = s.value("appearance/fontColor", QColor(Qt::white)).value<QColor>();
+    settings.backgroundColor = s.value("appearance/backgroundColor", QColor(Qt::black)).value<QColor>();
+    settings.backgroundOpacity = s.value("appearance/backgroundOpacity", 120).toInt();
+    settings.showSparklines = s.value("appearance/showSparklines", false).toBool();
+
+    for (int i = 0; i < DisplayItemCount; ++i) {
+        settings.display[i] = s.value(DisplayKeys[i], DisplayDefaults[i]).toBool();
+        if (StatisticKeys[i]) {
+            const QByteArray name = s.value(StatisticKeys[i], "latest").toString().toLatin1();
+            settings.statistics.statistic[static_cast<int>(StatisticMetrics[i])] = metricStatisticFromName(name.constData());
+        }
+    }
+    settings.statistics.averageSeconds = s.value("statistics/averageSeconds", 3.0).toDouble();
+    settings.statistics.windowSeconds = s.value("statistics/windowSeconds", 60).toInt();
+    settings.statistics.peakHoldSeconds = s.value("statistics/peakHoldSeconds", 5).toInt();
+
+    settings.sampler = SamplerSettings::load();
+
+    settings.windowPos = s.value("window/pos", QPoint(100, 100)).toPoint();
+    return settings;
+}
+
+SettingsStore::SettingsStore()
+    : m_current(std::make_shared<const OverlaySettings>(OverlaySettings::load()))
+{
+}
+
+SettingsStore* SettingsStore::instance()
+{
+    static SettingsStore* store = new SettingsStore();
+    return store;
+}
+
+std::shared_ptr<const OverlaySettings> SettingsStore::current()
+{
+    return std::atomic_load(&instance()->m_current);
+}
+
+void SettingsStore::reload()
+{
+    auto next = std::make_shared<const OverlaySettings>(OverlaySettings::load());
+    auto previous = std::atomic_exchange(&m_current, std::shared_ptr<const OverlaySettings>(next));
+
+    Groups groups = diff(*previous, *next);
+    if (groups) {
+        emit changed(groups);
+    }
+}
+
+void SettingsStore::setWindowPosition(const QPoint& pos)
+{
+    QSettings s;
+    s.setValue("window/pos", pos);
+
+    auto next = std::make_shared<OverlaySettings>(*current());
+    next->windowPos = pos;
+    std::atomic_store(&m_current, std::shared_ptr<const OverlaySettings>(std::move(next)));
+}
+
+SettingsStore::Groups SettingsStore::diff(const OverlaySettings& before, const OverlaySettings& after)
+{
+    Groups groups;
+    if (before.renderer != after.renderer || before.fontSize != after.fontSize ||
+        before.fontColor != after.fontColor || before.backgroundColor != after.backgroundColor ||
+        before.backgroundOpacity != after.backgroundOpacity || before.showSparklines != after.showSparklines) {
+        groups |= AppearanceGroup;
+    }
+    if (before.layoutOrientation != after.layoutOrientation) {
+        groups |= LayoutGroup;
+    }
+    for (int i = 0; i < OverlaySettings::DisplayItemCount; ++i) {
+        if (before.display[i] != after.display[i]) {
+            groups |= DisplayGroup;
+            break;
+        }
+    }
+    if (before.statistics != after.statistics) {
+        groups |= DisplayGroup;
+    }
+    const SamplerSettings& a = before.sampler;
+    const SamplerSettings& b = after.sampler;
+    if (a.updateInterval != b.updateInterval || a.historyMinutes != b.historyMinutes ||
+        a.adaptiveSampling != b.adaptiveSampling || a.minInterval != b.minInterval || a.maxInterval != b.maxInterval ||
+        a.alertRules != b.alertRules) {
+        groups |= BehaviorGroup;
+    }
+    if (a.sensorHelperPath != b.sensorHelperPath || a.sensorStreaming != b.sensorStreaming ||
+        a.sensorTransport != b.sensorTransport || a.frameSource != b.frameSource) {
+        groups |= SensorsGroup;
+    }
+    if (a.exporterEnabled != b.exporterEnabled || a.exporterPort != b.exporterPort) {
+        groups |= ExporterGroup;
+    }
+    if (a.recordingPath != b.recordingPath || a.playbackPath != b.playbackPath || a.playbackSpeed != b.playbackSpeed) {
+        groups |= RecordingGroup;
+    }
+    if (before.windowPos != after.windowPos) {
+        groups |= WindowGroup;
+    }
+    return groups;
+}
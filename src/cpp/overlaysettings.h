@@ -0,0 +1,90 @@
+#ifndef OVERLAYSETTINGS_H
+#define OVERLAYSETTINGS_H
+
+#include <QObject>
+#include <QColor>
+#include <QPoint>
+#include <QString>
+#include <memory>
+#include "samplersettings.h"
+#include "metricstatistics.h"
+
+// Typed, immutable copy of everything the overlay reads from QSettings. Loaded once and
+// shared by pointer, so paint and poll paths never touch the registry or the INI file.
+struct OverlaySettings {
+    static constexpr int DisplayItemCount = 17;
+
+    // Appearance
+    QString layoutOrientation = "Vertical";
+    QString renderer = "Widgets";
+    int fontSize = 11;
+    QColor fontColor = Qt::white;
+    QColor backgroundColor = Qt::black;
+    int backgroundOpacity = 120;
+    bool showSparklines = false;
+
+    // Display, in overlay row order (see displayKey())
+    bool display[DisplayItemCount] = {};
+    // What each row shows of its metric (see statisticMetric())
+    MetricStatisticsConfig statistics;
+
+    // Behavior and sensors
+    SamplerSettings sampler;
+
+    // Window
+    QPoint windowPos = QPoint(100, 100);
+
+    bool horizontal() const { return layoutOrientation == "Horizontal"; }
+    QColor backgroundFill() const;
+
+    static const char* displayKey(int item);
+    static bool displayDefault(int item);
+    // Metric whose statistic a row can show, and where the choice is stored. Metric::Count
+    // and nullptr for rows a statistic makes no sense for (totals, counters, process lists).
+    static Metric statisticMetric(int item);
+    static const char* statisticKey(int item);
+    static OverlaySettings load();
+};
+
+// Owns the current OverlaySettings snapshot. Readers on any thread grab the pointer with
+// current(); reload() re-reads QSettings once, swaps the pointer atomically and tells
+// subscribers which groups of keys actually changed.
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+public:
+    enum Group {
+        AppearanceGroup = 0x01,
+        LayoutGroup = 0x02,
+        DisplayGroup = 0x04,
+        BehaviorGroup = 0x08,
+        WindowGroup = 0x10,
+        SensorsGroup = 0x20,
+        ExporterGroup = 0x40,
+        RecordingGroup = 0x80,
+        AllGroups = 0xff
+    };
+    Q_DECLARE_FLAGS(Groups, Group)
+    Q_FLAG(Groups)
+
+    static SettingsStore* instance();
+    static std::shared_ptr<const OverlaySettings> current();
+
+    void reload();
+    // Persists a dragged window position without notifying anyone
+    void setWindowPosition(const QPoint& pos);
+
+signals:
+    void changed(SettingsStore::Groups groups);
+
+private:
+    SettingsStore();
+
+    static Groups diff(const OverlaySettings& before, const OverlaySettings& after);
+
+    std::shared_ptr<const OverlaySettings> m_current;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(SettingsStore::Groups)
+
+#endif // OVERLAYSETTINGS_H
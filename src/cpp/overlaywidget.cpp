@@ -1,5 +1,9 @@
 #include "overlaywidget.h"
 #include "settingsdialog.h"
+#include "sparkline.h"
+#include "heatstrip.h"
+#include "metricpanel.h"
+#include "instrumentation.h"
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -8,23 +12,65 @@
 #include <QGraphicsDropShadowEffect>
 #include <QMenu>
 #include <QApplication>
-#include <QSettings>
 #include <QPainter>
 #include <QStyle>
 #include <QPixmap>
+#include <QVector>
+#include <QWindow>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
 
+namespace {
+
+// What each row is drawn from; the overlay's own usage needs no group
+const MetricGroups RowMetricGroups[] = {
+    metricGroupBit(MetricGroup::Cpu), metricGroupBit(MetricGroup::Memory), metricGroupBit(MetricGroup::Memory),
+    metricGroupBit(MetricGroup::Disk), metricGroupBit(MetricGroup::Gpu), metricGroupBit(MetricGroup::Frames),
+    metricGroupBit(MetricGroup::Network), metricGroupBit(MetricGroup::Network), metricGroupBit(MetricGroup::Network),
+    metricGroupBit(MetricGroup::Temperatures), metricGroupBit(MetricGroup::Temperatures),
+    metricGroupBit(MetricGroup::Processes), metricGroupBit(MetricGroup::Uptime), 0,
+    metricGroupBit(MetricGroup::TopProcesses), metricGroupBit(MetricGroup::TopProcesses),
+    metricGroupBit(MetricGroup::CpuCores)
+};
+
+constexpr quint32 metricBit(Metric metric)
+{
+    return quint32(1) << static_cast<int>(metric);
+}
+
+// Metrics whose alert rules recolor each row
+const quint32 RowAlertMetrics[] = {
+    metricBit(Metric::CpuLoad), metricBit(Metric::MemUsage), metricBit(Metric::MemUsage) | metricBit(Metric::AvailRam),
+    metricBit(Metric::DiskLoad), metricBit(Metric::GpuLoad),
+    metricBit(Metric::Fps) | metricBit(Metric::FpsLow1Percent) | metricBit(Metric::FrameTimeP50) | metricBit(Metric::FrameTimeP99),
+    metricBit(Metric::NetworkDownload), metricBit(Metric::NetworkUpload), metricBit(Metric::DailyDataUsage),
+    metricBit(Metric::CpuTemp), metricBit(Metric::GpuTemp), metricBit(Metric::ActiveProcesses),
+    metricBit(Metric::SystemUptime), metricBit(Metric::SelfCpu) | metricBit(Metric::SelfMemory), 0, 0,
+    metricBit(Metric::CpuCoreMax) | metricBit(Metric::CpuFrequency) | metricBit(Metric::CpuFrequencyMax)
+};
+
+// Text colour of a row with a firing alert
+const QColor AlertColor(255, 80, 64);
+
+} // namespace
+
 OverlayWidget::OverlayWidget(QWidget *parent)
     : QWidget(parent)
+    , m_showSparklines(false)
+    , m_coreStrip(nullptr)
+    , m_panel(nullptr)
+    , m_paintedRenderer(false)
+    , m_alertRows(0)
+    , m_statsPending(false)
 {
     // Make the window frameless, always on top, and transparent
     setWindowFlags(Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::Tool);
     setAttribute(Qt::WA_TranslucentBackground);
 
-    m_monitor = new SysInfoMonitor(this);
+    m_settings = SettingsStore::current();
+    m_monitor = new SysInfoMonitor(m_settings->sampler, this);
 
     setupUi();
     createIcons();
@@ -32,6 +78,7 @@ OverlayWidget::OverlayWidget(QWidget *parent)
     loadSettings();
 
     connect(m_monitor, &SysInfoMonitor::statsUpdated, this, &OverlayWidget::updateStats, Qt::QueuedConnection);
+    connect(SettingsStore::instance(), &SettingsStore::changed, this, &OverlayWidget::loadSettings);
     m_monitor->start();
 }
 
@@ -53,6 +100,17 @@ void OverlayWidget::setupUi()
     m_gpuTempLabel = new QLabel("GPU°: ...", this);
     m_processesLabel = new QLabel("Proc: ...", this);
     m_uptimeLabel = new QLabel("Up: ...", this);
+    m_selfLabel = new QLabel("Self: ...", this);
+    m_topCpuLabel = new QLabel("Top CPU: ...", this);
+    m_topMemLabel = new QLabel("Top MEM: ...", this);
+    m_coresLabel = new QLabel("Cores: ...", this);
+
+    m_rowLabels = {
+        m_cpuLabel, m_memLabel, m_ramLabel, m_diskLabel, m_gpuLabel,
+        m_fpsLabel, m_netDownLabel, m_netUpLabel, m_dailyDataLabel,
+        m_cpuTempLabel, m_gpuTempLabel, m_processesLabel, m_uptimeLabel, m_selfLabel,
+        m_topCpuLabel, m_topMemLabel, m_coresLabel
+    };
     
     // Initialize container widgets to nullptr
     m_cpuWidget = nullptr;
@@ -68,13 +126,16 @@ void OverlayWidget::setupUi()
     m_gpuTempWidget = nullptr;
     m_processesWidget = nullptr;
     m_uptimeWidget = nullptr;
+    m_selfWidget = nullptr;
+    m_topCpuWidget = nullptr;
+    m_topMemWidget = nullptr;
+    m_coresWidget = nullptr;
 }
 
 void OverlayWidget::createIcons()
 {
     // Create simple colored icons using Qt's built-in shapes
-    QSettings s;
-    QColor fontColor = s.value("appearance/fontColor", QColor(Qt::white)).value<QColor>();
+    const QColor& fontColor = m_settings->fontColor;
     
     // Original icons
     m_cpuIcon = createColoredIcon(":/icons/cpu.svg", fontColor);
@@ -92,6 +153,10 @@ void OverlayWidget::createIcons()
     m_gpuTempIcon = createColoredIcon(":/icons/temp.svg", fontColor);
     m_processesIcon = createColoredIcon(":/icons/processes.svg", fontColor);
     m_uptimeIcon = createColoredIcon(":/icons/uptime.svg", fontColor);
+    m_selfIcon = createColoredIcon(":/icons/self.svg", fontColor);
+    m_topCpuIcon = createColoredIcon(":/icons/topcpu.svg", fontColor);
+    m_topMemIcon = createColoredIcon(":/icons/topmem.svg", fontColor);
+    m_coresIcon = createColoredIcon(":/icons/cores.svg", fontColor);
 }
 
 QPixmap OverlayWidget::createColoredIcon(const QString& iconPath, const QColor& color, const QSize& size)
@@ -180,6 +245,27 @@ QPixmap OverlayWidget::createColoredIcon(const QString& iconPath, const QColor&
         painter.drawLine(8, 8, 8, 5); // Hour hand
         painter.drawLine(8, 8, 11, 8); // Minute hand
         painter.drawPoint(8, 8); // Center
+    } else if (iconPath.contains("self")) {
+        // Own usage - gauge
+        painter.drawArc(2, 3, 12, 12, 0, 180 * 16);
+        painter.drawLine(2, 9, 14, 9);
+        painter.drawLine(8, 9, 11, 5); // Needle
+    } else if (iconPath.contains("topcpu")) {
+        // Busiest processes - descending bars
+        painter.drawRect(2, 3, 12, 2);
+        painter.drawRect(2, 7, 8, 2);
+        painter.drawRect(2, 11, 4, 2);
+    } else if (iconPath.contains("topmem")) {
+        // Largest processes - stacked blocks, biggest at the bottom
+        painter.drawRect(6, 2, 4, 3);
+        painter.drawRect(4, 6, 8, 3);
+        painter.drawRect(2, 10, 12, 4);
+    } else if (iconPath.contains("cores")) {
+        // Per-core load - a grid of cells
+        painter.drawRect(2, 2, 5, 5);
+        painter.drawRect(9, 2, 5, 5);
+        painter.drawRect(2, 9, 5, 5);
+        painter.drawRect(9, 9, 5, 5);
     }
 
     return pixmap;
@@ -188,8 +274,7 @@ QPixmap OverlayWidget::createColoredIcon(const QString& iconPath, const QColor&
 void OverlayWidget::createLayout()
 {
     // Create the layout and container widgets ONCE
-    QSettings s;
-    QString orientation = s.value("appearance/layoutOrientation", "Vertical").toString();
+    QString orientation = m_settings->layoutOrientation;
     
     QBoxLayout* mainLayout;
     if (orientation == "Horizontal") {
@@ -202,7 +287,7 @@ void OverlayWidget::createLayout()
     mainLayout->setContentsMargins(5, 2, 5, 2);
 
     // Create horizontal layouts for each metric with icon + text
-    auto createMetricLayout = [this, orientation](QLabel* label, const QPixmap& icon) -> QWidget* {
+    auto createMetricLayout = [this, orientation](QLabel* label, const QPixmap& icon, bool percent = false) -> QWidget* {
         QWidget* widget = new QWidget(this);
         QHBoxLayout* layout = new QHBoxLayout(widget);
         layout->setContentsMargins(0, 0, 0, 0);
@@ -213,8 +298,16 @@ void OverlayWidget::createLayout()
         iconLabel->setFixedSize(16, 16);
         iconLabel->setScaledContents(true);
         
+        SparklineWidget* sparkline = new SparklineWidget(widget);
+        if (percent) {
+            sparkline->sparkline().setFixedRange(0.0, 100.0);
+        }
+        sparkline->setVisible(false);
+        m_sparklines.append(sparkline);
+
         layout->addWidget(iconLabel);
         layout->addWidget(label);
+        layout->addWidget(sparkline);
         
         // Only add stretch in horizontal orientation to prevent icons from spreading out
         if (orientation == "Horizontal") {
@@ -225,11 +318,11 @@ void OverlayWidget::createLayout()
     };
 
     // Create container widgets for original metrics
-    m_cpuWidget = createMetricLayout(m_cpuLabel, m_cpuIcon);
-    m_memWidget = createMetricLayout(m_memLabel, m_memIcon);
+    m_cpuWidget = createMetricLayout(m_cpuLabel, m_cpuIcon, true);
+    m_memWidget = createMetricLayout(m_memLabel, m_memIcon, true);
     m_ramWidget = createMetricLayout(m_ramLabel, m_ramIcon);
-    m_diskWidget = createMetricLayout(m_diskLabel, m_diskIcon);
-    m_gpuWidget = createMetricLayout(m_gpuLabel, m_gpuIcon);
+    m_diskWidget = createMetricLayout(m_diskLabel, m_diskIcon, true);
+    m_gpuWidget = createMetricLayout(m_gpuLabel, m_gpuIcon, true);
     
     // Create container widgets for new metrics
     m_fpsWidget = createMetricLayout(m_fpsLabel, m_fpsIcon);
@@ -240,6 +333,14 @@ void OverlayWidget::createLayout()
     m_gpuTempWidget = createMetricLayout(m_gpuTempLabel, m_gpuTempIcon);
     m_processesWidget = createMetricLayout(m_processesLabel, m_processesIcon);
     m_uptimeWidget = createMetricLayout(m_uptimeLabel, m_uptimeIcon);
+    m_selfWidget = createMetricLayout(m_selfLabel, m_selfIcon);
+    m_topCpuWidget = createMetricLayout(m_topCpuLabel, m_topCpuIcon);
+    m_topMemWidget = createMetricLayout(m_topMemLabel, m_topMemIcon);
+    m_coresWidget = createMetricLayout(m_coresLabel, m_coresIcon, true);
+
+    // The heat strip goes between the cores row's text and its sparkline
+    m_coreStrip = new HeatStripWidget(m_coresWidget);
+    static_cast<QHBoxLayout*>(m_coresWidget->layout())->insertWidget(2, m_coreStrip);
     
     // Store references to icon labels for later updates
     m_cpuIconLabel = m_cpuWidget->findChild<QLabel*>();
@@ -255,6 +356,24 @@ void OverlayWidget::createLayout()
     m_gpuTempIconLabel = m_gpuTempWidget->findChild<QLabel*>();
     m_processesIconLabel = m_processesWidget->findChild<QLabel*>();
     m_uptimeIconLabel = m_uptimeWidget->findChild<QLabel*>();
+    m_selfIconLabel = m_selfWidget->findChild<QLabel*>();
+    m_topCpuIconLabel = m_topCpuWidget->findChild<QLabel*>();
+    m_topMemIconLabel = m_topMemWidget->findChild<QLabel*>();
+    m_coresIconLabel = m_coresWidget->findChild<QLabel*>();
+
+    m_rowWidgets = {
+        m_cpuWidget, m_memWidget, m_ramWidget, m_diskWidget, m_gpuWidget,
+        m_fpsWidget, m_netDownWidget, m_netUpWidget, m_dailyDataWidget,
+        m_cpuTempWidget, m_gpuTempWidget, m_processesWidget, m_uptimeWidget, m_selfWidget,
+        m_topCpuWidget, m_topMemWidget, m_coresWidget
+    };
+
+    // The painted renderer draws all rows in one widget; hidden until selected
+    m_panel = new MetricPanel(RowCount, this);
+    for (int row : {CpuRow, MemRow, DiskRow, GpuRow, CoresRow}) {
+        m_panel->rowSparkline(row).setFixedRange(0.0, 100.0);
+    }
+    m_panel->hide();
 
     // Add widgets to layout
     mainLayout->addWidget(m_cpuWidget);
@@ -270,97 +389,168 @@ void OverlayWidget::createLayout()
     mainLayout->addWidget(m_gpuTempWidget);
     mainLayout->addWidget(m_processesWidget);
     mainLayout->addWidget(m_uptimeWidget);
+    mainLayout->addWidget(m_selfWidget);
+    mainLayout->addWidget(m_topCpuWidget);
+    mainLayout->addWidget(m_topMemWidget);
+    mainLayout->addWidget(m_coresWidget);
+    mainLayout->addWidget(m_panel);
 }
 
-void OverlayWidget::loadSettings()
+void OverlayWidget::loadSettings(SettingsStore::Groups groups)
 {
-    QSettings s;
+    m_settings = SettingsStore::current();
+    const OverlaySettings& s = *m_settings;
 
-    // Restore position
-    move(s.value("window/pos", QPoint(100, 100)).toPoint());
+    if (groups & SettingsStore::WindowGroup) {
+        // Restore position
+        move(s.windowPos);
+    }
 
-    // Recreate icons with current color
-    createIcons();
-    
-    // Update icon labels with new icons
-    if (m_cpuIconLabel) m_cpuIconLabel->setPixmap(m_cpuIcon);
-    if (m_memIconLabel) m_memIconLabel->setPixmap(m_memIcon);
-    if (m_ramIconLabel) m_ramIconLabel->setPixmap(m_ramIcon);
-    if (m_diskIconLabel) m_diskIconLabel->setPixmap(m_diskIcon);
-    if (m_gpuIconLabel) m_gpuIconLabel->setPixmap(m_gpuIcon);
-    if (m_fpsIconLabel) m_fpsIconLabel->setPixmap(m_fpsIcon);
-    if (m_netDownIconLabel) m_netDownIconLabel->setPixmap(m_netDownIcon);
-    if (m_netUpIconLabel) m_netUpIconLabel->setPixmap(m_netUpIcon);
-    if (m_dailyDataIconLabel) m_dailyDataIconLabel->setPixmap(m_dailyDataIcon);
-    if (m_cpuTempIconLabel) m_cpuTempIconLabel->setPixmap(m_cpuTempIcon);
-    if (m_gpuTempIconLabel) m_gpuTempIconLabel->setPixmap(m_gpuTempIcon);
-    if (m_processesIconLabel) m_processesIconLabel->setPixmap(m_processesIcon);
-    if (m_uptimeIconLabel) m_uptimeIconLabel->setPixmap(m_uptimeIcon);
-
-    // Apply appearance settings to labels
-    int fontSize = s.value("appearance/fontSize", 11).toInt();
-    QColor fontColor = s.value("appearance/fontColor", QColor(Qt::white)).value<QColor>();
-    QString labelStyle = QString("QLabel { color: %1; font-size: %2px; font-weight: bold; }")
-                             .arg(fontColor.name(QColor::HexRgb), QString::number(fontSize));
-
-    // Apply styles to all text labels
-    QList<QLabel*> allLabels = {
-        m_cpuLabel, m_memLabel, m_ramLabel, m_diskLabel, m_gpuLabel,
-        m_fpsLabel, m_netDownLabel, m_netUpLabel, m_dailyDataLabel,
-        m_cpuTempLabel, m_gpuTempLabel, m_processesLabel, m_uptimeLabel
-    };
-    
-    for (auto* label : allLabels) {
-        label->setStyleSheet(labelStyle);
-    }
-
-    // Apply shadow effects to all text labels
-    for (auto* label : allLabels) {
-        auto* effect = new QGraphicsDropShadowEffect();
-        effect->setBlurRadius(8);
-        effect->setColor(QColor(0, 0, 0, 220));
-        effect->setOffset(0, 0);
-        label->setGraphicsEffect(effect);
-    }
-
-    // Apply visibility settings
-    if (m_cpuWidget) m_cpuWidget->setVisible(s.value("display/showCpu", true).toBool());
-    if (m_memWidget) m_memWidget->setVisible(s.value("display/showMem", true).toBool());
-    if (m_ramWidget) m_ramWidget->setVisible(s.value("display/showRam", true).toBool());
-    if (m_diskWidget) m_diskWidget->setVisible(s.value("display/showDisk", true).toBool());
-    if (m_gpuWidget) m_gpuWidget->setVisible(s.value("display/showGpu", true).toBool());
-    if (m_fpsWidget) m_fpsWidget->setVisible(s.value("display/showFps", false).toBool());
-    if (m_netDownWidget) m_netDownWidget->setVisible(s.value("display/showNetDown", false).toBool());
-    if (m_netUpWidget) m_netUpWidget->setVisible(s.value("display/showNetUp", false).toBool());
-    if (m_dailyDataWidget) m_dailyDataWidget->setVisible(s.value("display/showDailyData", false).toBool());
-    if (m_cpuTempWidget) m_cpuTempWidget->setVisible(s.value("display/showCpuTemp", false).toBool());
-    if (m_gpuTempWidget) m_gpuTempWidget->setVisible(s.value("display/showGpuTemp", false).toBool());
-    if (m_processesWidget) m_processesWidget->setVisible(s.value("display/showProcesses", false).toBool());
-    if (m_uptimeWidget) m_uptimeWidget->setVisible(s.value("display/showUptime", false).toBool());
-
-    // Check if layout orientation has changed
-    QString currentOrientation = s.value("appearance/layoutOrientation", "Vertical").toString();
-    QBoxLayout* currentLayout = qobject_cast<QBoxLayout*>(layout());
-    bool isHorizontal = qobject_cast<QHBoxLayout*>(currentLayout) != nullptr;
-    bool shouldBeHorizontal = (currentOrientation == "Horizontal");
-    
-    if (isHorizontal != shouldBeHorizontal) {
-        // Layout orientation changed, need to recreate
-        updateLayoutOrientation();
+    bool painted = s.renderer == "Painted";
+
+    if (groups & SettingsStore::AppearanceGroup) {
+        // Recreate icons with current color
+        createIcons();
+
+        // Update icon labels with new icons
+        if (m_cpuIconLabel) m_cpuIconLabel->setPixmap(m_cpuIcon);
+        if (m_memIconLabel) m_memIconLabel->setPixmap(m_memIcon);
+        if (m_ramIconLabel) m_ramIconLabel->setPixmap(m_ramIcon);
+        if (m_diskIconLabel) m_diskIconLabel->setPixmap(m_diskIcon);
+        if (m_gpuIconLabel) m_gpuIconLabel->setPixmap(m_gpuIcon);
+        if (m_fpsIconLabel) m_fpsIconLabel->setPixmap(m_fpsIcon);
+        if (m_netDownIconLabel) m_netDownIconLabel->setPixmap(m_netDownIcon);
+        if (m_netUpIconLabel) m_netUpIconLabel->setPixmap(m_netUpIcon);
+        if (m_dailyDataIconLabel) m_dailyDataIconLabel->setPixmap(m_dailyDataIcon);
+        if (m_cpuTempIconLabel) m_cpuTempIconLabel->setPixmap(m_cpuTempIcon);
+        if (m_gpuTempIconLabel) m_gpuTempIconLabel->setPixmap(m_gpuTempIcon);
+        if (m_processesIconLabel) m_processesIconLabel->setPixmap(m_processesIcon);
+        if (m_uptimeIconLabel) m_uptimeIconLabel->setPixmap(m_uptimeIcon);
+        if (m_selfIconLabel) m_selfIconLabel->setPixmap(m_selfIcon);
+        if (m_topCpuIconLabel) m_topCpuIconLabel->setPixmap(m_topCpuIcon);
+        if (m_topMemIconLabel) m_topMemIconLabel->setPixmap(m_topMemIcon);
+        if (m_coresIconLabel) m_coresIconLabel->setPixmap(m_coresIcon);
+
+        const QPixmap rowIcons[RowCount] = {
+            m_cpuIcon, m_memIcon, m_ramIcon, m_diskIcon, m_gpuIcon, m_fpsIcon, m_netDownIcon,
+            m_netUpIcon, m_dailyDataIcon, m_cpuTempIcon, m_gpuTempIcon, m_processesIcon, m_uptimeIcon,
+            m_selfIcon, m_topCpuIcon, m_topMemIcon, m_coresIcon
+        };
+        for (int i = 0; i < RowCount; ++i) {
+            m_panel->setRowIcon(i, rowIcons[i]);
+        }
+
+        // Apply appearance settings to labels
+        // Alerting rows only flip the "alert" property, see setRowAlert()
+        QString labelStyle = QString("QLabel { color: %1; font-size: %2px; font-weight: bold; } "
+                                     "QLabel[alert=\"true\"] { color: %3; }")
+                                 .arg(s.fontColor.name(QColor::HexRgb), QString::number(s.fontSize),
+                                      AlertColor.name(QColor::HexRgb));
+
+        // Apply styles to all text labels
+        for (auto* label : m_rowLabels) {
+            label->setStyleSheet(labelStyle);
+            fitRowLabel(label);
+        }
+
+        // Apply shadow effects to all text labels. The effect only depends on constants, so it
+        // is installed once rather than every time settings are applied.
+        for (auto* label : m_rowLabels) {
+            if (label->graphicsEffect()) {
+                continue;
+            }
+            auto* effect = new QGraphicsDropShadowEffect();
+            effect->setBlurRadius(8);
+            effect->setColor(QColor(0, 0, 0, 220));
+            effect->setOffset(0, 0);
+            label->setGraphicsEffect(effect);
+        }
+
+        for (auto* sparkline : m_sparklines) {
+            sparkline->sparkline().setColor(s.fontColor);
+        }
+    }
+
+    if (groups & (SettingsStore::AppearanceGroup | SettingsStore::LayoutGroup)) {
+        QFont panelFont = font();
+        panelFont.setPixelSize(s.fontSize);
+        panelFont.setBold(true);
+        m_panel->setAppearance(panelFont, s.fontColor, AlertColor, s.horizontal());
+    }
+
+    if (groups & (SettingsStore::AppearanceGroup | SettingsStore::DisplayGroup)) {
+        // Apply visibility settings
+        for (int i = 0; i < RowCount; ++i) {
+            m_rowWidgets[i]->setVisible(s.display[i] && !painted);
+            m_panel->setRowVisible(i, s.display[i]);
+        }
+        m_panel->setVisible(painted);
+    }
+
+    if (groups & SettingsStore::DisplayGroup) {
+        m_monitor->setStatistics(s.statistics);
     }
 
-    // Behavior
-    // The update interval is now handled by the SysInfoMonitor itself
+    if (groups & SettingsStore::AppearanceGroup) {
+        // Sparklines
+        for (auto* sparkline : m_sparklines) {
+            sparkline->setVisible(s.showSparklines);
+        }
+        m_panel->setSparklinesVisible(s.showSparklines);
+        bool rendererChanged = painted != m_paintedRenderer;
+        m_paintedRenderer = painted;
+        if (rendererChanged) {
+            // The other renderer still shows whatever it showed when it was last active
+            m_formatter.invalidate();
+        }
+        if (s.showSparklines && (!m_showSparklines || rendererChanged)) {
+            seedSparklines();
+        }
+        m_showSparklines = s.showSparklines;
+    }
+
+    if (groups & SettingsStore::LayoutGroup) {
+        // Check if layout orientation has changed
+        QBoxLayout* currentLayout = qobject_cast<QBoxLayout*>(layout());
+        bool isHorizontal = qobject_cast<QHBoxLayout*>(currentLayout) != nullptr;
+
+        if (isHorizontal != s.horizontal()) {
+            // Layout orientation changed, need to recreate
+            updateLayoutOrientation();
+        }
+    }
+
+    if (groups & (SettingsStore::DisplayGroup | SettingsStore::BehaviorGroup | SettingsStore::SensorsGroup |
+                  SettingsStore::ExporterGroup | SettingsStore::RecordingGroup)) {
+        SamplerSettings sampler = s.sampler;
+        sampler.metricGroups = metricGroups(s);
+        m_monitor->setSettings(sampler);
+    }
 
     adjustSize();
     update(); // Trigger a repaint
 }
 
+MetricGroups OverlayWidget::metricGroups(const OverlaySettings& s) const
+{
+    static_assert(sizeof(RowMetricGroups) / sizeof(RowMetricGroups[0]) == RowCount, "one group mask per row");
+    MetricGroups groups = 0;
+    // The exporter and recordings publish every metric, shown or not
+    if (s.sampler.exporterEnabled || !s.sampler.recordingPath.isEmpty()) {
+        groups = MetricSetGroups;
+    }
+    for (int i = 0; i < RowCount; ++i) {
+        if (s.display[i]) {
+            groups |= RowMetricGroups[i];
+        }
+    }
+    return groups;
+}
+
 void OverlayWidget::updateLayoutOrientation()
 {
     // Only recreate layout if orientation actually changed
-    QSettings s;
-    QString orientation = s.value("appearance/layoutOrientation", "Vertical").toString();
+    QString orientation = m_settings->layoutOrientation;
     
     // Remove widgets from current layout
     if (layout()) {
@@ -377,6 +567,11 @@ void OverlayWidget::updateLayoutOrientation()
         layout()->removeWidget(m_gpuTempWidget);
         layout()->removeWidget(m_processesWidget);
         layout()->removeWidget(m_uptimeWidget);
+        layout()->removeWidget(m_selfWidget);
+        layout()->removeWidget(m_topCpuWidget);
+        layout()->removeWidget(m_topMemWidget);
+        layout()->removeWidget(m_coresWidget);
+        layout()->removeWidget(m_panel);
         delete layout();
     }
     
@@ -405,11 +600,103 @@ void OverlayWidget::updateLayoutOrientation()
     newLayout->addWidget(m_gpuTempWidget);
     newLayout->addWidget(m_processesWidget);
     newLayout->addWidget(m_uptimeWidget);
+    newLayout->addWidget(m_selfWidget);
+    newLayout->addWidget(m_topCpuWidget);
+    newLayout->addWidget(m_topMemWidget);
+    newLayout->addWidget(m_coresWidget);
+    newLayout->addWidget(m_panel);
+}
+
+void OverlayWidget::seedSparklines()
+{
+    // Fill the graphs from the monitor's history so they don't start out empty
+    const MetricHistory& history = m_monitor->history();
+    const int width = rowSparkline(0).size().width();
+    QVector<float> values(width);
+    QVector<float> available(width);
+
+    // The top process rows have no history; Metric::Count leaves their graphs empty
+    const Metric rowMetrics[] = {
+        Metric::CpuLoad, Metric::MemUsage, Metric::TotalRam, Metric::DiskLoad, Metric::GpuLoad,
+        Metric::Fps, Metric::NetworkDownload, Metric::NetworkUpload, Metric::DailyDataUsage,
+        Metric::CpuTemp, Metric::GpuTemp, Metric::ActiveProcesses, Metric::SystemUptime, Metric::SelfCpu,
+        Metric::Count, Metric::Count, Metric::CpuCoreMax
+    };
+    for (int i = 0; i < RowCount; ++i) {
+        if (rowMetrics[i] == Metric::Count) {
+            rowSparkline(i).setSamples(values.constData(), 0);
+            continue;
+        }
+        int count = history.snapshot(rowMetrics[i], values.data(), nullptr, width);
+        if (rowMetrics[i] == Metric::TotalRam) {
+            // The RAM row shows used memory
+            int availableCount = history.snapshot(Metric::AvailRam, available.data(), nullptr, width);
+            count = qMin(count, availableCount);
+            for (int j = 0; j < count; ++j) {
+                values[j] -= available[j];
+            }
+        }
+        rowSparkline(i).setSamples(values.constData(), count);
+    }
+    if (m_paintedRenderer) {
+        m_panel->update();
+    } else {
+        for (auto* sparkline : m_sparklines) {
+            sparkline->update();
+        }
+    }
+}
+
+Sparkline& OverlayWidget::rowSparkline(int row)
+{
+    return m_paintedRenderer ? m_panel->rowSparkline(row) : m_sparklines[row]->sparkline();
+}
+
+void OverlayWidget::addRowSample(int row, double value)
+{
+    if (m_paintedRenderer) {
+        m_panel->addRowSample(row, value);
+    } else {
+        m_sparklines[row]->addSample(value);
+    }
+}
+
+void OverlayWidget::setRowText(MetricRow row, const QString& text)
+{
+    if (m_paintedRenderer) {
+        m_panel->setRowText(row, text);
+        return;
+    }
+    QLabel* label = m_rowLabels[row];
+    label->setText(text);
+    // With a fixed size, setText() does not invalidate the layout; it only has to be redone
+    // when the text no longer fits exactly
+    fitRowLabel(label);
+}
+
+void OverlayWidget::setRowAlert(int row, bool alert)
+{
+    // Both renderers, so switching between them never shows a stale colour. The label
+    // stylesheet already has the alert colour; re-polishing one label just applies it.
+    m_panel->setRowAlert(row, alert);
+    QLabel* label = m_rowLabels[row];
+    label->setProperty("alert", alert);
+    label->style()->unpolish(label);
+    label->style()->polish(label);
+}
+
+void OverlayWidget::fitRowLabel(QLabel* label)
+{
+    const QSize size = label->sizeHint();
+    if (label->minimumSize() != size || label->maximumSize() != size) {
+        label->setFixedSize(size);
+    }
 }
 
 void OverlayWidget::applySettings()
 {
-    loadSettings();
+    // Re-reads QSettings once; loadSettings() runs for the groups that actually changed
+    SettingsStore::instance()->reload();
 }
 
 void OverlayWidget::openSettingsDialog()
@@ -429,70 +716,91 @@ OverlayWidget::~OverlayWidget()
 
 void OverlayWidget::updateStats(const SysInfo &info)
 {
-    // Original metrics - use QString::number for better compatibility
-    m_cpuLabel->setText(QString("CPU: %1%").arg(QString::number(info.cpuLoad, 'f', 1)));
-    m_memLabel->setText(QString("MEM: %1%").arg(QString::number(info.memUsage)));
-    m_ramLabel->setText(QString("RAM: %1/%2 MB").arg(QString::number(info.totalRamMB - info.availRamMB)).arg(QString::number(info.totalRamMB)));
-    m_diskLabel->setText(QString("DSK: %1%").arg(QString::number(info.diskLoad, 'f', 1)));
-    m_gpuLabel->setText(QString("GPU: %1%").arg(QString::number(info.gpuLoad, 'f', 1)));
-
-    // Network metrics with better formatting
-    if (info.networkDownloadSpeed >= 1.0) {
-        m_netDownLabel->setText(QString("↓: %1 MB/s").arg(QString::number(info.networkDownloadSpeed, 'f', 2)));
-    } else if (info.networkDownloadSpeed >= 0.001) {
-        m_netDownLabel->setText(QString("↓: %1 KB/s").arg(QString::number(info.networkDownloadSpeed * 1024, 'f', 1)));
-    } else {
-        m_netDownLabel->setText("↓: 0.00 KB/s");
+    if (renderingPaused()) {
+        // Nobody would see it; keep the sample for when the overlay is shown again
+        m_pendingStats = info;
+        m_statsPending = true;
+        return;
     }
-    
-    if (info.networkUploadSpeed >= 1.0) {
-        m_netUpLabel->setText(QString("↑: %1 MB/s").arg(QString::number(info.networkUploadSpeed, 'f', 2)));
-    } else if (info.networkUploadSpeed >= 0.001) {
-        m_netUpLabel->setText(QString("↑: %1 KB/s").arg(QString::number(info.networkUploadSpeed * 1024, 'f', 1)));
-    } else {
-        m_netUpLabel->setText("↑: 0.00 KB/s");
+    renderStats(info, true);
+}
+
+bool OverlayWidget::renderingPaused() const
+{
+    // Not exposed covers windows that are fully occluded, on platforms that report it
+    const QWindow* window = windowHandle();
+    return !isVisible() || isMinimized() || !window || !window->isExposed();
+}
+
+void OverlayWidget::resumeRendering()
+{
+    if (!m_statsPending || renderingPaused()) {
+        return;
     }
-    
-    // Daily data usage with better formatting
-    if (info.dailyDataUsageMB >= 1024) {
-        m_dailyDataLabel->setText(QString("Daily: %1 GB").arg(QString::number(info.dailyDataUsageMB / 1024.0, 'f', 2)));
-    } else {
-        m_dailyDataLabel->setText(QString("Daily: %1 MB").arg(QString::number(info.dailyDataUsageMB, 'f', 0)));
+    m_statsPending = false;
+    renderStats(m_pendingStats, false);
+    // The graphs missed every sample while paused; the history has them
+    if (m_showSparklines) {
+        seedSparklines();
     }
-    
-    // Temperature readings
-    if (info.cpuTemp >= 0) {
-        m_cpuTempLabel->setText(QString("CPU°: %1°C").arg(QString::number(info.cpuTemp, 'f', 1)));
-    } else {
-        m_cpuTempLabel->setText("CPU°: N/A");
+}
+
+void OverlayWidget::renderStats(const SysInfo &info, bool addSparklineSamples)
+{
+    WINSYS_TRACE_SCOPE(UpdateStats);
+    static_assert(int(RowCount) == int(MetricFormatter::RowCount), "formatter rows must match the overlay rows");
+    // Only rows whose text changed are touched, so the rest are neither re-laid out nor repainted
+    const quint32 changed = m_formatter.format(info);
+    for (int row = 0; row < RowCount; ++row) {
+        if (changed & (1u << row)) {
+            setRowText(static_cast<MetricRow>(row), m_formatter.string(row));
+        }
     }
-    
-    if (info.gpuTemp >= 0) {
-        m_gpuTempLabel->setText(QString("GPU°: %1°C").arg(QString::number(info.gpuTemp, 'f', 1)));
-    } else {
-        m_gpuTempLabel->setText("GPU°: N/A");
+
+    static_assert(sizeof(RowAlertMetrics) / sizeof(RowAlertMetrics[0]) == RowCount, "one alert mask per row");
+    quint32 alertRows = 0;
+    for (int row = 0; row < RowCount; ++row) {
+        alertRows |= quint32((info.alertMetrics & RowAlertMetrics[row]) != 0) << row;
     }
-    
-    // Process count
-    m_processesLabel->setText(QString("Proc: %1").arg(QString::number(info.activeProcesses)));
-    
-    // System uptime with better formatting
-    if (info.systemUptime < 1) {
-        m_uptimeLabel->setText(QString("Up: %1m").arg(QString::number(info.systemUptime * 60, 'f', 0)));
-    } else if (info.systemUptime < 24) {
-        m_uptimeLabel->setText(QString("Up: %1h").arg(QString::number(info.systemUptime, 'f', 1)));
-    } else {
-        int days = static_cast<int>(info.systemUptime / 24);
-        double remainingHours = info.systemUptime - (days * 24);
-        if (remainingHours < 0.1) {
-            m_uptimeLabel->setText(QString("Up: %1d").arg(QString::number(days)));
+    if (alertRows != m_alertRows) {
+        for (int row = 0; row < RowCount; ++row) {
+            if ((alertRows ^ m_alertRows) & (1u << row)) {
+                setRowAlert(row, alertRows & (1u << row));
+            }
+        }
+        m_alertRows = alertRows;
+    }
+
+    // Repaints only when some core's rounded load changed
+    if (m_settings->display[CoresRow]) {
+        if (m_paintedRenderer) {
+            m_panel->setRowStrip(CoresRow, info.cpuCores.load, info.cpuCores.count);
         } else {
-            m_uptimeLabel->setText(QString("Up: %1d %2h").arg(QString::number(days)).arg(QString::number(remainingHours, 'f', 0)));
+            m_coreStrip->setLoads(info.cpuCores.load, info.cpuCores.count);
+        }
+    }
+
+    if (m_showSparklines && addSparklineSamples) {
+        const double rowValues[] = {
+            info.cpuLoad, static_cast<double>(info.memUsage), static_cast<double>(info.totalRamMB - info.availRamMB),
+            info.diskLoad, info.gpuLoad, info.fps, info.networkDownloadSpeed, info.networkUploadSpeed,
+            static_cast<double>(info.dailyDataUsageMB), info.cpuTemp, info.gpuTemp,
+            static_cast<double>(info.activeProcesses), info.systemUptime, info.selfCpuPercent,
+            info.topCpu[0].cpuPercent, info.topMemory[0].residentMB, info.cpuCoreMaxLoad
+        };
+        for (int i = 0; i < RowCount; ++i) {
+            addRowSample(i, rowValues[i]);
         }
     }
 
-    // FPS - placeholder for now
-    m_fpsLabel->setText("FPS: N/A");
+#if WINSYS_INSTRUMENTATION
+    // Do the relayout the new text asks for now rather than on the next event loop pass,
+    // so it can be timed on its own
+    if (isVisible() && layout()) {
+        WINSYS_TRACE_SCOPE(Layout);
+        layout()->activate();
+    }
+#endif
 
 #ifdef Q_OS_WIN
     // Periodically re-apply the HWND_TOPMOST flag
@@ -514,8 +822,7 @@ void OverlayWidget::mouseReleaseEvent(QMouseEvent *event)
 {
     // Save window position when done dragging
     if (event->button() == Qt::LeftButton) {
-        QSettings s;
-        s.setValue("window/pos", pos());
+        SettingsStore::instance()->setWindowPosition(pos());
     }
     QWidget::mouseReleaseEvent(event);
 }
@@ -523,16 +830,28 @@ void OverlayWidget::mouseReleaseEvent(QMouseEvent *event)
 void OverlayWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
-    QSettings s;
-    QColor bgColor = s.value("appearance/backgroundColor", QColor(Qt::black)).value<QColor>();
-    int opacity = s.value("appearance/backgroundOpacity", 120).toInt();
-    bgColor.setAlpha(opacity);
-
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
-    painter.setBrush(bgColor);
+    painter.setBrush(m_settings->backgroundFill());
     painter.setPen(Qt::NoPen);
     painter.drawRoundedRect(rect(), 5.0, 5.0);
+
+    // Being painted means being exposed again. Catch up outside the paint event.
+    if (m_statsPending) {
+        QMetaObject::invokeMethod(this, &OverlayWidget::resumeRendering, Qt::QueuedConnection);
+    }
+}
+
+bool OverlayWidget::event(QEvent *event)
+{
+#if WINSYS_INSTRUMENTATION
+    // An update request repaints the whole window, child labels and panel included
+    if (event->type() == QEvent::UpdateRequest) {
+        WINSYS_TRACE_SCOPE(Paint);
+        return QWidget::event(event);
+    }
+#endif
+    return QWidget::event(event);
 }
 
 void OverlayWidget::contextMenuEvent(QContextMenuEvent *event)
@@ -3,9 +3,16 @@
 
 #include <QWidget>
 #include <QPoint>
+#include <memory>
 #include "sysinfomonitor.h"
+#include "overlaysettings.h"
+#include "metricformatter.h"
 
 class QLabel;
+class SparklineWidget;
+class HeatStripWidget;
+class Sparkline;
+class MetricPanel;
 class QMouseEvent;
 class QContextMenuEvent;
 
@@ -25,6 +32,7 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    bool event(QEvent *event) override;
     void contextMenuEvent(QContextMenuEvent *event) override;
 
 private slots:
@@ -32,11 +40,28 @@ private slots:
     void applySettings();
 
 private:
-    void loadSettings();
+    // Metric rows in display order
+    enum MetricRow {
+        CpuRow, MemRow, RamRow, DiskRow, GpuRow, FpsRow, NetDownRow, NetUpRow,
+        DailyDataRow, CpuTempRow, GpuTempRow, ProcessesRow, UptimeRow, SelfRow,
+        TopCpuRow, TopMemRow, CoresRow, RowCount
+    };
+
+    void loadSettings(SettingsStore::Groups groups = SettingsStore::AllGroups);
+    MetricGroups metricGroups(const OverlaySettings& s) const;
+    void renderStats(const SysInfo& info, bool addSparklineSamples);
+    bool renderingPaused() const;
+    void resumeRendering();
     void setupUi();
     void createIcons();
     void createLayout();
     void updateLayoutOrientation();
+    void seedSparklines();
+    void setRowText(MetricRow row, const QString& text);
+    void setRowAlert(int row, bool alert);
+    void fitRowLabel(QLabel* label);
+    void addRowSample(int row, double value);
+    Sparkline& rowSparkline(int row);
     QPixmap createColoredIcon(const QString& iconPath, const QColor& color, const QSize& size = QSize(16, 16));
 
     // Original labels
@@ -55,8 +80,13 @@ private:
     QLabel *m_gpuTempLabel;
     QLabel *m_processesLabel;
     QLabel *m_uptimeLabel;
+    QLabel *m_selfLabel;
+    QLabel *m_topCpuLabel;
+    QLabel *m_topMemLabel;
+    QLabel *m_coresLabel;
     
     SysInfoMonitor *m_monitor;
+    std::shared_ptr<const OverlaySettings> m_settings;
     QPoint m_dragPosition;
     
     // Icon pixmaps
@@ -73,6 +103,10 @@ private:
     QPixmap m_gpuTempIcon;
     QPixmap m_processesIcon;
     QPixmap m_uptimeIcon;
+    QPixmap m_selfIcon;
+    QPixmap m_topCpuIcon;
+    QPixmap m_topMemIcon;
+    QPixmap m_coresIcon;
     
     // Container widgets for better management
     QWidget *m_cpuWidget;
@@ -88,6 +122,10 @@ private:
     QWidget *m_gpuTempWidget;
     QWidget *m_processesWidget;
     QWidget *m_uptimeWidget;
+    QWidget *m_selfWidget;
+    QWidget *m_topCpuWidget;
+    QWidget *m_topMemWidget;
+    QWidget *m_coresWidget;
     
     // Icon labels for updating icons
     QLabel *m_cpuIconLabel;
@@ -103,5 +141,34 @@ private:
     QLabel *m_gpuTempIconLabel;
     QLabel *m_processesIconLabel;
     QLabel *m_uptimeIconLabel;
+    QLabel *m_selfIconLabel;
+    QLabel *m_topCpuIconLabel;
+    QLabel *m_topMemIconLabel;
+    QLabel *m_coresIconLabel;
+
+    // The same rows and their containers, indexed by MetricRow
+    QList<QLabel*> m_rowLabels;
+    QList<QWidget*> m_rowWidgets;
+
+    // Optional trend graphs, one per metric row in layout order
+    QList<SparklineWidget*> m_sparklines;
+    bool m_showSparklines;
+
+    // Per-core heat strip of the cores row, after its text
+    HeatStripWidget *m_coreStrip;
+
+    // Single custom-painted alternative to the label widgets ("Painted" renderer)
+    MetricPanel *m_panel;
+    bool m_paintedRenderer;
+
+    // Row text of the latest sample, compared against the previous one
+    MetricFormatter m_formatter;
+
+    // Rows recolored for a firing alert, bit per MetricRow
+    quint32 m_alertRows;
+
+    // Latest sample that arrived while the overlay was hidden, minimized or occluded
+    SysInfo m_pendingStats;
+    bool m_statsPending;
 };
 #endif // OVERLAYWIDGET_H
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include "pdhcollector.h"
+#include <QString>
+#include <QVector>
+#include <algorithm>
+#include <cwchar>
+
+PdhCollector::PdhCollector()
+    : m_enabledGroups(AllMetricGroups)
+    , m_initialized(false)
+    , m_cpuQuery(nullptr)
+    , m_cpuTotalCounter(nullptr)
+    , m_diskQuery(nullptr)
+    , m_diskTotalCounter(nullptr)
+    , m_gpuQuery(nullptr)
+    , m_gpuEngines{ L"\\GPU Engine(*)\\Utilization Percentage", QStringList(), InstanceRegistry(), {} }
+    , m_networkQuery(nullptr)
+    , m_bytesReceived{ L"\\Network Interface(*)\\Bytes Received/sec", { "Loopback", "Teredo", "isatap" },
+                       InstanceRegistry(), {} }
+    , m_bytesSent{ L"\\Network Interface(*)\\Bytes Sent/sec", m_bytesReceived.excluded, InstanceRegistry(), {} }
+    , m_coreQuery(nullptr)
+    , m_coreLoadCounter(nullptr)
+    , m_coreFrequencyCounter(nullptr)
+    , m_corePerformanceCounter(nullptr)
+{
+}
+
+PdhCollector::~PdhCollector()
+{
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        closeGroup(static_cast<MetricGroup>(g));
+    }
+}
+
+bool PdhCollector::initialize() {
+    m_initialized = true;
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        if (m_enabledGroups & metricGroupBit(static_cast<MetricGroup>(g))) {
+            openGroup(static_cast<MetricGroup>(g));
+        }
+    }
+    // Without the CPU group there is no query to judge PDH by
+    return m_cpuQuery != nullptr || !(m_enabledGroups & metricGroupBit(MetricGroup::Cpu));
+}
+
+void PdhCollector::setEnabledGroups(MetricGroups groups)
+{
+    const MetricGroups changed = groups ^ m_enabledGroups;
+    m_enabledGroups = groups;
+    if (!m_initialized) {
+        return;
+    }
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        const MetricGroup group = static_cast<MetricGroup>(g);
+        if (changed & metricGroupBit(group)) {
+            if (groups & metricGroupBit(group)) {
+                openGroup(group);
+            } else {
+                closeGroup(group);
+            }
+        }
+    }
+}
+
+void PdhCollector::refreshCounters(PDH_HQUERY query, WildcardCounters& set)
+{
+    // A failed expansion keeps the instances we have rather than dropping them all
+    DWORD bufferSize = 0;
+    if (PdhExpandWildCardPathW(nullptr, set.path, nullptr, &bufferSize, 0) != PDH_MORE_DATA) {
+        return;
+    }
+    QVector<wchar_t> pathBuffer(bufferSize);
+    if (PdhExpandWildCardPathW(nullptr, set.path, pathBuffer.data(), &bufferSize, 0) != ERROR_SUCCESS) {
+        return;
+    }
+    std::vector<std::string> paths;
+    for (const wchar_t* p = pathBuffer.data(); *p != L'\0'; p += wcslen(p) + 1) {
+        const QString counterPath = QString::fromWCharArray(p);
+        bool skip = false;
+        for (const QString& pattern : set.excluded) {
+            skip = skip || counterPath.contains(pattern, Qt::CaseInsensitive);
+        }
+        if (!skip) {
+            paths.push_back(counterPath.toStdString());
+        }
+    }
+    if (set.instances.update(std::move(paths)).empty()) {
+        return;
+    }
+
+    std::vector<InstanceCounter> previous = std::move(set.counters);
+    set.counters.clear();
+    set.counters.reserve(set.instances.instances().size());
+    for (const InstanceRegistry::Instance& instance : set.instances.instances()) {
+        auto existing = std::find_if(previous.begin(), previous.end(),
+                                     [&instance](const InstanceCounter& counter) { return counter.id == instance.id; });
+        if (existing != previous.end()) {
+            set.counters.push_back(*existing);
+            previous.erase(existing);
+            continue;
+        }
+        // A counter that cannot be added stays registered without a handle, so it is not
+        // retried on every refresh. Its first value arrives after the next two collections.
+        PDH_HCOUNTER handle = nullptr;
+        const std::wstring path = QString::fromStdString(instance.name).toStdWString();
+        if (PdhAddEnglishCounterW(query, path.c_str(), 0, &handle) != ERROR_SUCCESS) {
+            handle = nullptr;
+        }
+        set.counters.push_back(InstanceCounter{ instance.id, handle });
+    }
+    // What is left was removed
+    for (const InstanceCounter& counter : previous) {
+        if (counter.handle) {
+            PdhRemoveCounter(counter.handle);
+        }
+    }
+}
+
+void PdhCollector::openGroup(MetricGroup group)
+{
+    // Rate counters need a first collection to have something to compare against
+    switch (group) {
+    case MetricGroup::Cpu:
+        PdhOpenQuery(nullptr, 0, &m_cpuQuery);
+        PdhAddEnglishCounter(m_cpuQuery, L"\\Processor(_Total)\\% Processor Time", 0, &m_cpuTotalCounter);
+        PdhCollectQueryData(m_cpuQuery);
+        break;
+    case MetricGroup::Disk:
+        PdhOpenQuery(nullptr, 0, &m_diskQuery);
+        PdhAddEnglishCounter(m_diskQuery, L"\\PhysicalDisk(_Total)\\% Disk Time", 0, &m_diskTotalCounter);
+        PdhCollectQueryData(m_diskQuery);
+        break;
+    case MetricGroup::Gpu:
+        PdhOpenQuery(nullptr, 0, &m_gpuQuery);
+        refreshCounters(m_gpuQuery, m_gpuEngines);
+        if (!m_gpuEngines.counters.empty()) {
+            PdhCollectQueryData(m_gpuQuery);
+        }
+        break;
+    case MetricGroup::Network:
+        PdhOpenQuery(nullptr, 0, &m_networkQuery);
+        refreshCounters(m_networkQuery, m_bytesReceived);
+        refreshCounters(m_networkQuery, m_bytesSent);
+        if (!m_bytesReceived.counters.empty() || !m_bytesSent.counters.empty()) {
+            PdhCollectQueryData(m_networkQuery);
+        }
+        break;
+    case MetricGroup::TopProcesses:
+        m_processTable.refresh();
+        break;
+    case MetricGroup::CpuCores: {
+        // Processor(*) only covers the caller's processor group, so hosts with more than 64
+        // logical CPUs need Processor Information(*), whose instances are "group,number"
+        int cores = 0;
+        m_groupFirstCore.clear();
+        for (WORD group = 0; group < GetActiveProcessorGroupCount(); ++group) {
+            m_groupFirstCore.push_back(cores);
+            cores += static_cast<int>(GetActiveProcessorCount(group));
+        }
+        m_cores.reset(cores);
+        m_corePerformance.assign(m_cores.cores(), 0.0f);
+        PdhOpenQuery(nullptr, 0, &m_coreQuery);
+        PdhAddEnglishCounter(m_coreQuery, L"\\Processor Information(*)\\% Processor Time", 0, &m_coreLoadCounter);
+        // The rated clock, and the actual one as a percentage of it (over 100 under boost)
+        PdhAddEnglishCounter(m_coreQuery, L"\\Processor Information(*)\\Processor Frequency", 0, &m_coreFrequencyCounter);
+        PdhAddEnglishCounter(m_coreQuery, L"\\Processor Information(*)\\% Processor Performance", 0,
+                             &m_corePerformanceCounter);
+        PdhCollectQueryData(m_coreQuery);
+        break;
+    }
+    default:
+        // Memory, processes and uptime are plain Win32 calls with nothing to open
+        break;
+    }
+}
+
+void PdhCollector::closeGroup(MetricGroup group)
+{
+    // Closing a query also frees its counters
+    auto closeQuery = [](PDH_HQUERY& query) {
+        if (query) {
+            PdhCloseQuery(query);
+            query = nullptr;
+        }
+    };
+    switch (group) {
+    case MetricGroup::Cpu:
+        closeQuery(m_cpuQuery);
+        m_cpuTotalCounter = nullptr;
+        break;
+    case MetricGroup::Disk:
+        closeQuery(m_diskQuery);
+        m_diskTotalCounter = nullptr;
+        break;
+    case MetricGroup::Gpu:
+        closeQuery(m_gpuQuery);
+        m_gpuEngines.counters.clear();
+        m_gpuEngines.instances.clear();
+        break;
+    case MetricGroup::Network:
+        closeQuery(m_networkQuery);
+        for (WildcardCounters* set : { &m_bytesReceived, &m_bytesSent }) {
+            set->counters.clear();
+            set->instances.clear();
+        }
+        break;
+    case MetricGroup::TopProcesses:
+        m_processTable.clear();
+        break;
+    case MetricGroup::CpuCores:
+        closeQuery(m_coreQuery);
+        m_coreLoadCounter = m_coreFrequencyCounter = m_corePerformanceCounter = nullptr;
+        m_coreItems.clear();
+        m_cores.reset(0);
+        break;
+    default:
+        break;
+    }
+}
+
+bool PdhCollector::readCoreCounter(PDH_HCOUNTER counter, float* out)
+{
+    if (!counter) {
+        return false;
+    }
+    DWORD bufferSize = static_cast<DWORD>(m_coreItems.size());
+    DWORD itemCount = 0;
+    PDH_STATUS status;
+    for (;;) {
+        auto* items = reinterpret_cast<PDH_FMT_COUNTERVALUE_ITEM_W*>(m_coreItems.data());
+        status = PdhGetFormattedCounterArrayW(counter, PDH_FMT_DOUBLE | PDH_FMT_NOCAP100, &bufferSize, &itemCount,
+                                              m_coreItems.empty() ? nullptr : items);
+        if (status != PDH_MORE_DATA) {
+            break;
+        }
+        // Sized once; the instance names live in the same buffer
+        m_coreItems.resize(bufferSize);
+    }
+    if (status != ERROR_SUCCESS) {
+        return false;
+    }
+    const auto* items = reinterpret_cast<const PDH_FMT_COUNTERVALUE_ITEM_W*>(m_coreItems.data());
+    for (DWORD i = 0; i < itemCount; ++i) {
+        // "0,12" is core 12 of group 0; "_Total" and "0,_Total" are skipped
+        const wchar_t* name = items[i].szName;
+        wchar_t* comma = nullptr;
+        const unsigned long group = std::wcstoul(name, &comma, 10);
+        if (comma == name || *comma != L',' || group >= m_groupFirstCore.size() || comma[1] == L'_') {
+            continue;
+        }
+        const int core = m_groupFirstCore[group] + static_cast<int>(std::wcstoul(comma + 1, nullptr, 10));
+        if (core < m_cores.cores() && items[i].FmtValue.CStatus == ERROR_SUCCESS) {
+            out[core] = static_cast<float>(items[i].FmtValue.doubleValue);
+        }
+    }
+    return true;
+}
+
+void PdhCollector::collect(SysInfo& info) {
+    collectGroups(info, AllMetricGroups);
+}
+
+void PdhCollector::collectGroups(SysInfo& info, MetricGroups groups) {
+    // Every counter set has its own query, so rates cover the time since that group was
+    // last collected
+    groups &= m_enabledGroups;
+    PDH_FMT_COUNTERVALUE counterVal;
+
+    if (groups & metricGroupBit(MetricGroup::Cpu)) {
+        if (m_cpuQuery && PdhCollectQueryData(m_cpuQuery) == ERROR_SUCCESS &&
+            PdhGetFormattedCounterValue(m_cpuTotalCounter, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
+            info.cpuLoad = counterVal.doubleValue;
+        } else {
+            info.cpuLoad = 0.0;
+        }
+    }
+
+    if (groups & metricGroupBit(MetricGroup::Memory)) {
+        MEMORYSTATUSEX memInfo;
+        memInfo.dwLength = sizeof(MEMORYSTATUSEX);
+        if (GlobalMemoryStatusEx(&memInfo)) {
+            info.memUsage = static_cast<int>(memInfo.dwMemoryLoad);
+            info.totalRamMB = memInfo.ullTotalPhys / (1024 * 1024);
+            info.availRamMB = memInfo.ullAvailPhys / (1024 * 1024);
+        } else {
+            info.memUsage = 0;
+            info.totalRamMB = 0;
+            info.availRamMB = 0;
+        }
+    }
+
+    if (groups & metricGroupBit(MetricGroup::Disk)) {
+        if (m_diskQuery && PdhCollectQueryData(m_diskQuery) == ERROR_SUCCESS &&
+            PdhGetFormattedCounterValue(m_diskTotalCounter, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
+            info.diskLoad = counterVal.doubleValue;
+        } else {
+            info.diskLoad = 0.0;
+        }
+    }
+
+    if (groups & metricGroupBit(MetricGroup::Gpu)) {
+        if (m_gpuQuery && m_gpuEngines.instances.refreshDue()) {
+            refreshCounters(m_gpuQuery, m_gpuEngines);
+        }
+        if (m_gpuQuery && !m_gpuEngines.counters.empty() && PdhCollectQueryData(m_gpuQuery) == ERROR_SUCCESS) {
+            double maxGpuLoad = 0.0;
+            for (const InstanceCounter& gpuCounter : m_gpuEngines.counters) {
+                if (gpuCounter.handle &&
+                    PdhGetFormattedCounterValue(gpuCounter.handle, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
+                    if (counterVal.doubleValue > maxGpuLoad) {
+                        maxGpuLoad = counterVal.doubleValue;
+                    }
+                }
+            }
+            info.gpuLoad = maxGpuLoad;
+        } else {
+            info.gpuLoad = 0.0;
+        }
+    }
+
+    if (groups & metricGroupBit(MetricGroup::Network)) {
+        if (m_networkQuery && m_bytesReceived.instances.refreshDue()) {
+            refreshCounters(m_networkQuery, m_bytesReceived);
+            refreshCounters(m_networkQuery, m_bytesSent);
+        }
+        if (m_networkQuery && PdhCollectQueryData(m_networkQuery) == ERROR_SUCCESS) {
+            auto getCounterValue = [&](const WildcardCounters& set) {
+                double total = 0.0;
+                for (const InstanceCounter& counter : set.counters) {
+                    if (counter.handle &&
+                        PdhGetFormattedCounterValue(counter.handle, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
+                        total += counterVal.doubleValue;
+                    }
+                }
+                return total;
+            };
+
+            // The PDH counter already provides the value in Bytes/sec, so we just convert to MB/s
+            info.networkDownloadSpeed = qMax(0.0, getCounterValue(m_bytesReceived) / (1024.0 * 1024.0));
+            info.networkUploadSpeed = qMax(0.0, getCounterValue(m_bytesSent) / (1024.0 * 1024.0));
+        } else {
+            info.networkDownloadSpeed = 0.0;
+            info.networkUploadSpeed = 0.0;
+        }
+    }
+
+    if (groups & metricGroupBit(MetricGroup::Processes)) {
+        // A full buffer may mean there are more processes than fit, so grow until it is not
+        if (m_processIds.empty()) {
+            m_processIds.resize(1024);
+        }
+        DWORD bytesNeeded = 0;
+        bool enumerated = false;
+        for (;;) {
+            const DWORD bytes = static_cast<DWORD>(m_processIds.size() * sizeof(DWORD));
+            enumerated = EnumProcesses(m_processIds.data(), bytes, &bytesNeeded);
+            if (!enumerated || bytesNeeded < bytes) {
+                break;
+            }
+            m_processIds.resize(m_processIds.size() * 2);
+        }
+        info.activeProcesses = enumerated ? bytesNeeded / sizeof(DWORD) : 0;
+    }
+
+    if (groups & metricGroupBit(MetricGroup::Uptime)) {
+        ULONGLONG uptimeMs = GetTickCount64();
+        info.systemUptime = uptimeMs / (1000.0 * 60.0 * 60.0);
+    }
+
+    if (groups & metricGroupBit(MetricGroup::TopProcesses)) {
+        if (!m_processTable.refresh()) {
+            m_processTable.clear();
+        }
+        info.activeProcesses = m_processTable.count();
+        m_processTable.topByCpu(info.topCpu, TopProcessCount);
+        m_processTable.topByMemory(info.topMemory, TopProcessCount);
+    }
+
+    if (groups & metricGroupBit(MetricGroup::CpuCores)) {
+        if (m_coreQuery && PdhCollectQueryData(m_coreQuery) == ERROR_SUCCESS &&
+            readCoreCounter(m_coreLoadCounter, m_cores.loads())) {
+            float* frequencies = m_cores.frequencies();
+            const int cores = m_cores.cores();
+            if (readCoreCounter(m_coreFrequencyCounter, frequencies) &&
+                readCoreCounter(m_corePerformanceCounter, m_corePerformance.data())) {
+                for (int core = 0; core < cores; ++core) {
+                    frequencies[core] *= m_corePerformance[core] / 100.0f;
+                }
+            } else {
+                std::fill(frequencies, frequencies + cores, 0.0f);
+            }
+            m_cores.summarize(info);
+        } else {
+            info.cpuCores.count = 0;
+            info.cpuCoreMaxLoad = info.cpuFrequencyMHz = info.cpuFrequencyMaxMHz = -1.0;
+        }
+    }
+}
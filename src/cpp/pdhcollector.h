@@ -0,0 +1,82 @@
+#ifndef PDHCOLLECTOR_H
+#define PDHCOLLECTOR_H
+
+#include "metriccollector.h"
+#include "cpucores.h"
+#include "instanceregistry.h"
+#include "processtable.h"
+#include <QStringList>
+#include <vector>
+
+#include <windows.h>
+#include <Pdh.h>
+#include <PdhMsg.h>
+#include <psapi.h>
+
+// Windows backend: Performance Data Helper counters plus a few Win32 calls. Each counter set
+// has its own query, opened only while its metric group is enabled; the GPU engine and
+// network interface wildcards alone can expand to hundreds of counters. GPU engines come
+// and go with processes and adapters with VPNs or tethering, so the wildcards are expanded
+// again every few seconds and only the counters of changed instances are added or removed.
+class PdhCollector : public MetricCollector
+{
+public:
+    PdhCollector();
+    ~PdhCollector() override;
+
+    const char* name() const override { return "pdh"; }
+    bool initialize() override;
+    void collect(SysInfo& info) override;
+    void collectGroups(SysInfo& info, MetricGroups groups) override;
+    void setEnabledGroups(MetricGroups groups) override;
+
+private:
+    // One counter per instance of a wildcard path, in the registry's order
+    struct InstanceCounter {
+        InstanceRegistry::Id id;
+        PDH_HCOUNTER handle;
+    };
+    struct WildcardCounters {
+        const wchar_t* path;
+        // Instances whose path contains any of these are skipped
+        QStringList excluded;
+        InstanceRegistry instances;
+        std::vector<InstanceCounter> counters;
+    };
+
+    void openGroup(MetricGroup group);
+    void closeGroup(MetricGroup group);
+    // Re-expands the wildcard and adds or removes the counters of instances that came or went
+    void refreshCounters(PDH_HQUERY query, WildcardCounters& set);
+    // Writes every per-core instance of a Processor Information wildcard counter to out,
+    // indexed like m_cores; false if the counter could not be read
+    bool readCoreCounter(PDH_HCOUNTER counter, float* out);
+
+    MetricGroups m_enabledGroups;
+    bool m_initialized;
+    PDH_HQUERY m_cpuQuery;
+    PDH_HCOUNTER m_cpuTotalCounter;
+    PDH_HQUERY m_diskQuery;
+    PDH_HCOUNTER m_diskTotalCounter;
+    PDH_HQUERY m_gpuQuery;
+    WildcardCounters m_gpuEngines;
+    PDH_HQUERY m_networkQuery;
+    WildcardCounters m_bytesReceived;
+    WildcardCounters m_bytesSent;
+    ProcessTable m_processTable;
+    std::vector<DWORD> m_processIds;
+
+    // Per-core counters: one wildcard counter each, read as an array in a single call, so
+    // there is no per-instance counter to maintain whatever the number of cores
+    PDH_HQUERY m_coreQuery;
+    PDH_HCOUNTER m_coreLoadCounter;
+    PDH_HCOUNTER m_coreFrequencyCounter;
+    PDH_HCOUNTER m_corePerformanceCounter;
+    // First core index of each processor group, for the "group,number" instance names
+    std::vector<int> m_groupFirstCore;
+    std::vector<BYTE> m_coreItems;
+    std::vector<float> m_corePerformance;
+    CpuCoreAggregator m_cores;
+};
+
+#endif // PDHCOLLECTOR_H
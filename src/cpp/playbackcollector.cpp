@@ -0,0 +1,60 @@
+#include "playbackcollector.h"
+
+PlaybackCollector::PlaybackCollector(std::string path, double speed)
+    : m_path(std::move(path))
+    , m_speed(speed)
+    , m_currentTimestamp(0)
+    , m_pendingTimestamp(0)
+    , m_hasPending(false)
+    , m_started(false)
+    , m_finished(false)
+{
+}
+
+bool PlaybackCollector::initialize()
+{
+    if (!m_recording.open(m_path)) {
+        m_finished = true;
+        return false;
+    }
+    m_cursor = std::make_unique<SampleRecording::Cursor>(m_recording);
+    m_hasPending = m_cursor->next(m_pending, m_pendingTimestamp);
+    m_finished = !m_hasPending;
+    return true;
+}
+
+void PlaybackCollector::advance()
+{
+    m_current = m_pending;
+    m_currentTimestamp = m_pendingTimestamp;
+    m_hasPending = m_cursor->next(m_pending, m_pendingTimestamp);
+}
+
+void PlaybackCollector::collect(SysInfo& info)
+{
+    if (!m_cursor) {
+        return;
+    }
+    if (m_speed <= 0.0) {
+        if (m_hasPending) {
+            advance();
+        }
+    } else {
+        const auto now = std::chrono::steady_clock::now();
+        if (!m_started) {
+            m_started = true;
+            m_startTime = now;
+            if (m_hasPending) {
+                advance();
+            }
+        }
+        const double elapsedMs = std::chrono::duration<double, std::milli>(now - m_startTime).count();
+        const int64_t target = m_recording.firstTimestampMs() + static_cast<int64_t>(elapsedMs * m_speed);
+        while (m_hasPending && m_pendingTimestamp <= target) {
+            advance();
+        }
+    }
+    // Finished once the last sample has been handed out
+    m_finished = !m_hasPending;
+    info = m_current;
+}
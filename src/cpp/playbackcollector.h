@@ -0,0 +1,50 @@
+#ifndef PLAYBACKCOLLECTOR_H
+#define PLAYBACKCOLLECTOR_H
+
+#include "metriccollector.h"
+#include "samplerecording.h"
+#include <chrono>
+#include <memory>
+#include <string>
+
+// Replays a recording written by SampleRecording::Recorder instead of reading the system.
+//
+// At a positive speed every collect() returns the newest recorded sample at or before
+// (time since the first collect) x speed, so 1 replays in real time whatever the poll
+// interval. At speed 0 every collect() returns the next sample, which together with the
+// sampler's lock-step mode feeds each one to the consumer exactly once.
+class PlaybackCollector : public MetricCollector
+{
+public:
+    PlaybackCollector(std::string path, double speed);
+
+    const char* name() const override { return "playback"; }
+    bool initialize() override;
+    void collect(SysInfo& info) override;
+    // The recording carries whatever temperatures were live when it was made
+    bool providesTemperatures() const override { return true; }
+    bool finished() const override { return m_finished; }
+
+    // Recorded time of the sample the last collect() returned
+    int64_t timestampMs() const { return m_currentTimestamp; }
+
+private:
+    void advance();
+
+    std::string m_path;
+    double m_speed;
+    SampleRecording::Recording m_recording;
+    std::unique_ptr<SampleRecording::Cursor> m_cursor;
+
+    SysInfo m_current;
+    int64_t m_currentTimestamp;
+    // One sample of lookahead, so real-time replay knows when to move on
+    SysInfo m_pending;
+    int64_t m_pendingTimestamp;
+    bool m_hasPending;
+    bool m_started;
+    bool m_finished;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+#endif // PLAYBACKCOLLECTOR_H
@@ -0,0 +1,336 @@
+#include "processtable.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include "procparse.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+ProcessTable::ProcessTable()
+    : m_lastRefresh(std::chrono::steady_clock::now())
+    , m_cpuCount(qMax(1u, std::thread::hardware_concurrency()))
+    , m_openHandles(0)
+#if defined(Q_OS_LINUX)
+    , m_procDir(nullptr)
+    , m_ticksPerSecond(sysconf(_SC_CLK_TCK))
+    , m_pageSize(sysconf(_SC_PAGESIZE))
+#endif
+{
+#if defined(Q_OS_LINUX)
+    // Leave most of the descriptor limit to the rest of the process
+    rlimit limit;
+    const rlim_t soft = getrlimit(RLIMIT_NOFILE, &limit) == 0 ? limit.rlim_cur : 1024;
+    m_handleBudget = static_cast<int>(qMin<rlim_t>(soft / 2, 65536));
+#else
+    // Process handles are cheap and plentiful
+    m_handleBudget = 1 << 20;
+#endif
+}
+
+ProcessTable::~ProcessTable()
+{
+    clear();
+}
+
+void ProcessTable::clear()
+{
+    for (Entry& entry : m_entries) {
+        close(entry);
+    }
+    m_entries.clear();
+#if defined(Q_OS_LINUX)
+    if (m_procDir) {
+        closedir(m_procDir);
+        m_procDir = nullptr;
+    }
+#endif
+}
+
+bool ProcessTable::refresh()
+{
+    if (!enumerate(m_pids)) {
+        return false;
+    }
+    // Usually in order already
+    std::sort(m_pids.begin(), m_pids.end());
+
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsedUs = std::chrono::duration<double, std::micro>(now - m_lastRefresh).count();
+    m_lastRefresh = now;
+    const double cpuScale = elapsedUs > 0 ? 100.0 / (elapsedUs * m_cpuCount) : 0.0;
+
+    // Both lists are sorted by PID: entries missing from m_pids have exited, PIDs missing
+    // from the entries are new
+    m_merged.clear();
+    m_merged.reserve(m_pids.size());
+    auto entry = m_entries.begin();
+    for (quint32 pid : m_pids) {
+        for (; entry != m_entries.end() && entry->process.pid < pid; ++entry) {
+            close(*entry);
+        }
+        if (entry != m_entries.end() && entry->process.pid == pid) {
+            m_merged.push_back(*entry);
+            ++entry;
+        } else {
+            Entry fresh = {};
+            fresh.process.pid = pid;
+            fresh.handle = InvalidHandle;
+            open(fresh);
+            m_merged.push_back(fresh);
+        }
+
+        Entry& current = m_merged.back();
+        quint64 cpuTimeUs = 0;
+        double residentMB = 0.0;
+        if (!sample(current, cpuTimeUs, residentMB)) {
+            // Exited since the enumeration; a new process reusing the PID shows up next time
+            close(current);
+            m_merged.pop_back();
+            continue;
+        }
+        Process& process = current.process;
+        process.cpuPercent = current.primed && cpuTimeUs >= current.cpuTimeUs ? (cpuTimeUs - current.cpuTimeUs) * cpuScale : 0.0;
+        process.residentDeltaMB = current.primed ? residentMB - process.residentMB : 0.0;
+        process.residentMB = residentMB;
+        current.cpuTimeUs = cpuTimeUs;
+        current.primed = true;
+    }
+    for (; entry != m_entries.end(); ++entry) {
+        close(*entry);
+    }
+    m_entries.swap(m_merged);
+    return true;
+}
+
+void ProcessTable::topByCpu(TopProcess* out, int count)
+{
+    top(out, count, false);
+}
+
+void ProcessTable::topByMemory(TopProcess* out, int count)
+{
+    top(out, count, true);
+}
+
+void ProcessTable::top(TopProcess* out, int count, bool byMemory)
+{
+    // O(n log count) rather than sorting the whole table
+    m_order.resize(m_entries.size());
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        m_order[i] = static_cast<int>(i);
+    }
+    const int found = qMin(count, static_cast<int>(m_order.size()));
+    std::partial_sort(m_order.begin(), m_order.begin() + found, m_order.end(), [this, byMemory](int a, int b) {
+        const Process& left = m_entries[a].process;
+        const Process& right = m_entries[b].process;
+        return byMemory ? left.residentMB > right.residentMB : left.cpuPercent > right.cpuPercent;
+    });
+    for (int i = 0; i < count; ++i) {
+        TopProcess& slot = out[i];
+        slot = TopProcess();
+        if (i >= found) {
+            continue;
+        }
+        const Process& process = m_entries[m_order[i]].process;
+        slot.pid = process.pid;
+        std::memcpy(slot.name, process.name, qMin(sizeof(slot.name), sizeof(process.name)));
+        slot.name[sizeof(slot.name) - 1] = '\0';
+        slot.cpuPercent = static_cast<float>(process.cpuPercent);
+        slot.residentMB = static_cast<float>(process.residentMB);
+    }
+}
+
+#if defined(Q_OS_WIN)
+
+bool ProcessTable::enumerate(std::vector<quint32>& pids)
+{
+    // EnumProcesses cannot say how many there are, only that the buffer was filled; grow
+    // until it is not
+    static_assert(sizeof(DWORD) == sizeof(quint32), "PIDs are enumerated in place");
+    pids.resize(qMax<size_t>(pids.capacity(), 1024));
+    DWORD bytesReturned = 0;
+    for (;;) {
+        const DWORD bytes = static_cast<DWORD>(pids.size() * sizeof(DWORD));
+        if (!EnumProcesses(reinterpret_cast<DWORD*>(pids.data()), bytes, &bytesReturned)) {
+            return false;
+        }
+        if (bytesReturned < bytes) {
+            break;
+        }
+        pids.resize(pids.size() * 2);
+    }
+    pids.resize(bytesReturned / sizeof(DWORD));
+    // The System Idle Process is not a process anyone is interested in
+    pids.erase(std::remove(pids.begin(), pids.end(), 0u), pids.end());
+    return true;
+}
+
+void ProcessTable::open(Entry& entry)
+{
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, entry.process.pid);
+    if (!process) {
+        // Protected processes; they are still counted
+        return;
+    }
+    entry.handle = reinterpret_cast<qintptr>(process);
+    ++m_openHandles;
+
+    wchar_t path[MAX_PATH];
+    DWORD length = MAX_PATH;
+    if (QueryFullProcessImageNameW(process, 0, path, &length)) {
+        const wchar_t* base = path;
+        for (const wchar_t* p = path; *p; ++p) {
+            if (*p == L'\\') {
+                base = p + 1;
+            }
+        }
+        WideCharToMultiByte(CP_UTF8, 0, base, -1, entry.process.name, sizeof(entry.process.name) - 1, nullptr, nullptr);
+    }
+}
+
+void ProcessTable::close(Entry& entry)
+{
+    if (entry.handle != InvalidHandle) {
+        CloseHandle(reinterpret_cast<HANDLE>(entry.handle));
+        entry.handle = InvalidHandle;
+        --m_openHandles;
+    }
+}
+
+bool ProcessTable::sample(Entry& entry, quint64& cpuTimeUs, double& residentMB)
+{
+    if (entry.handle == InvalidHandle) {
+        return true;
+    }
+    HANDLE process = reinterpret_cast<HANDLE>(entry.handle);
+    // The handle keeps an exited process's object alive, so ask whether it has ended
+    if (WaitForSingleObject(process, 0) == WAIT_OBJECT_0) {
+        return false;
+    }
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(process, &creation, &exit, &kernel, &user)) {
+        auto toUs = [](const FILETIME& t) {
+            return ((static_cast<quint64>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10;
+        };
+        cpuTimeUs = toUs(kernel) + toUs(user);
+    }
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(process, &counters, sizeof(counters))) {
+        residentMB = counters.WorkingSetSize / (1024.0 * 1024.0);
+    }
+    return true;
+}
+
+#elif defined(Q_OS_LINUX)
+
+bool ProcessTable::enumerate(std::vector<quint32>& pids)
+{
+    if (!m_procDir) {
+        m_procDir = opendir("/proc");
+        if (!m_procDir) {
+            return false;
+        }
+    }
+    pids.clear();
+    rewinddir(m_procDir);
+    while (dirent* entry = readdir(m_procDir)) {
+        if (std::isdigit(static_cast<unsigned char>(entry->d_name[0]))) {
+            pids.push_back(static_cast<quint32>(std::strtoul(entry->d_name, nullptr, 10)));
+        }
+    }
+    return true;
+}
+
+void ProcessTable::open(Entry& entry)
+{
+    if (m_openHandles >= m_handleBudget || !m_procDir) {
+        return;
+    }
+    char path[32];
+    std::snprintf(path, sizeof(path), "%u/stat", entry.process.pid);
+    const int fd = ::openat(dirfd(m_procDir), path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        entry.handle = fd;
+        ++m_openHandles;
+    }
+}
+
+void ProcessTable::close(Entry& entry)
+{
+    if (entry.handle != InvalidHandle) {
+        ::close(static_cast<int>(entry.handle));
+        entry.handle = InvalidHandle;
+        --m_openHandles;
+    }
+}
+
+bool ProcessTable::sample(Entry& entry, quint64& cpuTimeUs, double& residentMB)
+{
+    // Beyond the budget the file is opened just for this read. Once the process has exited,
+    // a kept descriptor fails to read (ESRCH) and a fresh open fails outright.
+    char buffer[1024];
+    int fd = static_cast<int>(entry.handle);
+    const bool transient = entry.handle == InvalidHandle;
+    if (transient) {
+        char path[32];
+        std::snprintf(path, sizeof(path), "%u/stat", entry.process.pid);
+        fd = m_procDir ? ::openat(dirfd(m_procDir), path, O_RDONLY | O_CLOEXEC) : -1;
+        if (fd < 0) {
+            return false;
+        }
+    }
+    const ssize_t length = ::pread(fd, buffer, sizeof(buffer), 0);
+    if (transient) {
+        ::close(fd);
+    }
+    if (length <= 0) {
+        return false;
+    }
+    const std::string_view text(buffer, static_cast<size_t>(length));
+
+    // pid (comm) state ppid ... The name may contain spaces and parentheses, so it ends at
+    // the last ')'.
+    const size_t open = text.find('(');
+    const size_t close = text.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+        return false;
+    }
+    const size_t nameLength = qMin(close - open - 1, sizeof(entry.process.name) - 1);
+    std::memcpy(entry.process.name, buffer + open + 1, nameLength);
+    entry.process.name[nameLength] = '\0';
+
+    // Fields after the name, counted from 3 (state): utime is 14, stime 15, rss 24
+    ProcCursor cursor(text.substr(close + 1));
+    cursor.skipWords(14 - 3);
+    const unsigned long long utime = cursor.number();
+    const unsigned long long stime = cursor.number();
+    cursor.skipWords(24 - 16);
+    const long long rssPages = cursor.signedNumber();
+    cpuTimeUs = (utime + stime) * 1000000ULL / static_cast<unsigned long long>(qMax(1L, m_ticksPerSecond));
+    residentMB = static_cast<double>(rssPages) * m_pageSize / (1024.0 * 1024.0);
+    return true;
+}
+
+#else
+
+bool ProcessTable::enumerate(std::vector<quint32>& pids)
+{
+    pids.clear();
+    return false;
+}
+
+void ProcessTable::open(Entry&) {}
+void ProcessTable::close(Entry&) {}
+bool ProcessTable::sample(Entry&, quint64&, double&) { return false; }
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef PROCESSTABLE_H
+#define PROCESSTABLE_H
+
+#include <QtGlobal>
+#include <chrono>
+#include <vector>
+#include "sysinfo.h"
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#endif
+
+// Every process on the machine with its CPU and memory use, in a table keyed by PID that
+// refresh() updates in place.
+//
+// A refresh enumerates the PIDs, merges them with the table (both sorted, so one pass finds
+// new and exited processes) and samples each process through a handle kept open for its
+// lifetime: its /proc/[pid]/stat descriptor on Linux, a process handle on Windows. Once the
+// descriptor budget is spent, further processes are opened for each sample instead. CPU use
+// is the growth of a process's CPU time over the wall time since the previous refresh.
+class ProcessTable
+{
+public:
+    struct Process {
+        quint32 pid;
+        char name[24];           // executable name, truncated; empty if it cannot be read
+        double cpuPercent;       // of the whole machine
+        double residentMB;
+        double residentDeltaMB;  // since the previous refresh
+    };
+
+    ProcessTable();
+    ~ProcessTable();
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    // Returns false if the process list cannot be read
+    bool refresh();
+    // Closes every handle and forgets all processes
+    void clear();
+
+    int count() const { return static_cast<int>(m_entries.size()); }
+    // Sorted by PID
+    const Process& process(int index) const { return m_entries[index].process; }
+
+    // The count busiest processes, busiest first; slots beyond the number of processes are cleared
+    void topByCpu(TopProcess* out, int count);
+    void topByMemory(TopProcess* out, int count);
+
+private:
+    struct Entry {
+        Process process;
+        quint64 cpuTimeUs;
+        qintptr handle;  // stat descriptor or process HANDLE; InvalidHandle when not kept open
+        bool primed;     // cpuTimeUs and residentMB hold a previous sample
+    };
+
+    static constexpr qintptr InvalidHandle = -1;
+
+    // Platform parts, in processtable.cpp
+    bool enumerate(std::vector<quint32>& pids);
+    void open(Entry& entry);
+    void close(Entry& entry);
+    // Reads CPU time, resident memory and the name. False once the process has exited.
+    bool sample(Entry& entry, quint64& cpuTimeUs, double& residentMB);
+
+    void top(TopProcess* out, int count, bool byMemory);
+
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_merged;
+    std::vector<quint32> m_pids;
+    std::vector<int> m_order;
+    std::chrono::steady_clock::time_point m_lastRefresh;
+    double m_cpuCount;
+    int m_openHandles;
+    int m_handleBudget;
+#ifdef Q_OS_LINUX
+    // Kept open for enumeration and for opening stat files relative to it
+    DIR* m_procDir;
+    long m_ticksPerSecond;
+    long m_pageSize;
+#endif
+};
+
+#endif // PROCESSTABLE_H
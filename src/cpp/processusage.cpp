@@ -0,0 +1,81 @@
+#include "processusage.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <sys/resource.h>
+#include "procparse.h"
+#endif
+
+namespace ProcessUsage {
+
+#if defined(Q_OS_WIN)
+
+static bool memoryCounters(PROCESS_MEMORY_COUNTERS& counters)
+{
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+}
+
+Memory memory()
+{
+    Memory memory;
+    PROCESS_MEMORY_COUNTERS counters;
+    if (memoryCounters(counters)) {
+        memory.residentKb = static_cast<qint64>(counters.WorkingSetSize / 1024);
+        memory.peakResidentKb = static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+    }
+    return memory;
+}
+
+qint64 cpuTimeMs()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return -1;
+    }
+    auto toMs = [](const FILETIME& t) {
+        return ((static_cast<qint64>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000;
+    };
+    return toMs(kernel) + toMs(user);
+}
+
+#elif defined(Q_OS_LINUX)
+
+Memory memory()
+{
+    // /proc/self/status stays open, one per calling thread: the sampler thread reads it
+    // every tick, and the headless collector reports from its main thread as well.
+    // The kernel prints VmHWM just before VmRSS.
+    thread_local ProcFile status;
+    thread_local ProcKeyTable keys{ "VmHWM:", "VmRSS:" };
+    Memory memory;
+    if (!status.isOpen() && !status.open("/proc/self/status")) {
+        return memory;
+    }
+    quint64 values[2];
+    if (keys.parse(status.read(), values)) {
+        memory.peakResidentKb = static_cast<qint64>(values[0]);
+        memory.residentKb = static_cast<qint64>(values[1]);
+    }
+    return memory;
+}
+
+qint64 cpuTimeMs()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    auto toMs = [](const timeval& t) { return static_cast<qint64>(t.tv_sec) * 1000 + t.tv_usec / 1000; };
+    return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+}
+
+#else
+
+Memory memory() { return Memory(); }
+qint64 cpuTimeMs() { return -1; }
+
+#endif
+
+} // namespace ProcessUsage
@@ -0,0 +1,23 @@
+#ifndef PROCESSUSAGE_H
+#define PROCESSUSAGE_H
+
+#include <QtGlobal>
+
+// Resource use of the current process, for keeping an eye on our own footprint. Each call
+// is a single system query; -1 means the platform does not report it. Callable from any
+// thread.
+namespace ProcessUsage {
+
+struct Memory {
+    qint64 residentKb = -1;
+    qint64 peakResidentKb = -1;
+};
+
+// Current and peak resident set size, both from the same query
+Memory memory();
+// User + kernel CPU time used so far
+qint64 cpuTimeMs();
+
+} // namespace ProcessUsage
+
+#endif // PROCESSUSAGE_H
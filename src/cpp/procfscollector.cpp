@@ -0,0 +1,522 @@
+#include "procfscollector.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <unistd.h>
+
+namespace {
+
+// Calls f(name, rxBytes, txBytes) for every interface in /proc/net/dev except loopback
+template <typename F>
+void forEachInterface(std::string_view text, F f)
+{
+    // Two header lines, then "iface: rx_bytes rx_packets ... (8 fields) tx_bytes ..."
+    ProcCursor cursor(text);
+    if (!cursor.nextLine() || !cursor.nextLine()) {
+        return;
+    }
+    do {
+        cursor.skipSpaces();
+        std::string_view name;
+        if (!cursor.until(':', name)) {
+            break;
+        }
+        if (name == "lo") {
+            continue;
+        }
+        const unsigned long long rxBytes = cursor.number();
+        cursor.skipWords(7);
+        const unsigned long long txBytes = cursor.number();
+        f(name, rxBytes, txBytes);
+    } while (cursor.nextLine());
+}
+
+// Rebuilds per-instance state in the registry's order, keeping the state of instances that
+// are still there and creating it with make(instance) for new ones
+template <typename State, typename Make>
+std::vector<State> carryOver(std::vector<State>& previous, const InstanceRegistry& registry, Make make)
+{
+    std::vector<State> current;
+    current.reserve(registry.instances().size());
+    for (const InstanceRegistry::Instance& instance : registry.instances()) {
+        auto existing = std::find_if(previous.begin(), previous.end(),
+                                     [&instance](const State& state) { return state.id == instance.id; });
+        current.push_back(existing != previous.end() ? std::move(*existing) : make(instance));
+        if (existing != previous.end()) {
+            previous.erase(existing);
+        }
+    }
+    return current;
+}
+
+} // namespace
+
+ProcfsCollector::ProcfsCollector()
+    : m_meminfoKeys{ "MemTotal:", "MemAvailable:" }
+    , m_procDir(nullptr)
+    , m_enabledGroups(AllMetricGroups)
+    , m_initialized(false)
+    , m_lastCpuTotal(0)
+    , m_lastCpuBusy(0)
+{
+}
+
+ProcfsCollector::~ProcfsCollector()
+{
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        closeGroup(static_cast<MetricGroup>(g));
+    }
+}
+
+bool ProcfsCollector::initialize()
+{
+    m_initialized = true;
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        if (m_enabledGroups & metricGroupBit(static_cast<MetricGroup>(g))) {
+            openGroup(static_cast<MetricGroup>(g));
+        }
+    }
+    return ::access("/proc/stat", R_OK) == 0;
+}
+
+void ProcfsCollector::setEnabledGroups(MetricGroups groups)
+{
+    const MetricGroups changed = groups ^ m_enabledGroups;
+    m_enabledGroups = groups;
+    if (!m_initialized) {
+        return;
+    }
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        const MetricGroup group = static_cast<MetricGroup>(g);
+        if (changed & metricGroupBit(group)) {
+            if (groups & metricGroupBit(group)) {
+                openGroup(group);
+            } else {
+                closeGroup(group);
+            }
+        }
+    }
+}
+
+void ProcfsCollector::openGroup(MetricGroup group)
+{
+    // Delta-based metrics are primed so the first real sample after opening is meaningful
+    SysInfo scratch;
+    switch (group) {
+    case MetricGroup::Cpu:
+        m_stat.open("/proc/stat");
+        m_lastCpuTotal = m_lastCpuBusy = 0;
+        collectCpu(scratch);
+        break;
+    case MetricGroup::Memory:
+        m_meminfo.open("/proc/meminfo");
+        break;
+    case MetricGroup::Disk:
+        m_diskstats.open("/proc/diskstats");
+        // Only whole block devices count towards disk activity, partitions would double count
+        if (DIR* blockDir = opendir("/sys/block")) {
+            while (dirent* entry = readdir(blockDir)) {
+                const char* name = entry->d_name;
+                if (name[0] == '.' || std::strncmp(name, "loop", 4) == 0 ||
+                    std::strncmp(name, "ram", 3) == 0 || std::strncmp(name, "zram", 4) == 0) {
+                    continue;
+                }
+                m_wholeDisks.emplace_back(name);
+            }
+            closedir(blockDir);
+        }
+        m_lastIoTicks.assign(m_wholeDisks.size(), 0);
+        m_lastDiskTime = std::chrono::steady_clock::now();
+        collectDisk(scratch, 0.0);
+        break;
+    case MetricGroup::Gpu:
+        refreshDrmCards();
+        break;
+    case MetricGroup::Network:
+        m_netDev.open("/proc/net/dev");
+        m_lastNetworkTime = std::chrono::steady_clock::now();
+        collectNetwork(scratch, 0.0);
+        break;
+    case MetricGroup::Temperatures:
+        findHwmonSensors();
+        break;
+    case MetricGroup::Processes:
+        m_procDir = opendir("/proc");
+        break;
+    case MetricGroup::Uptime:
+        m_uptime.open("/proc/uptime");
+        break;
+    case MetricGroup::TopProcesses:
+        m_processTable.refresh();
+        break;
+    case MetricGroup::CpuCores:
+        m_coreStat.open("/proc/stat");
+        m_cores.reset(0);
+        collectCpuCores(scratch);
+        break;
+    case MetricGroup::Frames:
+    case MetricGroup::Count:
+        break;
+    }
+}
+
+void ProcfsCollector::closeGroup(MetricGroup group)
+{
+    switch (group) {
+    case MetricGroup::Cpu:
+        m_stat.close();
+        break;
+    case MetricGroup::Memory:
+        m_meminfo.close();
+        break;
+    case MetricGroup::Disk:
+        m_diskstats.close();
+        m_wholeDisks.clear();
+        m_lastIoTicks.clear();
+        break;
+    case MetricGroup::Gpu:
+        m_gpuCards.clear();
+        m_drmCards.clear();
+        break;
+    case MetricGroup::Network:
+        m_netDev.close();
+        m_interfaceCounters.clear();
+        m_interfaces.clear();
+        break;
+    case MetricGroup::Temperatures:
+        m_cpuTemp.close();
+        m_gpuTemp.close();
+        break;
+    case MetricGroup::Processes:
+        if (m_procDir) {
+            closedir(m_procDir);
+            m_procDir = nullptr;
+        }
+        break;
+    case MetricGroup::Uptime:
+        m_uptime.close();
+        break;
+    case MetricGroup::TopProcesses:
+        m_processTable.clear();
+        break;
+    case MetricGroup::CpuCores:
+        m_coreStat.close();
+        m_frequencyFiles.clear();
+        m_cores.reset(0);
+        break;
+    case MetricGroup::Frames:
+    case MetricGroup::Count:
+        break;
+    }
+}
+
+bool ProcfsCollector::providesTemperatures() const
+{
+    return m_cpuTemp.isOpen() || m_gpuTemp.isOpen();
+}
+
+void ProcfsCollector::findHwmonSensors()
+{
+    static const char* const cpuDrivers[] = { "coretemp", "k10temp", "zenpower", "cpu_thermal" };
+    static const char* const gpuDrivers[] = { "amdgpu", "nouveau", "radeon" };
+
+    DIR* hwmonDir = opendir("/sys/class/hwmon");
+    if (!hwmonDir) {
+        return;
+    }
+    while (dirent* entry = readdir(hwmonDir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        const std::string base = std::string("/sys/class/hwmon/") + entry->d_name + "/";
+        ProcFile nameFile;
+        if (!nameFile.open(base + "name")) {
+            continue;
+        }
+        const std::string driver(ProcCursor(nameFile.read()).word());
+
+        auto matches = [&driver](const char* const* list, size_t count) {
+            return std::find(list, list + count, driver) != list + count;
+        };
+        if (!m_cpuTemp.isOpen() && matches(cpuDrivers, std::size(cpuDrivers))) {
+            m_cpuTemp.open(base + "temp1_input");
+        } else if (!m_gpuTemp.isOpen() && matches(gpuDrivers, std::size(gpuDrivers))) {
+            m_gpuTemp.open(base + "temp1_input");
+        }
+    }
+    closedir(hwmonDir);
+}
+
+void ProcfsCollector::collect(SysInfo& info)
+{
+    collectGroups(info, AllMetricGroups);
+}
+
+void ProcfsCollector::collectGroups(SysInfo& info, MetricGroups groups)
+{
+    groups &= m_enabledGroups;
+    const auto now = std::chrono::steady_clock::now();
+    auto elapsedMs = [now](std::chrono::steady_clock::time_point& last) {
+        const double ms = std::chrono::duration<double, std::milli>(now - last).count();
+        last = now;
+        return ms;
+    };
+
+    if (groups & metricGroupBit(MetricGroup::Cpu)) {
+        collectCpu(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::Memory)) {
+        collectMemory(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::Disk)) {
+        collectDisk(info, elapsedMs(m_lastDiskTime));
+    }
+    if (groups & metricGroupBit(MetricGroup::Gpu)) {
+        collectGpu(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::Network)) {
+        collectNetwork(info, elapsedMs(m_lastNetworkTime) / 1000.0);
+    }
+    if (groups & metricGroupBit(MetricGroup::Temperatures)) {
+        collectTemperatures(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::Processes)) {
+        collectProcesses(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::Uptime)) {
+        collectUptime(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::TopProcesses)) {
+        collectTopProcesses(info);
+    }
+    if (groups & metricGroupBit(MetricGroup::CpuCores)) {
+        collectCpuCores(info);
+    }
+}
+
+void ProcfsCollector::collectCpu(SysInfo& info)
+{
+    ProcCursor cursor(m_stat.read());
+    if (!cursor.consume("cpu ")) {
+        info.cpuLoad = 0.0;
+        return;
+    }
+    // cpu  user nice system idle iowait irq softirq steal guest guest_nice
+    unsigned long long fields[8] = {};
+    for (unsigned long long& field : fields) {
+        field = cursor.number();
+    }
+    unsigned long long total = 0;
+    for (unsigned long long field : fields) {
+        total += field;
+    }
+    const unsigned long long busy = total - fields[3] - fields[4];
+
+    const unsigned long long totalDelta = total - m_lastCpuTotal;
+    const unsigned long long busyDelta = busy - m_lastCpuBusy;
+    info.cpuLoad = (m_lastCpuTotal > 0 && totalDelta > 0) ? 100.0 * busyDelta / totalDelta : 0.0;
+
+    m_lastCpuTotal = total;
+    m_lastCpuBusy = busy;
+}
+
+void ProcfsCollector::collectMemory(SysInfo& info)
+{
+    quint64 values[2];
+    if (!m_meminfoKeys.parse(m_meminfo.read(), values)) {
+        info.memUsage = 0;
+        info.totalRamMB = 0;
+        info.availRamMB = 0;
+        return;
+    }
+    const unsigned long long totalKb = values[0];
+    const unsigned long long availableKb = values[1];
+    info.totalRamMB = static_cast<qint64>(totalKb / 1024);
+    info.availRamMB = static_cast<qint64>(availableKb / 1024);
+    info.memUsage = totalKb > 0 ? static_cast<int>((totalKb - availableKb) * 100 / totalKb) : 0;
+}
+
+void ProcfsCollector::collectDisk(SysInfo& info, double elapsedMs)
+{
+    double busiest = 0.0;
+    for (ProcCursor cursor(m_diskstats.read()); !cursor.atEnd(); cursor.nextLine()) {
+        // major minor name reads ... io_ticks is the 10th statistic after the name
+        cursor.skipWords(2);
+        const std::string_view name = cursor.word();
+        auto disk = std::find(m_wholeDisks.begin(), m_wholeDisks.end(), name);
+        if (disk == m_wholeDisks.end()) {
+            continue;
+        }
+        cursor.skipWords(9);
+        const unsigned long long ioTicks = cursor.number();
+        unsigned long long& lastIoTicks = m_lastIoTicks[disk - m_wholeDisks.begin()];
+        if (elapsedMs > 0 && lastIoTicks > 0 && ioTicks >= lastIoTicks) {
+            busiest = std::max(busiest, 100.0 * (ioTicks - lastIoTicks) / elapsedMs);
+        }
+        lastIoTicks = ioTicks;
+    }
+    info.diskLoad = std::min(busiest, 100.0);
+}
+
+void ProcfsCollector::refreshDrmCards()
+{
+    std::vector<std::string> names;
+    if (DIR* drmDir = opendir("/sys/class/drm")) {
+        while (dirent* entry = readdir(drmDir)) {
+            // cardN only; cardN-DP-1 and friends are connectors
+            if (std::strncmp(entry->d_name, "card", 4) == 0 && !std::strchr(entry->d_name, '-')) {
+                names.emplace_back(entry->d_name);
+            }
+        }
+        closedir(drmDir);
+    }
+    if (m_drmCards.update(std::move(names)).empty()) {
+        return;
+    }
+    // Cards without gpu_busy_percent stay registered with no descriptor, so they are not
+    // probed again on every refresh. What is left in previous was removed, and closes on return.
+    std::vector<GpuCard> previous = std::move(m_gpuCards);
+    m_gpuCards = carryOver(previous, m_drmCards, [](const InstanceRegistry::Instance& card) {
+        GpuCard state{ card.id, ProcFile() };
+        state.busy.open("/sys/class/drm/" + card.name + "/device/gpu_busy_percent");
+        return state;
+    });
+}
+
+void ProcfsCollector::collectGpu(SysInfo& info)
+{
+    if (m_drmCards.refreshDue()) {
+        refreshDrmCards();
+    }
+    double maxGpuLoad = 0.0;
+    for (GpuCard& card : m_gpuCards) {
+        const std::string_view text = card.busy.read();
+        if (!text.empty()) {
+            maxGpuLoad = std::max(maxGpuLoad, static_cast<double>(ProcCursor(text).number()));
+        }
+    }
+    info.gpuLoad = maxGpuLoad;
+}
+
+void ProcfsCollector::refreshInterfaces(std::string_view netDev)
+{
+    std::vector<std::string> names;
+    forEachInterface(netDev, [&names](std::string_view name, unsigned long long, unsigned long long) {
+        names.emplace_back(name);
+    });
+    if (m_interfaces.update(std::move(names)).empty()) {
+        return;
+    }
+    // New interfaces are primed by their first sample rather than counted from zero
+    m_interfaceCounters = carryOver(m_interfaceCounters, m_interfaces, [](const InstanceRegistry::Instance& interface) {
+        return InterfaceCounters{ interface.id, 0, 0, false };
+    });
+}
+
+void ProcfsCollector::collectNetwork(SysInfo& info, double elapsedSec)
+{
+    const std::string_view text = m_netDev.read();
+    if (text.empty()) {
+        info.networkDownloadSpeed = 0.0;
+        info.networkUploadSpeed = 0.0;
+        return;
+    }
+    if (m_interfaces.refreshDue()) {
+        refreshInterfaces(text);
+    }
+
+    // Per interface, so one appearing, disappearing or resetting its counters leaves the
+    // others' traffic intact. Interfaces newer than the last refresh wait for the next one.
+    unsigned long long rxDelta = 0;
+    unsigned long long txDelta = 0;
+    forEachInterface(text, [&](std::string_view name, unsigned long long rxBytes, unsigned long long txBytes) {
+        const int index = m_interfaces.indexOf(name);
+        if (index < 0) {
+            return;
+        }
+        InterfaceCounters& counters = m_interfaceCounters[index];
+        if (counters.primed && rxBytes >= counters.rxBytes && txBytes >= counters.txBytes) {
+            rxDelta += rxBytes - counters.rxBytes;
+            txDelta += txBytes - counters.txBytes;
+        }
+        counters.rxBytes = rxBytes;
+        counters.txBytes = txBytes;
+        counters.primed = true;
+    });
+
+    auto toMBps = [elapsedSec](unsigned long long bytes) {
+        return elapsedSec > 0 ? bytes / elapsedSec / (1024.0 * 1024.0) : 0.0;
+    };
+    info.networkDownloadSpeed = toMBps(rxDelta);
+    info.networkUploadSpeed = toMBps(txDelta);
+}
+
+void ProcfsCollector::collectTemperatures(SysInfo& info)
+{
+    // hwmon reports millidegrees Celsius
+    auto readTemperature = [](ProcFile& file) {
+        const std::string_view text = file.read();
+        return text.empty() ? -1.0 : ProcCursor(text).signedNumber() / 1000.0;
+    };
+    if (m_cpuTemp.isOpen()) {
+        info.cpuTemp = readTemperature(m_cpuTemp);
+    }
+    if (m_gpuTemp.isOpen()) {
+        info.gpuTemp = readTemperature(m_gpuTemp);
+    }
+}
+
+void ProcfsCollector::collectProcesses(SysInfo& info)
+{
+    int count = 0;
+    if (m_procDir) {
+        rewinddir(m_procDir);
+        while (dirent* entry = readdir(m_procDir)) {
+            if (std::isdigit(static_cast<unsigned char>(entry->d_name[0]))) {
+                ++count;
+            }
+        }
+    }
+    info.activeProcesses = count;
+}
+
+void ProcfsCollector::collectUptime(SysInfo& info)
+{
+    const std::string_view text = m_uptime.read();
+    info.systemUptime = !text.empty() ? std::strtod(text.data(), nullptr) / (60.0 * 60.0) : 0.0;
+}
+
+void ProcfsCollector::collectTopProcesses(SysInfo& info)
+{
+    if (!m_processTable.refresh()) {
+        m_processTable.clear();
+    }
+    // The table has just walked /proc, so its count is as fresh as collectProcesses()'s
+    info.activeProcesses = m_processTable.count();
+    m_processTable.topByCpu(info.topCpu, TopProcessCount);
+    m_processTable.topByMemory(info.topMemory, TopProcessCount);
+}
+
+void ProcfsCollector::collectCpuCores(SysInfo& info)
+{
+    if (readProcStatCores(m_coreStat.read(), m_cores) == 0) {
+        info.cpuCores.count = 0;
+        info.cpuCoreMaxLoad = info.cpuFrequencyMHz = info.cpuFrequencyMaxMHz = -1.0;
+        return;
+    }
+    m_cores.update();
+
+    // CPUs that came online since the last sample get their cpufreq file opened
+    for (int core = static_cast<int>(m_frequencyFiles.size()); core < m_cores.cores(); ++core) {
+        m_frequencyFiles.emplace_back();
+        m_frequencyFiles.back().open("/sys/devices/system/cpu/cpu" + std::to_string(core) + "/cpufreq/scaling_cur_freq");
+    }
+    // scaling_cur_freq is in kHz; CPUs without cpufreq (most VMs) or offline ones read 0
+    float* frequencies = m_cores.frequencies();
+    for (int core = 0; core < m_cores.cores(); ++core) {
+        frequencies[core] = ProcCursor(m_frequencyFiles[core].read()).number() / 1000.0f;
+    }
+    m_cores.summarize(info);
+}
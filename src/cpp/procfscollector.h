@@ -0,0 +1,96 @@
+#ifndef PROCFSCOLLECTOR_H
+#define PROCFSCOLLECTOR_H
+
+#include "metriccollector.h"
+#include "cpucores.h"
+#include "instanceregistry.h"
+#include "processtable.h"
+#include "procparse.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <dirent.h>
+
+// Linux backend reading /proc and /sys. Every file is opened once, when its metric group is
+// enabled, and re-read with pread() at offset 0, so a sample costs one syscall per source;
+// the text is parsed in place with ProcCursor. Disabled groups keep no descriptors open.
+class ProcfsCollector : public MetricCollector
+{
+public:
+    ProcfsCollector();
+    ~ProcfsCollector() override;
+
+    const char* name() const override { return "procfs"; }
+    bool initialize() override;
+    void collect(SysInfo& info) override;
+    void collectGroups(SysInfo& info, MetricGroups groups) override;
+    void setEnabledGroups(MetricGroups groups) override;
+    bool providesTemperatures() const override;
+
+private:
+    void collectCpu(SysInfo& info);
+    void collectMemory(SysInfo& info);
+    void collectDisk(SysInfo& info, double elapsedMs);
+    void collectGpu(SysInfo& info);
+    void collectNetwork(SysInfo& info, double elapsedSec);
+    void collectTemperatures(SysInfo& info);
+    void collectProcesses(SysInfo& info);
+    void collectUptime(SysInfo& info);
+    void collectTopProcesses(SysInfo& info);
+    void collectCpuCores(SysInfo& info);
+
+    void openGroup(MetricGroup group);
+    void closeGroup(MetricGroup group);
+    void findHwmonSensors();
+    void refreshDrmCards();
+    void refreshInterfaces(std::string_view netDev);
+
+    ProcFile m_stat;
+    ProcFile m_meminfo;
+    ProcKeyTable m_meminfoKeys;
+    ProcFile m_diskstats;
+    ProcFile m_netDev;
+    ProcFile m_uptime;
+    ProcFile m_cpuTemp;
+    ProcFile m_gpuTemp;
+
+    // DRM cards and network interfaces come and go (eGPUs, VPNs, USB tethering), so both
+    // are re-enumerated every few seconds. The state vectors follow the registries' order.
+    struct GpuCard {
+        InstanceRegistry::Id id;
+        ProcFile busy;
+    };
+    struct InterfaceCounters {
+        InstanceRegistry::Id id;
+        unsigned long long rxBytes;
+        unsigned long long txBytes;
+        bool primed;
+    };
+    InstanceRegistry m_drmCards;
+    std::vector<GpuCard> m_gpuCards;
+    InstanceRegistry m_interfaces;
+    std::vector<InterfaceCounters> m_interfaceCounters;
+    DIR* m_procDir;
+    ProcessTable m_processTable;
+
+    // Per-core ticks come from their own /proc/stat descriptor, since the CpuCores group has
+    // its own cadence; one scaling_cur_freq file per core, closed where there is none
+    ProcFile m_coreStat;
+    std::vector<ProcFile> m_frequencyFiles;
+    CpuCoreAggregator m_cores;
+
+    MetricGroups m_enabledGroups;
+    bool m_initialized;
+
+    // Disk and network rates are per group, since each has its own cadence
+    std::chrono::steady_clock::time_point m_lastDiskTime;
+    std::chrono::steady_clock::time_point m_lastNetworkTime;
+
+    // Previous counter values for delta-based metrics
+    unsigned long long m_lastCpuTotal;
+    unsigned long long m_lastCpuBusy;
+    std::vector<std::string> m_wholeDisks;
+    std::vector<unsigned long long> m_lastIoTicks;
+};
+
+#endif // PROCFSCOLLECTOR_H
@@ -0,0 +1,115 @@
+#include "procparse.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ProcKeyTable::ProcKeyTable(std::initializer_list<std::string_view> keys)
+{
+    m_keys.reserve(keys.size());
+    for (std::string_view key : keys) {
+        m_keys.push_back(Key{ std::string(key), std::string_view::npos });
+    }
+}
+
+bool ProcKeyTable::parse(std::string_view text, quint64* values)
+{
+    bool all = true;
+    // Keys are usually asked for in file order, so a search starts where the last key was
+    size_t from = 0;
+    auto startsLine = [&text](size_t offset) { return offset == 0 || text[offset - 1] == '\n'; };
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        Key& key = m_keys[i];
+        if (key.offset >= text.size() || text.compare(key.offset, key.name.size(), key.name) != 0 ||
+            !startsLine(key.offset)) {
+            key.offset = std::string_view::npos;
+            for (size_t start : { from, size_t(0) }) {
+                for (size_t at = text.find(key.name, start); at != std::string_view::npos;
+                     at = text.find(key.name, at + 1)) {
+                    if (startsLine(at)) {
+                        key.offset = at;
+                        break;
+                    }
+                }
+                if (key.offset != std::string_view::npos || start == 0) {
+                    break;
+                }
+            }
+        }
+        if (key.offset == std::string_view::npos) {
+            values[i] = 0;
+            all = false;
+            continue;
+        }
+        ProcCursor cursor(text.substr(key.offset + key.name.size()));
+        values[i] = cursor.number();
+        from = key.offset + key.name.size();
+    }
+    return all;
+}
+
+#ifdef Q_OS_LINUX
+
+ProcFile::~ProcFile()
+{
+    close();
+}
+
+ProcFile::ProcFile(ProcFile&& other) noexcept
+    : m_fd(other.m_fd)
+    , m_buffer(std::move(other.m_buffer))
+{
+    other.m_fd = -1;
+}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        m_buffer = std::move(other.m_buffer);
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+bool ProcFile::open(const std::string& path)
+{
+    close();
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return m_fd >= 0;
+}
+
+void ProcFile::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+std::string_view ProcFile::read()
+{
+    if (m_fd < 0) {
+        return std::string_view();
+    }
+    // Small to start with, since a /sys file holds a single number; /proc/stat on a large
+    // machine grows it a few times on the first read and never again
+    if (m_buffer.empty()) {
+        m_buffer.resize(256);
+    }
+    for (;;) {
+        const ssize_t bytesRead = ::pread(m_fd, m_buffer.data(), m_buffer.size() - 1, 0);
+        if (bytesRead < 0) {
+            return std::string_view();
+        }
+        if (static_cast<size_t>(bytesRead) < m_buffer.size() - 1) {
+            m_buffer[bytesRead] = '\0';
+            return std::string_view(m_buffer.data(), static_cast<size_t>(bytesRead));
+        }
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef PROCPARSE_H
+#define PROCPARSE_H
+
+#include <QtAlgorithms>
+#include <QtGlobal>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Parsing of /proc text without copies or allocations.
+//
+// ProcFile re-reads a file with pread() into a buffer it keeps, and ProcCursor walks the
+// text in place, handing out std::string_views of it and parsing numbers as it goes. No
+// QString, std::string or strtoull is involved: /proc/stat with hundreds of CPUs, meminfo,
+// /proc/net/dev and every /proc/[pid]/stat are parsed at a few nanoseconds per field.
+
+// Parses the unsigned decimal at p, stopping at end or the first non-digit, and returns
+// the position after it. 0 when p is not at a digit; values beyond 2^64 wrap around.
+//
+// Eight bytes are looked at at once where eight remain: which of them are digits is found
+// with a few mask operations, and up to eight digits are converted with three multiplies
+// (Lemire's SWAR method) instead of a multiply and a branch per digit.
+inline const char* parseDecimal(const char* p, const char* end, quint64& value)
+{
+    quint64 result = 0;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    static const quint64 powersOf10[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    while (end - p >= 8) {
+        quint64 chunk;
+        std::memcpy(&chunk, p, sizeof(chunk));
+        // A byte is a digit if its high nibble is 3 and adding 6 leaves it at 3. Carries only
+        // run from a non-digit into the bytes after it, which are not looked at.
+        const quint64 nonDigits = ((chunk & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL) |
+                                  (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL);
+        const int digits = nonDigits ? static_cast<int>(qCountTrailingZeroBits(nonDigits)) / 8 : 8;
+        if (digits == 0) {
+            break;
+        }
+        // Right-align the digits so the bytes in front of them read as leading zeros
+        chunk = (chunk - 0x3030303030303030ULL) << (8 * (8 - digits));
+        chunk = chunk * 10 + (chunk >> 8);
+        chunk = ((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)) +
+                 ((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+        result = result * powersOf10[digits] + chunk;
+        p += digits;
+        if (digits < 8) {
+            value = result;
+            return p;
+        }
+    }
+#endif
+    for (unsigned digit; p != end && (digit = static_cast<unsigned char>(*p) - '0') < 10; ++p) {
+        result = result * 10 + digit;
+    }
+    value = result;
+    return p;
+}
+
+// A position in /proc text. Fields are separated by spaces or tabs; a field never extends
+// past the end of its line, so a short line cannot make the cursor read the next one.
+class ProcCursor
+{
+public:
+    explicit ProcCursor(std::string_view text)
+        : m_p(text.data())
+        , m_end(text.data() + text.size())
+    {
+    }
+
+    bool atEnd() const { return m_p == m_end; }
+    // The text from the cursor on
+    std::string_view rest() const { return std::string_view(m_p, static_cast<size_t>(m_end - m_p)); }
+
+    void skipSpaces()
+    {
+        while (m_p != m_end && (*m_p == ' ' || *m_p == '\t')) ++m_p;
+    }
+
+    // Skips spaces and parses the unsigned decimal that follows; 0 if there is none
+    quint64 number()
+    {
+        skipSpaces();
+        quint64 value;
+        m_p = parseDecimal(m_p, m_end, value);
+        return value;
+    }
+
+    // The same with an optional minus sign, e.g. hwmon temperatures below zero
+    qint64 signedNumber()
+    {
+        skipSpaces();
+        const bool negative = m_p != m_end && *m_p == '-';
+        m_p += negative;
+        quint64 value;
+        m_p = parseDecimal(m_p, m_end, value);
+        return negative ? -static_cast<qint64>(value) : static_cast<qint64>(value);
+    }
+
+    // Skips spaces and returns the field up to the next space or the end of the line
+    std::string_view word()
+    {
+        skipSpaces();
+        const char* start = m_p;
+        while (m_p != m_end && *m_p != ' ' && *m_p != '\t' && *m_p != '\n') ++m_p;
+        return std::string_view(start, static_cast<size_t>(m_p - start));
+    }
+
+    void skipWords(int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            word();
+        }
+    }
+
+    // Moves past prefix if the text at the cursor starts with it
+    bool consume(std::string_view prefix)
+    {
+        if (static_cast<size_t>(m_end - m_p) < prefix.size() || std::memcmp(m_p, prefix.data(), prefix.size()) != 0) {
+            return false;
+        }
+        m_p += prefix.size();
+        return true;
+    }
+
+    // Moves past the next delimiter on the current line, handing out the text before it;
+    // false, with the cursor left where it was, if the line has none
+    bool until(char delimiter, std::string_view& text)
+    {
+        for (const char* p = m_p; p != m_end && *p != '\n'; ++p) {
+            if (*p == delimiter) {
+                text = std::string_view(m_p, static_cast<size_t>(p - m_p));
+                m_p = p + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves to the start of the next line; false, at the end of the text, if there is none
+    bool nextLine()
+    {
+        if (m_p == m_end) {
+            return false;
+        }
+        const void* newline = std::memchr(m_p, '\n', static_cast<size_t>(m_end - m_p));
+        m_p = newline ? static_cast<const char*>(newline) + 1 : m_end;
+        return m_p != m_end;
+    }
+
+private:
+    const char* m_p;
+    const char* m_end;
+};
+
+// Values of "Key:   value" lines, such as /proc/meminfo or /proc/self/status.
+//
+// The first parse searches the text for every key and remembers the offset of its line.
+// The kernel prints the same keys in the same order at the same width every time, so later
+// parses find each key with one compare at its offset and only search again when that
+// misses (a value grew a digit, a kernel update added a line).
+class ProcKeyTable
+{
+public:
+    // Keys as they start their lines, colon included, e.g. "MemAvailable:"
+    ProcKeyTable(std::initializer_list<std::string_view> keys);
+
+    int size() const { return static_cast<int>(m_keys.size()); }
+    // Stores the number after each key in values, in the order the keys were given; false
+    // if any key is missing, whose value is then 0
+    bool parse(std::string_view text, quint64* values);
+
+private:
+    struct Key {
+        std::string name;
+        size_t offset;
+    };
+    std::vector<Key> m_keys;
+};
+
+#ifdef Q_OS_LINUX
+
+// A /proc or /sys file kept open and re-read from offset 0 with one pread() per read, into
+// a buffer of its own that is grown once when the file outgrows it and then reused.
+class ProcFile
+{
+public:
+    ProcFile() = default;
+    ~ProcFile();
+    ProcFile(ProcFile&& other) noexcept;
+    ProcFile& operator=(ProcFile&& other) noexcept;
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    // Closes any file open before; false if path cannot be opened
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    // The whole file as it is now, valid until the next read(); empty when the file is not
+    // open or cannot be read. The text is followed by a NUL for the odd strtod().
+    std::string_view read();
+
+private:
+    int m_fd = -1;
+    std::vector<char> m_buffer;
+};
+
+#endif
+
+#endif // PROCPARSE_H
@@ -0,0 +1,183 @@
+#include "quantilesketch.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+int highestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+} // namespace
+
+int QuantileSketch::bucketIndex(uint64_t value)
+{
+    // The first two powers of two are exact; above that, the top SubBucketBits bits below
+    // the leading one pick the sub-bucket
+    if (value < 2 * SubBuckets) {
+        return static_cast<int>(value);
+    }
+    const uint64_t largest = (uint64_t(1) << (MaxExponent + 1)) - 1;
+    if (value > largest) {
+        value = largest;
+    }
+    const int shift = highestBit(value) - SubBucketBits;
+    const int mantissa = static_cast<int>(value >> shift);
+    return (shift + 1) * SubBuckets + (mantissa - SubBuckets);
+}
+
+uint64_t QuantileSketch::bucketLowerBound(int index)
+{
+    if (index < 2 * SubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = index / SubBuckets - 1;
+    const uint64_t mantissa = static_cast<uint64_t>(index % SubBuckets + SubBuckets);
+    return mantissa << shift;
+}
+
+uint64_t QuantileSketch::bucketUpperBound(int index)
+{
+    if (index < 2 * SubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = index / SubBuckets - 1;
+    const uint64_t mantissa = static_cast<uint64_t>(index % SubBuckets + SubBuckets);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void QuantileSketch::add(uint64_t value)
+{
+    ++m_buckets[bucketIndex(value)];
+    ++m_count;
+    m_sum += value;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+}
+
+void QuantileSketch::subtract(const QuantileSketch& other)
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        m_buckets[i] -= other.m_buckets[i];
+    }
+    m_count -= other.m_count;
+    m_sum -= other.m_sum;
+}
+
+void QuantileSketch::clear()
+{
+    *this = QuantileSketch();
+}
+
+uint64_t QuantileSketch::quantile(double q) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    // Rank of the requested value, 1-based, so q = 0 is the minimum and q = 1 the maximum
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(m_count) + 0.5);
+    rank = rank < 1 ? 1 : (rank > m_count ? m_count : rank);
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return (bucketLowerBound(i) + bucketUpperBound(i)) / 2;
+        }
+    }
+    return bucketUpperBound(BucketCount - 1);
+}
+
+SlidingQuantileSketch::SlidingQuantileSketch(qint64 sliceLength, int sliceCount)
+    : m_sliceLength(qMax<qint64>(1, sliceLength))
+    , m_currentSlice(0)
+    , m_started(false)
+    , m_slices(qMax(1, sliceCount))
+{
+}
+
+int SlidingQuantileSketch::slot(qint64 slice) const
+{
+    const qint64 index = slice % sliceCount();
+    return static_cast<int>(index < 0 ? index + sliceCount() : index);
+}
+
+void SlidingQuantileSketch::add(uint64_t value, qint64 time)
+{
+    advance(time);
+    m_slices[slot(m_currentSlice)].add(value);
+    m_total.add(value);
+}
+
+void SlidingQuantileSketch::advance(qint64 time)
+{
+    const qint64 slice = time >= 0 ? time / m_sliceLength : (time + 1) / m_sliceLength - 1;
+    if (!m_started) {
+        m_currentSlice = slice;
+        m_started = true;
+        return;
+    }
+    if (slice <= m_currentSlice) {
+        return;
+    }
+    if (slice - m_currentSlice >= sliceCount()) {
+        // A gap longer than the window: nothing in it survives
+        for (QuantileSketch& sketch : m_slices) {
+            sketch.clear();
+        }
+        m_total.clear();
+        m_currentSlice = slice;
+        return;
+    }
+    // Each step reuses the oldest slice as the new current one
+    while (m_currentSlice < slice) {
+        ++m_currentSlice;
+        QuantileSketch& expired = m_slices[slot(m_currentSlice)];
+        if (expired.count() > 0) {
+            m_total.subtract(expired);
+            expired.clear();
+        }
+    }
+}
+
+void SlidingQuantileSketch::clear()
+{
+    for (QuantileSketch& sketch : m_slices) {
+        sketch.clear();
+    }
+    m_total.clear();
+    m_started = false;
+}
+
+uint64_t SlidingQuantileSketch::recentCount(int slices) const
+{
+    uint64_t count = 0;
+    for (int i = 0; i < qMin(slices, sliceCount()); ++i) {
+        count += m_slices[slot(m_currentSlice - i)].count();
+    }
+    return count;
+}
+
+uint64_t SlidingQuantileSketch::recentSum(int slices) const
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < qMin(slices, sliceCount()); ++i) {
+        sum += m_slices[slot(m_currentSlice - i)].sum();
+    }
+    return sum;
+}
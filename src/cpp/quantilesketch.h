@@ -0,0 +1,73 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <QtGlobal>
+#include <cstdint>
+#include <vector>
+
+// Counts of non-negative integer values in log-linear buckets, the layout of
+// Instrumentation::LatencyHistogram without the atomics: 16 linear sub-buckets per power of
+// two, so a quantile is off by at most 1/32 of its value (reported at the bucket's
+// midpoint), in fixed storage whatever the number of values. Values above 2^32 are clamped.
+class QuantileSketch
+{
+public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxExponent = 32;
+    static constexpr int BucketCount = (MaxExponent - SubBucketBits + 2) * SubBuckets;
+
+    void add(uint64_t value);
+    // Adds or takes away every value of other, e.g. a slice entering or leaving a window
+    void merge(const QuantileSketch& other);
+    void subtract(const QuantileSketch& other);
+    void clear();
+
+    uint64_t count() const { return m_count; }
+    uint64_t sum() const { return m_sum; }
+    // Value at quantile q in [0, 1]; 0 when empty
+    uint64_t quantile(double q) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(int index);
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    quint32 m_buckets[BucketCount] = {};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+};
+
+// A QuantileSketch over the last sliceCount slices of sliceLength time units. Each slice
+// has its own sketch and the window's total is kept alongside, so a value costs two bucket
+// increments and moving the window costs one subtract per expired slice, however many
+// values there are. Time is whatever the caller counts in and only ever moves forward;
+// results depend on nothing but the values and their times.
+class SlidingQuantileSketch
+{
+public:
+    SlidingQuantileSketch(qint64 sliceLength, int sliceCount);
+
+    void add(uint64_t value, qint64 time);
+    // Expires the slices that ended before the window reaching up to time
+    void advance(qint64 time);
+    void clear();
+
+    qint64 sliceLength() const { return m_sliceLength; }
+    int sliceCount() const { return static_cast<int>(m_slices.size()); }
+    const QuantileSketch& window() const { return m_total; }
+    // Count and sum over the newest slices only, the current one included
+    uint64_t recentCount(int slices) const;
+    uint64_t recentSum(int slices) const;
+
+private:
+    int slot(qint64 slice) const;
+
+    qint64 m_sliceLength;
+    qint64 m_currentSlice;  // absolute index, time / sliceLength
+    bool m_started;
+    std::vector<QuantileSketch> m_slices;
+    QuantileSketch m_total;
+};
+
+#endif // QUANTILESKETCH_H
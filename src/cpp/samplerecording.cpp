@@ -0,0 +1,543 @@
+#include "samplerecording.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SampleRecording {
+
+namespace {
+
+constexpr size_t FileHeaderSize = 8;
+constexpr size_t BlockHeaderSize = 32;
+// Keeps every delta and delta-of-delta far away from int64 overflow
+constexpr int64_t MaxQuantized = int64_t(1) << 52;
+
+void put16(unsigned char* p, uint16_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+void put32(unsigned char* p, uint32_t v) { put16(p, uint16_t(v)); put16(p + 2, uint16_t(v >> 16)); }
+void put64(unsigned char* p, uint64_t v) { put32(p, uint32_t(v)); put32(p + 4, uint32_t(v >> 32)); }
+uint16_t get16(const unsigned char* p) { return uint16_t(p[0] | (p[1] << 8)); }
+uint32_t get32(const unsigned char* p) { return get16(p) | (uint32_t(get16(p + 2)) << 16); }
+uint64_t get64(const unsigned char* p) { return get32(p) | (uint64_t(get32(p + 4)) << 32); }
+
+double getDouble(const unsigned char* p)
+{
+    const uint64_t bits = get64(p);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void putDouble(unsigned char* p, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put64(p, bits);
+}
+
+int64_t quantize(double value, double inverseResolution)
+{
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    const double scaled = std::round(value * inverseResolution);
+    return static_cast<int64_t>(std::clamp(scaled, double(-MaxQuantized), double(MaxQuantized)));
+}
+
+int64_t signExtend(uint64_t value, int bits)
+{
+    const uint64_t sign = uint64_t(1) << (bits - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+} // namespace
+
+double metricResolution(Metric metric)
+{
+    switch (metric) {
+    case Metric::CpuLoad:
+    case Metric::DiskLoad:
+    case Metric::GpuLoad:
+    case Metric::Fps:
+    case Metric::FpsLow1Percent:
+    case Metric::CpuTemp:
+    case Metric::GpuTemp:
+    case Metric::HelperStartup:
+    case Metric::SelfMemory:
+        return 0.1;
+    case Metric::NetworkDownload:
+    case Metric::NetworkUpload:
+        return 0.001; // 1 KB/s
+    case Metric::SystemUptime:
+        return 1.0 / 3600.0; // one second, in hours
+    case Metric::SensorLatency:
+    case Metric::HelperCpu:
+    case Metric::SelfCpu:
+    case Metric::FrameTimeP50:
+    case Metric::FrameTimeP99:
+        return 0.01;
+    default:
+        return 1.0;
+    }
+}
+
+// --- Bit streams ---
+
+void BitWriter::write(uint64_t value, int bits)
+{
+    if (bits < 64) {
+        value &= (uint64_t(1) << bits) - 1;
+    }
+    const int free = 64 - m_used;
+    if (bits <= free) {
+        m_accumulator |= value << (free - bits);
+        m_used += bits;
+        if (m_used == 64) {
+            flushWord();
+        }
+        return;
+    }
+    const int rest = bits - free;
+    m_accumulator |= value >> rest;
+    flushWord();
+    m_accumulator = value << (64 - rest);
+    m_used = rest;
+}
+
+void BitWriter::flushWord()
+{
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        m_bytes.push_back(static_cast<unsigned char>(m_accumulator >> shift));
+    }
+    m_accumulator = 0;
+    m_used = 0;
+}
+
+const std::vector<unsigned char>& BitWriter::finish()
+{
+    for (int shift = 56; m_used > 0; shift -= 8, m_used -= std::min(m_used, 8)) {
+        m_bytes.push_back(static_cast<unsigned char>(m_accumulator >> shift));
+    }
+    m_accumulator = 0;
+    return m_bytes;
+}
+
+void BitReader::refill()
+{
+    m_buffer = 0;
+    for (int i = 0; i < 8; ++i) {
+        m_buffer <<= 8;
+        if (m_offset < m_size) {
+            m_buffer |= m_data[m_offset];
+        }
+        ++m_offset;
+    }
+    m_available = 64;
+}
+
+uint64_t BitReader::read(int bits)
+{
+    uint64_t result = 0;
+    while (bits > 0) {
+        if (m_available == 0) {
+            refill();
+        }
+        const int take = std::min(bits, m_available);
+        const uint64_t chunk = take == 64 ? m_buffer : (m_buffer >> (m_available - take)) & ((uint64_t(1) << take) - 1);
+        result = take == 64 ? chunk : (result << take) | chunk;
+        m_available -= take;
+        bits -= take;
+    }
+    return result;
+}
+
+// --- Column coding ---
+
+void ColumnEncoder::encode(BitWriter& out, int64_t value)
+{
+    if (count++ == 0) {
+        out.write(static_cast<uint64_t>(value), 64);
+        previous = value;
+        previousDelta = 0;
+        return;
+    }
+    const int64_t delta = value - previous;
+    const int64_t dod = delta - previousDelta;
+    previous = value;
+    previousDelta = delta;
+
+    if (dod == 0) {
+        out.write(0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        out.write(0x2, 2);
+        out.write(static_cast<uint64_t>(dod), 7);
+    } else if (dod >= -2048 && dod <= 2047) {
+        out.write(0x6, 3);
+        out.write(static_cast<uint64_t>(dod), 12);
+    } else if (dod >= -524288 && dod <= 524287) {
+        out.write(0xe, 4);
+        out.write(static_cast<uint64_t>(dod), 20);
+    } else {
+        out.write(0xf, 4);
+        out.write(static_cast<uint64_t>(dod), 64);
+    }
+}
+
+int64_t ColumnDecoder::decode(BitReader& in)
+{
+    if (count++ == 0) {
+        previous = static_cast<int64_t>(in.read(64));
+        previousDelta = 0;
+        return previous;
+    }
+    int64_t dod = 0;
+    if (in.read(1)) {
+        if (!in.read(1)) {
+            dod = signExtend(in.read(7), 7);
+        } else if (!in.read(1)) {
+            dod = signExtend(in.read(12), 12);
+        } else if (!in.read(1)) {
+            dod = signExtend(in.read(20), 20);
+        } else {
+            dod = static_cast<int64_t>(in.read(64));
+        }
+    }
+    previousDelta += dod;
+    previous += previousDelta;
+    return previous;
+}
+
+// --- Recorder ---
+
+Recorder::Recorder()
+    : m_file(nullptr)
+    , m_samples(0)
+    , m_firstTimestamp(0)
+    , m_lastTimestamp(0)
+{
+    for (int m = 0; m < MetricCount; ++m) {
+        m_inverseResolution[m] = 1.0 / metricResolution(static_cast<Metric>(m));
+    }
+}
+
+Recorder::~Recorder()
+{
+    close();
+}
+
+bool Recorder::open(const std::string& path)
+{
+    close();
+
+    std::error_code error;
+    if (std::filesystem::exists(path, error) && std::filesystem::file_size(path, error) > 0) {
+        Recording existing;
+        if (!existing.open(path) || existing.metricCount() != MetricCount) {
+            return false;
+        }
+        for (int m = 0; m < MetricCount; ++m) {
+            if (existing.resolution(m) != metricResolution(static_cast<Metric>(m))) {
+                return false;
+            }
+        }
+        // Drop a block that was cut off by a crash so new blocks follow the last good one
+        const size_t validLength = existing.validLength();
+        existing.close();
+        std::filesystem::resize_file(path, validLength, error);
+        if (error) {
+            return false;
+        }
+        m_file = std::fopen(path.c_str(), "ab");
+        if (!m_file) {
+            return false;
+        }
+    } else {
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file) {
+            return false;
+        }
+        std::vector<unsigned char> header(FileHeaderSize + 8 * MetricCount);
+        put32(header.data(), FileMagic);
+        put16(header.data() + 4, FormatVersion);
+        put16(header.data() + 6, MetricCount);
+        for (int m = 0; m < MetricCount; ++m) {
+            putDouble(header.data() + FileHeaderSize + 8 * m, metricResolution(static_cast<Metric>(m)));
+        }
+        if (std::fwrite(header.data(), 1, header.size(), m_file) != header.size() || std::fflush(m_file) != 0) {
+            close();
+            return false;
+        }
+    }
+
+    m_samples = 0;
+    for (int c = 0; c <= MetricCount; ++c) {
+        m_columns[c].clear();
+        m_encoders[c].reset();
+    }
+    return true;
+}
+
+void Recorder::close()
+{
+    if (!m_file) {
+        return;
+    }
+    flush();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void Recorder::append(const SysInfo& info, int64_t timestampMs)
+{
+    if (!m_file) {
+        return;
+    }
+    if (m_samples == 0) {
+        m_firstTimestamp = timestampMs;
+    }
+    m_lastTimestamp = timestampMs;
+    m_encoders[0].encode(m_columns[0], timestampMs);
+    for (int m = 0; m < MetricCount; ++m) {
+        m_encoders[m + 1].encode(m_columns[m + 1], quantize(metricValue(info, static_cast<Metric>(m)), m_inverseResolution[m]));
+    }
+    if (++m_samples == BlockSamples) {
+        writeBlock();
+    }
+}
+
+bool Recorder::flush()
+{
+    if (!m_file || m_samples == 0) {
+        return true;
+    }
+    return writeBlock();
+}
+
+bool Recorder::writeBlock()
+{
+    constexpr int Columns = MetricCount + 1;
+    unsigned char header[BlockHeaderSize + 4 * Columns];
+    put32(header, BlockMagic);
+    put32(header + 4, static_cast<uint32_t>(m_samples));
+    put32(header + 8, Columns);
+    put32(header + 12, 0);
+    put64(header + 16, static_cast<uint64_t>(m_firstTimestamp));
+    put64(header + 24, static_cast<uint64_t>(m_lastTimestamp));
+    for (int c = 0; c < Columns; ++c) {
+        put32(header + BlockHeaderSize + 4 * c, static_cast<uint32_t>(m_columns[c].finish().size()));
+    }
+
+    bool ok = std::fwrite(header, 1, sizeof(header), m_file) == sizeof(header);
+    for (int c = 0; c < Columns; ++c) {
+        const std::vector<unsigned char>& bytes = m_columns[c].finish();
+        ok = ok && std::fwrite(bytes.data(), 1, bytes.size(), m_file) == bytes.size();
+        m_columns[c].clear();
+        m_encoders[c].reset();
+    }
+    m_samples = 0;
+    return std::fflush(m_file) == 0 && ok;
+}
+
+// --- Recording ---
+
+Recording::~Recording()
+{
+    close();
+}
+
+bool Recording::open(const std::string& path)
+{
+    close();
+    if (!map(path)) {
+        return false;
+    }
+    if (m_size < FileHeaderSize || get32(m_data) != FileMagic || get16(m_data + 4) != FormatVersion) {
+        close();
+        return false;
+    }
+    const int fileMetrics = get16(m_data + 6);
+    size_t offset = FileHeaderSize + 8 * size_t(fileMetrics);
+    if (offset > m_size) {
+        close();
+        return false;
+    }
+    // Recordings from builds with fewer metrics replay fine; extra metrics are ignored
+    m_metricCount = std::min(fileMetrics, MetricCount);
+    for (int m = 0; m < m_metricCount; ++m) {
+        m_resolution[m] = getDouble(m_data + FileHeaderSize + 8 * m);
+    }
+
+    const size_t columns = size_t(fileMetrics) + 1;
+    while (offset + BlockHeaderSize + 4 * columns <= m_size) {
+        const unsigned char* p = m_data + offset;
+        if (get32(p) != BlockMagic || get32(p + 8) != columns) {
+            break;
+        }
+        Block block;
+        block.samples = static_cast<int>(get32(p + 4));
+        block.firstTimestampMs = static_cast<int64_t>(get64(p + 16));
+        block.lastTimestampMs = static_cast<int64_t>(get64(p + 24));
+        size_t columnOffset = offset + BlockHeaderSize + 4 * columns;
+        for (size_t c = 0; c < columns; ++c) {
+            const uint32_t size = get32(p + BlockHeaderSize + 4 * c);
+            if (c <= size_t(MetricCount)) {
+                block.columns[c] = m_data + columnOffset;
+                block.columnSizes[c] = size;
+            }
+            columnOffset += size;
+        }
+        if (columnOffset > m_size) {
+            break;
+        }
+        m_blocks.push_back(block);
+        m_sampleCount += block.samples;
+        offset = columnOffset;
+    }
+    m_validLength = offset;
+    return true;
+}
+
+#ifdef _WIN32
+
+bool Recording::map(const std::string& path)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    m_fileHandle = file;
+    m_mapping = mapping;
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void Recording::close()
+{
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if (m_fileHandle) {
+        CloseHandle(m_fileHandle);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_fileHandle = nullptr;
+    m_size = 0;
+    m_blocks.clear();
+    m_sampleCount = 0;
+    m_validLength = 0;
+}
+
+#else
+
+bool Recording::map(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    // Replay reads front to back
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char*>(view);
+    m_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void Recording::close()
+{
+    if (m_data) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_blocks.clear();
+    m_sampleCount = 0;
+    m_validLength = 0;
+}
+
+#endif
+
+// --- Cursor ---
+
+Cursor::Cursor(const Recording& recording)
+    : m_recording(recording)
+{
+    rewind();
+}
+
+void Cursor::rewind()
+{
+    m_block = 0;
+    m_remaining = 0;
+    if (!m_recording.blocks().empty()) {
+        loadBlock(0);
+    }
+}
+
+void Cursor::loadBlock(size_t index)
+{
+    const Recording::Block& block = m_recording.blocks()[index];
+    m_block = index;
+    m_remaining = block.samples;
+    for (int c = 0; c <= m_recording.metricCount(); ++c) {
+        m_readers[c] = BitReader(block.columns[c], block.columnSizes[c]);
+        m_decoders[c] = ColumnDecoder();
+    }
+}
+
+bool Cursor::next(SysInfo& info, int64_t& timestampMs)
+{
+    while (m_remaining == 0) {
+        if (m_block + 1 >= m_recording.blocks().size()) {
+            return false;
+        }
+        loadBlock(m_block + 1);
+    }
+    --m_remaining;
+    timestampMs = m_decoders[0].decode(m_readers[0]);
+    for (int m = 0; m < m_recording.metricCount(); ++m) {
+        const int64_t value = m_decoders[m + 1].decode(m_readers[m + 1]);
+        setMetricValue(info, static_cast<Metric>(m), value * m_recording.resolution(m));
+    }
+    return true;
+}
+
+} // namespace SampleRecording
@@ -0,0 +1,202 @@
+#ifndef SAMPLERECORDING_H
+#define SAMPLERECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "sysinfo.h"
+
+// Append-only on-disk recording of samples (recording/path), replayed by PlaybackCollector.
+//
+// Samples are grouped into blocks of up to BlockSamples. Within a block every metric is
+// its own column, so a reader can decode one metric without touching the others. Each
+// column is a bit stream compressed in the style of Gorilla: values are quantized to the
+// resolution the overlay displays (per-metric, stored in the file header), then the first
+// value of a block is stored raw and every later one as a delta-of-delta in a variable
+// width bucket:
+//
+//   0                       same delta as before
+//   10   +  7 bits          delta-of-delta in [-64, 63]
+//   110  + 12 bits          [-2048, 2047]
+//   1110 + 20 bits          [-524288, 524287]
+//   1111 + 64 bits          anything else
+//
+// Timestamps (ms) are column 0 and use the same scheme, so a steady interval costs one bit
+// per sample. A metric that holds still costs one bit; a noisy one around ten.
+//
+// Everything is little-endian:
+//
+//   file header   u32 magic "WSRC", u16 version, u16 metric count, f64 resolution per metric
+//   block         u32 magic "WSRB", u32 sample count, u32 column count, u32 reserved,
+//                 i64 first timestamp, i64 last timestamp, u32 byte length per column,
+//                 then the columns back to back
+//
+// A block is only written once it is complete (or on flush), so a crash loses at most the
+// samples of the block in progress and never leaves a half-written block behind that a
+// reader would trust: a truncated tail is ignored, and cut off when appending.
+namespace SampleRecording {
+
+constexpr uint32_t FileMagic = 0x43525357;  // "WSRC" read as little-endian
+constexpr uint32_t BlockMagic = 0x42525357; // "WSRB"
+constexpr uint16_t FormatVersion = 1;
+constexpr int BlockSamples = 600;
+
+// Resolution a metric is recorded at
+double metricResolution(Metric metric);
+
+class BitWriter
+{
+public:
+    void clear() { m_bytes.clear(); m_accumulator = 0; m_used = 0; }
+    // Writes the low bits of value, most significant first. bits is 1..64.
+    void write(uint64_t value, int bits);
+    // Pads the last byte with zeros and returns the stream
+    const std::vector<unsigned char>& finish();
+
+private:
+    void flushWord();
+
+    std::vector<unsigned char> m_bytes;
+    uint64_t m_accumulator = 0;
+    int m_used = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader() = default;
+    BitReader(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+    // Reads past the end return zeros
+    uint64_t read(int bits);
+
+private:
+    void refill();
+
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    uint64_t m_buffer = 0;
+    int m_available = 0;
+};
+
+// Delta-of-delta coding of one column of integers
+struct ColumnEncoder {
+    void encode(BitWriter& out, int64_t value);
+    void reset() { count = 0; previous = 0; previousDelta = 0; }
+
+    int64_t count = 0;
+    int64_t previous = 0;
+    int64_t previousDelta = 0;
+};
+
+struct ColumnDecoder {
+    int64_t decode(BitReader& in);
+
+    int64_t count = 0;
+    int64_t previous = 0;
+    int64_t previousDelta = 0;
+};
+
+// Writer side. Lives on the sampler thread.
+class Recorder
+{
+public:
+    Recorder();
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Appends to an existing compatible recording, or starts a new one. Fails rather than
+    // overwrite a file that is not a recording of the same layout.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_file != nullptr; }
+
+    // Encodes into the block in memory; the block is written out when it is full
+    void append(const SysInfo& info, int64_t timestampMs);
+    // Writes out the block in progress, even if it is short
+    bool flush();
+
+private:
+    bool writeBlock();
+
+    std::FILE* m_file;
+    int m_samples;
+    int64_t m_firstTimestamp;
+    int64_t m_lastTimestamp;
+    BitWriter m_columns[MetricCount + 1];
+    ColumnEncoder m_encoders[MetricCount + 1];
+    double m_inverseResolution[MetricCount];
+};
+
+// Reader side: the file is memory-mapped read-only and decoded on demand.
+class Recording
+{
+public:
+    struct Block {
+        const unsigned char* columns[MetricCount + 1];
+        uint32_t columnSizes[MetricCount + 1];
+        int samples;
+        int64_t firstTimestampMs;
+        int64_t lastTimestampMs;
+    };
+
+    Recording() = default;
+    ~Recording();
+    Recording(const Recording&) = delete;
+    Recording& operator=(const Recording&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int64_t sampleCount() const { return m_sampleCount; }
+    int64_t firstTimestampMs() const { return m_blocks.empty() ? 0 : m_blocks.front().firstTimestampMs; }
+    int64_t lastTimestampMs() const { return m_blocks.empty() ? 0 : m_blocks.back().lastTimestampMs; }
+    const std::vector<Block>& blocks() const { return m_blocks; }
+    int metricCount() const { return m_metricCount; }
+    double resolution(int metric) const { return m_resolution[metric]; }
+    // Bytes up to the end of the last complete block
+    size_t validLength() const { return m_validLength; }
+
+private:
+    bool map(const std::string& path);
+
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mapping = nullptr;
+#endif
+    int m_metricCount = 0;
+    double m_resolution[MetricCount] = {};
+    std::vector<Block> m_blocks;
+    int64_t m_sampleCount = 0;
+    size_t m_validLength = 0;
+};
+
+// Sequential decoder over a Recording
+class Cursor
+{
+public:
+    explicit Cursor(const Recording& recording);
+
+    // Decodes the next sample. Metrics the recording does not have are left untouched.
+    bool next(SysInfo& info, int64_t& timestampMs);
+    void rewind();
+
+private:
+    void loadBlock(size_t index);
+
+    const Recording& m_recording;
+    size_t m_block;
+    int m_remaining;
+    BitReader m_readers[MetricCount + 1];
+    ColumnDecoder m_decoders[MetricCount + 1];
+};
+
+} // namespace SampleRecording
+
+#endif // SAMPLERECORDING_H
@@ -0,0 +1,37 @@
+#include "samplersettings.h"
+#include <QSettings>
+
+bool SamplerSettings::operator==(const SamplerSettings& other) const
+{
+    return updateInterval == other.updateInterval && historyMinutes == other.historyMinutes &&
+           adaptiveSampling == other.adaptiveSampling && minInterval == other.minInterval &&
+           maxInterval == other.maxInterval && metricGroups == other.metricGroups &&
+           sensorHelperPath == other.sensorHelperPath && sensorStreaming == other.sensorStreaming &&
+           sensorTransport == other.sensorTransport && frameSource == other.frameSource &&
+           exporterEnabled == other.exporterEnabled &&
+           exporterPort == other.exporterPort && recordingPath == other.recordingPath &&
+           playbackPath == other.playbackPath && playbackSpeed == other.playbackSpeed &&
+           alertRules == other.alertRules && trackDailyData == other.trackDailyData;
+}
+
+SamplerSettings SamplerSettings::load()
+{
+    QSettings s;
+    SamplerSettings settings;
+    settings.updateInterval = s.value("behavior/updateInterval", 1000).toInt();
+    settings.historyMinutes = s.value("behavior/historyMinutes", 60).toInt();
+    settings.adaptiveSampling = s.value("behavior/adaptiveSampling", false).toBool();
+    settings.minInterval = s.value("behavior/minInterval", 100).toInt();
+    settings.maxInterval = s.value("behavior/maxInterval", 5000).toInt();
+    settings.sensorHelperPath = s.value("sensors/helperPath").toString();
+    settings.sensorStreaming = s.value("sensors/streaming", true).toBool();
+    settings.sensorTransport = s.value("sensors/transport", "pipe").toString();
+    settings.frameSource = s.value("fps/source").toString();
+    settings.exporterEnabled = s.value("exporter/enabled", false).toBool();
+    settings.exporterPort = s.value("exporter/port", 9469).toInt();
+    settings.recordingPath = s.value("recording/path").toString();
+    settings.playbackPath = s.value("playback/path").toString();
+    settings.playbackSpeed = s.value("playback/speed", 1.0).toDouble();
+    settings.alertRules = AlertEngine::load(s);
+    return settings;
+}
@@ -0,0 +1,58 @@
+#ifndef SAMPLERSETTINGS_H
+#define SAMPLERSETTINGS_H
+
+#include <QString>
+#include "metriccollector.h"
+#include "alertengine.h"
+
+// The part of the settings the sampler itself needs. Qt Core only, so it can be shared
+// by the overlay (as part of OverlaySettings) and the headless collector.
+struct SamplerSettings {
+    int updateInterval = 1000;
+    int historyMinutes = 60;
+    // Every metric group starts at updateInterval. Adaptive sampling then speeds a group up
+    // while its values move, to no faster than minInterval, and backs it off while they hold
+    // still, to maxInterval (see SamplingScheduler).
+    bool adaptiveSampling = false;
+    int minInterval = 100;
+    int maxInterval = 5000;
+    // Groups worth collecting at all. Not a stored setting; the overlay narrows it to the
+    // rows it shows unless the exporter or a recording needs every metric.
+    MetricGroups metricGroups = MetricSetGroups;
+
+    // Empty means TempReader.exe on Windows and no helper elsewhere
+    QString sensorHelperPath;
+    // Helper pushes frames every updateInterval instead of answering per-poll requests
+    bool sensorStreaming = true;
+    // "pipe" frames readings on the helper's stdout, "shm" uses a shared seqlock segment
+    QString sensorTransport = "pipe";
+
+    // Where FPS comes from, see FrameEventSource::create(); empty is ETW on Windows and
+    // nothing elsewhere
+    QString frameSource;
+
+    // Localhost OpenMetrics endpoint, see MetricsExporter
+    bool exporterEnabled = false;
+    int exporterPort = 9469;
+
+    // Appends every sample to this file (see SampleRecording); empty records nothing
+    QString recordingPath;
+    // Replays this recording instead of collecting live samples. Speed 1 follows the
+    // recorded timestamps; 0 replays every sample as fast as the consumer takes them.
+    QString playbackPath;
+    double playbackSpeed = 1.0;
+
+    // Threshold rules evaluated on every sample (see AlertEngine); the "alerts" array
+    AlertRules alertRules;
+
+    // Integrate network traffic into the persisted daily usage counter. Not a stored
+    // setting; the headless collector turns it off so it never touches the overlay's total.
+    bool trackDailyData = true;
+
+    bool operator==(const SamplerSettings& other) const;
+    bool operator!=(const SamplerSettings& other) const { return !(*this == other); }
+
+    static SamplerSettings load();
+};
+
+#endif // SAMPLERSETTINGS_H
@@ -0,0 +1,140 @@
+#include "samplingscheduler.h"
+#include <cmath>
+
+namespace {
+
+// Relative cost of collecting a group, as a multiple of the minimum interval it may run at
+const int CostFactor[MetricGroupCount] = {
+    1, // Cpu
+    1, // Memory
+    2, // Disk
+    4, // Gpu: one PDH counter per engine on Windows
+    1, // Network
+    2, // Temperatures
+    4, // Processes: walks every process
+    1, // Uptime, which never speeds up anyway
+    8, // TopProcesses: reads every process's stat
+    1, // Frames: a drain of what the frame source buffered
+    2  // CpuCores: a /proc/stat line and a cpufreq read per core on Linux
+};
+
+// Values a group is judged by, and the change that counts as "moving"
+int groupValues(MetricGroup group, const SysInfo& info, double* values)
+{
+    switch (group) {
+    case MetricGroup::Cpu: values[0] = info.cpuLoad; return 1;
+    case MetricGroup::Memory: values[0] = info.memUsage; return 1;
+    case MetricGroup::Disk: values[0] = info.diskLoad; return 1;
+    case MetricGroup::Gpu: values[0] = info.gpuLoad; return 1;
+    case MetricGroup::Network: values[0] = info.networkDownloadSpeed; values[1] = info.networkUploadSpeed; return 2;
+    case MetricGroup::Temperatures: values[0] = info.cpuTemp; values[1] = info.gpuTemp; return 2;
+    case MetricGroup::Processes: values[0] = info.activeProcesses; return 1;
+    case MetricGroup::TopProcesses: values[0] = info.topCpu[0].cpuPercent; values[1] = info.topMemory[0].residentMB; return 2;
+    case MetricGroup::Frames: values[0] = info.fps; values[1] = info.fpsLow1Percent; return 2;
+    case MetricGroup::CpuCores: values[0] = info.cpuCoreMaxLoad; values[1] = info.cpuFrequencyMHz; return 2;
+    case MetricGroup::Uptime: case MetricGroup::Count: break;
+    }
+    return 0;
+}
+
+double threshold(MetricGroup group, double a, double b)
+{
+    switch (group) {
+    case MetricGroup::Memory: return 1.0;            // percentage point
+    case MetricGroup::Temperatures: return 1.0;      // degree
+    case MetricGroup::Processes: return 5.0;
+    case MetricGroup::TopProcesses:
+        // Percentage points for CPU, and for memory 5 MB or 2% of a large footprint
+        return qMax(5.0, 0.02 * qMax(std::fabs(a), std::fabs(b)));
+    case MetricGroup::CpuCores:
+        // Load percentage points, and for the clock 5% of the current frequency
+        return qMax(5.0, 0.05 * qMax(std::fabs(a), std::fabs(b)));
+    case MetricGroup::Network:
+        // 50 KB/s, or a quarter of the current rate once traffic is heavy
+        return qMax(0.05, 0.25 * qMax(std::fabs(a), std::fabs(b)));
+    default: return 5.0;                             // load percentage points
+    }
+}
+
+} // namespace
+
+SamplingScheduler::SamplingScheduler()
+{
+    configure(Config(), 0);
+}
+
+void SamplingScheduler::configure(const Config& config, qint64 nowMs)
+{
+    m_config = config;
+    m_config.intervalMs = qMax(1, m_config.intervalMs);
+    m_config.minIntervalMs = qMax(1, m_config.minIntervalMs);
+    m_config.maxIntervalMs = qMax(m_config.minIntervalMs, m_config.maxIntervalMs);
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        GroupState& state = m_groups[g];
+        state.intervalMs = m_config.adaptive ? qBound(floorMs(g), m_config.intervalMs, m_config.maxIntervalMs) : m_config.intervalMs;
+        state.dueMs = nowMs;
+        state.haveLast = false;
+    }
+}
+
+int SamplingScheduler::floorMs(int group) const
+{
+    if (group == static_cast<int>(MetricGroup::Uptime)) {
+        return m_config.maxIntervalMs;
+    }
+    return qMin(m_config.maxIntervalMs, m_config.minIntervalMs * CostFactor[group]);
+}
+
+MetricGroups SamplingScheduler::due(qint64 nowMs) const
+{
+    MetricGroups groups = 0;
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        const GroupState& state = m_groups[g];
+        // Up to a tenth of its interval early, to ride along with a wakeup for another group
+        if ((m_config.groups & metricGroupBit(MetricGroup(g))) && state.dueMs - nowMs <= state.intervalMs / 10) {
+            groups |= metricGroupBit(MetricGroup(g));
+        }
+    }
+    return groups;
+}
+
+void SamplingScheduler::sampled(MetricGroups groups, const SysInfo& info, qint64 nowMs)
+{
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        const MetricGroup group = static_cast<MetricGroup>(g);
+        if (!(groups & metricGroupBit(group))) {
+            continue;
+        }
+        GroupState& state = m_groups[g];
+        double values[2];
+        const int count = groupValues(group, info, values);
+        if (m_config.adaptive && state.haveLast) {
+            double change = 0.0;
+            for (int i = 0; i < count; ++i) {
+                change = qMax(change, std::fabs(values[i] - state.last[i]) / threshold(group, values[i], state.last[i]));
+            }
+            // Speed up at once, slow down gradually
+            if (change >= 1.0) {
+                state.intervalMs = qMax(floorMs(g), state.intervalMs / 2);
+            } else if (change < 0.25) {
+                state.intervalMs = qMin(m_config.maxIntervalMs, state.intervalMs + state.intervalMs / 2);
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            state.last[i] = values[i];
+        }
+        state.haveLast = true;
+        state.dueMs = nowMs + state.intervalMs;
+    }
+}
+
+qint64 SamplingScheduler::nextDueMs() const
+{
+    qint64 next = -1;
+    for (int g = 0; g < MetricGroupCount; ++g) {
+        if ((m_config.groups & metricGroupBit(MetricGroup(g))) && (next < 0 || m_groups[g].dueMs < next)) {
+            next = m_groups[g].dueMs;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,58 @@
+#ifndef SAMPLINGSCHEDULER_H
+#define SAMPLINGSCHEDULER_H
+
+#include <QtGlobal>
+#include "metriccollector.h"
+
+// Decides which metric groups the sampler collects on each wakeup.
+//
+// Every group has its own interval and due time. With a fixed rate all groups run at the
+// update interval, as before. With adaptive sampling (behavior/adaptiveSampling) a group
+// whose values moved by more than its threshold since the last sample halves its
+// interval, down to minIntervalMs times the group's cost factor, and one that holds still
+// backs off by half again, up to maxIntervalMs. Cheap groups such as memory can follow a
+// burst closely while GPU counters and the process count stay on a slower clock. Groups
+// that are not enabled are never due.
+class SamplingScheduler
+{
+public:
+    struct Config {
+        MetricGroups groups = AllMetricGroups;
+        bool adaptive = false;
+        int intervalMs = 1000;
+        int minIntervalMs = 100;
+        int maxIntervalMs = 5000;
+    };
+
+    SamplingScheduler();
+
+    // Applies config and makes every enabled group due at nowMs
+    void configure(const Config& config, qint64 nowMs);
+    const Config& config() const { return m_config; }
+
+    // Groups due at nowMs. Groups falling due within a few ms are included, so that
+    // nearly simultaneous deadlines share one wakeup.
+    MetricGroups due(qint64 nowMs) const;
+    // Records that groups were collected into info at nowMs, adapts their intervals and
+    // schedules their next sample
+    void sampled(MetricGroups groups, const SysInfo& info, qint64 nowMs);
+
+    // Earliest due time of any enabled group, or -1 if none is enabled
+    qint64 nextDueMs() const;
+    int intervalMs(MetricGroup group) const { return m_groups[static_cast<int>(group)].intervalMs; }
+
+private:
+    struct GroupState {
+        int intervalMs = 1000;
+        qint64 dueMs = 0;
+        double last[2] = {};
+        bool haveLast = false;
+    };
+
+    int floorMs(int group) const;
+
+    Config m_config;
+    GroupState m_groups[MetricGroupCount];
+};
+
+#endif // SAMPLINGSCHEDULER_H
@@ -0,0 +1,605 @@
+// winsys-sensor-helper: a stand-in for TempReader.exe that speaks the same binary frame
+// protocol (see sensorprotocol.h) without .NET or LibreHardwareMonitor, so the overlay's
+// helper path can be exercised on Linux.
+//
+//   winsys-sensor-helper [--source synthetic|hwmon] [--sensors N] [--work-ms N]
+//       Serve frames on stdout, one per "update" line on stdin or pushed after "stream <ms>"
+//       (phase-locked to the reader by "due <ms>"), until "exit" or EOF. --work-ms busy-waits that long per sample to mimic the cost of
+//       a real hardware traversal. Point the overlay at it with the sensors/helperPath setting.
+//       --startup-ms spins that long before serving, like LibreHardwareMonitor's initial
+//       enumeration; --crash-after N aborts and --hang-after N stops responding (heartbeat
+//       included) once N frames have been written, with 0 meaning before the first one.
+//   winsys-sensor-helper --emit N [--source ...] [--sensors N]
+//       Write N frames back to back and exit; the rate is reported on stderr.
+//   winsys-sensor-helper --decode
+//       Decode frames from stdin with the overlay's parser and report throughput, sequence
+//       gaps and skipped bytes. Pipe --emit into it to measure the protocol end to end.
+//   winsys-sensor-helper --compare INTERVAL_MS SECONDS [source options]
+//       Linux only. Runs a child helper in request/response, streaming and shared-memory
+//       mode, consuming it the way the sampler does, and reports sample latency, read()
+//       calls on the consumer side and helper CPU.
+
+#include "sensorprotocol.h"
+#include "sensorsharedmemory.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using namespace SensorProtocol;
+
+uint64_t nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct HwmonSensor {
+    uint16_t id;
+    std::string path;
+};
+
+// Same driver lists as ProcfsCollector; the first chip of each kind wins
+std::vector<HwmonSensor> findHwmonSensors()
+{
+    std::vector<HwmonSensor> sensors;
+#ifndef _WIN32
+    static const char* const cpuDrivers[] = { "coretemp", "k10temp", "zenpower", "cpu_thermal" };
+    static const char* const gpuDrivers[] = { "amdgpu", "nouveau", "radeon" };
+    bool haveCpu = false;
+    bool haveGpu = false;
+
+    DIR* dir = opendir("/sys/class/hwmon");
+    if (!dir) {
+        return sensors;
+    }
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        const std::string base = std::string("/sys/class/hwmon/") + entry->d_name + "/";
+        std::string driver;
+        if (FILE* f = std::fopen((base + "name").c_str(), "r")) {
+            char name[64] = {};
+            if (std::fgets(name, sizeof(name), f)) {
+                driver.assign(name, std::strcspn(name, "\n"));
+            }
+            std::fclose(f);
+        }
+        auto matches = [&driver](const char* const* list, size_t count) {
+            return std::find(list, list + count, driver) != list + count;
+        };
+        if (!haveCpu && matches(cpuDrivers, std::size(cpuDrivers))) {
+            sensors.push_back({ CpuPackageTemp, base + "temp1_input" });
+            haveCpu = true;
+        } else if (!haveGpu && matches(gpuDrivers, std::size(gpuDrivers))) {
+            sensors.push_back({ GpuCoreTemp, base + "temp1_input" });
+            haveGpu = true;
+        }
+    }
+    closedir(dir);
+#endif
+    return sensors;
+}
+
+class Source
+{
+public:
+    Source(bool hwmon, int syntheticCount, int workMs)
+        : m_syntheticCount(std::clamp(syntheticCount, 1, MaxReadings))
+        , m_workMs(workMs)
+    {
+        if (hwmon) {
+            m_hwmon = findHwmonSensors();
+            if (m_hwmon.empty()) {
+                std::fprintf(stderr, "winsys-sensor-helper: no hwmon sensors found, using synthetic data\n");
+            }
+        }
+    }
+
+    void fill(Frame& frame)
+    {
+        if (m_workMs > 0) {
+            // Stand in for LibreHardwareMonitor's hardware traversal, which burns CPU
+            const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_workMs);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        }
+        frame.count = 0;
+        frame.timestampUs = nowUs();
+        if (!m_hwmon.empty()) {
+            for (const HwmonSensor& sensor : m_hwmon) {
+                float value = -1.0f;
+                if (FILE* f = std::fopen(sensor.path.c_str(), "r")) {
+                    long milli = 0;
+                    if (std::fscanf(f, "%ld", &milli) == 1) {
+                        value = milli / 1000.0f;
+                    }
+                    std::fclose(f);
+                }
+                frame.add(sensor.id, value);
+            }
+            return;
+        }
+
+        // Slow sine waves around plausible values; ids past the known ones are still
+        // valid frames and exercise the reader's unknown-id skipping.
+        const double t = frame.timestampUs / 1e6;
+        for (int i = 0; i < m_syntheticCount; ++i) {
+            const float value = static_cast<float>(50.0 + 15.0 * std::sin(t / (3.0 + i) + i));
+            frame.add(static_cast<uint16_t>(CpuPackageTemp + i), value);
+        }
+    }
+
+private:
+    std::vector<HwmonSensor> m_hwmon;
+    int m_syntheticCount;
+    int m_workMs;
+};
+
+bool writeFrame(Frame& frame, uint32_t& sequence)
+{
+    unsigned char bytes[MaxFrameSize];
+    frame.sequence = sequence++;
+    const size_t length = encode(frame, bytes);
+    return std::fwrite(bytes, 1, length, stdout) == length;
+}
+
+// Answers "update" on the main thread and, after "stream <ms>", pushes frames from a second
+// thread. A reader that stops draining the pipe blocks the writer, so frames that would
+// have been produced meanwhile are never produced rather than queued up. After "shm <name>"
+// frames go to the shared segment instead and the second thread also keeps its heartbeat.
+// "due <ms>" moves the stream's phase so the next frame is finished DueLeadMs before the
+// reader looks, rather than up to a whole period before it.
+class Server
+{
+public:
+    static constexpr int DueLeadMs = 2;
+
+    // Misbehaviour on demand, for exercising the overlay's helper supervisor
+    struct Faults {
+        long long crashAfter = -1;
+        long long hangAfter = -1;
+    };
+
+    Server(Source& source, const Faults& faults) : m_source(source), m_faults(faults) {}
+
+    int run()
+    {
+        std::thread streamer(&Server::streamLoop, this);
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line == "exit") {
+                break;
+            }
+            // Before the lock, which a frame being written holds for as long as it takes
+            const auto received = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (line == "update") {
+                if (!writeOne()) {
+                    break;
+                }
+            } else if (line.compare(0, 7, "stream ") == 0) {
+                m_periodMs = std::max(0, std::atoi(line.c_str() + 7));
+                m_nextFrame = std::chrono::steady_clock::now();
+                m_readStart.reset();
+                m_wake.notify_one();
+            } else if (line.compare(0, 4, "due ") == 0) {
+                if (m_periodMs > 0) {
+                    // Start early by the frame cost; a frame is still due within a
+                    // period however far off the read is, which keeps the reader's watchdog fed
+                    const auto now = std::chrono::steady_clock::now();
+                    m_readStart = received + std::chrono::milliseconds(std::max(0, std::atoi(line.c_str() + 4)) - DueLeadMs) -
+                                  m_frameCost;
+                    m_nextFrame = std::min(std::max(*m_readStart, now), now + std::chrono::milliseconds(m_periodMs));
+                    m_wake.notify_one();
+                }
+            } else if (line.compare(0, 4, "shm ") == 0) {
+                if (!m_shared.open(line.substr(4))) {
+                    std::fprintf(stderr, "winsys-sensor-helper: cannot open shared segment %s\n", line.c_str() + 4);
+                }
+                m_wake.notify_one();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+            m_wake.notify_one();
+        }
+        streamer.join();
+        return m_failed ? 1 : 0;
+    }
+
+private:
+    bool writeOne()
+    {
+        if (m_sequence == m_faults.crashAfter) {
+            std::fprintf(stderr, "winsys-sensor-helper: crashing after %u frames as requested\n", m_sequence);
+            std::abort();
+        }
+        if (m_sequence == m_faults.hangAfter) {
+            // Holding the lock also stops the heartbeat and every later command
+            std::fprintf(stderr, "winsys-sensor-helper: hanging after %u frames as requested\n", m_sequence);
+            for (;;) {
+                std::this_thread::sleep_for(std::chrono::hours(1));
+            }
+        }
+        m_source.fill(m_frame);
+        if (SharedBlock* block = m_shared.block()) {
+            m_frame.sequence = m_sequence++;
+            writeShared(*block, m_frame);
+        } else if (!writeFrame(m_frame, m_sequence) || std::fflush(stdout) != 0) {
+            m_failed = true;
+        }
+        return !m_failed;
+    }
+
+    void streamLoop()
+    {
+        using Clock = std::chrono::steady_clock;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_quit) {
+            const auto now = Clock::now();
+            if (m_periodMs > 0 && now >= m_nextFrame) {
+                if (m_readStart && now >= *m_readStart) {
+                    m_readStart.reset();
+                }
+                const auto planned = m_nextFrame;
+                if (!writeOne()) {
+                    return;
+                }
+                // From the planned start, so a late wakeup counts too; held at its peak and
+                // let down slowly, as one frame too late costs a whole period of staleness
+                m_frameCost = std::max<Clock::duration>(Clock::now() - planned, m_frameCost - m_frameCost / 8);
+                m_nextFrame = now + std::chrono::milliseconds(m_periodMs);
+                if (m_readStart) {
+                    m_nextFrame = std::min(m_nextFrame, *m_readStart);
+                }
+            }
+            auto wake = m_periodMs > 0 ? m_nextFrame : Clock::time_point::max();
+            if (SharedBlock* block = m_shared.block()) {
+                beatShared(*block);
+                wake = std::min(wake, now + std::chrono::milliseconds(HeartbeatIntervalMs));
+            }
+            if (wake == Clock::time_point::max()) {
+                m_wake.wait(lock);
+            } else {
+                m_wake.wait_until(lock, wake);
+            }
+        }
+    }
+
+    Source& m_source;
+    Faults m_faults;
+    Frame m_frame;
+    uint32_t m_sequence = 0;
+    SharedSegment m_shared;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    int m_periodMs = 0;
+    std::chrono::steady_clock::time_point m_nextFrame;
+    // When to start the frame for the read announced by "due", until that frame is written
+    std::optional<std::chrono::steady_clock::time_point> m_readStart;
+    std::chrono::steady_clock::duration m_frameCost{};
+    bool m_quit = false;
+    bool m_failed = false;
+};
+
+int emit(Source& source, long long count)
+{
+    Frame frame;
+    uint32_t sequence = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < count; ++i) {
+        source.fill(frame);
+        if (!writeFrame(frame, sequence)) {
+            return 1;
+        }
+    }
+    std::fflush(stdout);
+    const double elapsed = secondsSince(start);
+    std::fprintf(stderr, "emitted %lld frames in %.3f s (%.0f frames/s)\n", count, elapsed, count / elapsed);
+    return 0;
+}
+
+int decode()
+{
+    FrameParser parser;
+    Frame frame;
+    unsigned char chunk[64 * 1024];
+    uint64_t bytes = 0;
+    uint64_t gaps = 0;
+    uint64_t readings = 0;
+    bool first = true;
+    uint32_t expected = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        bytes += n;
+        size_t offset = 0;
+        while (offset < n) {
+            offset += parser.feed(chunk + offset, n - offset);
+            while (parser.next(frame)) {
+                if (!first && frame.sequence != expected) {
+                    ++gaps;
+                }
+                first = false;
+                expected = frame.sequence + 1;
+                readings += frame.count;
+            }
+        }
+    }
+    const double elapsed = secondsSince(start);
+    std::printf("frames: %llu\nreadings: %llu\nbytes: %llu\nsequence gaps: %llu\nbytes skipped: %llu\n"
+                "elapsed: %.3f s\nrate: %.0f frames/s, %.1f MB/s\n",
+                static_cast<unsigned long long>(parser.framesDecoded()),
+                static_cast<unsigned long long>(readings),
+                static_cast<unsigned long long>(bytes),
+                static_cast<unsigned long long>(gaps),
+                static_cast<unsigned long long>(parser.bytesSkipped()),
+                elapsed, parser.framesDecoded() / elapsed, bytes / elapsed / (1024.0 * 1024.0));
+    return gaps == 0 && parser.bytesSkipped() == 0 ? 0 : 1;
+}
+
+#ifndef _WIN32
+enum class Transport { Poll, Stream, Shared };
+
+struct ConsumerRun {
+    std::vector<double> latenciesMs;
+    uint64_t frames = 0;
+    uint64_t reads = 0;
+    double helperCpuMs = 0.0;
+    double wallSeconds = 0.0;
+};
+
+// Plays the overlay's part against a child copy of this helper: ticks every intervalMs,
+// takes the newest frame (draining the pipe, or one seqlock read) and records its age at
+// the tick. In poll mode each tick also sends the "update" whose answer the next tick uses;
+// otherwise it announces the next tick with "due", as the sampler does.
+bool runConsumer(const char* self, Transport transport, int intervalMs, int seconds,
+                 const std::vector<std::string>& helperArgs, ConsumerRun& run)
+{
+    SharedSegment shared;
+    if (transport == Transport::Shared && !shared.create(SharedSegment::nameForProcess(getpid()))) {
+        return false;
+    }
+
+    int toChild[2];
+    int fromChild[2];
+    if (pipe(toChild) != 0 || pipe(fromChild) != 0) {
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        close(toChild[0]);
+        close(toChild[1]);
+        close(fromChild[0]);
+        close(fromChild[1]);
+        std::vector<char*> argv{ const_cast<char*>(self) };
+        for (const std::string& arg : helperArgs) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(self, argv.data());
+        _exit(127);
+    }
+    close(toChild[0]);
+    close(fromChild[1]);
+    fcntl(fromChild[0], F_SETFL, fcntl(fromChild[0], F_GETFL) | O_NONBLOCK);
+
+    auto send = [fd = toChild[1]](const std::string& command) {
+        return write(fd, command.data(), command.size()) == static_cast<ssize_t>(command.size());
+    };
+    if (transport == Transport::Shared) {
+        send("shm " + shared.name() + "\n");
+    }
+    if (transport != Transport::Poll) {
+        send("stream " + std::to_string(intervalMs) + "\ndue " + std::to_string(intervalMs) + "\n");
+    }
+
+    FrameParser parser;
+    Frame latest;
+    bool haveFrame = false;
+    unsigned char chunk[4096];
+    const auto start = std::chrono::steady_clock::now();
+    const int ticks = seconds * 1000 / intervalMs;
+    for (int tick = 1; tick <= ticks; ++tick) {
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(tick * intervalMs));
+        if (transport == Transport::Shared) {
+            if (readShared(*shared.block(), latest)) {
+                haveFrame = true;
+                ++run.frames;
+            }
+        } else {
+            ssize_t n;
+            do {
+                n = read(fromChild[0], chunk, sizeof(chunk));
+                ++run.reads;
+                size_t offset = 0;
+                while (n > 0 && offset < static_cast<size_t>(n)) {
+                    offset += parser.feed(chunk + offset, static_cast<size_t>(n) - offset);
+                    while (parser.next(latest)) {
+                        haveFrame = true;
+                    }
+                }
+            } while (n > 0);
+            run.frames = parser.framesDecoded();
+        }
+        if (haveFrame) {
+            run.latenciesMs.push_back((nowUs() - latest.timestampUs) / 1000.0);
+        }
+        if (transport == Transport::Poll) {
+            send("update\n");
+        } else {
+            const auto untilNext = start + std::chrono::milliseconds((tick + 1) * intervalMs) - std::chrono::steady_clock::now();
+            send("due " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(untilNext).count()) + "\n");
+        }
+    }
+    run.wallSeconds = secondsSince(start);
+
+    send("exit\n");
+    close(toChild[1]);
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    close(fromChild[0]);
+    run.helperCpuMs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+                      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int compare(const char* self, int intervalMs, int seconds, const std::vector<std::string>& helperArgs)
+{
+    std::printf("%-8s %6s %6s %6s %9s %9s %9s %9s %11s %7s\n", "mode", "ticks", "frames", "reads", "lat mean",
+                "lat p50", "lat p99", "lat max", "helper cpu", "cpu %");
+    const std::pair<Transport, const char*> modes[] = {
+        { Transport::Poll, "poll" }, { Transport::Stream, "stream" }, { Transport::Shared, "shm" }
+    };
+    for (const auto& [transport, label] : modes) {
+        ConsumerRun run;
+        if (!runConsumer(self, transport, intervalMs, seconds, helperArgs, run)) {
+            std::fprintf(stderr, "helper run failed\n");
+            return 1;
+        }
+        std::vector<double>& lat = run.latenciesMs;
+        std::sort(lat.begin(), lat.end());
+        double mean = 0.0;
+        for (double v : lat) {
+            mean += v;
+        }
+        mean = lat.empty() ? 0.0 : mean / lat.size();
+        auto percentile = [&lat](double p) {
+            return lat.empty() ? 0.0 : lat[std::min(lat.size() - 1, static_cast<size_t>(p * lat.size()))];
+        };
+        std::printf("%-8s %6zu %6llu %6llu %7.2fms %7.2fms %7.2fms %7.2fms %9.1fms %6.2f%%\n", label, lat.size(),
+                    static_cast<unsigned long long>(run.frames), static_cast<unsigned long long>(run.reads), mean,
+                    percentile(0.5), percentile(0.99), lat.empty() ? 0.0 : lat.back(), run.helperCpuMs,
+                    100.0 * run.helperCpuMs / (run.wallSeconds * 1000.0));
+    }
+    return 0;
+}
+#endif
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: winsys-sensor-helper [--source synthetic|hwmon] [--sensors N] [--work-ms N] [--emit N]\n"
+                 "                            [--startup-ms N] [--crash-after N] [--hang-after N]\n"
+                 "       winsys-sensor-helper --decode\n"
+                 "       winsys-sensor-helper --compare INTERVAL_MS SECONDS [--source ...] [--sensors N] [--work-ms N]\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+    bool hwmon = false;
+#else
+    bool hwmon = true;
+#endif
+    int sensors = 2;
+    int workMs = 0;
+    int startupMs = 0;
+    Server::Faults faults;
+    long long emitCount = -1;
+    bool decodeMode = false;
+    int compareInterval = 0;
+    int compareSeconds = 0;
+    // Source options are forwarded to the child helpers in --compare mode
+    std::vector<std::string> helperArgs;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--source" && hasValue) {
+            hwmon = std::strcmp(argv[++i], "hwmon") == 0;
+            helperArgs.insert(helperArgs.end(), { arg, argv[i] });
+        } else if (arg == "--sensors" && hasValue) {
+            sensors = std::atoi(argv[++i]);
+            helperArgs.insert(helperArgs.end(), { arg, argv[i] });
+        } else if (arg == "--work-ms" && hasValue) {
+            workMs = std::atoi(argv[++i]);
+            helperArgs.insert(helperArgs.end(), { arg, argv[i] });
+        } else if (arg == "--startup-ms" && hasValue) {
+            startupMs = std::atoi(argv[++i]);
+        } else if (arg == "--crash-after" && hasValue) {
+            faults.crashAfter = std::atoll(argv[++i]);
+        } else if (arg == "--hang-after" && hasValue) {
+            faults.hangAfter = std::atoll(argv[++i]);
+        } else if (arg == "--emit" && hasValue) {
+            emitCount = std::atoll(argv[++i]);
+        } else if (arg == "--decode") {
+            decodeMode = true;
+        } else if (arg == "--compare" && i + 2 < argc) {
+            compareInterval = std::max(1, std::atoi(argv[++i]));
+            compareSeconds = std::max(1, std::atoi(argv[++i]));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (decodeMode) {
+        return decode();
+    }
+    if (compareInterval > 0) {
+#ifndef _WIN32
+        return compare(argv[0], compareInterval, compareSeconds, helperArgs);
+#else
+        std::fprintf(stderr, "--compare is only available on Linux\n");
+        return 2;
+#endif
+    }
+    Source source(hwmon, sensors, workMs);
+    if (emitCount >= 0) {
+        return emit(source, emitCount);
+    }
+    if (startupMs > 0) {
+        // Stand in for LibreHardwareMonitor's initial hardware enumeration
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(startupMs);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+    Server server(source, faults);
+    return server.run();
+}
@@ -0,0 +1,249 @@
+#include "sensorhelperclient.h"
+#include "instrumentation.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFileInfo>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <string>
+#include <unistd.h>
+#endif
+
+SensorHelperClient::SensorHelperClient(QObject *parent)
+    : QObject(parent)
+    , m_process(new QProcess(this))
+    , m_hasFrame(false)
+    , m_streamPeriodMs(0)
+    , m_sharedMemory(false)
+    , m_lastHeartbeat(0)
+    , m_startupMs(-1)
+{
+    m_lastSignOfLife.start();
+    connect(m_process, &QProcess::started, this, &SensorHelperClient::onStarted);
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &SensorHelperClient::readFrames);
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &SensorHelperClient::onFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [](QProcess::ProcessError error) {
+        qWarning() << "QProcess error:" << error;
+    });
+}
+
+SensorHelperClient::~SensorHelperClient()
+{
+    stop();
+}
+
+void SensorHelperClient::setProgram(const QString& program, const QStringList& arguments)
+{
+    m_program = program;
+    m_arguments = arguments;
+}
+
+bool SensorHelperClient::start()
+{
+    if (m_process->state() != QProcess::NotRunning) {
+        return true;
+    }
+    if (!QFileInfo::exists(m_program)) {
+        qWarning() << "Sensor helper not found at:" << m_program;
+        return false;
+    }
+    m_parser = SensorProtocol::FrameParser();
+    m_hasFrame = false;
+    m_startupMs = -1;
+    m_startClock.start();
+    m_lastSignOfLife.start();
+    if (m_sharedMemory) {
+        // A fresh segment per helper run, so a dead helper's last frame is never read back
+        const auto name = SensorProtocol::SharedSegment::nameForProcess(QCoreApplication::applicationPid());
+        if (!m_segment.create(name)) {
+            qWarning() << "Cannot create shared sensor segment" << QString::fromStdString(name) << "- using the pipe";
+        }
+        m_lastHeartbeat = 0;
+    }
+    m_process->start(m_program, m_arguments);
+    return true;
+}
+
+void SensorHelperClient::stop()
+{
+    if (m_process->state() != QProcess::Running) {
+        return;
+    }
+    // Don't report a deliberate shutdown as a crash
+    disconnect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &SensorHelperClient::onFinished);
+    m_process->write("exit\n");
+    if (!m_process->waitForFinished(1000)) {
+        m_process->kill();
+        m_process->waitForFinished(1000);
+    }
+    m_segment.close();
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &SensorHelperClient::onFinished);
+}
+
+void SensorHelperClient::kill()
+{
+    if (m_process->state() != QProcess::NotRunning) {
+        m_process->kill();
+    }
+}
+
+bool SensorHelperClient::isRunning() const
+{
+    return m_process->state() == QProcess::Running;
+}
+
+void SensorHelperClient::requestUpdate()
+{
+    if (isRunning()) {
+        m_process->write("update\n");
+    }
+}
+
+void SensorHelperClient::setSharedMemory(bool enabled)
+{
+    m_sharedMemory = enabled;
+}
+
+void SensorHelperClient::sync()
+{
+    SensorProtocol::SharedBlock* block = m_segment.block();
+    if (!block) {
+        return;
+    }
+    // The helper beats from its own timer, independent of the stream period, so a stalled
+    // counter means the process is gone or wedged even if a frame was written recently.
+    const quint64 heartbeat = block->heartbeat.load(std::memory_order_relaxed);
+    if (heartbeat != m_lastHeartbeat) {
+        m_lastHeartbeat = heartbeat;
+        m_lastSignOfLife.restart();
+    } else if (m_lastSignOfLife.elapsed() > HeartbeatTimeoutMs) {
+        m_hasFrame = false;
+        return;
+    }
+    if (SensorProtocol::readShared(*block, m_frame)) {
+        onFrame();
+    }
+}
+
+void SensorHelperClient::onFrame()
+{
+    const bool first = m_startupMs < 0;
+    if (first) {
+        m_startupMs = m_startClock.elapsed();
+    }
+    m_hasFrame = true;
+    if (!m_segment.block()) {
+        m_lastSignOfLife.restart();
+    }
+    if (first) {
+        emit firstFrameReceived();
+    }
+}
+
+void SensorHelperClient::setStreamPeriod(int periodMs)
+{
+    m_streamPeriodMs = qMax(0, periodMs);
+    if (isRunning()) {
+        m_process->write(QByteArray("stream ") + QByteArray::number(m_streamPeriodMs) + '\n');
+    }
+}
+
+void SensorHelperClient::announceRead(int inMs)
+{
+    if (m_streamPeriodMs > 0 && isRunning()) {
+        m_process->write(QByteArray("due ") + QByteArray::number(qMax(0, inMs)) + '\n');
+    }
+}
+
+void SensorHelperClient::onStarted()
+{
+    if (m_segment.block()) {
+        m_process->write(QByteArray("shm ") + QByteArray::fromStdString(m_segment.name()) + '\n');
+    }
+    if (m_streamPeriodMs > 0) {
+        setStreamPeriod(m_streamPeriodMs);
+    }
+}
+
+qint64 SensorHelperClient::cpuTimeMs()
+{
+    if (!isRunning()) {
+        return -1;
+    }
+#if defined(Q_OS_WIN)
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(m_process->processId()));
+    if (!process) {
+        return -1;
+    }
+    FILETIME creation, exit, kernel, user;
+    qint64 result = -1;
+    if (GetProcessTimes(process, &creation, &exit, &kernel, &user)) {
+        auto toMs = [](const FILETIME& t) {
+            return ((static_cast<qint64>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000;
+        };
+        result = toMs(kernel) + toMs(user);
+    }
+    CloseHandle(process);
+    return result;
+#elif defined(Q_OS_LINUX)
+    // Fields 14 and 15 of /proc/<pid>/stat, counted after the parenthesised command name.
+    // The file stays open for as long as the helper keeps its pid.
+    const qint64 pid = m_process->processId();
+    if (pid != m_statPid || !m_stat.isOpen()) {
+        m_statPid = pid;
+        if (!m_stat.open("/proc/" + std::to_string(pid) + "/stat")) {
+            return -1;
+        }
+    }
+    const std::string_view text = m_stat.read();
+    const size_t commEnd = text.rfind(')');
+    if (commEnd == std::string_view::npos) {
+        // The process is gone, maybe with its pid taken by the next one: open again next time
+        m_stat.close();
+        return -1;
+    }
+    ProcCursor cursor(text.substr(commEnd + 1));
+    // state, ppid, pgrp, session, tty_nr, tpgid, flags, minflt, cminflt, majflt, cmajflt
+    cursor.skipWords(11);
+    const quint64 utime = cursor.number();
+    const quint64 stime = cursor.number();
+    return static_cast<qint64>((utime + stime) * 1000 / static_cast<quint64>(sysconf(_SC_CLK_TCK)));
+#else
+    return -1;
+#endif
+}
+
+void SensorHelperClient::readFrames()
+{
+    // Read straight into a stack buffer and decode in place; nothing here allocates
+    WINSYS_TRACE_SCOPE(SensorIpc);
+    char chunk[SensorProtocol::MaxFrameSize];
+    bool received = false;
+    for (;;) {
+        const qint64 n = m_process->read(chunk, sizeof(chunk));
+        if (n <= 0) {
+            break;
+        }
+        size_t offset = 0;
+        while (offset < static_cast<size_t>(n)) {
+            offset += m_parser.feed(chunk + offset, static_cast<size_t>(n) - offset);
+            while (m_parser.next(m_frame)) {
+                received = true;
+            }
+        }
+    }
+    if (received) {
+        onFrame();
+        emit frameReceived();
+    }
+}
+
+void SensorHelperClient::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    qWarning() << "Sensor helper finished unexpectedly. Exit code:" << exitCode << "Status:" << exitStatus;
+    m_hasFrame = false;
+    m_segment.close();
+    emit helperFinished(exitCode, exitStatus);
+}
@@ -0,0 +1,108 @@
+#ifndef SENSORHELPERCLIENT_H
+#define SENSORHELPERCLIENT_H
+
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "procparse.h"
+#include "sensorprotocol.h"
+#include "sensorsharedmemory.h"
+
+// Runs the sensor helper process and decodes the frames it writes to stdout. Lives on the
+// sampler thread next to the SysInfoSampler that owns it.
+//
+// Only the newest decoded frame is kept; readers look at latestFrame() when they build a
+// sample rather than reacting to every frame. That is also the backpressure policy when
+// streaming: every readyRead drains the pipe and older frames in it are simply dropped.
+//
+// With the shared-memory transport the pipe only carries commands. The helper writes
+// into a seqlock-protected segment, and sync() copies the newest frame out of it without
+// making any syscalls. A heartbeat in the segment that stops moving for
+// HeartbeatTimeoutMs counts as a dead or hung helper, and then hasFrame() returns false.
+class SensorHelperClient : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int HeartbeatTimeoutMs = 2000;
+
+    explicit SensorHelperClient(QObject *parent = nullptr);
+    ~SensorHelperClient();
+
+    void setProgram(const QString& program, const QStringList& arguments = QStringList());
+    QString program() const { return m_program; }
+
+    bool start();
+    void stop();
+    // Terminates a hung helper; reported through helperFinished() like a crash
+    void kill();
+    bool isRunning() const;
+
+    // Asks the helper for one fresh frame
+    void requestUpdate();
+    // Switches the helper to pushing a frame every periodMs on its own schedule; 0 goes
+    // back to request/response. Remembered and re-sent whenever the helper restarts.
+    void setStreamPeriod(int periodMs);
+    int streamPeriod() const { return m_streamPeriodMs; }
+    // While streaming, tells the helper the next read is inMs away so it times its next
+    // frame to land just before it rather than anywhere in the period
+    void announceRead(int inMs);
+
+    // Use the shared segment instead of stdout from the next start() on
+    void setSharedMemory(bool enabled);
+    bool usesSharedMemory() const { return m_sharedMemory; }
+    // Refreshes latestFrame() from the shared segment and checks the heartbeat. No-op on
+    // the pipe transport, where frames arrive through readyRead.
+    void sync();
+
+    // Total user + kernel CPU time the helper process has used, or -1 if unknown
+    qint64 cpuTimeMs();
+
+    // Time since the helper last showed it was alive: a frame on the pipe, or a heartbeat
+    // in the shared segment. Counts from start() until the first one.
+    qint64 silenceMs() const { return m_lastSignOfLife.elapsed(); }
+    // Wall time from start() to the first frame of the current run, or -1 before it
+    qint64 startupMs() const { return m_startupMs; }
+
+    bool hasFrame() const { return m_hasFrame; }
+    const SensorProtocol::Frame& latestFrame() const { return m_frame; }
+    quint64 framesReceived() const { return m_parser.framesDecoded(); }
+
+signals:
+    void frameReceived();
+    void firstFrameReceived();
+    void helperFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private slots:
+    void readFrames();
+    void onStarted();
+    void onFrame();
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    QProcess* m_process;
+    QString m_program;
+    QStringList m_arguments;
+    SensorProtocol::FrameParser m_parser;
+    SensorProtocol::Frame m_frame;
+    bool m_hasFrame;
+    int m_streamPeriodMs;
+
+    // Shared-memory transport
+    bool m_sharedMemory;
+    SensorProtocol::SharedSegment m_segment;
+    quint64 m_lastHeartbeat;
+
+    QElapsedTimer m_startClock;
+    QElapsedTimer m_lastSignOfLife;
+    qint64 m_startupMs;
+
+#ifdef Q_OS_LINUX
+    // /proc/<pid>/stat of the helper for cpuTimeMs(), reopened when the pid changes
+    ProcFile m_stat;
+    qint64 m_statPid = 0;
+#endif
+};
+
+#endif // SENSORHELPERCLIENT_H
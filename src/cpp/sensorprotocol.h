@@ -0,0 +1,205 @@
+#ifndef SENSORPROTOCOL_H
+#define SENSORPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Wire format spoken by the sensor helper (TempReader.exe, or winsys-sensor-helper when
+// testing) on its stdout. Plain C++ with no Qt so the stand-in helper can share it.
+//
+// Every frame is little-endian:
+//
+//   offset  size  field
+//        0     4  magic       "WSSF"
+//        4     2  length      total frame size in bytes, header included
+//        6     1  version     ProtocolVersion
+//        7     1  count       number of readings that follow
+//        8     4  sequence    incremented by the helper for every frame it writes
+//       12     8  timestamp   microseconds since the Unix epoch when the readings were taken
+//       20  8*n  readings    { u16 sensor id, u16 reserved, f32 value }
+//
+// The overlay drives the helper with text lines on its stdin:
+//
+//   update         read the sensors once and write one frame
+//   stream <ms>    from now on read and write a frame every <ms> on the helper's own
+//                  schedule; "stream 0" returns to request/response
+//   due <ms>       while streaming: the overlay reads again in <ms>, so time the next frame
+//                  to be written just before then and keep the period from there
+//   exit           quit
+//
+// Readers resynchronise on the magic, so a helper that prints a stray log line does not
+// wedge the stream. Unknown sensor ids are skipped, which lets helpers add sensors without
+// a version bump; the version only changes when the header or reading layout does.
+namespace SensorProtocol {
+
+constexpr uint32_t Magic = 0x46535357; // "WSSF" read as little-endian
+constexpr uint8_t ProtocolVersion = 1;
+constexpr size_t HeaderSize = 20;
+constexpr size_t ReadingSize = 8;
+constexpr int MaxReadings = 32;
+constexpr size_t MaxFrameSize = HeaderSize + ReadingSize * MaxReadings;
+
+// Values are degrees Celsius, watts or RPM; -1 means the helper found no such sensor
+enum SensorId : uint16_t {
+    CpuPackageTemp = 1,
+    GpuCoreTemp = 2,
+    GpuHotspotTemp = 3,
+    CpuPackagePower = 4,
+    GpuPower = 5,
+    CpuFanSpeed = 6,
+    GpuFanSpeed = 7
+};
+
+struct Reading {
+    uint16_t id;
+    float value;
+};
+
+struct Frame {
+    uint32_t sequence = 0;
+    uint64_t timestampUs = 0;
+    int count = 0;
+    Reading readings[MaxReadings];
+
+    bool add(uint16_t id, float value)
+    {
+        if (count >= MaxReadings) {
+            return false;
+        }
+        readings[count++] = Reading{ id, value };
+        return true;
+    }
+
+    // Returns fallback if the frame does not carry the sensor
+    float value(uint16_t id, float fallback = -1.0f) const
+    {
+        for (int i = 0; i < count; ++i) {
+            if (readings[i].id == id) {
+                return readings[i].value;
+            }
+        }
+        return fallback;
+    }
+};
+
+namespace detail {
+
+inline void put16(unsigned char* p, uint16_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+inline void put32(unsigned char* p, uint32_t v) { put16(p, uint16_t(v)); put16(p + 2, uint16_t(v >> 16)); }
+inline void put64(unsigned char* p, uint64_t v) { put32(p, uint32_t(v)); put32(p + 4, uint32_t(v >> 32)); }
+inline uint16_t get16(const unsigned char* p) { return uint16_t(p[0] | (p[1] << 8)); }
+inline uint32_t get32(const unsigned char* p) { return get16(p) | (uint32_t(get16(p + 2)) << 16); }
+inline uint64_t get64(const unsigned char* p) { return get32(p) | (uint64_t(get32(p + 4)) << 32); }
+
+} // namespace detail
+
+// Serialises frame into out, which must hold at least MaxFrameSize bytes. Returns the
+// number of bytes written.
+inline size_t encode(const Frame& frame, unsigned char* out)
+{
+    using namespace detail;
+    const size_t length = HeaderSize + ReadingSize * size_t(frame.count);
+    put32(out, Magic);
+    put16(out + 4, uint16_t(length));
+    out[6] = ProtocolVersion;
+    out[7] = uint8_t(frame.count);
+    put32(out + 8, frame.sequence);
+    put64(out + 12, frame.timestampUs);
+
+    unsigned char* p = out + HeaderSize;
+    for (int i = 0; i < frame.count; ++i, p += ReadingSize) {
+        uint32_t bits;
+        std::memcpy(&bits, &frame.readings[i].value, sizeof(bits));
+        put16(p, frame.readings[i].id);
+        put16(p + 2, 0);
+        put32(p + 4, bits);
+    }
+    return length;
+}
+
+// Incremental decoder for a byte stream of frames. All state lives in a fixed buffer of
+// two maximum-size frames, so feeding and decoding never allocate.
+class FrameParser
+{
+public:
+    // Copies as much of data as fits and returns how many bytes were consumed. Call next()
+    // until it returns false, then feed the rest.
+    size_t feed(const void* data, size_t size)
+    {
+        if (m_start > 0 && m_end + size > sizeof(m_buffer)) {
+            std::memmove(m_buffer, m_buffer + m_start, m_end - m_start);
+            m_end -= m_start;
+            m_start = 0;
+        }
+        const size_t n = size < sizeof(m_buffer) - m_end ? size : sizeof(m_buffer) - m_end;
+        std::memcpy(m_buffer + m_end, data, n);
+        m_end += n;
+        return n;
+    }
+
+    // Decodes the next complete frame into frame. Returns false if more bytes are needed.
+    bool next(Frame& frame)
+    {
+        using namespace detail;
+        for (;;) {
+            const size_t available = m_end - m_start;
+            if (available < HeaderSize) {
+                return false;
+            }
+            const unsigned char* p = m_buffer + m_start;
+            const size_t length = get16(p + 4);
+            const int count = p[7];
+            if (get32(p) != Magic || p[6] != ProtocolVersion || count > MaxReadings ||
+                length != HeaderSize + ReadingSize * size_t(count)) {
+                skipToNextMagic();
+                continue;
+            }
+            if (available < length) {
+                return false;
+            }
+
+            frame.sequence = get32(p + 8);
+            frame.timestampUs = get64(p + 12);
+            frame.count = count;
+            p += HeaderSize;
+            for (int i = 0; i < count; ++i, p += ReadingSize) {
+                const uint32_t bits = get32(p + 4);
+                frame.readings[i].id = get16(p);
+                std::memcpy(&frame.readings[i].value, &bits, sizeof(bits));
+            }
+            m_start += length;
+            ++m_framesDecoded;
+            return true;
+        }
+    }
+
+    uint64_t framesDecoded() const { return m_framesDecoded; }
+    uint64_t bytesSkipped() const { return m_bytesSkipped; }
+
+private:
+    void skipToNextMagic()
+    {
+        // Drop at least one byte, then everything up to the next possible magic
+        size_t pos = m_start + 1;
+        while (pos + 4 <= m_end && detail::get32(m_buffer + pos) != Magic) {
+            ++pos;
+        }
+        if (pos + 4 > m_end) {
+            // Keep a partial magic at the tail
+            pos = m_end > 3 && m_end - 3 > m_start + 1 ? m_end - 3 : m_start + 1;
+        }
+        m_bytesSkipped += pos - m_start;
+        m_start = pos;
+    }
+
+    unsigned char m_buffer[2 * MaxFrameSize];
+    size_t m_start = 0;
+    size_t m_end = 0;
+    uint64_t m_framesDecoded = 0;
+    uint64_t m_bytesSkipped = 0;
+};
+
+} // namespace SensorProtocol
+
+#endif // SENSORPROTOCOL_H
@@ -0,0 +1,186 @@
+#include "sensorsharedmemory.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace SensorProtocol {
+
+void writeShared(SharedBlock& block, const Frame& frame)
+{
+    const uint32_t sequence = block.sequence.load(std::memory_order_relaxed);
+    block.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    block.frameSequence.store(frame.sequence, std::memory_order_relaxed);
+    block.timestampUs.store(frame.timestampUs, std::memory_order_relaxed);
+    block.count.store(static_cast<uint32_t>(frame.count), std::memory_order_relaxed);
+    for (int i = 0; i < frame.count; ++i) {
+        uint32_t bits;
+        std::memcpy(&bits, &frame.readings[i].value, sizeof(bits));
+        block.readings[2 * i].store(frame.readings[i].id, std::memory_order_relaxed);
+        block.readings[2 * i + 1].store(bits, std::memory_order_relaxed);
+    }
+
+    block.sequence.store(sequence + 2, std::memory_order_release);
+    beatShared(block);
+}
+
+void beatShared(SharedBlock& block)
+{
+    block.heartbeat.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool readShared(const SharedBlock& block, Frame& frame)
+{
+    // A write is a few dozen stores, so a reader that keeps colliding is rare; give up
+    // after a few tries and keep the previous frame rather than spin.
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        const uint32_t before = block.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;
+        }
+        frame.sequence = block.frameSequence.load(std::memory_order_relaxed);
+        frame.timestampUs = block.timestampUs.load(std::memory_order_relaxed);
+        const uint32_t count = block.count.load(std::memory_order_relaxed);
+        frame.count = count < uint32_t(MaxReadings) ? int(count) : MaxReadings;
+        for (int i = 0; i < frame.count; ++i) {
+            const uint32_t bits = block.readings[2 * i + 1].load(std::memory_order_relaxed);
+            frame.readings[i].id = static_cast<uint16_t>(block.readings[2 * i].load(std::memory_order_relaxed));
+            std::memcpy(&frame.readings[i].value, &bits, sizeof(bits));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SharedSegment::~SharedSegment()
+{
+    close();
+}
+
+std::string SharedSegment::nameForProcess(long long pid)
+{
+#ifdef _WIN32
+    return "Local\\winsys-sensors-" + std::to_string(pid);
+#else
+    return "/winsys-sensors-" + std::to_string(pid);
+#endif
+}
+
+bool SharedSegment::create(const std::string& name)
+{
+    close();
+    m_name = name;
+    if (!map(true)) {
+        return false;
+    }
+    m_owner = true;
+    m_block->sequence.store(0, std::memory_order_relaxed);
+    m_block->heartbeat.store(0, std::memory_order_relaxed);
+    m_block->version.store(SharedVersion, std::memory_order_relaxed);
+    m_block->magic.store(SharedMagic, std::memory_order_release);
+    return true;
+}
+
+bool SharedSegment::open(const std::string& name)
+{
+    close();
+    m_name = name;
+    if (!map(false)) {
+        return false;
+    }
+    if (m_block->magic.load(std::memory_order_acquire) != SharedMagic ||
+        m_block->version.load(std::memory_order_relaxed) != SharedVersion) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool SharedSegment::map(bool create)
+{
+    const DWORD size = sizeof(SharedBlock);
+    HANDLE mapping = create
+        ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, m_name.c_str())
+        : OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_name.c_str());
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_mapping = mapping;
+    m_block = static_cast<SharedBlock*>(view);
+    return true;
+}
+
+void SharedSegment::close()
+{
+    // The mapping disappears with its last handle, so the owner has nothing to unlink
+    if (m_block) {
+        UnmapViewOfFile(m_block);
+        m_block = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    m_owner = false;
+}
+
+#else
+
+bool SharedSegment::map(bool create)
+{
+    const int fd = create ? shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600)
+                          : shm_open(m_name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (create && ftruncate(fd, sizeof(SharedBlock)) != 0) {
+        ::close(fd);
+        shm_unlink(m_name.c_str());
+        return false;
+    }
+    void* view = mmap(nullptr, sizeof(SharedBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        if (create) {
+            shm_unlink(m_name.c_str());
+        }
+        return false;
+    }
+    m_block = static_cast<SharedBlock*>(view);
+    return true;
+}
+
+void SharedSegment::close()
+{
+    if (m_block) {
+        munmap(m_block, sizeof(SharedBlock));
+        m_block = nullptr;
+    }
+    if (m_owner) {
+        shm_unlink(m_name.c_str());
+        m_owner = false;
+    }
+}
+
+#endif
+
+} // namespace SensorProtocol
@@ -0,0 +1,93 @@
+#ifndef SENSORSHAREDMEMORY_H
+#define SENSORSHAREDMEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "sensorprotocol.h"
+
+// Optional shared-memory transport for sensor frames (sensors/transport = "shm"). The
+// overlay creates the segment and sends "shm <name>" to the helper, which from then on
+// writes readings into the segment instead of framing them on stdout. Reading the newest
+// frame is then a handful of loads with no syscall, pipe or event-loop wakeup.
+//
+// The segment is one seqlock-protected frame. The writer makes the sequence odd, stores
+// the payload and makes it even again; a reader retries if the sequence was odd or
+// changed underneath it. Every field is an atomic so neither side has a data race, and
+// the layout is fixed (little-endian, offsets below) so TempReader.cs can map it too:
+//
+//   offset  size  field
+//        0     4  magic          "WSSM"
+//        4     4  version        SharedVersion
+//        8     4  sequence       seqlock counter, odd while a write is in progress
+//       12     4  frameSequence  helper's frame counter, as in the pipe protocol
+//       16     8  heartbeat      bumped by the helper at least every HeartbeatIntervalMs
+//       24     8  timestampUs    microseconds since the Unix epoch
+//       32     4  count          number of valid readings
+//       36     4  reserved
+//       40   256  readings       MaxReadings x { u32 sensor id, u32 float bits }
+namespace SensorProtocol {
+
+constexpr uint32_t SharedMagic = 0x4d535357; // "WSSM" read as little-endian
+constexpr uint32_t SharedVersion = 1;
+constexpr int HeartbeatIntervalMs = 250;
+
+struct SharedBlock {
+    std::atomic<uint32_t> magic;
+    std::atomic<uint32_t> version;
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> frameSequence;
+    std::atomic<uint64_t> heartbeat;
+    std::atomic<uint64_t> timestampUs;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> reserved;
+    std::atomic<uint32_t> readings[MaxReadings * 2];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "the seqlock needs address-free atomics to work across processes");
+static_assert(sizeof(SharedBlock) == 40 + 8 * MaxReadings, "SharedBlock layout is part of the protocol");
+
+// Writer side of the seqlock. Only one process may write.
+void writeShared(SharedBlock& block, const Frame& frame);
+void beatShared(SharedBlock& block);
+
+// Copies a consistent frame out of the block. Returns false if the helper has not written
+// one yet or a write kept overlapping the read.
+bool readShared(const SharedBlock& block, Frame& frame);
+
+// A mapped, named segment holding one SharedBlock: POSIX shm on Unix, a pagefile-backed
+// file mapping on Windows. The creator owns the name and removes it when destroyed.
+class SharedSegment
+{
+public:
+    SharedSegment() = default;
+    ~SharedSegment();
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    // Platform-appropriate segment name for the overlay with the given process id
+    static std::string nameForProcess(long long pid);
+
+    bool create(const std::string& name);
+    bool open(const std::string& name);
+    void close();
+
+    SharedBlock* block() const { return m_block; }
+    const std::string& name() const { return m_name; }
+
+private:
+    bool map(bool create);
+
+    SharedBlock* m_block = nullptr;
+    std::string m_name;
+    bool m_owner = false;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+};
+
+} // namespace SensorProtocol
+
+#endif // SENSORSHAREDMEMORY_H
@@ -1,10 +1,12 @@
 #include "settingsdialog.h"
+#include "overlaysettings.h"
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QDialogButtonBox>
 #include <QSettings>
 #include <QCheckBox>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QPushButton>
 #include <QColorDialog>
 #include <QComboBox>
@@ -97,6 +99,32 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     QWidget* opacityWidget = new QWidget();
     opacityWidget->setLayout(opacityLayout);
     appearanceLayout->addRow("Background Opacity:", opacityWidget);
+
+    // Sparklines
+    QHBoxLayout* sparklineLayout = new QHBoxLayout();
+    QLabel* sparklineIcon = new QLabel();
+    sparklineIcon->setPixmap(style()->standardIcon(QStyle::SP_FileDialogInfoView).pixmap(16, 16));
+    m_showSparklinesCheckBox = new QCheckBox("Show trend next to each value");
+    sparklineLayout->addWidget(sparklineIcon);
+    sparklineLayout->addWidget(m_showSparklinesCheckBox);
+    sparklineLayout->addStretch();
+    QWidget* sparklineWidget = new QWidget();
+    sparklineWidget->setLayout(sparklineLayout);
+    appearanceLayout->addRow("Sparklines:", sparklineWidget);
+
+    // Renderer
+    QHBoxLayout* rendererLayout = new QHBoxLayout();
+    QLabel* rendererIcon = new QLabel();
+    rendererIcon->setPixmap(style()->standardIcon(QStyle::SP_DesktopIcon).pixmap(16, 16));
+    m_rendererComboBox = new QComboBox();
+    m_rendererComboBox->addItems({"Widgets", "Painted"});
+    m_rendererComboBox->setToolTip("Painted draws all rows in a single widget with cached text shadows, which is cheaper to update.");
+    rendererLayout->addWidget(rendererIcon);
+    rendererLayout->addWidget(m_rendererComboBox);
+    rendererLayout->addStretch();
+    QWidget* rendererWidget = new QWidget();
+    rendererWidget->setLayout(rendererLayout);
+    appearanceLayout->addRow("Renderer:", rendererWidget);
     
     appearanceGroup->setLayout(appearanceLayout);
 
@@ -107,9 +135,10 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     // Create checkboxes with icons - now with all metrics
     QStringList displayNames = {
         "CPU Load", "Memory Usage %", "RAM Usage (MB)", "Disk Activity", "GPU Load",
-        "FPS (Estimated)", "Network Download Speed", "Network Upload Speed", 
+        "FPS and 1% Lows", "Network Download Speed", "Network Upload Speed", 
         "Daily Data Usage", "CPU Temperature", "GPU Temperature", 
-        "Active Processes", "System Uptime"
+        "Active Processes", "System Uptime", "Overlay's Own CPU and Memory",
+        "Busiest Processes (CPU)", "Largest Processes (Memory)", "Per-Core Load and Clock"
     };
     
     QList<QStyle::StandardPixmap> displayIcons = {
@@ -117,7 +146,8 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
         QStyle::SP_DriveHDIcon, QStyle::SP_ComputerIcon, QStyle::SP_MediaPlay,
         QStyle::SP_ArrowDown, QStyle::SP_ArrowUp, QStyle::SP_DriveNetIcon,
         QStyle::SP_DialogApplyButton, QStyle::SP_DialogApplyButton,
-        QStyle::SP_FileDialogListView, QStyle::SP_BrowserReload
+        QStyle::SP_FileDialogListView, QStyle::SP_BrowserReload, QStyle::SP_FileDialogInfoView,
+        QStyle::SP_FileDialogDetailedView, QStyle::SP_FileDialogDetailedView, QStyle::SP_ComputerIcon
     };
     
     for (int i = 0; i < displayNames.size(); ++i) {
@@ -128,6 +158,20 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
         checkLayout->addWidget(checkIcon);
         checkLayout->addWidget(checkBox);
         checkLayout->addStretch();
+        QComboBox* statisticCombo = nullptr;
+        if (OverlaySettings::statisticKey(i)) {
+            statisticCombo = new QComboBox();
+            statisticCombo->addItem("Latest", "latest");
+            statisticCombo->addItem("Average", "avg");
+            statisticCombo->addItem("Median", "p50");
+            statisticCombo->addItem("95th Percentile", "p95");
+            statisticCombo->addItem("99th Percentile", "p99");
+            statisticCombo->addItem("Peak", "peak");
+            statisticCombo->setToolTip("Shows a smoothed value, a percentile over the statistics window "
+                                       "or the held peak instead of the latest sample.");
+            checkLayout->addWidget(statisticCombo);
+        }
+        m_statisticCombos.append(statisticCombo);
         QWidget* checkWidget = new QWidget();
         checkWidget->setLayout(checkLayout);
         displayLayout->addWidget(checkWidget);
@@ -153,6 +197,69 @@ SettingsDialog::SettingsDialog(QWidget *parent) : QDialog(parent)
     QWidget* intervalWidget = new QWidget();
     intervalWidget->setLayout(intervalLayout);
     behaviorLayout->addRow("Update Interval:", intervalWidget);
+
+    QHBoxLayout* historyLayout = new QHBoxLayout();
+    QLabel* historyIcon = new QLabel();
+    historyIcon->setPixmap(style()->standardIcon(QStyle::SP_FileDialogContentsView).pixmap(16, 16));
+    m_historyMinutesSpinBox = new QSpinBox();
+    m_historyMinutesSpinBox->setRange(1, 1440);
+    m_historyMinutesSpinBox->setSuffix(" min");
+    m_historyMinutesSpinBox->setToolTip("How much metric history is kept for trends and averages. Applied on next start.");
+    historyLayout->addWidget(historyIcon);
+    historyLayout->addWidget(m_historyMinutesSpinBox);
+    historyLayout->addStretch();
+    QWidget* historyWidget = new QWidget();
+    historyWidget->setLayout(historyLayout);
+    behaviorLayout->addRow("History Window:", historyWidget);
+
+    m_adaptiveSamplingCheckBox = new QCheckBox("Adaptive Sampling");
+    m_adaptiveSamplingCheckBox->setToolTip("Sample metrics faster while they change and back off while they are steady. "
+                                           "The update interval is where each metric starts.");
+    behaviorLayout->addRow("", m_adaptiveSamplingCheckBox);
+
+    QHBoxLayout* smoothingLayout = new QHBoxLayout();
+    QLabel* smoothingIcon = new QLabel();
+    smoothingIcon->setPixmap(style()->standardIcon(QStyle::SP_FileDialogInfoView).pixmap(16, 16));
+    m_averageSecondsSpinBox = new QDoubleSpinBox();
+    m_averageSecondsSpinBox->setRange(0.5, 60.0);
+    m_averageSecondsSpinBox->setSingleStep(0.5);
+    m_averageSecondsSpinBox->setDecimals(1);
+    m_averageSecondsSpinBox->setSuffix(" s");
+    m_averageSecondsSpinBox->setToolTip("Time constant of the Average statistic, and how fast a held peak falls back.");
+    smoothingLayout->addWidget(smoothingIcon);
+    smoothingLayout->addWidget(m_averageSecondsSpinBox);
+    smoothingLayout->addStretch();
+    QWidget* smoothingWidget = new QWidget();
+    smoothingWidget->setLayout(smoothingLayout);
+    behaviorLayout->addRow("Smoothing:", smoothingWidget);
+
+    QHBoxLayout* windowLayout = new QHBoxLayout();
+    QLabel* windowIcon = new QLabel();
+    windowIcon->setPixmap(style()->standardIcon(QStyle::SP_FileDialogContentsView).pixmap(16, 16));
+    m_statisticsWindowSpinBox = new QSpinBox();
+    m_statisticsWindowSpinBox->setRange(10, 3600);
+    m_statisticsWindowSpinBox->setSuffix(" s");
+    m_statisticsWindowSpinBox->setToolTip("How far back the median and percentiles look.");
+    windowLayout->addWidget(windowIcon);
+    windowLayout->addWidget(m_statisticsWindowSpinBox);
+    windowLayout->addStretch();
+    QWidget* windowWidget = new QWidget();
+    windowWidget->setLayout(windowLayout);
+    behaviorLayout->addRow("Percentile Window:", windowWidget);
+
+    QHBoxLayout* peakHoldLayout = new QHBoxLayout();
+    QLabel* peakHoldIcon = new QLabel();
+    peakHoldIcon->setPixmap(style()->standardIcon(QStyle::SP_ArrowUp).pixmap(16, 16));
+    m_peakHoldSpinBox = new QSpinBox();
+    m_peakHoldSpinBox->setRange(0, 600);
+    m_peakHoldSpinBox->setSuffix(" s");
+    m_peakHoldSpinBox->setToolTip("How long the Peak statistic holds a peak before it decays.");
+    peakHoldLayout->addWidget(peakHoldIcon);
+    peakHoldLayout->addWidget(m_peakHoldSpinBox);
+    peakHoldLayout->addStretch();
+    QWidget* peakHoldWidget = new QWidget();
+    peakHoldWidget->setLayout(peakHoldLayout);
+    behaviorLayout->addRow("Peak Hold:", peakHoldWidget);
     
     behaviorGroup->setLayout(behaviorLayout);
 
@@ -195,25 +302,23 @@ void SettingsDialog::loadSettings()
     m_layoutOrientationComboBox->setCurrentText(s.value("appearance/layoutOrientation", "Vertical").toString());
     m_fontSizeSpinBox->setValue(s.value("appearance/fontSize", 11).toInt());
     m_backgroundOpacitySpinBox->setValue(s.value("appearance/backgroundOpacity", 120).toInt());
+    m_showSparklinesCheckBox->setChecked(s.value("appearance/showSparklines", false).toBool());
+    m_rendererComboBox->setCurrentText(s.value("appearance/renderer", "Widgets").toString());
     m_updateIntervalSpinBox->setValue(s.value("behavior/updateInterval", 1000).toInt());
+    m_historyMinutesSpinBox->setValue(s.value("behavior/historyMinutes", 60).toInt());
+    m_adaptiveSamplingCheckBox->setChecked(s.value("behavior/adaptiveSampling", false).toBool());
 
     // Load display settings for all metrics
-    QStringList settingsKeys = {
-        "display/showCpu", "display/showMem", "display/showRam", "display/showDisk", "display/showGpu",
-        "display/showFps", "display/showNetDown", "display/showNetUp", "display/showDailyData",
-        "display/showCpuTemp", "display/showGpuTemp", "display/showProcesses", "display/showUptime"
-    };
-    
-    QList<bool> defaultValues = {
-        true, true, true, true, true,  // Original metrics default to true
-        false, false, false, false,    // New metrics default to false
-        false, false, false, false
-    };
-
-    for (int i = 0; i < m_displayChecks.size() && i < settingsKeys.size(); ++i) {
-        bool defaultValue = i < defaultValues.size() ? defaultValues[i] : false;
-        m_displayChecks[i]->setChecked(s.value(settingsKeys[i], defaultValue).toBool());
+    for (int i = 0; i < m_displayChecks.size() && i < OverlaySettings::DisplayItemCount; ++i) {
+        m_displayChecks[i]->setChecked(s.value(OverlaySettings::displayKey(i), OverlaySettings::displayDefault(i)).toBool());
+        if (m_statisticCombos[i]) {
+            const int index = m_statisticCombos[i]->findData(s.value(OverlaySettings::statisticKey(i), "latest").toString());
+            m_statisticCombos[i]->setCurrentIndex(qMax(0, index));
+        }
     }
+    m_averageSecondsSpinBox->setValue(s.value("statistics/averageSeconds", 3.0).toDouble());
+    m_statisticsWindowSpinBox->setValue(s.value("statistics/windowSeconds", 60).toInt());
+    m_peakHoldSpinBox->setValue(s.value("statistics/peakHoldSeconds", 5).toInt());
 }
 
 void SettingsDialog::saveAndApplySettings()
@@ -222,18 +327,22 @@ void SettingsDialog::saveAndApplySettings()
     s.setValue("appearance/layoutOrientation", m_layoutOrientationComboBox->currentText());
     s.setValue("appearance/fontSize", m_fontSizeSpinBox->value());
     s.setValue("appearance/backgroundOpacity", m_backgroundOpacitySpinBox->value());
+    s.setValue("appearance/showSparklines", m_showSparklinesCheckBox->isChecked());
+    s.setValue("appearance/renderer", m_rendererComboBox->currentText());
     s.setValue("behavior/updateInterval", m_updateIntervalSpinBox->value());
+    s.setValue("behavior/historyMinutes", m_historyMinutesSpinBox->value());
+    s.setValue("behavior/adaptiveSampling", m_adaptiveSamplingCheckBox->isChecked());
 
     // Save display settings for all metrics
-    QStringList settingsKeys = {
-        "display/showCpu", "display/showMem", "display/showRam", "display/showDisk", "display/showGpu",
-        "display/showFps", "display/showNetDown", "display/showNetUp", "display/showDailyData",
-        "display/showCpuTemp", "display/showGpuTemp", "display/showProcesses", "display/showUptime"
-    };
-
-    for (int i = 0; i < m_displayChecks.size() && i < settingsKeys.size(); ++i) {
-        s.setValue(settingsKeys[i], m_displayChecks[i]->isChecked());
+    for (int i = 0; i < m_displayChecks.size() && i < OverlaySettings::DisplayItemCount; ++i) {
+        s.setValue(OverlaySettings::displayKey(i), m_displayChecks[i]->isChecked());
+        if (m_statisticCombos[i]) {
+            s.setValue(OverlaySettings::statisticKey(i), m_statisticCombos[i]->currentData().toString());
+        }
     }
+    s.setValue("statistics/averageSeconds", m_averageSecondsSpinBox->value());
+    s.setValue("statistics/windowSeconds", m_statisticsWindowSpinBox->value());
+    s.setValue("statistics/peakHoldSeconds", m_peakHoldSpinBox->value());
 
     emit settingsApplied();
 }
@@ -6,6 +6,7 @@
 
 class QCheckBox;
 class QSpinBox;
+class QDoubleSpinBox;
 class QPushButton;
 class QComboBox;
 
@@ -33,8 +34,17 @@ private:
     QPushButton *m_backgroundColorButton;
     QSpinBox *m_backgroundOpacitySpinBox;
     QComboBox *m_layoutOrientationComboBox;
+    QCheckBox *m_showSparklinesCheckBox;
+    QComboBox *m_rendererComboBox;
     QSpinBox *m_updateIntervalSpinBox;
+    QSpinBox *m_historyMinutesSpinBox;
+    QCheckBox *m_adaptiveSamplingCheckBox;
     QList<QCheckBox*> m_displayChecks;
+    // What each row shows of its metric; nullptr for rows without a statistic
+    QList<QComboBox*> m_statisticCombos;
+    QDoubleSpinBox *m_averageSecondsSpinBox;
+    QSpinBox *m_statisticsWindowSpinBox;
+    QSpinBox *m_peakHoldSpinBox;
 };
 
 #endif // SETTINGSDIALOG_H
\ No newline at end of file
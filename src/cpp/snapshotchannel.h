@@ -0,0 +1,52 @@
+#ifndef SNAPSHOTCHANNEL_H
+#define SNAPSHOTCHANNEL_H
+
+#include <atomic>
+
+// Lock-free single-producer/single-consumer handoff of the latest value (triple buffering).
+// The producer fills writeBuffer() and publishes it; the consumer picks up whatever was
+// published last. Neither side ever waits for the other, and intermediate values the
+// consumer did not get to in time are simply overwritten.
+template <typename T>
+class SnapshotChannel
+{
+public:
+    SnapshotChannel() = default;
+    SnapshotChannel(const SnapshotChannel&) = delete;
+    SnapshotChannel& operator=(const SnapshotChannel&) = delete;
+
+    // Producer side
+    T& writeBuffer() { return m_buffers[m_writeIndex]; }
+
+    void publish()
+    {
+        int previous = m_middle.exchange(m_writeIndex | FreshBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & IndexMask;
+    }
+
+    // Consumer side. Returns false if nothing new was published since the last call.
+    bool consume()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FreshBit)) {
+            return false;
+        }
+        int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & IndexMask;
+        return true;
+    }
+
+    const T& readBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+    static constexpr int IndexMask = 0x3;
+    static constexpr int FreshBit = 0x4;
+
+    T m_buffers[3];
+
+    // Producer and consumer state live on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<int> m_middle{1};
+    alignas(64) int m_writeIndex = 0;
+    alignas(64) int m_readIndex = 2;
+};
+
+#endif // SNAPSHOTCHANNEL_H
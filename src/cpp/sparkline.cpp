@@ -0,0 +1,171 @@
+#include "sparkline.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+Sparkline::Sparkline(const QSize& size)
+    : m_image(size, QImage::Format_ARGB32_Premultiplied)
+    , m_color(Qt::white)
+    , m_nextColumn(0)
+    , m_values(size.width(), 0.0f)
+    , m_valueCount(0)
+    , m_lastValue(0.0)
+    , m_fixedRange(false)
+    , m_minimum(0.0)
+    , m_maximum(1.0)
+{
+    m_image.fill(Qt::transparent);
+}
+
+void Sparkline::setColor(const QColor& color)
+{
+    if (color == m_color) {
+        return;
+    }
+    m_color = color;
+    redraw();
+}
+
+void Sparkline::setFixedRange(double minimum, double maximum)
+{
+    m_fixedRange = true;
+    m_minimum = minimum;
+    m_maximum = qMax(maximum, minimum + 1e-9);
+    redraw();
+}
+
+void Sparkline::clear()
+{
+    m_nextColumn = 0;
+    m_valueCount = 0;
+    m_image.fill(Qt::transparent);
+}
+
+void Sparkline::addSample(double value)
+{
+    const int width = m_image.width();
+    if (width == 0) {
+        return;
+    }
+    const double previous = m_valueCount > 0 ? m_lastValue : value;
+    m_values[m_nextColumn] = static_cast<float>(value);
+    m_valueCount = qMin(m_valueCount + 1, width);
+    m_lastValue = value;
+
+    if (!m_fixedRange) {
+        // Grow immediately when a value goes off the top; shrink once the peak that set the
+        // scale has scrolled out and everything left would fit in half the height.
+        const float visibleMax = *std::max_element(m_values.begin(), m_values.begin() + m_valueCount);
+        if (value > m_maximum || (m_nextColumn == 0 && visibleMax < m_maximum * 0.5)) {
+            m_maximum = qMax(visibleMax * 1.25, 1e-9);
+            m_nextColumn = (m_nextColumn + 1) % width;
+            redraw();
+            return;
+        }
+    }
+
+    drawColumn(m_nextColumn, previous, value);
+    m_nextColumn = (m_nextColumn + 1) % width;
+}
+
+void Sparkline::setSamples(const float* values, int count)
+{
+    const int width = m_image.width();
+    const int first = qMax(0, count - width);
+    m_valueCount = count - first;
+    m_nextColumn = m_valueCount % width;
+    for (int i = 0; i < m_valueCount; ++i) {
+        m_values[i] = values[first + i];
+    }
+    m_lastValue = m_valueCount > 0 ? values[count - 1] : 0.0;
+
+    if (!m_fixedRange && m_valueCount > 0) {
+        const float visibleMax = *std::max_element(m_values.begin(), m_values.begin() + m_valueCount);
+        m_maximum = qMax(visibleMax * 1.25, 1e-9);
+    }
+    redraw();
+}
+
+void Sparkline::redraw()
+{
+    m_image.fill(Qt::transparent);
+    const int width = m_image.width();
+    // Columns are stored in ring order; the oldest sample sits at m_nextColumn once full
+    const int oldest = m_valueCount == width ? m_nextColumn : 0;
+    for (int i = 0; i < m_valueCount; ++i) {
+        const int column = (oldest + i) % width;
+        const int previousColumn = (column + width - 1) % width;
+        const double previous = i > 0 ? m_values[previousColumn] : m_values[column];
+        drawColumn(column, previous, m_values[column]);
+    }
+}
+
+int Sparkline::toY(double value) const
+{
+    const int height = m_image.height();
+    const double fraction = (value - m_minimum) / (m_maximum - m_minimum);
+    return height - 1 - qBound(0, static_cast<int>(fraction * (height - 1) + 0.5), height - 1);
+}
+
+void Sparkline::drawColumn(int column, double previous, double value)
+{
+    const int height = m_image.height();
+    QPainter painter(&m_image);
+    painter.setClipRect(column, 0, 1, height);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(column, 0, 1, height, Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    const int yPrevious = toY(previous);
+    const int y = toY(value);
+
+    // Area under the curve for this column, then the curve itself on top
+    QPainterPath area;
+    area.moveTo(column, yPrevious);
+    area.lineTo(column + 1, y);
+    area.lineTo(column + 1, height);
+    area.lineTo(column, height);
+    area.closeSubpath();
+    QColor fill = m_color;
+    fill.setAlpha(m_color.alpha() / 3);
+    painter.fillPath(area, fill);
+
+    painter.fillRect(column, qMin(y, yPrevious), 1, qAbs(y - yPrevious) + 1, m_color);
+}
+
+void Sparkline::paint(QPainter& painter, const QPoint& topLeft) const
+{
+    const int width = m_image.width();
+    const int height = m_image.height();
+    if (m_valueCount < width) {
+        // Not wrapped yet: columns [0, count) are already oldest-first. Right-align them
+        painter.drawImage(QPoint(topLeft.x() + width - m_valueCount, topLeft.y()),
+                          m_image, QRect(0, 0, m_valueCount, height));
+        return;
+    }
+    const int tail = width - m_nextColumn;
+    painter.drawImage(topLeft, m_image, QRect(m_nextColumn, 0, tail, height));
+    if (m_nextColumn > 0) {
+        painter.drawImage(QPoint(topLeft.x() + tail, topLeft.y()), m_image, QRect(0, 0, m_nextColumn, height));
+    }
+}
+
+SparklineWidget::SparklineWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setFixedSize(m_sparkline.size());
+    setAttribute(Qt::WA_TranslucentBackground);
+}
+
+void SparklineWidget::addSample(double value)
+{
+    m_sparkline.addSample(value);
+    update();
+}
+
+void SparklineWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    m_sparkline.paint(painter, QPoint(0, 0));
+}
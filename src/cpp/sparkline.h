@@ -0,0 +1,74 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <QColor>
+#include <QImage>
+#include <QSize>
+#include <QWidget>
+#include <vector>
+
+class QPainter;
+
+// Small trend graph rendered into a cached QImage.
+//
+// The image is used as a circular buffer of pixel columns: each new sample draws exactly
+// one column at the write position and advances it, so the cost of a sample is one column
+// no matter how wide the graph is. paint() blits the two halves of the ring in order,
+// which is what makes the graph appear to scroll. Everything goes through the raster
+// engine, so it works the same on the offscreen platform.
+class Sparkline
+{
+public:
+    explicit Sparkline(const QSize& size = QSize(48, 14));
+
+    QSize size() const { return m_image.size(); }
+    void setColor(const QColor& color);
+
+    // A fixed range (e.g. 0-100 for percentages). Without one the graph scales to the
+    // largest value it currently shows.
+    void setFixedRange(double minimum, double maximum);
+
+    void addSample(double value);
+    // Replaces the contents, e.g. with a window copied out of MetricHistory
+    void setSamples(const float* values, int count);
+    void clear();
+
+    void paint(QPainter& painter, const QPoint& topLeft) const;
+
+private:
+    void redraw();
+    void drawColumn(int column, double previous, double value);
+    int toY(double value) const;
+
+    QImage m_image;
+    QColor m_color;
+    int m_nextColumn;
+
+    // The values currently on screen, in the same ring order as the image columns; only
+    // needed to redraw everything when the scale changes.
+    std::vector<float> m_values;
+    int m_valueCount;
+    double m_lastValue;
+
+    bool m_fixedRange;
+    double m_minimum;
+    double m_maximum;
+};
+
+class SparklineWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SparklineWidget(QWidget *parent = nullptr);
+
+    Sparkline& sparkline() { return m_sparkline; }
+    void addSample(double value);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    Sparkline m_sparkline;
+};
+
+#endif // SPARKLINE_H
@@ -0,0 +1,251 @@
+#ifndef SYSINFO_H
+#define SYSINFO_H
+
+#include <QtGlobal>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Lifecycle of the sensor helper process, as reported by HelperSupervisor
+enum class HelperHealth : int {
+    Disabled,   // no helper configured, or sampling stopped
+    Starting,   // launched, waiting for the first frame
+    Running,
+    Restarting, // crashed or hung, waiting out the backoff
+    Failed      // missing, or restart budget exhausted
+};
+
+// One of the busiest processes, for the top-N rows
+struct TopProcess {
+    quint32 pid = 0;     // 0 marks an empty slot
+    char name[24] = {};  // executable name, truncated
+    float cpuPercent = 0.0f; // of the whole machine, since the previous sample
+    float residentMB = 0.0f;
+};
+
+constexpr int TopProcessCount = 3;
+
+constexpr int MaxCpuCores = 256;
+constexpr int BusiestCoreCount = 3;
+
+// Per logical CPU, for the cores row and its heat strip (see CpuCoreAggregator)
+struct CpuCores {
+    int count = 0;                          // 0 until the CpuCores group is collected
+    quint8 load[MaxCpuCores] = {};          // percent since the previous sample
+    quint16 frequencyMHz[MaxCpuCores] = {}; // 0 where unknown
+    qint16 busiest[BusiestCoreCount] = { -1, -1, -1 }; // core numbers, busiest first; -1 when empty
+};
+
+struct SysInfo {
+    double cpuLoad = 0.0;
+    int memUsage = 0;
+    qint64 totalRamMB = 0;
+    qint64 availRamMB = 0;
+    double diskLoad = 0.0;
+    double gpuLoad = 0.0;
+    double fps = -1.0;  // -1 while there is no frame source or nothing presents
+    double networkDownloadSpeed = 0.0;
+    double networkUploadSpeed = 0.0;
+    qint64 dailyDataUsageMB = 0;
+    double cpuTemp = -1.0;
+    double gpuTemp = -1.0;
+    int activeProcesses = 0;
+    double systemUptime = 0.0;
+    // Sensor helper cost: age of the newest helper frame when this sample was published,
+    // and the helper's CPU use since the previous sample. -1 when no helper is running.
+    double sensorLatencyMs = -1.0;
+    double helperCpuPercent = -1.0;
+    // HelperHealth as int, restarts so far and wall time to first frame of the latest start
+    int helperHealth = static_cast<int>(HelperHealth::Disabled);
+    int helperRestarts = 0;
+    double helperStartupMs = -1.0;
+    // The overlay's own cost: CPU since the previous sample and resident memory. -1 when
+    // built without WINSYS_INSTRUMENTATION.
+    double selfCpuPercent = -1.0;
+    double selfMemoryMB = -1.0;
+    // Frame pacing over the last few seconds (see FrameTimingEngine): the 1% low and the
+    // median and 99th percentile frame times. -1 whenever fps is.
+    double fpsLow1Percent = -1.0;
+    double frameTimeP50Ms = -1.0;
+    double frameTimeP99Ms = -1.0;
+    // Per-core aggregates: the busiest core's load and the mean and highest clock across
+    // cores. -1 while not collected, or where the platform reports no frequency.
+    double cpuCoreMaxLoad = -1.0;
+    double cpuFrequencyMHz = -1.0;
+    double cpuFrequencyMaxMHz = -1.0;
+    // Busiest processes by CPU and by resident memory, busiest first. Only filled in while
+    // the top process rows are shown; not part of the Metric set below.
+    TopProcess topCpu[TopProcessCount];
+    TopProcess topMemory[TopProcessCount];
+    // Per-core detail behind the aggregates above; not part of the Metric set below
+    CpuCores cpuCores;
+    // Bit per Metric that has a firing alert rule (see AlertEngine). Set on the copy the
+    // overlay receives only; not part of the Metric set below.
+    quint32 alertMetrics = 0;
+};
+
+// Every numeric SysInfo field, in declaration order. Used to address per-metric storage
+// such as the history ring buffers without naming each field.
+enum class Metric : int {
+    CpuLoad,
+    MemUsage,
+    TotalRam,
+    AvailRam,
+    DiskLoad,
+    GpuLoad,
+    Fps,
+    NetworkDownload,
+    NetworkUpload,
+    DailyDataUsage,
+    CpuTemp,
+    GpuTemp,
+    ActiveProcesses,
+    SystemUptime,
+    SensorLatency,
+    HelperCpu,
+    HelperState,
+    HelperRestarts,
+    HelperStartup,
+    SelfCpu,
+    SelfMemory,
+    FpsLow1Percent,
+    FrameTimeP50,
+    FrameTimeP99,
+    CpuCoreMax,
+    CpuFrequency,
+    CpuFrequencyMax,
+    Count
+};
+
+constexpr int MetricCount = static_cast<int>(Metric::Count);
+
+inline double metricValue(const SysInfo& info, Metric metric)
+{
+    switch (metric) {
+    case Metric::CpuLoad: return info.cpuLoad;
+    case Metric::MemUsage: return info.memUsage;
+    case Metric::TotalRam: return static_cast<double>(info.totalRamMB);
+    case Metric::AvailRam: return static_cast<double>(info.availRamMB);
+    case Metric::DiskLoad: return info.diskLoad;
+    case Metric::GpuLoad: return info.gpuLoad;
+    case Metric::Fps: return info.fps;
+    case Metric::NetworkDownload: return info.networkDownloadSpeed;
+    case Metric::NetworkUpload: return info.networkUploadSpeed;
+    case Metric::DailyDataUsage: return static_cast<double>(info.dailyDataUsageMB);
+    case Metric::CpuTemp: return info.cpuTemp;
+    case Metric::GpuTemp: return info.gpuTemp;
+    case Metric::ActiveProcesses: return info.activeProcesses;
+    case Metric::SystemUptime: return info.systemUptime;
+    case Metric::SensorLatency: return info.sensorLatencyMs;
+    case Metric::HelperCpu: return info.helperCpuPercent;
+    case Metric::HelperState: return info.helperHealth;
+    case Metric::HelperRestarts: return info.helperRestarts;
+    case Metric::HelperStartup: return info.helperStartupMs;
+    case Metric::SelfCpu: return info.selfCpuPercent;
+    case Metric::SelfMemory: return info.selfMemoryMB;
+    case Metric::FpsLow1Percent: return info.fpsLow1Percent;
+    case Metric::FrameTimeP50: return info.frameTimeP50Ms;
+    case Metric::FrameTimeP99: return info.frameTimeP99Ms;
+    case Metric::CpuCoreMax: return info.cpuCoreMaxLoad;
+    case Metric::CpuFrequency: return info.cpuFrequencyMHz;
+    case Metric::CpuFrequencyMax: return info.cpuFrequencyMaxMHz;
+    case Metric::Count: break;
+    }
+    return 0.0;
+}
+
+// Inverse of metricValue(), for restoring recorded samples
+inline void setMetricValue(SysInfo& info, Metric metric, double value)
+{
+    switch (metric) {
+    case Metric::CpuLoad: info.cpuLoad = value; break;
+    case Metric::MemUsage: info.memUsage = static_cast<int>(value); break;
+    case Metric::TotalRam: info.totalRamMB = static_cast<qint64>(value); break;
+    case Metric::AvailRam: info.availRamMB = static_cast<qint64>(value); break;
+    case Metric::DiskLoad: info.diskLoad = value; break;
+    case Metric::GpuLoad: info.gpuLoad = value; break;
+    case Metric::Fps: info.fps = value; break;
+    case Metric::NetworkDownload: info.networkDownloadSpeed = value; break;
+    case Metric::NetworkUpload: info.networkUploadSpeed = value; break;
+    case Metric::DailyDataUsage: info.dailyDataUsageMB = static_cast<qint64>(value); break;
+    case Metric::CpuTemp: info.cpuTemp = value; break;
+    case Metric::GpuTemp: info.gpuTemp = value; break;
+    case Metric::ActiveProcesses: info.activeProcesses = static_cast<int>(value); break;
+    case Metric::SystemUptime: info.systemUptime = value; break;
+    case Metric::SensorLatency: info.sensorLatencyMs = value; break;
+    case Metric::HelperCpu: info.helperCpuPercent = value; break;
+    case Metric::HelperState: info.helperHealth = static_cast<int>(value); break;
+    case Metric::HelperRestarts: info.helperRestarts = static_cast<int>(value); break;
+    case Metric::HelperStartup: info.helperStartupMs = value; break;
+    case Metric::SelfCpu: info.selfCpuPercent = value; break;
+    case Metric::SelfMemory: info.selfMemoryMB = value; break;
+    case Metric::FpsLow1Percent: info.fpsLow1Percent = value; break;
+    case Metric::FrameTimeP50: info.frameTimeP50Ms = value; break;
+    case Metric::FrameTimeP99: info.frameTimeP99Ms = value; break;
+    case Metric::CpuCoreMax: info.cpuCoreMaxLoad = value; break;
+    case Metric::CpuFrequency: info.cpuFrequencyMHz = value; break;
+    case Metric::CpuFrequencyMax: info.cpuFrequencyMaxMHz = value; break;
+    case Metric::Count: break;
+    }
+}
+
+// Stable snake_case name of a metric for machine-readable output such as the headless
+// collector's columns. Changing one breaks whoever parses that output.
+inline const char* metricName(Metric metric)
+{
+    switch (metric) {
+    case Metric::CpuLoad: return "cpu_load";
+    case Metric::MemUsage: return "mem_usage";
+    case Metric::TotalRam: return "total_ram_mb";
+    case Metric::AvailRam: return "avail_ram_mb";
+    case Metric::DiskLoad: return "disk_load";
+    case Metric::GpuLoad: return "gpu_load";
+    case Metric::Fps: return "fps";
+    case Metric::NetworkDownload: return "net_down_mb_s";
+    case Metric::NetworkUpload: return "net_up_mb_s";
+    case Metric::DailyDataUsage: return "daily_data_mb";
+    case Metric::CpuTemp: return "cpu_temp";
+    case Metric::GpuTemp: return "gpu_temp";
+    case Metric::ActiveProcesses: return "processes";
+    case Metric::SystemUptime: return "uptime_hours";
+    case Metric::SensorLatency: return "sensor_latency_ms";
+    case Metric::HelperCpu: return "helper_cpu";
+    case Metric::HelperState: return "helper_state";
+    case Metric::HelperRestarts: return "helper_restarts";
+    case Metric::HelperStartup: return "helper_startup_ms";
+    case Metric::SelfCpu: return "self_cpu";
+    case Metric::SelfMemory: return "self_rss_mb";
+    case Metric::FpsLow1Percent: return "fps_low_1pct";
+    case Metric::FrameTimeP50: return "frame_time_p50_ms";
+    case Metric::FrameTimeP99: return "frame_time_p99_ms";
+    case Metric::CpuCoreMax: return "cpu_core_max";
+    case Metric::CpuFrequency: return "cpu_freq_mhz";
+    case Metric::CpuFrequencyMax: return "cpu_freq_max_mhz";
+    case Metric::Count: break;
+    }
+    return "";
+}
+
+// Inverse of metricName(); false for a name it does not know
+inline bool metricFromName(const char* name, Metric& metric)
+{
+    for (int m = 0; m < MetricCount; ++m) {
+        if (std::strcmp(name, metricName(static_cast<Metric>(m))) == 0) {
+            metric = static_cast<Metric>(m);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Writes value for machine-readable output: integral values (RAM, counts) exactly,
+// everything else with 6 significant digits. Returns what snprintf returns.
+inline int formatMetricValue(char* out, size_t size, double value)
+{
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        return std::snprintf(out, size, "%lld", static_cast<long long>(value));
+    }
+    return std::snprintf(out, size, "%.6g", value);
+}
+
+#endif // SYSINFO_H
@@ -1,281 +1,169 @@
 #include "sysinfomonitor.h"
-#include <QDebug>
-#include <QCoreApplication>
-#include <QDir>
-#include <QSettings>
-#include <QDate>
-#include <QFileInfo>
+#include "sysinfosampler.h"
+#include "metricsexporter.h"
+#include "instrumentation.h"
+#include <QThread>
+#include <QMetaObject>
+
+SysInfoMonitor::SysInfoMonitor(const SamplerSettings& settings, QObject *parent)
+    : SysInfoMonitor(settings, MetricCollectorFactory(), parent)
+{
+}
 
-SysInfoMonitor::SysInfoMonitor(QObject *parent) : QObject(parent)
+SysInfoMonitor::SysInfoMonitor(const SamplerSettings& settings, MetricCollectorFactory collectorFactory,
+                               QObject *parent)
+    : QObject(parent)
+    , m_settings(settings)
+    , m_exporterThread(nullptr)
+    , m_exporter(nullptr)
+    , m_deliveryPending(false)
 {
-    m_tempReaderProcess = new QProcess(this);
-    m_timer = new QTimer(this);
+    // The history window is sized once; a changed interval only changes how much wall-clock
+    // time the same number of samples covers until the next start.
+    int interval = qMax(1, settings.updateInterval);
+    m_history = std::make_unique<MetricHistory>(settings.historyMinutes * 60 * 1000 / interval);
 
-    m_dailyDataBytes = 0;
-    m_lastResetDate = QDate::currentDate();
+    m_alerts.configure(settings.alertRules);
 
-    m_lastNetworkTime = QDateTime::currentMSecsSinceEpoch();
+    m_thread = new QThread(this);
+    m_thread->setObjectName("SysInfoSampler");
 
-    connect(m_timer, &QTimer::timeout, this, &SysInfoMonitor::poll);
-    connect(m_tempReaderProcess, &QProcess::readyReadStandardOutput, this, &SysInfoMonitor::readTempData);
-    connect(m_tempReaderProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &SysInfoMonitor::onTempReaderFinished);
-    connect(m_tempReaderProcess, &QProcess::errorOccurred, this, [](QProcess::ProcessError error) {
-        qWarning() << "QProcess error:" << error;
-    });
+    m_sampler = new SysInfoSampler([this](const SysInfo& info, qint64 timestampMs) {
+        publishSnapshot(info, timestampMs);
+    }, settings, std::move(collectorFactory));
+    m_sampler->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_sampler, &QObject::deleteLater);
+    connect(m_sampler, &SysInfoSampler::playbackFinished, this, &SysInfoMonitor::playbackFinished);
 
-    initializeLegacyCounters();
-    loadDailyDataUsage();
-    startTempReaderProcess();
+    m_thread->start();
+    QMetaObject::invokeMethod(m_sampler, &SysInfoSampler::initialize, Qt::QueuedConnection);
+
+    configureExporter();
 }
 
 SysInfoMonitor::~SysInfoMonitor()
 {
-    stop();
-    saveDailyDataUsage();
+    // The sampler is destroyed on its own thread (deleteLater on finished), which stops the
+    // helper process and saves the daily data usage before the thread exits.
+    m_thread->quit();
+    m_thread->wait();
+    // Only after the sampler thread is gone, since it renders into the exporter
+    if (m_exporterThread) {
+        m_exporterThread->quit();
+        m_exporterThread->wait();
+    }
 }
 
 void SysInfoMonitor::start() {
-    QSettings s;
-    int interval = s.value("behavior/updateInterval", 1000).toInt();
-    m_timer->start(interval);
+    QMetaObject::invokeMethod(m_sampler, &SysInfoSampler::start, Qt::QueuedConnection);
 }
 
 void SysInfoMonitor::stop() {
-    m_timer->stop();
-    if (m_tempReaderProcess->state() == QProcess::Running) {
-        m_tempReaderProcess->write("exit\n");
-        m_tempReaderProcess->waitForFinished(1000);
-        m_tempReaderProcess->kill();
-    }
-    saveDailyDataUsage();
+    QMetaObject::invokeMethod(m_sampler, &SysInfoSampler::stop, Qt::QueuedConnection);
 }
 
-void SysInfoMonitor::startTempReaderProcess() {
-    if (m_tempReaderProcess->state() != QProcess::NotRunning) {
-        return;
-    }
-    QString programPath = QCoreApplication::applicationDirPath() + QDir::separator() + "TempReader.exe";
-    QFileInfo tempReaderInfo(programPath);
-
-    if (!tempReaderInfo.exists()) {
-        qWarning() << "TempReader.exe not found at:" << programPath;
-        m_sysInfo.cpuTemp = -1;
-        m_sysInfo.gpuTemp = -1;
-        return;
-    }
-    m_tempReaderProcess->start(programPath);
-}
-
-
-void SysInfoMonitor::poll() {
-    updateLegacyStats(m_sysInfo);
-
-    if (m_tempReaderProcess->state() == QProcess::Running) {
-        m_tempReaderProcess->write("update\n");
-        m_tempReaderProcess->waitForBytesWritten(100);
-    } else {
-        startTempReaderProcess();
+void SysInfoMonitor::setSettings(const SamplerSettings& settings)
+{
+    SamplerSettings samplerPart = settings;
+    samplerPart.exporterEnabled = m_settings.exporterEnabled;
+    samplerPart.exporterPort = m_settings.exporterPort;
+    samplerPart.alertRules = m_settings.alertRules;
+    const bool samplerChanged = samplerPart != m_settings;
+    const bool exporterChanged = settings.exporterEnabled != m_settings.exporterEnabled ||
+                                 settings.exporterPort != m_settings.exporterPort;
+    const bool alertsChanged = settings.alertRules != m_settings.alertRules;
+    m_settings = settings;
+
+    if (samplerChanged) {
+        QMetaObject::invokeMethod(m_sampler, [sampler = m_sampler, settings]() {
+            sampler->setSettings(settings);
+        }, Qt::QueuedConnection);
+    }
+    if (exporterChanged) {
+        configureExporter();
+    }
+    if (alertsChanged) {
+        // The exporter reads the rules while rendering, which also happens on the sampler thread
+        QMetaObject::invokeMethod(m_sampler, [this, rules = settings.alertRules]() {
+            m_alerts.configure(rules);
+        }, Qt::QueuedConnection);
     }
-
-    emit statsUpdated(m_sysInfo);
 }
 
-void SysInfoMonitor::readTempData() {
-    while (m_tempReaderProcess->canReadLine()) {
-        QByteArray output = m_tempReaderProcess->readLine();
-        QString outputStr(output.trimmed());
-
-        if (outputStr.contains("CPU:") && outputStr.contains("GPU:")) {
-            QStringList parts = outputStr.split(',');
-            if (parts.length() == 2) {
-                m_sysInfo.cpuTemp = parts[0].mid(4).toDouble();
-                m_sysInfo.gpuTemp = parts[1].mid(4).toDouble();
-            }
+void SysInfoMonitor::setStatistics(const MetricStatisticsConfig& config)
+{
+    // Applied between two samples on the sampler thread, which is the only one that uses them
+    QMetaObject::invokeMethod(m_sampler, [this, config]() {
+        if (config != m_statistics.config()) {
+            m_statistics.configure(config);
         }
-    }
+    }, Qt::QueuedConnection);
 }
 
-void SysInfoMonitor::onTempReaderFinished(int exitCode, QProcess::ExitStatus exitStatus) {
-    qWarning() << "TempReader.exe finished unexpectedly. Exit code:" << exitCode << "Status:" << exitStatus;
-    m_sysInfo.cpuTemp = -1;
-    m_sysInfo.gpuTemp = -1;
-}
-
-void SysInfoMonitor::loadDailyDataUsage()
+void SysInfoMonitor::configureExporter()
 {
-    QSettings s;
-    QDate savedDate = s.value("network/lastResetDate", QDate::currentDate()).toDate();
-
-    if (savedDate != QDate::currentDate()) {
-        m_dailyDataBytes = 0;
-        m_lastResetDate = QDate::currentDate();
-        saveDailyDataUsage();
-    } else {
-        m_dailyDataBytes = s.value("network/dailyDataBytes", 0).toLongLong();
+    MetricsExporter* exporter = m_exporter.load(std::memory_order_relaxed);
+    if (!m_settings.exporterEnabled) {
+        if (exporter) {
+            QMetaObject::invokeMethod(exporter, &MetricsExporter::close, Qt::QueuedConnection);
+        }
+        return;
     }
+    if (!exporter) {
+        m_exporterThread = new QThread(this);
+        m_exporterThread->setObjectName("MetricsExporter");
+        exporter = new MetricsExporter(*m_history, m_alerts);
+        exporter->moveToThread(m_exporterThread);
+        connect(m_exporterThread, &QThread::finished, exporter, &QObject::deleteLater);
+        m_exporterThread->start();
+        m_exporter.store(exporter, std::memory_order_release);
+    }
+    const int port = m_settings.exporterPort;
+    QMetaObject::invokeMethod(exporter, [exporter, port]() { exporter->listen(port); }, Qt::QueuedConnection);
 }
 
-void SysInfoMonitor::saveDailyDataUsage()
+void SysInfoMonitor::addSampleObserver(SampleObserver observer)
 {
-    QSettings s;
-    s.setValue("network/dailyDataBytes", m_dailyDataBytes);
-    s.setValue("network/lastResetDate", m_lastResetDate);
+    m_observers.push_back(std::move(observer));
 }
 
-void SysInfoMonitor::initializeLegacyCounters() {
-    PdhOpenQuery(nullptr, 0, &m_cpuQuery);
-    PdhAddEnglishCounter(m_cpuQuery, L"\\Processor(_Total)\\% Processor Time", 0, &m_cpuTotalCounter);
-    PdhCollectQueryData(m_cpuQuery);
-
-    PdhOpenQuery(nullptr, 0, &m_diskQuery);
-    PdhAddEnglishCounter(m_diskQuery, L"\\PhysicalDisk(_Total)\\% Disk Time", 0, &m_diskTotalCounter);
-    PdhCollectQueryData(m_diskQuery);
-
-    PdhOpenQuery(nullptr, 0, &m_gpuQuery);
-    const wchar_t* gpuCounterPath = L"\\GPU Engine(*)\\Utilization Percentage";
-    DWORD gpuBufferSize = 0;
-    if (PdhExpandWildCardPathW(nullptr, gpuCounterPath, nullptr, &gpuBufferSize, 0) == PDH_MORE_DATA) {
-        QVector<wchar_t> gpuPathBuffer(gpuBufferSize);
-        if (PdhExpandWildCardPathW(nullptr, gpuCounterPath, gpuPathBuffer.data(), &gpuBufferSize, 0) == ERROR_SUCCESS) {
-            for (const wchar_t* p = gpuPathBuffer.data(); *p != L'\0'; p += wcslen(p) + 1) {
-                PDH_HCOUNTER gpuCounter;
-                if (PdhAddEnglishCounterW(m_gpuQuery, p, 0, &gpuCounter) == ERROR_SUCCESS) {
-                    m_gpuCounters.append(gpuCounter);
-                }
-            }
-        }
-    }
-    if (!m_gpuCounters.isEmpty()) {
-        PdhCollectQueryData(m_gpuQuery);
-    }
-
-    PdhOpenQuery(nullptr, 0, &m_networkQuery);
-    const wchar_t* receivedPath = L"\\Network Interface(*)\\Bytes Received/sec";
-    const wchar_t* sentPath = L"\\Network Interface(*)\\Bytes Sent/sec";
-    
-    auto addCounters = [&](const wchar_t* path, QList<PDH_HCOUNTER>& list) {
-        DWORD bufferSize = 0;
-        if (PdhExpandWildCardPathW(nullptr, path, nullptr, &bufferSize, 0) == PDH_MORE_DATA) {
-            QVector<wchar_t> pathBuffer(bufferSize);
-            if (PdhExpandWildCardPathW(nullptr, path, pathBuffer.data(), &bufferSize, 0) == ERROR_SUCCESS) {
-                for (const wchar_t* p = pathBuffer.data(); *p != L'\0'; p += wcslen(p) + 1) {
-                    QString interfaceName = QString::fromWCharArray(p);
-                    if (!interfaceName.contains("Loopback", Qt::CaseInsensitive) &&
-                        !interfaceName.contains("Teredo", Qt::CaseInsensitive) &&
-                        !interfaceName.contains("isatap", Qt::CaseInsensitive)) {
-                        PDH_HCOUNTER counter;
-                        if (PdhAddEnglishCounterW(m_networkQuery, p, 0, &counter) == ERROR_SUCCESS) {
-                            list.append(counter);
-                        }
-                    }
-                }
-            }
-        }
-    };
-    
-    addCounters(receivedPath, m_networkBytesReceivedCounters);
-    addCounters(sentPath, m_networkBytesSentCounters);
-    
-    if (!m_networkBytesReceivedCounters.isEmpty() || !m_networkBytesSentCounters.isEmpty()) {
-        PdhCollectQueryData(m_networkQuery);
+void SysInfoMonitor::publishSnapshot(const SysInfo& info, qint64 timestampMs)
+{
+    // Called on the sampler thread
+    WINSYS_TRACE_SCOPE(Publish);
+    // On the raw sample, before the exporter renders the rule states
+    const quint32 alertMetrics = m_alerts.evaluate(info, timestampMs);
+    m_history->push(info, timestampMs);
+    for (const SampleObserver& observer : m_observers) {
+        observer(info, timestampMs);
+    }
+    if (MetricsExporter* exporter = m_exporter.load(std::memory_order_acquire)) {
+        exporter->render(info, timestampMs);
+    }
+
+    // Every sample goes through the statistics, coalesced or not, so they follow the real cadence
+    SysInfo& shown = m_channel.writeBuffer();
+    shown = info;
+    m_statistics.apply(shown, timestampMs);
+    shown.alertMetrics = alertMetrics;
+    m_channel.publish();
+
+    // Only wake the GUI thread if it has not been woken already; a pending delivery will
+    // pick up the newest snapshot anyway.
+    if (!m_deliveryPending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &SysInfoMonitor::deliverSnapshot, Qt::QueuedConnection);
     }
 }
 
-void SysInfoMonitor::updateLegacyStats(SysInfo& info) {
-    PDH_FMT_COUNTERVALUE counterVal;
-
-    if (m_cpuQuery && PdhCollectQueryData(m_cpuQuery) == ERROR_SUCCESS &&
-        PdhGetFormattedCounterValue(m_cpuTotalCounter, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
-        info.cpuLoad = counterVal.doubleValue;
-    } else {
-        info.cpuLoad = 0.0;
-    }
-
-    MEMORYSTATUSEX memInfo;
-    memInfo.dwLength = sizeof(MEMORYSTATUSEX);
-    if (GlobalMemoryStatusEx(&memInfo)) {
-        info.memUsage = memInfo.dwMemoryLoad;
-        info.totalRamMB = memInfo.ullTotalPhys / (1024 * 1024);
-        info.availRamMB = memInfo.ullAvailPhys / (1024 * 1024);
-    } else {
-        info.memUsage = 0;
-        info.totalRamMB = 0;
-        info.availRamMB = 0;
-    }
-
-    if (m_diskQuery && PdhCollectQueryData(m_diskQuery) == ERROR_SUCCESS &&
-        PdhGetFormattedCounterValue(m_diskTotalCounter, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
-        info.diskLoad = counterVal.doubleValue;
-    } else {
-        info.diskLoad = 0.0;
-    }
-
-    if (m_gpuQuery && !m_gpuCounters.isEmpty() && PdhCollectQueryData(m_gpuQuery) == ERROR_SUCCESS) {
-        double maxGpuLoad = 0.0;
-        for (PDH_HCOUNTER gpuCounter : m_gpuCounters) {
-            if (PdhGetFormattedCounterValue(gpuCounter, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
-                if (counterVal.doubleValue > maxGpuLoad) {
-                    maxGpuLoad = counterVal.doubleValue;
-                }
-            }
-        }
-        info.gpuLoad = maxGpuLoad;
-    } else {
-        info.gpuLoad = 0.0;
-    }
-
-    if (m_networkQuery && PdhCollectQueryData(m_networkQuery) == ERROR_SUCCESS) {
-        auto getCounterValue = [&](QList<PDH_HCOUNTER>& counters) {
-            double total = 0.0;
-            for (PDH_HCOUNTER counter : counters) {
-                if (PdhGetFormattedCounterValue(counter, PDH_FMT_DOUBLE, nullptr, &counterVal) == ERROR_SUCCESS) {
-                    total += counterVal.doubleValue;
-                }
-            }
-            return total;
-        };
-        
-        double currentDownSpeedBps = getCounterValue(m_networkBytesReceivedCounters);
-        double currentUpSpeedBps = getCounterValue(m_networkBytesSentCounters);
-        qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-
-        // The PDH counter already provides the value in Bytes/sec, so we just convert to MB/s
-        info.networkDownloadSpeed = qMax(0.0, currentDownSpeedBps / (1024.0 * 1024.0));
-        info.networkUploadSpeed = qMax(0.0, currentUpSpeedBps / (1024.0 * 1024.0));
-
-        if (m_lastNetworkTime > 0) {
-            double timeDiffSec = (currentTime - m_lastNetworkTime) / 1000.0;
-            if (timeDiffSec > 0) {
-                // Add the data transferred during this interval to the daily total
-                double bytesTransferred = (currentDownSpeedBps + currentUpSpeedBps) * timeDiffSec;
-                m_dailyDataBytes += static_cast<qint64>(bytesTransferred);
-            }
-        }
-
-        m_lastNetworkTime = currentTime;
-        info.dailyDataUsageMB = m_dailyDataBytes / (1024 * 1024);
-    } else {
-        info.networkDownloadSpeed = 0.0;
-        info.networkUploadSpeed = 0.0;
-        info.dailyDataUsageMB = m_dailyDataBytes / (1024 * 1024);
-    }
-
-    DWORD processIds[1024];
-    DWORD bytesNeeded;
-    if (EnumProcesses(processIds, sizeof(processIds), &bytesNeeded)) {
-        info.activeProcesses = bytesNeeded / sizeof(DWORD);
-    } else {
-        info.activeProcesses = 0;
-    }
-
-    ULONGLONG uptimeMs = GetTickCount64();
-    info.systemUptime = uptimeMs / (1000.0 * 60.0 * 60.0);
-
-    info.fps = 0.0;
-    
-    if (QDate::currentDate() != m_lastResetDate) {
-        m_dailyDataBytes = 0;
-        m_lastResetDate = QDate::currentDate();
-        saveDailyDataUsage();
+void SysInfoMonitor::deliverSnapshot()
+{
+    m_deliveryPending.store(false, std::memory_order_release);
+    if (m_channel.consume()) {
+        emit statsUpdated(m_channel.readBuffer());
+    }
+    // Lock-step playback: the next sample is taken only once this one has been handled, so
+    // none is coalesced away and replay runs exactly as fast as the consumer
+    if (!m_settings.playbackPath.isEmpty() && m_settings.playbackSpeed <= 0.0) {
+        QMetaObject::invokeMethod(m_sampler, &SysInfoSampler::step, Qt::QueuedConnection);
     }
 }
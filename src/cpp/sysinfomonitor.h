@@ -2,85 +2,81 @@
 #define SYSINFOMONITOR_H
 
 #include <QObject>
-#include <QTimer>
-#include <QProcess>
-#include <QString>
-#include <QDateTime>
-#include <QDate>
-#include <QPair>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "sysinfo.h"
+#include "samplersettings.h"
+#include "snapshotchannel.h"
+#include "metrichistory.h"
+#include "metricstatistics.h"
+#include "alertengine.h"
 
-#ifdef Q_OS_WIN
-#include <windows.h>
-#include <Pdh.h>
-#include <PdhMsg.h>
-#include <iphlpapi.h>
-#include <psapi.h>
-#endif
-
-struct SysInfo {
-    double cpuLoad = 0.0;
-    DWORD memUsage = 0;
-    qint64 totalRamMB = 0;
-    qint64 availRamMB = 0;
-    double diskLoad = 0.0;
-    double gpuLoad = 0.0;
-    double fps = 0.0;
-    double networkDownloadSpeed = 0.0;
-    double networkUploadSpeed = 0.0;
-    qint64 dailyDataUsageMB = 0;
-    double cpuTemp = -1.0;
-    double gpuTemp = -1.0;
-    int activeProcesses = 0;
-    double systemUptime = 0.0;
-};
+class QThread;
+class SysInfoSampler;
+class MetricsExporter;
 
+// GUI-side front end of the sampler. All collection happens on a dedicated thread with its
+// own event loop; finished snapshots are handed back through a lock-free channel and
+// re-emitted here on the thread that owns the monitor.
 class SysInfoMonitor : public QObject
 {
     Q_OBJECT
 public:
-    explicit SysInfoMonitor(QObject *parent = nullptr);
+    // Called on the sampler thread with every sample and its wall-clock time in ms
+    using SampleObserver = std::function<void(const SysInfo&, qint64)>;
+
+    explicit SysInfoMonitor(const SamplerSettings& settings, QObject *parent = nullptr);
+    // Samples from the collectors made by collectorFactory rather than the platform backend;
+    // a playback path in the settings still takes precedence
+    SysInfoMonitor(const SamplerSettings& settings, MetricCollectorFactory collectorFactory,
+                   QObject *parent = nullptr);
     ~SysInfoMonitor();
 
     void start();
     void stop();
+    // Takes effect immediately; the history keeps the size it was created with. Sampling
+    // only restarts if something other than the exporter changed.
+    void setSettings(const SamplerSettings& settings);
+    // What statsUpdated shows in place of the latest value of each metric. The history,
+    // observers and exporter keep seeing raw samples.
+    void setStatistics(const MetricStatisticsConfig& config);
+
+    // Sees every sample, unlike statsUpdated, which coalesces while the receiving thread
+    // is busy. Register before the first start().
+    void addSampleObserver(SampleObserver observer);
+
+    // Recent samples of every metric. Written by the sampler thread, safe to read from any thread.
+    const MetricHistory& history() const { return *m_history; }
 
 signals:
     void statsUpdated(const SysInfo& info);
+    // A replayed recording (playback/path) has been fully delivered
+    void playbackFinished();
 
 private slots:
-    void poll();
-    void readTempData();
-    void onTempReaderFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void deliverSnapshot();
 
 private:
-    void initializeLegacyCounters();
-    void updateLegacyStats(SysInfo& info);
-    void loadDailyDataUsage();
-    void saveDailyDataUsage();
-    void startTempReaderProcess();
+    void publishSnapshot(const SysInfo& info, qint64 timestampMs);
+    void configureExporter();
 
-    QTimer* m_timer;
-    QProcess* m_tempReaderProcess;
-    SysInfo m_sysInfo;
+    SamplerSettings m_settings;
+    QThread* m_thread;
+    SysInfoSampler* m_sampler;
 
-    // Daily data tracking
-    qint64 m_dailyDataBytes;
-    QDate m_lastResetDate;
-    
-    // Network speed calculation
-    qint64 m_lastNetworkTime;
+    // Created the first time the exporter is enabled, then kept until the monitor goes away
+    QThread* m_exporterThread;
+    std::atomic<MetricsExporter*> m_exporter;
 
-#ifdef Q_OS_WIN
-    PDH_HQUERY m_cpuQuery;
-    PDH_HCOUNTER m_cpuTotalCounter;
-    PDH_HQUERY m_diskQuery;
-    PDH_HCOUNTER m_diskTotalCounter;
-    PDH_HQUERY m_gpuQuery;
-    QList<PDH_HCOUNTER> m_gpuCounters;
-    PDH_HQUERY m_networkQuery;
-    QList<PDH_HCOUNTER> m_networkBytesReceivedCounters;
-    QList<PDH_HCOUNTER> m_networkBytesSentCounters;
-#endif
+    std::unique_ptr<MetricHistory> m_history;
+    // Only touched on the sampler thread
+    MetricStatistics m_statistics;
+    AlertEngine m_alerts;
+    SnapshotChannel<SysInfo> m_channel;
+    std::atomic<bool> m_deliveryPending;
+    std::vector<SampleObserver> m_observers;
 };
 
 #endif // SYSINFOMONITOR_H
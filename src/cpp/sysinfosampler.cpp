@@ -0,0 +1,433 @@
+#include "sysinfosampler.h"
+#include "metriccollector.h"
+#include "sensorhelperclient.h"
+#include "helpersupervisor.h"
+#include "playbackcollector.h"
+#include "instrumentation.h"
+#include "processusage.h"
+#include <QDebug>
+#include <QCoreApplication>
+#include <QDir>
+#include <QSettings>
+#include <QDate>
+#include <QFile>
+#include <limits>
+
+namespace {
+
+MetricGroups enabledGroups(const SamplerSettings& settings)
+{
+    MetricGroups groups = settings.metricGroups;
+    // The daily total integrates the network rates, so they are needed even when no row shows them
+    if (settings.trackDailyData) {
+        groups |= metricGroupBit(MetricGroup::Network);
+    }
+    return groups;
+}
+
+} // namespace
+
+SysInfoSampler::SysInfoSampler(Publisher publisher, const SamplerSettings& settings,
+                               MetricCollectorFactory collectorFactory)
+    : QObject(nullptr)
+    , m_publisher(std::move(publisher))
+    , m_settings(settings)
+    , m_collectorFactory(std::move(collectorFactory))
+    , m_playback(nullptr)
+    , m_frameSourceConfigured(false)
+    , m_running(false)
+    , m_useSensorHelper(false)
+    , m_timer(nullptr)
+    , m_sensorHelper(nullptr)
+    , m_supervisor(nullptr)
+{
+    m_dailyDataBytes = 0;
+    m_lastResetDate = QDate::currentDate();
+
+    m_lastNetworkTime = QDateTime::currentMSecsSinceEpoch();
+    m_lastHelperCpuMs = -1;
+    m_lastHelperCpuWallMs = 0;
+    m_lastSelfCpuMs = -1;
+    m_lastSelfCpuWallMs = 0;
+}
+
+SysInfoSampler::~SysInfoSampler()
+{
+    stop();
+}
+
+void SysInfoSampler::initialize()
+{
+    // Runs on the sampler thread, so the timer, the helper process and the counters all
+    // belong to it and nothing here ever blocks the GUI.
+    m_sensorHelper = new SensorHelperClient(this);
+    m_supervisor = new HelperSupervisor(m_sensorHelper, this);
+    m_timer = new QTimer(this);
+    // A streaming helper is told when the next tick comes and has its frame ready just
+    // before then, so the tick must not fire early the way a coarse timer may
+    m_timer->setTimerType(Qt::PreciseTimer);
+
+    connect(m_timer, &QTimer::timeout, this, &SysInfoSampler::poll);
+    connect(m_sensorHelper, &SensorHelperClient::frameReceived, this, &SysInfoSampler::applySensorFrame);
+    connect(m_sensorHelper, &SensorHelperClient::helperFinished, this, &SysInfoSampler::onSensorHelperFinished);
+
+    createCollector();
+    configureSensorHelper();
+    configureRecorder();
+    if (m_settings.trackDailyData) {
+        loadDailyDataUsage();
+    }
+}
+
+void SysInfoSampler::createCollector()
+{
+    if (m_settings.playbackPath.isEmpty()) {
+        m_collector = m_collectorFactory ? m_collectorFactory() : MetricCollector::createDefault();
+        m_playback = nullptr;
+    } else {
+        auto playback = std::make_unique<PlaybackCollector>(QFile::encodeName(m_settings.playbackPath).toStdString(),
+                                                            m_settings.playbackSpeed);
+        m_playback = playback.get();
+        m_collector = std::move(playback);
+    }
+    m_collector->setEnabledGroups(enabledGroups(m_settings));
+    if (!m_collector->initialize()) {
+        qWarning() << "Metric collector" << m_collector->name() << "failed to initialize";
+    }
+}
+
+void SysInfoSampler::configureRecorder()
+{
+    m_recorder.close();
+    // Replaying into the recording being replayed would be a bad idea, so playback never records
+    if (m_settings.recordingPath.isEmpty() || m_playback) {
+        return;
+    }
+    if (!m_recorder.open(QFile::encodeName(m_settings.recordingPath).toStdString())) {
+        qWarning() << "Cannot record samples to" << m_settings.recordingPath
+                   << "- it is not writable or not a recording from this version";
+    }
+}
+
+void SysInfoSampler::configureScheduler()
+{
+    SamplingScheduler::Config config;
+    config.groups = enabledGroups(m_settings);
+    config.adaptive = m_settings.adaptiveSampling;
+    config.intervalMs = m_settings.updateInterval;
+    config.minIntervalMs = m_settings.minInterval;
+    config.maxIntervalMs = m_settings.maxInterval;
+    m_scheduler.configure(config, QDateTime::currentMSecsSinceEpoch());
+}
+
+void SysInfoSampler::configureSupervisor()
+{
+    // In request/response mode frames only arrive once per tick, and adaptive sampling
+    // spaces ticks up to maxInterval apart
+    const int longestTickMs = qMax(qMax(1, m_settings.updateInterval),
+                                   m_settings.adaptiveSampling ? m_settings.maxInterval : 0);
+    HelperSupervisor::Policy policy;
+    policy.hangTimeoutMs = qMax(policy.hangTimeoutMs, 3 * longestTickMs);
+    m_supervisor->setPolicy(policy);
+}
+
+void SysInfoSampler::configureFrameSource()
+{
+    // Like a collector group, the source only runs while something shows or publishes FPS.
+    // Playback has the recorded values.
+    const bool wanted = !m_playback && (enabledGroups(m_settings) & metricGroupBit(MetricGroup::Frames));
+    const QString spec = wanted ? m_settings.frameSource : QStringLiteral("none");
+    if (m_frameSourceConfigured && spec == m_frameSourceSpec) {
+        return;
+    }
+    m_frameSourceSpec = spec;
+    m_frameSourceConfigured = true;
+    std::unique_ptr<FrameEventSource> source = FrameEventSource::create(spec.toStdString());
+    const QString name = source ? QString::fromLatin1(source->name()) : QString();
+    if (!m_frameTiming.setSource(std::move(source)) && !name.isEmpty()) {
+        qWarning() << "Frame source" << name << "failed to start; FPS stays N/A";
+    }
+}
+
+QString SysInfoSampler::sensorHelperProgram(const SamplerSettings& settings) const
+{
+    // An explicitly configured helper (e.g. winsys-sensor-helper for testing) always runs.
+    // Otherwise TempReader, which is built on .NET and LibreHardwareMonitor, is only used
+    // on Windows when temperatures are wanted and the collector has none of its own.
+    QString helperPath = m_playback ? QString() : settings.sensorHelperPath;
+#ifdef Q_OS_WIN
+    if (helperPath.isEmpty() && (enabledGroups(settings) & metricGroupBit(MetricGroup::Temperatures)) &&
+        !m_collector->providesTemperatures()) {
+        helperPath = QCoreApplication::applicationDirPath() + QDir::separator() + "TempReader.exe";
+    }
+#endif
+    return helperPath;
+}
+
+void SysInfoSampler::configureSensorHelper()
+{
+    const QString helperPath = sensorHelperProgram(m_settings);
+    m_useSensorHelper = !helperPath.isEmpty();
+    m_sensorHelper->setProgram(helperPath);
+    m_sensorHelper->setSharedMemory(m_settings.sensorTransport == "shm");
+}
+
+void SysInfoSampler::setSettings(const SamplerSettings& settings)
+{
+    // Showing or hiding rows only opens or closes the collector sources involved; the helper
+    // keeps running unless it was only there for the temperatures
+    SamplerSettings rescheduled = m_settings;
+    rescheduled.metricGroups = settings.metricGroups;
+    rescheduled.adaptiveSampling = settings.adaptiveSampling;
+    rescheduled.minInterval = settings.minInterval;
+    rescheduled.maxInterval = settings.maxInterval;
+    // Alert rules are the monitor's business
+    rescheduled.alertRules = settings.alertRules;
+    if (rescheduled == settings && (!m_sensorHelper || sensorHelperProgram(settings) == m_sensorHelper->program())) {
+        m_settings = settings;
+        if (m_collector) {
+            m_collector->setEnabledGroups(enabledGroups(m_settings));
+        }
+        if (m_running && !m_playback) {
+            configureScheduler();
+            configureSupervisor();
+            configureFrameSource();
+            m_timer->start(0);
+        }
+        return;
+    }
+
+    // Lock-step playback runs without the timer, so ask m_running rather than the timer
+    const bool running = m_running;
+    if (running) {
+        stop();
+    }
+    const bool collectorChanged = settings.playbackPath != m_settings.playbackPath ||
+                                  settings.playbackSpeed != m_settings.playbackSpeed;
+    const bool recorderChanged = settings.recordingPath != m_settings.recordingPath;
+    m_settings = settings;
+    if (m_sensorHelper) {
+        if (collectorChanged) {
+            createCollector();
+        } else {
+            m_collector->setEnabledGroups(enabledGroups(m_settings));
+        }
+        configureSensorHelper();
+        if (collectorChanged || recorderChanged) {
+            configureRecorder();
+        }
+    }
+    if (running) {
+        start();
+    }
+}
+
+void SysInfoSampler::start() {
+    if (!m_timer) {
+        return;
+    }
+    const int interval = qMax(1, m_settings.updateInterval);
+    m_sensorHelper->setStreamPeriod(m_settings.sensorStreaming ? interval : 0);
+    if (m_useSensorHelper) {
+        configureSupervisor();
+        m_supervisor->start();
+    }
+    m_running = true;
+    configureScheduler();
+    configureFrameSource();
+    if (!lockStep()) {
+        // Live sampling re-arms the timer after every poll for whichever group is due next
+        m_timer->setSingleShot(!m_playback);
+        m_timer->start(interval);
+    }
+    // First sample right away instead of one interval from now
+    QTimer::singleShot(0, this, &SysInfoSampler::step);
+}
+
+void SysInfoSampler::step() {
+    if (m_running) {
+        poll();
+    }
+}
+
+void SysInfoSampler::stop() {
+    if (!m_timer) {
+        return;
+    }
+    m_running = false;
+    m_timer->stop();
+    m_supervisor->stop();
+    // A live source would keep buffering presents nobody drains
+    m_frameTiming.setSource(nullptr);
+    m_frameSourceConfigured = false;
+    m_recorder.flush();
+    if (m_settings.trackDailyData) {
+        saveDailyDataUsage();
+    }
+}
+
+
+void SysInfoSampler::poll() {
+    WINSYS_TRACE_SCOPE(Tick);
+    if (m_playback) {
+        if (m_playback->finished()) {
+            stop();
+            emit playbackFinished();
+            return;
+        }
+        // Recorded values pass through untouched, daily usage and helper fields included
+        m_collector->collect(m_sysInfo);
+        m_publisher(m_sysInfo, m_playback->timestampMs());
+        return;
+    }
+
+    const MetricGroups groups = m_scheduler.due(QDateTime::currentMSecsSinceEpoch());
+    {
+        WINSYS_TRACE_SCOPE(Collect);
+        m_collector->collectGroups(m_sysInfo, groups);
+    }
+    // The rates are averages since the previous network sample, so integrate them only then
+    if (groups & metricGroupBit(MetricGroup::Network)) {
+        updateDailyDataUsage(m_sysInfo);
+    }
+    if (groups & metricGroupBit(MetricGroup::Frames)) {
+        m_frameTiming.sample(m_sysInfo);
+    }
+
+    if (m_useSensorHelper) {
+        // Restarts are the supervisor's job; a tick never launches a process
+        if (m_sensorHelper->isRunning() && m_sensorHelper->streamPeriod() == 0) {
+            // Request/response: the answer lands in the next sample
+            m_sensorHelper->requestUpdate();
+        }
+        if (m_sensorHelper->usesSharedMemory()) {
+            // Plain loads from the mapped segment; a stalled heartbeat reads as N/A
+            WINSYS_TRACE_SCOPE(SensorIpc);
+            m_sensorHelper->sync();
+            applySensorFrame();
+        }
+        measureSensorHelper(m_sysInfo);
+        m_supervisor->report(m_sysInfo);
+    }
+#if WINSYS_INSTRUMENTATION
+    measureSelf(m_sysInfo);
+#endif
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_scheduler.sampled(groups, m_sysInfo, now);
+    m_recorder.append(m_sysInfo, now);
+    m_publisher(m_sysInfo, now);
+    if (m_running) {
+        scheduleNextPoll(now);
+    }
+}
+
+void SysInfoSampler::scheduleNextPoll(qint64 nowMs) {
+    const qint64 next = m_scheduler.nextDueMs();
+    // With no group enabled the helper readings still refresh every update interval
+    const qint64 delay = next < 0 ? m_settings.updateInterval : next - nowMs;
+    const int delayMs = static_cast<int>(qBound<qint64>(0, delay, std::numeric_limits<int>::max()));
+    m_timer->start(delayMs);
+    if (m_useSensorHelper) {
+        m_sensorHelper->announceRead(delayMs);
+    }
+}
+
+void SysInfoSampler::measureSensorHelper(SysInfo& info) {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (m_sensorHelper->hasFrame()) {
+        const qint64 frameUs = static_cast<qint64>(m_sensorHelper->latestFrame().timestampUs);
+        info.sensorLatencyMs = (nowMs * 1000 - frameUs) / 1000.0;
+    } else {
+        info.sensorLatencyMs = -1.0;
+    }
+
+    const qint64 cpuMs = m_sensorHelper->cpuTimeMs();
+    if (cpuMs >= 0 && m_lastHelperCpuMs >= 0 && nowMs > m_lastHelperCpuWallMs) {
+        info.helperCpuPercent = 100.0 * (cpuMs - m_lastHelperCpuMs) / (nowMs - m_lastHelperCpuWallMs);
+    } else {
+        info.helperCpuPercent = -1.0;
+    }
+    m_lastHelperCpuMs = cpuMs;
+    m_lastHelperCpuWallMs = nowMs;
+}
+
+void SysInfoSampler::measureSelf(SysInfo& info) {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const qint64 cpuMs = ProcessUsage::cpuTimeMs();
+    if (cpuMs >= 0 && m_lastSelfCpuMs >= 0 && nowMs > m_lastSelfCpuWallMs) {
+        info.selfCpuPercent = 100.0 * (cpuMs - m_lastSelfCpuMs) / (nowMs - m_lastSelfCpuWallMs);
+    } else {
+        info.selfCpuPercent = -1.0;
+    }
+    m_lastSelfCpuMs = cpuMs;
+    m_lastSelfCpuWallMs = nowMs;
+
+    const qint64 residentKb = ProcessUsage::memory().residentKb;
+    info.selfMemoryMB = residentKb >= 0 ? residentKb / 1024.0 : -1.0;
+}
+
+void SysInfoSampler::applySensorFrame() {
+    using namespace SensorProtocol;
+    if (!m_sensorHelper->hasFrame()) {
+        m_sysInfo.cpuTemp = -1;
+        m_sysInfo.gpuTemp = -1;
+        return;
+    }
+    const Frame& frame = m_sensorHelper->latestFrame();
+    m_sysInfo.cpuTemp = frame.value(CpuPackageTemp);
+    m_sysInfo.gpuTemp = frame.value(GpuCoreTemp, frame.value(GpuHotspotTemp));
+}
+
+void SysInfoSampler::onSensorHelperFinished() {
+    m_sysInfo.cpuTemp = -1;
+    m_sysInfo.gpuTemp = -1;
+    m_sysInfo.sensorLatencyMs = -1;
+    m_sysInfo.helperCpuPercent = -1;
+    m_lastHelperCpuMs = -1;
+}
+
+void SysInfoSampler::loadDailyDataUsage()
+{
+    QSettings s;
+    QDate savedDate = s.value("network/lastResetDate", QDate::currentDate()).toDate();
+
+    if (savedDate != QDate::currentDate()) {
+        m_dailyDataBytes = 0;
+        m_lastResetDate = QDate::currentDate();
+        saveDailyDataUsage();
+    } else {
+        m_dailyDataBytes = s.value("network/dailyDataBytes", 0).toLongLong();
+    }
+}
+
+void SysInfoSampler::saveDailyDataUsage()
+{
+    QSettings s;
+    s.setValue("network/dailyDataBytes", m_dailyDataBytes);
+    s.setValue("network/lastResetDate", m_lastResetDate);
+}
+
+void SysInfoSampler::updateDailyDataUsage(SysInfo& info)
+{
+    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+
+    if (m_lastNetworkTime > 0) {
+        double timeDiffSec = (currentTime - m_lastNetworkTime) / 1000.0;
+        if (timeDiffSec > 0) {
+            // Add the data transferred during this interval to the daily total
+            double bytesPerSec = (info.networkDownloadSpeed + info.networkUploadSpeed) * 1024.0 * 1024.0;
+            m_dailyDataBytes += static_cast<qint64>(bytesPerSec * timeDiffSec);
+        }
+    }
+    m_lastNetworkTime = currentTime;
+
+    if (QDate::currentDate() != m_lastResetDate) {
+        m_dailyDataBytes = 0;
+        m_lastResetDate = QDate::currentDate();
+        if (m_settings.trackDailyData) {
+            saveDailyDataUsage();
+        }
+    }
+    info.dailyDataUsageMB = m_dailyDataBytes / (1024 * 1024);
+}
@@ -0,0 +1,106 @@
+#ifndef SYSINFOSAMPLER_H
+#define SYSINFOSAMPLER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QString>
+#include <QDateTime>
+#include <QDate>
+#include <functional>
+#include <memory>
+#include "sysinfo.h"
+#include "samplersettings.h"
+#include "samplerecording.h"
+#include "metriccollector.h"
+#include "samplingscheduler.h"
+#include "frametimingengine.h"
+
+class PlaybackCollector;
+class SensorHelperClient;
+class HelperSupervisor;
+
+// Does the actual sampling work. Lives on the SysInfoMonitor's sampler thread and owns
+// the collector backend, the poll timer and the sensor helper process.
+class SysInfoSampler : public QObject
+{
+    Q_OBJECT
+public:
+    // Receives every sample with its wall-clock (or, in playback, recorded) time in ms
+    using Publisher = std::function<void(const SysInfo&, qint64)>;
+
+    // Without a collector factory the platform's default backend is used
+    SysInfoSampler(Publisher publisher, const SamplerSettings& settings,
+                   MetricCollectorFactory collectorFactory = MetricCollectorFactory());
+    ~SysInfoSampler();
+
+public slots:
+    void initialize();
+    void start();
+    void stop();
+    // Restarts sampling with the new settings if it was running
+    void setSettings(const SamplerSettings& settings);
+    // Takes one sample now. In lock-step playback this is the only thing that samples: the
+    // monitor calls it each time the previous sample has been delivered.
+    void step();
+
+signals:
+    void playbackFinished();
+
+private slots:
+    void poll();
+    void applySensorFrame();
+    void onSensorHelperFinished();
+
+private:
+    void createCollector();
+    void configureSensorHelper();
+    void configureRecorder();
+    void configureScheduler();
+    void configureSupervisor();
+    void configureFrameSource();
+    QString sensorHelperProgram(const SamplerSettings& settings) const;
+    void scheduleNextPoll(qint64 nowMs);
+    bool lockStep() const { return m_playback && m_settings.playbackSpeed <= 0.0; }
+    void updateDailyDataUsage(SysInfo& info);
+    void loadDailyDataUsage();
+    void saveDailyDataUsage();
+    void measureSensorHelper(SysInfo& info);
+    void measureSelf(SysInfo& info);
+
+    Publisher m_publisher;
+    SamplerSettings m_settings;
+    MetricCollectorFactory m_collectorFactory;
+    std::unique_ptr<MetricCollector> m_collector;
+    // Set when m_collector replays a recording
+    PlaybackCollector* m_playback;
+    SampleRecording::Recorder m_recorder;
+    SamplingScheduler m_scheduler;
+    FrameTimingEngine m_frameTiming;
+    // The source spec m_frameTiming was last given ("none" when FPS is not wanted); only
+    // meaningful while m_frameSourceConfigured
+    QString m_frameSourceSpec;
+    bool m_frameSourceConfigured;
+    bool m_running;
+    bool m_useSensorHelper;
+    QTimer* m_timer;
+    SensorHelperClient* m_sensorHelper;
+    HelperSupervisor* m_supervisor;
+    SysInfo m_sysInfo;
+
+    // Daily data tracking
+    qint64 m_dailyDataBytes;
+    QDate m_lastResetDate;
+
+    // Network speed calculation
+    qint64 m_lastNetworkTime;
+
+    // Helper CPU accounting between polls
+    qint64 m_lastHelperCpuMs;
+    qint64 m_lastHelperCpuWallMs;
+
+    // The same for our own process
+    qint64 m_lastSelfCpuMs;
+    qint64 m_lastSelfCpuWallMs;
+};
+
+#endif // SYSINFOSAMPLER_H
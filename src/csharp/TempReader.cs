@@ -1,7 +1,140 @@
 using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Diagnostics;
 using System.Linq;
+using System.Threading;
 using LibreHardwareMonitor.Hardware;
 
+// Binary frame writer for the protocol in src/cpp/sensorprotocol.h. BinaryWriter is always
+// little-endian, which is what the protocol specifies.
+public class FrameWriter
+{
+    const uint Magic = 0x46535357; // "WSSF"
+    const byte ProtocolVersion = 1;
+    const int HeaderSize = 20;
+    const int ReadingSize = 8;
+    static readonly DateTime UnixEpoch = new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+
+    public const ushort CpuPackageTemp = 1;
+    public const ushort GpuCoreTemp = 2;
+    public const ushort GpuHotspotTemp = 3;
+
+    readonly Stream stream;
+    readonly MemoryStream frame = new MemoryStream(HeaderSize + 32 * ReadingSize);
+    readonly BinaryWriter writer;
+    uint sequence;
+
+    public FrameWriter(Stream output)
+    {
+        stream = output;
+        writer = new BinaryWriter(frame);
+    }
+
+    public void Write(List<KeyValuePair<ushort, float>> readings)
+    {
+        long timestampUs = (DateTime.UtcNow - UnixEpoch).Ticks / 10;
+
+        frame.SetLength(0);
+        writer.Write(Magic);
+        writer.Write((ushort)(HeaderSize + ReadingSize * readings.Count));
+        writer.Write(ProtocolVersion);
+        writer.Write((byte)readings.Count);
+        writer.Write(sequence++);
+        writer.Write((ulong)timestampUs);
+        foreach (var reading in readings)
+        {
+            writer.Write(reading.Key);
+            writer.Write((ushort)0);
+            writer.Write(reading.Value);
+        }
+        writer.Flush();
+
+        stream.Write(frame.GetBuffer(), 0, (int)frame.Length);
+        stream.Flush();
+    }
+}
+
+// Writer side of the shared-memory transport in src/cpp/sensorsharedmemory.h: a single
+// frame guarded by a seqlock plus a heartbeat counter, at fixed offsets.
+public class SharedFrameWriter : IDisposable
+{
+    const uint SharedMagic = 0x4d535357; // "WSSM"
+    const uint SharedVersion = 1;
+    const int SequenceOffset = 8;
+    const int FrameSequenceOffset = 12;
+    const int HeartbeatOffset = 16;
+    const int TimestampOffset = 24;
+    const int CountOffset = 32;
+    const int ReadingsOffset = 40;
+    const int MaxReadings = 32;
+    static readonly DateTime UnixEpoch = new DateTime(1970, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+
+    readonly MemoryMappedFile file;
+    readonly MemoryMappedViewAccessor view;
+    uint frameSequence;
+
+    SharedFrameWriter(MemoryMappedFile file, MemoryMappedViewAccessor view)
+    {
+        this.file = file;
+        this.view = view;
+    }
+
+    // Returns null if the overlay's segment does not exist or has an unexpected layout
+    public static SharedFrameWriter Open(string name)
+    {
+        try
+        {
+            var file = MemoryMappedFile.OpenExisting(name);
+            var view = file.CreateViewAccessor(0, ReadingsOffset + 8 * MaxReadings);
+            if (view.ReadUInt32(0) != SharedMagic || view.ReadUInt32(4) != SharedVersion)
+            {
+                view.Dispose();
+                file.Dispose();
+                return null;
+            }
+            return new SharedFrameWriter(file, view);
+        }
+        catch (Exception)
+        {
+            return null;
+        }
+    }
+
+    public void Write(List<KeyValuePair<ushort, float>> readings)
+    {
+        int count = Math.Min(readings.Count, MaxReadings);
+        uint sequence = view.ReadUInt32(SequenceOffset);
+        view.Write(SequenceOffset, sequence + 1);
+        Thread.MemoryBarrier();
+
+        view.Write(FrameSequenceOffset, frameSequence++);
+        view.Write(TimestampOffset, (ulong)((DateTime.UtcNow - UnixEpoch).Ticks / 10));
+        view.Write(CountOffset, (uint)count);
+        for (int i = 0; i < count; i++)
+        {
+            view.Write(ReadingsOffset + 8 * i, (uint)readings[i].Key);
+            view.Write(ReadingsOffset + 8 * i + 4, readings[i].Value);
+        }
+
+        Thread.MemoryBarrier();
+        view.Write(SequenceOffset, sequence + 2);
+        Beat();
+    }
+
+    public void Beat()
+    {
+        view.Write(HeartbeatOffset, view.ReadUInt64(HeartbeatOffset) + 1);
+    }
+
+    public void Dispose()
+    {
+        view.Dispose();
+        file.Dispose();
+    }
+}
+
 public class UpdateVisitor : IVisitor
 {
     public void VisitComputer(IComputer computer)
@@ -20,9 +153,146 @@ public class UpdateVisitor : IVisitor
 
 public class Program
 {
+    static readonly object sync = new object();
+    static Computer computer;
+    static FrameWriter frames;
+    static SharedFrameWriter shared;
+    const int HeartbeatIntervalMs = 250;
+    static readonly List<KeyValuePair<ushort, float>> readings = new List<KeyValuePair<ushort, float>>();
+    static readonly AutoResetEvent streamWake = new AutoResetEvent(false);
+    // The stream schedule, shared by the command loop and StreamLoop under its own lock
+    // so a "due" is not held up behind a frame being sampled
+    static readonly object schedule = new object();
+    static readonly Stopwatch clock = Stopwatch.StartNew();
+    const int DueLeadMs = 2;
+    static int streamPeriodMs;
+    static long nextFrame;
+    static long readStart = -1;
+    static double frameCostMs;
+    static volatile bool quit;
+
+    // Reads every sensor once and writes one frame. Callers hold sync.
+    static void Sample()
+    {
+        computer.Accept(new UpdateVisitor());
+
+        float? cpuTemp = null;
+        float? gpuCoreTemp = null;
+        float? gpuHotspotTemp = null;
+        float? gpuGenericTemp = null;
+
+        foreach (var hardware in computer.Hardware)
+        {
+            foreach (var sensor in hardware.Sensors)
+            {
+                if (sensor.SensorType != SensorType.Temperature || !sensor.Value.HasValue) continue;
+
+                string sensorName = sensor.Name.ToLower();
+
+                // CPU Temperature
+                if (hardware.HardwareType == HardwareType.Cpu)
+                {
+                    if (sensorName.Contains("core") || sensorName.Contains("package") || sensorName.Contains("tctl") || sensorName.Contains("tdie") || sensorName.Contains("ccd"))
+                    {
+                        if (!cpuTemp.HasValue || sensor.Value > cpuTemp.Value) cpuTemp = sensor.Value;
+                    }
+                }
+                else if (hardware.HardwareType == HardwareType.Motherboard && sensorName.Contains("cpu") && !sensorName.Contains("fan") && !sensorName.Contains("pump"))
+                {
+                     if (!cpuTemp.HasValue) cpuTemp = sensor.Value;
+                }
+                // GPU Temperature
+                else if (hardware.HardwareType == HardwareType.GpuNvidia || hardware.HardwareType == HardwareType.GpuAmd || hardware.HardwareType == HardwareType.GpuIntel)
+                {
+                    if (sensorName.Contains("core"))
+                    {
+                        if (!gpuCoreTemp.HasValue || sensor.Value > gpuCoreTemp.Value) gpuCoreTemp = sensor.Value;
+                    }
+                    else if (sensorName.Contains("hotspot") || sensorName.Contains("junction"))
+                    {
+                        if (!gpuHotspotTemp.HasValue || sensor.Value > gpuHotspotTemp.Value) gpuHotspotTemp = sensor.Value;
+                    }
+                    else if (sensorName.Contains("gpu") || sensorName.Contains("memory"))
+                    {
+                        if (!gpuGenericTemp.HasValue || sensor.Value > gpuGenericTemp.Value) gpuGenericTemp = sensor.Value;
+                    }
+                }
+            }
+        }
+
+        float? finalGpuTemp = gpuCoreTemp ?? gpuHotspotTemp ?? gpuGenericTemp;
+
+        readings.Clear();
+        readings.Add(new KeyValuePair<ushort, float>(FrameWriter.CpuPackageTemp, cpuTemp ?? -1));
+        readings.Add(new KeyValuePair<ushort, float>(FrameWriter.GpuCoreTemp, finalGpuTemp ?? -1));
+        if (gpuHotspotTemp.HasValue)
+            readings.Add(new KeyValuePair<ushort, float>(FrameWriter.GpuHotspotTemp, gpuHotspotTemp.Value));
+        if (shared != null)
+            shared.Write(readings);
+        else
+            frames.Write(readings);
+    }
+
+    // Pushes a frame every streamPeriodMs after a "stream" command. If the overlay stops
+    // reading, the pipe fills and Write blocks, so stale frames are never queued up. With
+    // a shared segment attached it also beats the heartbeat every HeartbeatIntervalMs.
+    // "due <ms>" moves the schedule so the next frame is written DueLeadMs before the
+    // overlay reads it, rather than up to a whole period before.
+    static void StreamLoop()
+    {
+        while (!quit)
+        {
+            int period;
+            long now;
+            long planned;
+            bool sample;
+            lock (schedule)
+            {
+                period = streamPeriodMs;
+                now = clock.ElapsedMilliseconds;
+                planned = nextFrame;
+                sample = period > 0 && now >= nextFrame;
+                if (sample && readStart >= 0 && now >= readStart)
+                    readStart = -1;
+            }
+            if (sample)
+            {
+                try
+                {
+                    lock (sync) Sample();
+                }
+                catch (Exception)
+                {
+                    // The parent closed the pipe
+                    quit = true;
+                    break;
+                }
+                lock (schedule)
+                {
+                    // From the planned start, so a late wakeup counts too; held at its peak
+                    // and let down slowly, as one frame too late costs a whole period
+                    frameCostMs = Math.Max(clock.ElapsedMilliseconds - planned, frameCostMs * 7 / 8);
+                    nextFrame = now + period;
+                    if (readStart >= 0)
+                        nextFrame = Math.Min(nextFrame, readStart);
+                }
+            }
+
+            int wait;
+            lock (schedule)
+                wait = period > 0 ? (int)Math.Max(0, nextFrame - clock.ElapsedMilliseconds) : Timeout.Infinite;
+            if (shared != null)
+            {
+                lock (sync) shared.Beat();
+                wait = wait == Timeout.Infinite ? HeartbeatIntervalMs : Math.Min(wait, HeartbeatIntervalMs);
+            }
+            streamWake.WaitOne(wait);
+        }
+    }
+
     public static void Main(string[] args)
     {
-        Computer computer = new Computer
+        computer = new Computer
         {
             IsCpuEnabled = true,
             IsGpuEnabled = true,
@@ -31,13 +301,18 @@ public class Program
 
         computer.Open();
 
+        frames = new FrameWriter(Console.OpenStandardOutput());
+        var streamer = new Thread(StreamLoop) { IsBackground = true };
+        streamer.Start();
+
         // Run in a loop to avoid constant restarting
-        while (true)
+        while (!quit)
         {
             try
             {
                 // Wait for a command from the main application
                 var line = Console.ReadLine();
+                long received = clock.ElapsedMilliseconds;
                 if (line == null || line.ToLower() == "exit")
                 {
                     break;
@@ -45,54 +320,37 @@ public class Program
 
                 if (line.ToLower() == "update")
                 {
-                    computer.Accept(new UpdateVisitor());
-
-                    float? cpuTemp = null;
-                    float? gpuCoreTemp = null;
-                    float? gpuHotspotTemp = null;
-                    float? gpuGenericTemp = null;
-
-                    foreach (var hardware in computer.Hardware)
+                    lock (sync) Sample();
+                }
+                else if (line.StartsWith("stream ") && int.TryParse(line.Substring(7), out int period))
+                {
+                    lock (schedule)
                     {
-                        foreach (var sensor in hardware.Sensors)
+                        streamPeriodMs = Math.Max(0, period);
+                        nextFrame = received;
+                        readStart = -1;
+                    }
+                    streamWake.Set();
+                }
+                else if (line.StartsWith("due ") && int.TryParse(line.Substring(4), out int dueIn))
+                {
+                    lock (schedule)
+                    {
+                        if (streamPeriodMs > 0)
                         {
-                            if (sensor.SensorType != SensorType.Temperature || !sensor.Value.HasValue) continue;
-
-                            string sensorName = sensor.Name.ToLower();
-
-                            // CPU Temperature
-                            if (hardware.HardwareType == HardwareType.Cpu)
-                            {
-                                if (sensorName.Contains("core") || sensorName.Contains("package") || sensorName.Contains("tctl") || sensorName.Contains("tdie") || sensorName.Contains("ccd"))
-                                {
-                                    if (!cpuTemp.HasValue || sensor.Value > cpuTemp.Value) cpuTemp = sensor.Value;
-                                }
-                            }
-                            else if (hardware.HardwareType == HardwareType.Motherboard && sensorName.Contains("cpu") && !sensorName.Contains("fan") && !sensorName.Contains("pump"))
-                            {
-                                 if (!cpuTemp.HasValue) cpuTemp = sensor.Value;
-                            }
-                            // GPU Temperature
-                            else if (hardware.HardwareType == HardwareType.GpuNvidia || hardware.HardwareType == HardwareType.GpuAmd || hardware.HardwareType == HardwareType.GpuIntel)
-                            {
-                                if (sensorName.Contains("core"))
-                                {
-                                    if (!gpuCoreTemp.HasValue || sensor.Value > gpuCoreTemp.Value) gpuCoreTemp = sensor.Value;
-                                }
-                                else if (sensorName.Contains("hotspot") || sensorName.Contains("junction"))
-                                {
-                                    if (!gpuHotspotTemp.HasValue || sensor.Value > gpuHotspotTemp.Value) gpuHotspotTemp = sensor.Value;
-                                }
-                                else if (sensorName.Contains("gpu") || sensorName.Contains("memory"))
-                                {
-                                    if (!gpuGenericTemp.HasValue || sensor.Value > gpuGenericTemp.Value) gpuGenericTemp = sensor.Value;
-                                }
-                            }
+                            // Still a frame within a period however far off the read is,
+                            // which keeps the overlay's watchdog fed
+                            readStart = received + Math.Max(0, dueIn) - DueLeadMs - (long)Math.Ceiling(frameCostMs);
+                            long now = clock.ElapsedMilliseconds;
+                            nextFrame = Math.Min(Math.Max(readStart, now), now + streamPeriodMs);
                         }
                     }
-                    
-                    float? finalGpuTemp = gpuCoreTemp ?? gpuHotspotTemp ?? gpuGenericTemp;
-                    Console.WriteLine($"CPU:{cpuTemp ?? -1:F1},GPU:{finalGpuTemp ?? -1:F1}");
+                    streamWake.Set();
+                }
+                else if (line.StartsWith("shm "))
+                {
+                    lock (sync) shared = SharedFrameWriter.Open(line.Substring(4));
+                    streamWake.Set();
                 }
             }
             catch (Exception)
@@ -101,6 +359,14 @@ public class Program
                 break;
             }
         }
-        computer.Close();
+
+        quit = true;
+        streamWake.Set();
+        streamer.Join(2000);
+        lock (sync)
+        {
+            computer.Close();
+            shared?.Dispose();
+        }
     }
 }
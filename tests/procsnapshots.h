@@ -0,0 +1,216 @@
+#ifndef PROCSNAPSHOTS_H
+#define PROCSNAPSHOTS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <string_view>
+#include "procparse.h"
+
+// /proc text captured from a live system, with the values the collectors take from it parsed
+// two ways, shared by tst_procparse and the /proc benchmarks in winsys-bench.
+
+// Captured on a 1-CPU x86-64 VM. The process in pid/stat is renamed to one with a space and
+// parentheses, which the kernel prints unescaped.
+const char* const procSnapshots[] = {
+    "MemTotal:        6147400 kB\n"
+    "MemFree:         4769852 kB\n"
+    "MemAvailable:    5585972 kB\n"
+    "Buffers:          384924 kB\n"
+    "Cached:           589504 kB\n"
+    "SwapCached:            0 kB\n"
+    "Active:           512996 kB\n"
+    "Inactive:         641924 kB\n"
+    "Active(anon):         32 kB\n"
+    "Inactive(anon):   189748 kB\n"
+    "Active(file):     512964 kB\n"
+    "Inactive(file):   452176 kB\n"
+    "Unevictable:       13424 kB\n"
+    "Mlocked:           13424 kB\n"
+    "SwapTotal:             0 kB\n"
+    "SwapFree:              0 kB\n"
+    "Zswap:                 0 kB\n"
+    "Zswapped:              0 kB\n"
+    "Dirty:               216 kB\n"
+    "Writeback:             0 kB\n"
+    "AnonPages:        193916 kB\n"
+    "Mapped:           144204 kB\n"
+    "Shmem:              9288 kB\n"
+    "KReclaimable:     116204 kB\n"
+    "Slab:             139984 kB\n"
+    "SReclaimable:     116204 kB\n"
+    "SUnreclaim:        23780 kB\n"
+    "KernelStack:        1136 kB\n"
+    "PageTables:         2040 kB\n"
+    "SecPageTables:         0 kB\n"
+    "NFS_Unstable:          0 kB\n"
+    "Bounce:                0 kB\n"
+    "WritebackTmp:          0 kB\n"
+    "CommitLimit:     3073700 kB\n"
+    "Committed_AS:     344256 kB\n"
+    "VmallocTotal:   34359738367 kB\n"
+    "VmallocUsed:       15896 kB\n"
+    "VmallocChunk:          0 kB\n"
+    "Percpu:              284 kB\n"
+    "AnonHugePages:         0 kB\n"
+    "ShmemHugePages:        0 kB\n"
+    "ShmemPmdMapped:        0 kB\n"
+    "FileHugePages:         0 kB\n"
+    "FilePmdMapped:         0 kB\n"
+    "Balloon:               0 kB\n"
+    "HugePages_Total:       0\n"
+    "HugePages_Free:        0\n"
+    "HugePages_Rsvd:        0\n"
+    "HugePages_Surp:        0\n"
+    "Hugepagesize:       2048 kB\n"
+    "Hugetlb:               0 kB\n"
+    "DirectMap4k:       24576 kB\n"
+    "DirectMap2M:     2072576 kB\n"
+    "DirectMap1G:     6291456 kB\n",
+
+    "cpu  36568 0 8296 92018 303 0 3 2194 0 0\n"
+    "cpu0 36568 0 8296 92018 303 0 3 2194 0 0\n"
+    "intr 228547 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1 1 2 0 0 0 0 276 17 0 35 1 60872 1 1198 0 11 "
+    "10 0 1353 4069 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+    "ctxt 672137\n"
+    "btime 1792188929\n"
+    "processes 57986\n"
+    "procs_running 4\n"
+    "procs_blocked 0\n"
+    "softirq 136082 0 47020 1 2160 0 0 1 0 1 86899\n",
+
+    "Inter-|   Receive                                                |  Transmit\n"
+    " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier "
+    "compressed\n"
+    "    lo: 26443566    2327    0    0    0     0          0         0 26443566    2327    0    0    0     0       0  "
+    "        0\n"
+    "  ifb0:       0       0    0    0    0     0          0         0        0       0    0    0    0     0       0  "
+    "        0\n"
+    "  ifb1:       0       0    0    0    0     0          0         0        0       0    0    0    0     0       0  "
+    "        0\n"
+    "  eth0:     864      12    0    0    0     0          0         0     1096      14    0    0    0     0       0  "
+    "        0\n",
+
+    "1 (Web (Content) 2) S 0 0 0 0 -1 4194560 42029 15467 69 60 156 313 21 17 20 0 6 0 7 28696576 3362 "
+    "18446744073709551615 1 1 0 0 0 0 0 4096 1088 0 0 0 17 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+};
+const char* const procSnapshotNames[] = { "meminfo", "stat", "net/dev", "pid/stat" };
+enum ProcSnapshot { MeminfoSnapshot, StatSnapshot, NetDevSnapshot, PidStatSnapshot, ProcSnapshotCount };
+
+// What the collectors take from each file: MemTotal and MemAvailable; total and busy ticks;
+// received and sent bytes without loopback; utime, stime and rss
+using ProcValues = std::array<quint64, 3>;
+
+inline ProcValues parseProcFast(int snapshot, std::string_view text, ProcKeyTable& meminfoKeys)
+{
+    ProcValues values = {};
+    switch (snapshot) {
+    case MeminfoSnapshot:
+        meminfoKeys.parse(text, values.data());
+        break;
+    case StatSnapshot: {
+        ProcCursor cursor(text);
+        if (cursor.consume("cpu ")) {
+            quint64 fields[8];
+            for (quint64& field : fields) {
+                field = cursor.number();
+                values[0] += field;
+            }
+            values[1] = values[0] - fields[3] - fields[4];
+        }
+        break;
+    }
+    case NetDevSnapshot: {
+        ProcCursor cursor(text);
+        if (!cursor.nextLine() || !cursor.nextLine()) {
+            break;
+        }
+        do {
+            cursor.skipSpaces();
+            std::string_view name;
+            if (!cursor.until(':', name)) {
+                break;
+            }
+            if (name != "lo") {
+                values[0] += cursor.number();
+                cursor.skipWords(7);
+                values[1] += cursor.number();
+            }
+        } while (cursor.nextLine());
+        break;
+    }
+    case PidStatSnapshot: {
+        const size_t open = text.find('(');
+        const size_t close = text.rfind(')');
+        if (open != std::string_view::npos && close != std::string_view::npos && close > open) {
+            ProcCursor cursor(text.substr(close + 1));
+            cursor.skipWords(11);
+            values[0] = cursor.number();
+            values[1] = cursor.number();
+            cursor.skipWords(8);
+            values[2] = cursor.number();
+        }
+        break;
+    }
+    }
+    return values;
+}
+
+// The same the obvious Qt way, as the old collectors and most examples do it
+inline ProcValues parseProcNaive(int snapshot, const QByteArray& bytes)
+{
+    ProcValues values = {};
+    const QString text = QString::fromLatin1(bytes);
+    const QStringList lines = text.split('\n');
+    switch (snapshot) {
+    case MeminfoSnapshot: {
+        const QString keys[] = { "MemTotal:", "MemAvailable:" };
+        for (int k = 0; k < 2; ++k) {
+            for (const QString& line : lines) {
+                if (line.startsWith(keys[k])) {
+                    values[k] = line.mid(keys[k].size()).split(' ', Qt::SkipEmptyParts).value(0).toULongLong();
+                    break;
+                }
+            }
+        }
+        break;
+    }
+    case StatSnapshot:
+        if (lines[0].startsWith("cpu ")) {
+            const QStringList fields = lines[0].split(' ', Qt::SkipEmptyParts);
+            for (int i = 1; i <= 8; ++i) {
+                values[0] += fields.value(i).toULongLong();
+            }
+            values[1] = values[0] - fields.value(4).toULongLong() - fields.value(5).toULongLong();
+        }
+        break;
+    case NetDevSnapshot:
+        for (qsizetype i = 2; i < lines.size(); ++i) {
+            const qsizetype colon = lines[i].indexOf(':');
+            if (colon < 0) {
+                break;
+            }
+            if (lines[i].left(colon).trimmed() != "lo") {
+                const QStringList fields = lines[i].mid(colon + 1).split(' ', Qt::SkipEmptyParts);
+                values[0] += fields.value(0).toULongLong();
+                values[1] += fields.value(8).toULongLong();
+            }
+        }
+        break;
+    case PidStatSnapshot: {
+        const qsizetype open = text.indexOf('(');
+        const qsizetype close = text.lastIndexOf(')');
+        if (open >= 0 && close > open) {
+            const QStringList fields = text.mid(close + 1).split(' ', Qt::SkipEmptyParts);
+            values[0] = fields.value(11).toULongLong();
+            values[1] = fields.value(12).toULongLong();
+            values[2] = fields.value(21).toULongLong();
+        }
+        break;
+    }
+    }
+    return values;
+}
+
+#endif // PROCSNAPSHOTS_H
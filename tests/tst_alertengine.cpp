@@ -0,0 +1,246 @@
+// AlertEngine rule behaviour, one property per test, and a scripted recording replayed
+// through the default rules with the transitions it must give.
+
+#include <QTemporaryDir>
+#include <QtTest>
+#include <vector>
+#include "alertengine.h"
+#include "playbackcollector.h"
+#include "samplerecording.h"
+
+namespace {
+
+const quint32 CpuTempBit = quint32(1) << int(Metric::CpuTemp);
+
+// A CPU temperature rule with nothing but the threshold set
+AlertRule cpuTempRule(double threshold)
+{
+    AlertRule rule;
+    rule.name = "cpu_temp";
+    rule.metric = Metric::CpuTemp;
+    rule.threshold = threshold;
+    return rule;
+}
+
+SysInfo cpuTemp(double celsius)
+{
+    SysInfo info;
+    info.cpuTemp = celsius;
+    return info;
+}
+
+// CPU temperature, one sample per second: a 5 s spike that the min duration filters out,
+// a long excursion wobbling inside the hysteresis band, and a second one that starts
+// during the cooldown
+double scriptedCpuTemp(int second)
+{
+    if ((second >= 100 && second < 105) || (second >= 200 && second < 230) || (second >= 270 && second < 300)) {
+        return 95.0;
+    }
+    if (second >= 230 && second < 260) {
+        return second % 2 ? 88.0 : 93.0;
+    }
+    return 60.0;
+}
+
+} // namespace
+
+class AlertEngineTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void firesPastThreshold();
+    void belowRuleFiresUnderThreshold();
+    void hysteresisDelaysClear();
+    void forMsDebouncesSpikes();
+    void cooldownSuppressesRefire();
+    void invalidSampleRestartsPendingRule();
+    void backwardTimestampStartsOver();
+    void scriptedReplay();
+};
+
+void AlertEngineTest::firesPastThreshold()
+{
+    AlertEngine alerts;
+    alerts.configure({ cpuTempRule(90.0) });
+    QCOMPARE(alerts.evaluate(cpuTemp(90.0), 1000), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(90.5), 2000), CpuTempBit);
+    QVERIFY(alerts.firing(0));
+    QCOMPARE(alerts.firedCount(0), quint64(1));
+    QCOMPARE(alerts.evaluate(cpuTemp(89.0), 3000), quint32(0));
+    QCOMPARE(alerts.firingMetrics(), quint32(0));
+}
+
+void AlertEngineTest::belowRuleFiresUnderThreshold()
+{
+    AlertRule rule;
+    rule.metric = Metric::MemUsage;
+    rule.below = true;
+    rule.threshold = 10.0;
+    rule.hysteresis = 5.0;
+    const quint32 memBit = quint32(1) << int(Metric::MemUsage);
+    AlertEngine alerts;
+    alerts.configure({ rule });
+
+    SysInfo info;
+    info.memUsage = 12;
+    QCOMPARE(alerts.evaluate(info, 1000), quint32(0));
+    info.memUsage = 8;
+    QCOMPARE(alerts.evaluate(info, 2000), memBit);
+    // Clears above threshold + hysteresis, not at the threshold
+    info.memUsage = 14;
+    QCOMPARE(alerts.evaluate(info, 3000), memBit);
+    info.memUsage = 16;
+    QCOMPARE(alerts.evaluate(info, 4000), quint32(0));
+}
+
+void AlertEngineTest::hysteresisDelaysClear()
+{
+    AlertRule rule = cpuTempRule(90.0);
+    rule.hysteresis = 5.0;
+    AlertEngine alerts;
+    alerts.configure({ rule });
+
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 1000), CpuTempBit);
+    // Below the threshold but inside the band: still firing
+    QCOMPARE(alerts.evaluate(cpuTemp(88.0), 2000), CpuTempBit);
+    QCOMPARE(alerts.evaluate(cpuTemp(85.0), 3000), CpuTempBit);
+    QCOMPARE(alerts.evaluate(cpuTemp(84.9), 4000), quint32(0));
+    QCOMPARE(alerts.firedCount(0), quint64(1));
+}
+
+void AlertEngineTest::forMsDebouncesSpikes()
+{
+    AlertRule rule = cpuTempRule(90.0);
+    rule.forMs = 5000;
+    AlertEngine alerts;
+    alerts.configure({ rule });
+
+    // 4 s above, then a dip: the pending time starts over
+    for (qint64 ms = 0; ms <= 4000; ms += 1000) {
+        QCOMPARE(alerts.evaluate(cpuTemp(95.0), ms), quint32(0));
+    }
+    QCOMPARE(alerts.evaluate(cpuTemp(60.0), 5000), quint32(0));
+    for (qint64 ms = 6000; ms < 11000; ms += 1000) {
+        QCOMPARE(alerts.evaluate(cpuTemp(95.0), ms), quint32(0));
+    }
+    // Exactly forMs after the first sample above
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 11000), CpuTempBit);
+    QCOMPARE(alerts.firedCount(0), quint64(1));
+}
+
+void AlertEngineTest::cooldownSuppressesRefire()
+{
+    AlertRule rule = cpuTempRule(90.0);
+    rule.cooldownMs = 30000;
+    AlertEngine alerts;
+    alerts.configure({ rule });
+
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 1000), CpuTempBit);
+    QCOMPARE(alerts.evaluate(cpuTemp(60.0), 2000), quint32(0));
+    // Above the threshold for the whole cooldown without firing
+    for (qint64 ms = 3000; ms < 32000; ms += 1000) {
+        QCOMPARE(alerts.evaluate(cpuTemp(95.0), ms), quint32(0));
+    }
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 32000), CpuTempBit);
+    QCOMPARE(alerts.firedCount(0), quint64(2));
+}
+
+void AlertEngineTest::invalidSampleRestartsPendingRule()
+{
+    AlertRule rule = cpuTempRule(90.0);
+    rule.forMs = 5000;
+    AlertEngine alerts;
+    alerts.configure({ rule });
+
+    // A missing reading in the middle of a pending period starts it over
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 0), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 1000), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(-1.0), 2000), quint32(0));
+    for (qint64 ms = 3000; ms < 8000; ms += 1000) {
+        QCOMPARE(alerts.evaluate(cpuTemp(95.0), ms), quint32(0));
+    }
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 8000), CpuTempBit);
+
+    // and does not clear a firing rule
+    QCOMPARE(alerts.evaluate(cpuTemp(-1.0), 9000), CpuTempBit);
+    QVERIFY(alerts.firing(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(60.0), 10000), quint32(0));
+}
+
+void AlertEngineTest::backwardTimestampStartsOver()
+{
+    AlertRule rule = cpuTempRule(90.0);
+    rule.forMs = 2000;
+    rule.cooldownMs = 60000;
+    AlertEngine alerts;
+    alerts.configure({ rule });
+
+    for (qint64 ms = 100000; ms <= 102000; ms += 1000) {
+        alerts.evaluate(cpuTemp(95.0), ms);
+    }
+    QVERIFY(alerts.firing(0));
+
+    // A sample from before the last one (a replay looping, the clock stepping back) clears
+    // a firing rule, and the pending time starts from that sample
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 50000), quint32(0));
+    QVERIFY(!alerts.firing(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 51000), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 52000), CpuTempBit);
+
+    // It also ends a cooldown
+    QCOMPARE(alerts.evaluate(cpuTemp(60.0), 53000), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 56000), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 20000), quint32(0));
+    QCOMPARE(alerts.evaluate(cpuTemp(95.0), 22000), CpuTempBit);
+}
+
+void AlertEngineTest::scriptedReplay()
+{
+    const int samples = 400;
+    const qint64 startMs = 1700000000000LL;
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const std::string path = dir.filePath("alerts.wsr").toStdString();
+    {
+        SampleRecording::Recorder recorder;
+        QVERIFY(recorder.open(path));
+        for (int i = 0; i < samples; ++i) {
+            SysInfo info;
+            info.cpuTemp = scriptedCpuTemp(i);
+            info.memUsage = 40;
+            info.gpuLoad = 10.0;
+            recorder.append(info, startMs + i * 1000LL);
+        }
+        recorder.close();
+    }
+
+    // The default CPU temperature rule (above 90, 5 s hysteresis, for 5 s, 30 s cooldown)
+    // ignores the 5 s spike, fires at 205 s and holds through the wobble until 260 s, and
+    // fires again at 290 s, 30 s after that clear, however long the value was above before
+    PlaybackCollector collector(path, 0.0);
+    QVERIFY(collector.initialize());
+    AlertEngine alerts;
+    alerts.configure(AlertEngine::defaultRules());
+    std::vector<qint64> transitions;
+    quint32 previous = 0;
+    SysInfo info;
+    while (!collector.finished()) {
+        collector.collect(info);
+        const qint64 second = (collector.timestampMs() - startMs) / 1000;
+        const quint32 firing = alerts.evaluate(info, collector.timestampMs());
+        if (firing != previous) {
+            transitions.push_back((firing & CpuTempBit) ? second : -second);
+            previous = firing;
+        }
+    }
+    const std::vector<qint64> expected = { 205, -260, 290, -300 };
+    QCOMPARE(transitions, expected);
+    QCOMPARE(alerts.firedCount(0), quint64(2));
+    QCOMPARE(alerts.firedCount(1), quint64(0));
+    QCOMPARE(alerts.firedCount(2), quint64(0));
+}
+
+QTEST_MAIN(AlertEngineTest)
+#include "tst_alertengine.moc"
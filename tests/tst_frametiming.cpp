@@ -0,0 +1,147 @@
+// FrameTimingEngine statistics for present sequences whose FPS, 1% low and frame time
+// percentiles are known in advance. The engine reads no clock, so every value is exact up to
+// the quantile sketch's bucket precision.
+
+#include <QtTest>
+#include <vector>
+#include "frameeventsource.h"
+#include "frametimingengine.h"
+
+namespace {
+
+// Percentiles are reported at the midpoint of a sketch bucket, at most 1/32 off
+bool withinSketchPrecision(double actual, double expected)
+{
+    return qAbs(actual - expected) <= expected / 32.0;
+}
+
+} // namespace
+
+class FrameTimingTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void noPresentsIsNotAvailable();
+    void constantFrameRate();
+    void hitchesSetTheOnePercentLow();
+    void pauseIsNotAFrame();
+    void syntheticReplay_data();
+    void syntheticReplay();
+};
+
+void FrameTimingTest::noPresentsIsNotAvailable()
+{
+    FrameTimingEngine engine;
+    const FrameTimingEngine::Stats stats = engine.stats(0);
+    QCOMPARE(stats.fps, -1.0);
+    QCOMPARE(stats.low1PercentFps, -1.0);
+    QCOMPARE(stats.frameTimeP50Ms, -1.0);
+    QCOMPARE(stats.frameTimeP99Ms, -1.0);
+}
+
+void FrameTimingTest::constantFrameRate()
+{
+    const qint64 frameUs = 16667;
+    FrameTimingEngine engine;
+    qint64 timestampUs = 0;
+    for (int i = 0; i < 600; ++i, timestampUs += frameUs) {
+        engine.addPresent(timestampUs);
+    }
+    const FrameTimingEngine::Stats stats = engine.stats(timestampUs - frameUs);
+    // Every frame is the same length, so FPS is exact and both percentiles are that length
+    QCOMPARE(stats.fps, 1e6 / frameUs);
+    QVERIFY(withinSketchPrecision(stats.frameTimeP50Ms, frameUs / 1000.0));
+    QVERIFY(withinSketchPrecision(stats.frameTimeP99Ms, frameUs / 1000.0));
+    QCOMPARE(stats.low1PercentFps, 1000.0 / stats.frameTimeP99Ms);
+}
+
+void FrameTimingTest::hitchesSetTheOnePercentLow()
+{
+    // Each half second is 45 frames of 10 ms and a 50 ms hitch: 92 frames a second, 2% of
+    // them hitches, so the 99th percentile is a hitch and the median is not
+    FrameTimingEngine engine;
+    qint64 timestampUs = 0;
+    for (int frame = 1; timestampUs < 10 * 1000 * 1000; ++frame) {
+        engine.addPresent(timestampUs);
+        timestampUs += frame % 46 == 0 ? 50 * 1000 : 10 * 1000;
+    }
+    // Just before 10 s the FPS slices hold the frames that ended in [9 s, 10 s)
+    const FrameTimingEngine::Stats stats = engine.stats(10 * 1000 * 1000 - 1);
+    QCOMPARE(stats.fps, 92.0);
+    QVERIFY2(withinSketchPrecision(stats.frameTimeP50Ms, 10.0), qPrintable(QString::number(stats.frameTimeP50Ms)));
+    QVERIFY2(withinSketchPrecision(stats.frameTimeP99Ms, 50.0), qPrintable(QString::number(stats.frameTimeP99Ms)));
+    QVERIFY2(withinSketchPrecision(stats.low1PercentFps, 20.0), qPrintable(QString::number(stats.low1PercentFps)));
+}
+
+void FrameTimingTest::pauseIsNotAFrame()
+{
+    FrameTimingEngine engine;
+    for (qint64 timestampUs = 0; timestampUs < 2 * 1000 * 1000; timestampUs += 10 * 1000) {
+        engine.addPresent(timestampUs);
+    }
+    // Over a second without a present there is nothing to report
+    const FrameTimingEngine::Stats paused = engine.stats(4500 * 1000);
+    QCOMPARE(paused.fps, -1.0);
+    QCOMPARE(paused.low1PercentFps, -1.0);
+
+    // The 3 s gap ending at 5 s is longer than MaxFrameUs and is dropped, not a frame
+    for (qint64 timestampUs = 5 * 1000 * 1000; timestampUs < 6 * 1000 * 1000; timestampUs += 20 * 1000) {
+        engine.addPresent(timestampUs);
+    }
+    const FrameTimingEngine::Stats resumed = engine.stats(6 * 1000 * 1000 - 1);
+    QCOMPARE(resumed.fps, 50.0);
+    // The window still holds 100 frames of 10 ms from before the pause and 49 of 20 ms after
+    QVERIFY2(withinSketchPrecision(resumed.frameTimeP50Ms, 10.0), qPrintable(QString::number(resumed.frameTimeP50Ms)));
+    QVERIFY2(withinSketchPrecision(resumed.frameTimeP99Ms, 20.0), qPrintable(QString::number(resumed.frameTimeP99Ms)));
+}
+
+void FrameTimingTest::syntheticReplay_data()
+{
+    QTest::addColumn<double>("rate");
+    QTest::addColumn<double>("fps");
+    QTest::addColumn<double>("p50Ms");
+    QTest::addColumn<double>("p99Ms");
+
+    // 10 s of SyntheticFrameSource presents with the default seed: +-5% jitter and a frame
+    // three times as long every hundredth. The values are those of the replay at the time
+    // it was written; a change here means the engine, the sketch or the source changed.
+    QTest::newRow("60 fps") << 60.0 << 60.2824231524693 << 16.895 << 17.919;
+    QTest::newRow("1000 fps") << 1000.0 << 980.941143531388 << 1.007 << 1.055;
+    QTest::newRow("5000 fps") << 5000.0 << 4902.25975877642 << 0.203 << 0.211;
+}
+
+void FrameTimingTest::syntheticReplay()
+{
+    QFETCH(double, rate);
+    QFETCH(double, fps);
+    QFETCH(double, p50Ms);
+    QFETCH(double, p99Ms);
+
+    SyntheticFrameSource source(rate);
+    std::vector<qint64> presents;
+    source.generate(10 * 1000 * 1000, presents);
+
+    // Read back every 100 ms as the sampler would, which must not change the result
+    FrameTimingEngine engine;
+    qint64 nextReadUs = 100 * 1000;
+    for (qint64 timestampUs : presents) {
+        if (timestampUs >= nextReadUs) {
+            engine.stats(nextReadUs);
+            nextReadUs += 100 * 1000;
+        }
+        engine.addPresent(timestampUs);
+    }
+    const FrameTimingEngine::Stats stats = engine.stats(presents.back());
+
+    QVERIFY2(qAbs(stats.fps - fps) <= fps * 1e-9, qPrintable(QString::number(stats.fps, 'g', 15)));
+    QCOMPARE(stats.frameTimeP50Ms, p50Ms);
+    QCOMPARE(stats.frameTimeP99Ms, p99Ms);
+    QCOMPARE(stats.low1PercentFps, 1000.0 / p99Ms);
+    // Close to the nominal rate, with the stutters pulling the 1% low below it
+    QVERIFY(withinSketchPrecision(stats.frameTimeP50Ms, 1000.0 / rate));
+    QVERIFY(stats.low1PercentFps < stats.fps);
+}
+
+QTEST_MAIN(FrameTimingTest)
+#include "tst_frametiming.moc"
@@ -0,0 +1,53 @@
+// The sampler's helper supervision against the stand-in winsys-sensor-helper: a helper
+// that answers every request must not be taken for hung however far apart the requests are.
+
+#include <QtTest>
+#include <vector>
+#include "sysinfomonitor.h"
+
+namespace {
+
+// Past HelperSupervisor's default hang timeout, so only the adaptive sizing keeps it alive
+const int MaxIntervalMs = 6000;
+
+} // namespace
+
+class HelperSupervisorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void adaptiveRequestResponseStaysRunning();
+};
+
+void HelperSupervisorTest::adaptiveRequestResponseStaysRunning()
+{
+    // Uptime is only ever sampled at maxInterval, so with request/response every frame is
+    // a full maxInterval after the one before
+    SamplerSettings settings;
+    settings.metricGroups = metricGroupBit(MetricGroup::Uptime);
+    settings.adaptiveSampling = true;
+    settings.maxInterval = MaxIntervalMs;
+    settings.sensorHelperPath = QStringLiteral(WINSYS_SENSOR_HELPER);
+    settings.sensorStreaming = false;
+    settings.trackDailyData = false;
+
+    SysInfoMonitor monitor(settings);
+    std::vector<SysInfo> samples;
+    connect(&monitor, &SysInfoMonitor::statsUpdated, this, [&samples](const SysInfo& info) { samples.push_back(info); });
+
+    monitor.start();
+    // Samples at 0, 1 and 2 maxIntervals: the last comes after two gaps without a frame
+    QTRY_VERIFY_WITH_TIMEOUT(samples.size() >= 3, 3 * MaxIntervalMs + 5000);
+    monitor.stop();
+
+    for (const SysInfo& info : samples) {
+        QVERIFY2(info.helperHealth == int(HelperHealth::Starting) || info.helperHealth == int(HelperHealth::Running),
+                 qPrintable(QString("helper health %1").arg(info.helperHealth)));
+        QCOMPARE(info.helperRestarts, 0);
+    }
+    QCOMPARE(samples.back().helperHealth, int(HelperHealth::Running));
+}
+
+QTEST_MAIN(HelperSupervisorTest)
+#include "tst_helpersupervisor.moc"
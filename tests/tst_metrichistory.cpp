@@ -0,0 +1,104 @@
+// MetricHistory's rolling window aggregates against a plain recomputation over the window,
+// with N/A (-1) samples left out of min, max and mean.
+
+#include <QtTest>
+#include <algorithm>
+#include <vector>
+#include "metrichistory.h"
+
+namespace {
+
+SysInfo cpuTemp(double celsius)
+{
+    SysInfo info;
+    info.cpuTemp = celsius;
+    return info;
+}
+
+} // namespace
+
+class MetricHistoryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void naSamplesAreLeftOutOfStats();
+    void statsMatchTheWindow();
+};
+
+void MetricHistoryTest::naSamplesAreLeftOutOfStats()
+{
+    MetricHistory history(4);
+    qint64 timestampMs = 1000;
+    for (double value : { 50.0, -1.0, 70.0, 60.0 }) {
+        history.push(cpuTemp(value), timestampMs += 1000);
+    }
+    MetricStats stats = history.stats(Metric::CpuTemp);
+    QCOMPARE(stats.min, 50.0f);
+    QCOMPARE(stats.max, 70.0f);
+    QCOMPARE(stats.mean, 60.0f);
+    QCOMPARE(stats.samples, 4);
+
+    // The window becomes 60 and three N/A
+    for (int i = 0; i < 3; ++i) {
+        history.push(cpuTemp(-1.0), timestampMs += 1000);
+    }
+    stats = history.stats(Metric::CpuTemp);
+    QCOMPARE(stats.min, 60.0f);
+    QCOMPARE(stats.max, 60.0f);
+    QCOMPARE(stats.mean, 60.0f);
+
+    // Nothing but N/A left: the aggregates are N/A too
+    history.push(cpuTemp(-1.0), timestampMs += 1000);
+    stats = history.stats(Metric::CpuTemp);
+    QCOMPARE(stats.min, -1.0f);
+    QCOMPARE(stats.max, -1.0f);
+    QCOMPARE(stats.mean, -1.0f);
+    QCOMPARE(stats.samples, 4);
+
+    history.push(cpuTemp(80.0), timestampMs += 1000);
+    stats = history.stats(Metric::CpuTemp);
+    QCOMPARE(stats.min, 80.0f);
+    QCOMPARE(stats.max, 80.0f);
+    QCOMPARE(stats.mean, 80.0f);
+}
+
+void MetricHistoryTest::statsMatchTheWindow()
+{
+    const int capacity = 16;
+    MetricHistory history(capacity);
+    std::vector<float> pushed;
+    quint64 random = 12345;
+    for (int i = 0; i < 500; ++i) {
+        random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Whole degrees, so the float sums are exact; about one in five is N/A
+        const int roll = static_cast<int>((random >> 33) % 100);
+        const float value = roll < 20 ? -1.0f : static_cast<float>(roll);
+        history.push(cpuTemp(value), 1000 + i * 1000LL);
+        pushed.push_back(value);
+
+        std::vector<float> window;
+        for (size_t j = pushed.size() - std::min<size_t>(pushed.size(), capacity); j < pushed.size(); ++j) {
+            if (pushed[j] >= 0.0f) {
+                window.push_back(pushed[j]);
+            }
+        }
+        const MetricStats stats = history.stats(Metric::CpuTemp);
+        QCOMPARE(stats.samples, std::min(i + 1, capacity));
+        if (window.empty()) {
+            QCOMPARE(stats.min, -1.0f);
+            QCOMPARE(stats.mean, -1.0f);
+            continue;
+        }
+        float sum = 0.0f;
+        for (float v : window) {
+            sum += v;
+        }
+        QCOMPARE(stats.min, *std::min_element(window.begin(), window.end()));
+        QCOMPARE(stats.max, *std::max_element(window.begin(), window.end()));
+        QCOMPARE(stats.mean, sum / static_cast<float>(window.size()));
+    }
+}
+
+QTEST_MAIN(MetricHistoryTest)
+#include "tst_metrichistory.moc"
@@ -0,0 +1,202 @@
+// MetricStatistics against values worked out by hand: the moving average over irregular
+// tick spacing, the percentiles against the sorted input, the peak hold and its decay, N/A
+// samples and a clock stepping back.
+
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "metricstatistics.h"
+
+namespace {
+
+// One metric per statistic, all doubles so nothing is rounded on the way back
+MetricStatisticsConfig statisticsConfig()
+{
+    MetricStatisticsConfig config;
+    config.statistic[int(Metric::CpuLoad)] = MetricStatistic::Average;
+    config.statistic[int(Metric::DiskLoad)] = MetricStatistic::P50;
+    config.statistic[int(Metric::GpuLoad)] = MetricStatistic::P95;
+    config.statistic[int(Metric::CpuTemp)] = MetricStatistic::P99;
+    config.statistic[int(Metric::GpuTemp)] = MetricStatistic::Peak;
+    config.averageSeconds = 2.0;
+    config.windowSeconds = 60;
+    config.peakHoldSeconds = 5;
+    return config;
+}
+
+// value in every metric of statisticsConfig()
+SysInfo allMetrics(double value)
+{
+    SysInfo info;
+    info.cpuLoad = value;
+    info.diskLoad = value;
+    info.gpuLoad = value;
+    info.cpuTemp = value;
+    info.gpuTemp = value;
+    return info;
+}
+
+double average(MetricStatistics& statistics, double value, qint64 timestampMs)
+{
+    SysInfo info = allMetrics(value);
+    statistics.apply(info, timestampMs);
+    return info.cpuLoad;
+}
+
+double peak(MetricStatistics& statistics, double value, qint64 timestampMs)
+{
+    SysInfo info = allMetrics(value);
+    statistics.apply(info, timestampMs);
+    return info.gpuTemp;
+}
+
+// Percentiles are reported at the midpoint of a sketch bucket, at most 1/32 off
+bool withinSketchPrecision(double actual, double expected)
+{
+    return qAbs(actual - expected) <= expected / 32.0 + 1e-9;
+}
+
+// The value of rank round(q * n), 1-based, as the sketch picks it
+double sortedPercentile(std::vector<double> values, double q)
+{
+    std::sort(values.begin(), values.end());
+    const size_t rank = std::clamp<size_t>(static_cast<size_t>(q * values.size() + 0.5), 1, values.size());
+    return values[rank - 1];
+}
+
+} // namespace
+
+class MetricStatisticsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void averageFollowsTickSpacing();
+    void percentilesMatchSortedInput();
+    void peakHoldsThenDecays();
+    void naSamplesLeaveStateUntouched();
+    void backwardClockStartsOver();
+};
+
+void MetricStatisticsTest::averageFollowsTickSpacing()
+{
+    MetricStatistics statistics;
+    statistics.configure(statisticsConfig());
+
+    // exp(-dt / 2 s) of the previous average survives each step
+    QCOMPARE(average(statistics, 10.0, 0), 10.0);
+    QCOMPARE(average(statistics, 20.0, 1000), 13.934693402873666);
+    QCOMPARE(average(statistics, 20.0, 3000), 17.768698398515703);
+    QCOMPARE(average(statistics, 0.0, 3100), 16.90210875174685);
+
+    // One 2 s step lands where two 1 s steps of the same value do
+    MetricStatistics steady;
+    steady.configure(statisticsConfig());
+    average(steady, 10.0, 0);
+    average(steady, 20.0, 1000);
+    average(steady, 20.0, 2000);
+    QCOMPARE(average(steady, 20.0, 3000), 17.768698398515703);
+}
+
+void MetricStatisticsTest::percentilesMatchSortedInput()
+{
+    MetricStatistics statistics;
+    statistics.configure(statisticsConfig());
+
+    // 300 values in hundredths, 100 ms apart: 30 s, all inside the 60 s window
+    std::vector<double> values;
+    quint64 random = 7;
+    for (int i = 0; i < 300; ++i) {
+        random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+        const double value = static_cast<double>((random >> 33) % 10000) / 100.0;
+        values.push_back(value);
+        SysInfo info = allMetrics(value);
+        statistics.apply(info, 1000 + i * 100LL);
+
+        const double p50 = sortedPercentile(values, 0.50);
+        const double p95 = sortedPercentile(values, 0.95);
+        const double p99 = sortedPercentile(values, 0.99);
+        QVERIFY2(withinSketchPrecision(info.diskLoad, p50), qPrintable(QString("p50 %1, sorted %2").arg(info.diskLoad).arg(p50)));
+        QVERIFY2(withinSketchPrecision(info.gpuLoad, p95), qPrintable(QString("p95 %1, sorted %2").arg(info.gpuLoad).arg(p95)));
+        QVERIFY2(withinSketchPrecision(info.cpuTemp, p99), qPrintable(QString("p99 %1, sorted %2").arg(info.cpuTemp).arg(p99)));
+    }
+}
+
+void MetricStatisticsTest::peakHoldsThenDecays()
+{
+    MetricStatistics statistics;
+    statistics.configure(statisticsConfig());
+
+    QCOMPARE(peak(statistics, 80.0, 0), 80.0);
+    // Held for the full 5 s
+    for (qint64 ms = 1000; ms <= 5000; ms += 1000) {
+        QCOMPARE(peak(statistics, 40.0, ms), 80.0);
+    }
+    // then falls towards the current value with the average's 2 s time constant
+    QCOMPARE(peak(statistics, 40.0, 6000), 40.0 + 40.0 * std::exp(-0.5));
+    QCOMPARE(peak(statistics, 40.0, 7000), 40.0 + 40.0 * std::exp(-1.0));
+    QCOMPARE(peak(statistics, 40.0, 9000), 40.0 + 40.0 * std::exp(-2.0));
+    // A value above the decayed peak is the new peak, held again
+    QCOMPARE(peak(statistics, 50.0, 9500), 50.0);
+    QCOMPARE(peak(statistics, 40.0, 14500), 50.0);
+}
+
+void MetricStatisticsTest::naSamplesLeaveStateUntouched()
+{
+    MetricStatistics statistics;
+    statistics.configure(statisticsConfig());
+
+    SysInfo first = allMetrics(20.0);
+    first.gpuTemp = 80.0;
+    statistics.apply(first, 0);
+
+    // Every metric passes -1 through
+    SysInfo missing = allMetrics(-1.0);
+    statistics.apply(missing, 1000);
+    QCOMPARE(missing.cpuLoad, -1.0);
+    QCOMPARE(missing.diskLoad, -1.0);
+    QCOMPARE(missing.gpuLoad, -1.0);
+    QCOMPARE(missing.cpuTemp, -1.0);
+    QCOMPARE(missing.gpuTemp, -1.0);
+
+    // The average decays over the 2 s since the last real sample, not the 1 s since the N/A
+    SysInfo next = allMetrics(10.0);
+    next.gpuTemp = 40.0;
+    statistics.apply(next, 2000);
+    QCOMPARE(next.cpuLoad, 10.0 + 10.0 * std::exp(-1.0));
+    // The window holds 20 and 10 only: the median is the lower, p95 and p99 the upper
+    QVERIFY2(withinSketchPrecision(next.diskLoad, 10.0), qPrintable(QString::number(next.diskLoad)));
+    QVERIFY2(withinSketchPrecision(next.gpuLoad, 20.0), qPrintable(QString::number(next.gpuLoad)));
+    QVERIFY2(withinSketchPrecision(next.cpuTemp, 20.0), qPrintable(QString::number(next.cpuTemp)));
+    // The peak is still held
+    QCOMPARE(next.gpuTemp, 80.0);
+}
+
+void MetricStatisticsTest::backwardClockStartsOver()
+{
+    MetricStatistics statistics;
+    statistics.configure(statisticsConfig());
+
+    for (qint64 ms = 10000; ms <= 12000; ms += 1000) {
+        SysInfo info = allMetrics(90.0);
+        statistics.apply(info, ms);
+    }
+
+    // A sample from before the last one restarts every statistic from that sample
+    SysInfo stepped = allMetrics(20.0);
+    statistics.apply(stepped, 5000);
+    QCOMPARE(stepped.cpuLoad, 20.0);
+    QCOMPARE(stepped.gpuTemp, 20.0);
+    // The 90s are gone from the window
+    QVERIFY2(withinSketchPrecision(stepped.diskLoad, 20.0), qPrintable(QString::number(stepped.diskLoad)));
+    QVERIFY2(withinSketchPrecision(stepped.gpuLoad, 20.0), qPrintable(QString::number(stepped.gpuLoad)));
+    QVERIFY2(withinSketchPrecision(stepped.cpuTemp, 20.0), qPrintable(QString::number(stepped.cpuTemp)));
+
+    // and goes on from there
+    QCOMPARE(average(statistics, 30.0, 7000), 30.0 - 10.0 * std::exp(-1.0));
+    QCOMPARE(peak(statistics, 10.0, 8000), 30.0);
+}
+
+QTEST_MAIN(MetricStatisticsTest)
+#include "tst_metricstatistics.moc"
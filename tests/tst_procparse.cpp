@@ -0,0 +1,264 @@
+// The zero-copy /proc parser against known values and against simple reference parsers:
+// captured snapshots, every truncation of them and randomly mutated copies. Each text is
+// copied to a buffer of exactly its size, so a sanitizer build catches any read past the end.
+
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "procparse.h"
+#include "procsnapshots.h"
+
+Q_DECLARE_METATYPE(ProcValues)
+
+namespace {
+
+const int MutationsPerSnapshot = 500;
+
+// splitmix64, so the mutations are the same on every platform and standard library
+quint64 nextRandom(quint64& state)
+{
+    quint64 z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// The snapshot with up to four bytes replaced by digits, blanks, newlines, parentheses,
+// colons, signs or bytes above 0x7F
+std::vector<char> mutatedSnapshot(int snapshot, quint64& random)
+{
+    static const char replacements[] = "0123456789  \t\n\n():-+kB\x7f\x80\xff";
+    const std::string_view full(procSnapshots[snapshot]);
+    std::vector<char> text(full.begin(), full.end());
+    for (int edits = 1 + static_cast<int>(nextRandom(random) % 4); edits > 0; --edits) {
+        text[nextRandom(random) % text.size()] = replacements[nextRandom(random) % (sizeof(replacements) - 1)];
+    }
+    return text;
+}
+
+// The unsigned decimal at p the plain way, one digit at a time
+const char* digitLoop(const char* p, const char* end, quint64& value)
+{
+    value = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        value = value * 10 + static_cast<quint64>(*p - '0');
+    }
+    return p;
+}
+
+QString describe(const ProcValues& values)
+{
+    return QString("%1 %2 %3").arg(values[0]).arg(values[1]).arg(values[2]);
+}
+
+} // namespace
+
+class ProcParseTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseDecimal_data();
+    void parseDecimal();
+    void cursorStaysOnItsLine();
+    void keyTableFollowsMovedKeys();
+    void snapshots_data();
+    void snapshots();
+    void procFileRereads();
+    void truncatedSnapshotsMatchNaive();
+    void mutatedNumbersMatchDigitLoop();
+    void cachedKeyTableMatchesFresh();
+};
+
+void ProcParseTest::parseDecimal_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<quint64>("value");
+    QTest::addColumn<int>("length");
+
+    QTest::newRow("empty") << QByteArray() << quint64(0) << 0;
+    QTest::newRow("not a digit") << QByteArray("x12") << quint64(0) << 0;
+    QTest::newRow("zero") << QByteArray("0") << quint64(0) << 1;
+    QTest::newRow("leading zeros") << QByteArray("000042 kB") << quint64(42) << 6;
+    QTest::newRow("seven digits") << QByteArray("1234567") << quint64(1234567) << 7;
+    QTest::newRow("eight digits") << QByteArray("12345678") << quint64(12345678) << 8;
+    QTest::newRow("eight then space") << QByteArray("12345678 9") << quint64(12345678) << 8;
+    QTest::newRow("nine digits") << QByteArray("123456789") << quint64(123456789) << 9;
+    QTest::newRow("sixteen digits") << QByteArray("9876543210123456:") << quint64(9876543210123456ULL) << 16;
+    QTest::newRow("max") << QByteArray("18446744073709551615\n") << quint64(18446744073709551615ULL) << 20;
+    QTest::newRow("wraps") << QByteArray("18446744073709551616") << quint64(0) << 20;
+    QTest::newRow("colon after") << QByteArray("98:") << quint64(98) << 2;
+    QTest::newRow("high byte after") << QByteArray("12345\xb9") << quint64(12345) << 5;
+}
+
+void ProcParseTest::parseDecimal()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(quint64, value);
+    QFETCH(int, length);
+
+    const std::vector<char> exact(text.begin(), text.end());
+    quint64 parsed = ~quint64(0);
+    const char* end = ::parseDecimal(exact.data(), exact.data() + exact.size(), parsed);
+    QCOMPARE(parsed, value);
+    QCOMPARE(static_cast<int>(end - exact.data()), length);
+}
+
+void ProcParseTest::cursorStaysOnItsLine()
+{
+    const std::string text = "cpu0 12 -3\nkey: value 7\n";
+    ProcCursor cursor(text);
+    QCOMPARE(cursor.word(), std::string_view("cpu0"));
+    QCOMPARE(cursor.number(), quint64(12));
+    QCOMPARE(cursor.signedNumber(), qint64(-3));
+    // Past the last field of a line there is nothing more to take from it
+    QCOMPARE(cursor.word(), std::string_view());
+    std::string_view name;
+    QVERIFY(!cursor.until(':', name));
+    QVERIFY(cursor.nextLine());
+    QVERIFY(cursor.until(':', name));
+    QCOMPARE(name, std::string_view("key"));
+    QCOMPARE(cursor.number(), quint64(0));
+    cursor.skipWords(1);
+    QCOMPARE(cursor.number(), quint64(7));
+    QVERIFY(!cursor.nextLine());
+    QVERIFY(cursor.atEnd());
+}
+
+void ProcParseTest::keyTableFollowsMovedKeys()
+{
+    ProcKeyTable keys{ "MemTotal:", "MemAvailable:" };
+    quint64 values[2];
+    QVERIFY(keys.parse("MemTotal: 100 kB\nMemFree: 5 kB\nMemAvailable: 50 kB\n", values));
+    QCOMPARE(values[0], quint64(100));
+    QCOMPARE(values[1], quint64(50));
+    // A value grew a digit and a line was added in front, so both cached offsets miss
+    QVERIFY(keys.parse("Extra: 1\nMemTotal: 1000 kB\nMemFree: 5 kB\nMemAvailable: 60 kB\n", values));
+    QCOMPARE(values[0], quint64(1000));
+    QCOMPARE(values[1], quint64(60));
+    // A key in the middle of a line is not a key
+    QVERIFY(!keys.parse("MemTotal: 7\nXMemAvailable: 8\n", values));
+    QCOMPARE(values[0], quint64(7));
+    QCOMPARE(values[1], quint64(0));
+}
+
+void ProcParseTest::snapshots_data()
+{
+    QTest::addColumn<int>("snapshot");
+    QTest::addColumn<ProcValues>("expected");
+
+    // MemTotal and MemAvailable; total and busy ticks of the first eight cpu fields; bytes
+    // received and sent without loopback; utime, stime and rss after the renamed comm
+    QTest::newRow("meminfo") << int(MeminfoSnapshot) << ProcValues{ 6147400, 5585972, 0 };
+    QTest::newRow("stat") << int(StatSnapshot) << ProcValues{ 139382, 47061, 0 };
+    QTest::newRow("net/dev") << int(NetDevSnapshot) << ProcValues{ 864, 1096, 0 };
+    QTest::newRow("pid/stat") << int(PidStatSnapshot) << ProcValues{ 156, 313, 3362 };
+}
+
+void ProcParseTest::snapshots()
+{
+    QFETCH(int, snapshot);
+    QFETCH(ProcValues, expected);
+
+    ProcKeyTable meminfoKeys{ "MemTotal:", "MemAvailable:" };
+    const std::string_view text(procSnapshots[snapshot]);
+    QCOMPARE(describe(parseProcFast(snapshot, text, meminfoKeys)), describe(expected));
+    // Again with the offsets the first parse cached
+    QCOMPARE(describe(parseProcFast(snapshot, text, meminfoKeys)), describe(expected));
+    QCOMPARE(describe(parseProcNaive(snapshot, procSnapshots[snapshot])), describe(expected));
+}
+
+void ProcParseTest::procFileRereads()
+{
+#ifdef Q_OS_LINUX
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const std::string path = dir.filePath("meminfo").toStdString();
+    auto write = [&path](const std::string& text) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        QVERIFY(file);
+        std::fputs(text.c_str(), file);
+        std::fclose(file);
+    };
+
+    ProcFile file;
+    QVERIFY(!file.open(dir.filePath("missing").toStdString()));
+    QVERIFY(!file.isOpen());
+    QVERIFY(file.read().empty());
+
+    write(procSnapshots[MeminfoSnapshot]);
+    QVERIFY(file.open(path));
+    // Larger than the first buffer, so the buffer grows on the first read
+    const std::string_view text = file.read();
+    QCOMPARE(text, std::string_view(procSnapshots[MeminfoSnapshot]));
+    QCOMPARE(text.data()[text.size()], '\0');
+
+    // The same descriptor sees the file as it is at each read
+    write("MemTotal: 1 kB\n");
+    QCOMPARE(file.read(), std::string_view("MemTotal: 1 kB\n"));
+    file.close();
+    QVERIFY(file.read().empty());
+#else
+    QSKIP("ProcFile is Linux only");
+#endif
+}
+
+void ProcParseTest::truncatedSnapshotsMatchNaive()
+{
+    // Every prefix, as when a file changes length between reads
+    ProcKeyTable cached{ "MemTotal:", "MemAvailable:" };
+    for (int snapshot = 0; snapshot < ProcSnapshotCount; ++snapshot) {
+        const std::string_view full(procSnapshots[snapshot]);
+        for (size_t length = 0; length <= full.size(); ++length) {
+            const std::vector<char> text(full.begin(), full.begin() + length);
+            const ProcValues fast = parseProcFast(snapshot, std::string_view(text.data(), text.size()), cached);
+            const ProcValues naive = parseProcNaive(snapshot, QByteArray(text.data(), static_cast<qsizetype>(text.size())));
+            QVERIFY2(fast == naive, qPrintable(QString("%1 cut at %2: %3, naive %4")
+                                                   .arg(procSnapshotNames[snapshot]).arg(length)
+                                                   .arg(describe(fast), describe(naive))));
+        }
+    }
+}
+
+void ProcParseTest::mutatedNumbersMatchDigitLoop()
+{
+    quint64 random = 1;
+    for (int snapshot = 0; snapshot < ProcSnapshotCount; ++snapshot) {
+        for (int mutation = 0; mutation < MutationsPerSnapshot; ++mutation) {
+            const std::vector<char> text = mutatedSnapshot(snapshot, random);
+            const char* end = text.data() + text.size();
+            for (const char* p = text.data(); p != end; ++p) {
+                quint64 expected;
+                const char* expectedEnd = digitLoop(p, end, expected);
+                quint64 value;
+                const char* valueEnd = ::parseDecimal(p, end, value);
+                QVERIFY2(valueEnd == expectedEnd && value == expected,
+                         qPrintable(QString("%1 mutation %2 offset %3: %4, digit loop %5")
+                                        .arg(procSnapshotNames[snapshot]).arg(mutation).arg(p - text.data())
+                                        .arg(value).arg(expected)));
+            }
+        }
+    }
+}
+
+void ProcParseTest::cachedKeyTableMatchesFresh()
+{
+    // One table through every mutated copy, its offsets cached from the copy before
+    ProcKeyTable cached{ "MemTotal:", "MemAvailable:" };
+    quint64 random = 2;
+    for (int mutation = 0; mutation < MutationsPerSnapshot; ++mutation) {
+        const std::vector<char> text = mutatedSnapshot(MeminfoSnapshot, random);
+        const std::string_view view(text.data(), text.size());
+        ProcKeyTable fresh{ "MemTotal:", "MemAvailable:" };
+        const ProcValues fromCached = parseProcFast(MeminfoSnapshot, view, cached);
+        const ProcValues fromFresh = parseProcFast(MeminfoSnapshot, view, fresh);
+        QVERIFY2(fromCached == fromFresh, qPrintable(QString("mutation %1: %2, fresh %3")
+                                                         .arg(mutation)
+                                                         .arg(describe(fromCached), describe(fromFresh))));
+    }
+}
+
+QTEST_MAIN(ProcParseTest)
+#include "tst_procparse.moc"
@@ -0,0 +1,91 @@
+// The sampler runs on its own thread: a collector that takes far longer than the sampling
+// interval must not hold up the GUI thread's event loop.
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QtTest>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "metriccollector.h"
+#include "sysinfomonitor.h"
+
+namespace {
+
+const int SampleIntervalMs = 50;
+// Each sample blocks the sampler thread for five intervals
+const int SlowCollectMs = 250;
+const int GuiTimerMs = 10;
+// How late the GUI timer may fire; a GUI thread blocked by a collect would be SlowCollectMs late
+const qint64 MaxLatenessMs = 40;
+
+class SlowCollector : public MetricCollector
+{
+public:
+    explicit SlowCollector(std::atomic<int>& collects)
+        : m_collects(collects)
+    {
+    }
+
+    const char* name() const override { return "slow"; }
+    bool initialize() override { return true; }
+    void collect(SysInfo& info) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SlowCollectMs));
+        info.cpuLoad = ++m_collects;
+    }
+
+private:
+    std::atomic<int>& m_collects;
+};
+
+} // namespace
+
+class SamplerLatencyTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void guiTimerKeepsFiringWhileCollectorBlocks();
+};
+
+void SamplerLatencyTest::guiTimerKeepsFiringWhileCollectorBlocks()
+{
+    SamplerSettings settings;
+    settings.updateInterval = SampleIntervalMs;
+    settings.metricGroups = metricGroupBit(MetricGroup::Cpu);
+    settings.trackDailyData = false;
+
+    std::atomic<int> collects(0);
+    SysInfoMonitor monitor(settings, [&collects]() { return std::make_unique<SlowCollector>(collects); });
+    int delivered = 0;
+    connect(&monitor, &SysInfoMonitor::statsUpdated, this, [&delivered](const SysInfo&) { ++delivered; });
+
+    QTimer timer;
+    timer.setTimerType(Qt::PreciseTimer);
+    QElapsedTimer sinceLastTick;
+    qint64 worstLatenessMs = 0;
+    int ticks = 0;
+    connect(&timer, &QTimer::timeout, this, [&]() {
+        if (ticks++ > 0) {
+            worstLatenessMs = qMax(worstLatenessMs, sinceLastTick.elapsed() - GuiTimerMs);
+        }
+        sinceLastTick.start();
+    });
+
+    monitor.start();
+    timer.start(GuiTimerMs);
+    QTest::qWait(6 * SlowCollectMs);
+    timer.stop();
+    monitor.stop();
+
+    // The sampler was busy for most of the window, and its samples still got through
+    QVERIFY2(collects.load() >= 4, qPrintable(QString("only %1 collects").arg(collects.load())));
+    QVERIFY(delivered >= 3);
+    QVERIFY2(worstLatenessMs <= MaxLatenessMs,
+             qPrintable(QString("GUI timer fired %1 ms late").arg(worstLatenessMs)));
+    QVERIFY(ticks >= 6 * SlowCollectMs / GuiTimerMs / 2);
+}
+
+QTEST_MAIN(SamplerLatencyTest)
+#include "tst_samplerlatency.moc"